@@ -98,8 +98,9 @@ end BatcherState
 
 /-! ## Stream Entry Parsing
 
-Redis XREAD returns entries in RESP format. This section provides utilities
-to parse stream entries into structured data.
+XREAD replies are decoded on the C side into `FFI.StreamRead`
+(stream → entries → field/value pairs); this section turns them into
+`StreamEntry` values.
 -/
 
 /-- A parsed stream entry -/
@@ -114,6 +115,13 @@ namespace StreamEntry
 instance : Repr StreamEntry where
   reprPrec e _ := s!"StreamEntry(id={e.id}, fields={e.fields.size})"
 
+/-- Build an entry from a decoded XREAD entry. Fields whose name is not
+    valid UTF-8 are dropped; values are kept as raw bytes. -/
+def ofRaw (id : ByteArray) (fields : Array (ByteArray × ByteArray)) : StreamEntry := {
+  id := String.fromUTF8? id |>.getD ""
+  fields := fields.filterMap fun (k, v) => (String.fromUTF8? k).map (·, v)
+}
+
 end StreamEntry
 
 /-- Parse a simple key-value list from stream response
@@ -188,14 +196,12 @@ def processStreamToBatches
     let streams := [(streamCfg.streamKey, state.lastId)]
     let data ← xread streams (some streamCfg.maxBatchRows) streamCfg.blockTimeoutMs
 
-    -- Check if we got data (non-empty response)
-    if data.size > 0 then
-      -- Note: In a real implementation, you'd parse the RESP response here
-      -- For now, we'll track that data was received
-      -- The actual parsing depends on the RESP format from redis-lean
-
-      -- Simulate entry addition (real implementation would parse `data`)
-      state := { state with entryCount := state.entryCount + 1 }
+    -- Entries arrive decoded; addEntry also advances lastId
+    let mut received : Nat := 0
+    for (_, entries) in data do
+      for (id, fields) in entries do
+        state := addEntry state (StreamEntry.ofRaw id fields)
+        received := received + 1
 
     -- Check flush conditions
     let currentTime ← IO.monoMsNow
@@ -223,7 +229,7 @@ def processStreamToBatches
       | none => pure ()
 
     -- Small delay to prevent tight loop when no data
-    if data.size == 0 then
+    if received == 0 then
       -- Exit if non-blocking and no data
       if streamCfg.blockTimeoutMs.isNone then
         break
@@ -22,6 +22,7 @@ import RedisExamples.Mathlib.DistProof
 import RedisExamples.Features.TypedKeys
 import RedisExamples.Features.Caching
 import RedisExamples.Features.Pool
+import RedisExamples.Features.Cluster
 import RedisExamples.Features.Metrics
 import RedisExamples.Features.Lists
 import RedisExamples.Features.SortedSets
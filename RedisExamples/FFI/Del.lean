@@ -24,14 +24,14 @@ def ex0 : EIO Error Unit := do
 
     try
       Log.EIO.info "del temp"
-      let deleted ← FFI.del ctx [key]
+      let deleted ← FFI.del ctx #[key]
       Log.EIO.info s!"✓ deleted {deleted} key"
     catch e =>
       Log.EIO.error s!"✗ del error: {e}"
 
     try
       Log.EIO.info "del temp [already deleted]"
-      let deleted ← FFI.del ctx [key]
+      let deleted ← FFI.del ctx #[key]
       Log.EIO.info s!"✓ deleted {deleted} key (should be 0)"
     catch e =>
       Log.EIO.error s!"✗ del error: {e}"
@@ -40,7 +40,7 @@ def ex1 : EIO Error Unit := do
   Log.EIO.info "example: multiple key deletion"
 
   FFI.withRedis "127.0.0.1" 6379 fun ctx => do
-    let testData := [
+    let testData := #[
       ("user:1", "Alice"),
       ("user:2", "Bob"),
       ("user:3", "Charlie")
@@ -95,7 +95,7 @@ def ex2 : EIO Error Unit := do
 
     try
       Log.EIO.info "del existing missing"
-      let deleted ← FFI.del ctx [existingKey, missingKey]
+      let deleted ← FFI.del ctx #[existingKey, missingKey]
       Log.EIO.info s!"✓ deleted {deleted} keys (should be 1)"
     catch e =>
       Log.EIO.error s!"✗ del error: {e}"
@@ -13,6 +13,7 @@ Demonstrates non-blocking Redis operations:
 - Polling for data availability
 - Non-blocking read/write
 - Building responsive applications
+- The async engine: many requests in flight on one connection
 
 These patterns are useful for building event-driven applications
 or when you need to handle multiple connections without blocking.
@@ -63,7 +64,7 @@ def exPollingForData (ctx : FFI.Ctx) : EIO Error Unit := do
   let readable1 ← FFI.canRead ctx 1000
   if readable1 then
     let reply1 ← FFI.getReply ctx
-    Log.EIO.info s!"  SET reply: {String.fromUTF8! reply1}"
+    Log.EIO.info s!"  SET reply: {reply1}"
   else
     Log.EIO.info "  No data available within 1s"
 
@@ -71,7 +72,7 @@ def exPollingForData (ctx : FFI.Ctx) : EIO Error Unit := do
   let readable2 ← FFI.canRead ctx 1000
   if readable2 then
     let reply2 ← FFI.getReply ctx
-    Log.EIO.info s!"  GET reply: {String.fromUTF8! reply2}"
+    Log.EIO.info s!"  GET reply: {reply2}"
   else
     Log.EIO.info "  No data available within 1s"
 
@@ -91,7 +92,7 @@ def exPollReply (ctx : FFI.Ctx) : EIO Error Unit := do
   -- Use pollReply for convenient non-blocking read
   let reply ← FFI.pollReply ctx 2000
   match reply with
-  | some data => Log.EIO.info s!"  Got reply: {String.fromUTF8! data}"
+  | some data => Log.EIO.info s!"  Got reply: {data}"
   | none => Log.EIO.info "  No reply within 2s timeout"
 
   -- Cleanup
@@ -121,7 +122,7 @@ def exManualBufferControl (ctx : FFI.Ctx) : EIO Error Unit := do
     -- Get reply from buffer (non-blocking)
     let replyOpt ← FFI.getReplyNonBlock ctx
     match replyOpt with
-    | some data => Log.EIO.info s!"  Reply: {String.fromUTF8! data}"
+    | some data => Log.EIO.info s!"  Reply: {data}"
     | none => Log.EIO.info "  Reply not yet complete"
   else
     Log.EIO.info "  No data available"
@@ -148,7 +149,7 @@ def exTimeoutHandling (ctx : FFI.Ctx) : EIO Error Unit := do
     Log.EIO.info "  Trying with 1000ms timeout..."
     let longer ← FFI.pollReply ctx 1000
     match longer with
-    | some data => Log.EIO.info s!"  Got reply: {String.fromUTF8! data}"
+    | some data => Log.EIO.info s!"  Got reply: {data}"
     | none => Log.EIO.info "  Still no reply"
 
   -- Cleanup
@@ -193,12 +194,12 @@ def exAsyncTaskQueue (ctx : FFI.Ctx) : EIO Error Unit := do
       match replyOpt with
       | some data =>
         processedCount := processedCount + 1
-        Log.EIO.info s!"  Task {i}: {String.fromUTF8! data}"
+        Log.EIO.info s!"  Task {i}: {data}"
       | none =>
         -- Might need more data, try blocking read
         let reply ← FFI.getReply ctx
         processedCount := processedCount + 1
-        Log.EIO.info s!"  Task {i}: {String.fromUTF8! reply}"
+        Log.EIO.info s!"  Task {i}: {reply}"
 
   Log.EIO.info s!"  Processed {processedCount} tasks"
 
@@ -233,14 +234,39 @@ def exInterleavedOperations (ctx : FFI.Ctx) : EIO Error Unit := do
   let reply1 ← FFI.pollReply ctx 1000
   let reply2 ← FFI.pollReply ctx 1000
 
-  Log.EIO.info s!"  Reply A: {reply1.map String.fromUTF8!}"
-  Log.EIO.info s!"  Reply B: {reply2.map String.fromUTF8!}"
+  Log.EIO.info s!"  Reply A: {reply1}"
+  Log.EIO.info s!"  Reply B: {reply2}"
 
   -- Cleanup
   FFI.appendCommand ctx "DEL interleave:a interleave:b"
   FFI.flushPipeline ctx
   let _ ← FFI.getReply ctx
 
+/-- Example: Async engine with many requests in flight -/
+def exAsyncEngine : IO Unit := do
+  Log.info "Example: Async engine"
+
+  let result ← (FFI.Async.connect "127.0.0.1" 6379).toBaseIO
+  match result with
+  | .ok actx =>
+    -- Queue 100 SETs without waiting; the I/O thread sends them back to back
+    let sets ← (List.range 100).toArray.mapM fun i =>
+      FFI.Async.sendAsync actx #["SET".toUTF8, s!"async:{i}".toUTF8, (toString i).toUTF8]
+    let setResults ← sets.mapM IO.wait
+    let ok := setResults.filter fun r => r matches .ok _
+    Log.info s!"  {ok.size}/{sets.size} SETs acknowledged"
+
+    let get ← FFI.Async.sendAsync actx #["GET".toUTF8, "async:42".toUTF8]
+    match ← IO.wait get with
+    | .ok r => Log.info s!"  GET async:42 -> {r}"
+    | .error e => Log.error s!"  GET failed: {e}"
+
+    let keys := (List.range 100).toArray.map fun i => s!"async:{i}".toUTF8
+    let _ ← IO.wait (← FFI.Async.sendAsync actx (#["DEL".toUTF8] ++ keys))
+    FFI.Async.close actx
+  | .error e =>
+    Log.error s!"  Async connection failed: {e}"
+
 /-- Run all async operations examples -/
 def runAsyncOperationsExamples : IO Unit := do
   let logOk ← Log.initZlog "config/zlog.conf" "async-examples"
@@ -250,6 +276,7 @@ def runAsyncOperationsExamples : IO Unit := do
   Log.info "=== Redis Async Operations Examples ==="
 
   exNonBlockingConnect
+  exAsyncEngine
 
   -- For other examples, use a regular connection
   let result ← (FFI.connectPlain "127.0.0.1" 6379).toBaseIO
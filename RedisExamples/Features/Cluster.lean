@@ -0,0 +1,133 @@
+import RedisLean.Cluster
+import RedisLean.Log
+import RedisLean.Monad
+import RedisLean.Ops
+
+namespace FeaturesClusterExample
+
+open Redis
+
+/-!
+# Redis Cluster Examples
+
+Demonstrates the cluster client against a local cluster on ports 7000-7005
+(see "Redis Cluster" in `RedisLean/README.md` to start one):
+- keys are routed to the node serving their hash slot
+- hashtags keep related keys on one node, so multi-key commands work
+- MGET/MSET/DEL on keys of many slots fan out to all nodes in parallel
+- the slot map is reloaded when a MOVED redirection arrives
+- reads go to the fastest replica with `ReadPreference.replica`
+-/
+
+def clusterConfig : ClusterConfig := {
+  seeds := #[{ port := 7000 }, { port := 7001 }, { port := 7002 }]
+  pool := { maxConnections := 4, minConnections := 1 }
+}
+
+/-- Example: slot map and key routing -/
+def exRouting (c : Cluster) : IO Unit := do
+  Log.info "Example: slot map and key routing"
+
+  let m ← c.slotMap
+  Log.info s!"Slot map: {m.shards.size} shards, {m.coveredSlots} slots covered"
+  for shard in m.shards do
+    Log.info s!"  {shard.primary} serves {shard.ranges} ({shard.replicas.size} replicas)"
+
+  let keys := #["user:1", "user:2", "user:3", "session:abc"]
+  let result ← c.run do
+    for k in keys do
+      set k s!"value of {k}"
+    keys.mapM fun k => getAs String k
+
+  match result with
+  | .ok values =>
+    for (k, v) in keys.zip values do
+      let slot := Cluster.keySlot k.toUTF8
+      Log.info s!"  {k} (slot {slot} on {(m.primary? slot).map toString |>.getD "?"}) = {v}"
+  | .error e => Log.error s!"Error: {e}"
+
+/-- Example: hashtags keep related keys in one slot -/
+def exHashTags (c : Cluster) : IO Unit := do
+  Log.info "Example: hashtags"
+
+  let result ← c.run do
+    let _ ← hset "{user:42}:profile" "name" "Ada"
+    let _ ← sadd "{user:42}:roles" "admin"
+    -- both keys share the slot of "user:42", so RENAME across them is allowed
+    set "{user:42}:tmp" "token"
+    rename "{user:42}:tmp" "{user:42}:token"
+    let name ← hgetAs String "{user:42}:profile" "name"
+    let token ← getAs String "{user:42}:token"
+    return (name, token)
+
+  match result with
+  | .ok (name, token) => Log.info s!"  name={name} token={token} (slot {Cluster.keySlot "user:42".toUTF8})"
+  | .error e => Log.error s!"Error: {e}"
+
+/-- Example: cross-slot MSET/MGET/DEL, split by slot and sent to all nodes at once -/
+def exFanOut (c : Cluster) : IO Unit := do
+  Log.info "Example: cross-slot fan-out"
+
+  let names := (Array.range 50).map fun i => s!"thm:{i}"
+  let result ← c.run do
+    msetArray (names.map fun n => (n, s!"statement of {n}"))
+    let values ← mgetArray (names.push "thm:missing")
+    let present ← existsCount names.toList
+    let deleted ← del names.toList
+    return (values, present, deleted)
+
+  match result with
+  | .ok (values, present, deleted) =>
+    let slots := (Cluster.groupBySlot (names.map String.toUTF8)).size
+    Log.info s!"  {names.size} keys over {slots} slots: {values.filter Option.isSome |>.size} values fetched, missing key -> {values.back?.join.isNone}"
+    Log.info s!"  existsCount={present} del={deleted}"
+  | .error e => Log.error s!"Error: {e}"
+
+/-- Example: reads served by replicas -/
+def exReplicaReads : IO Unit := do
+  Log.info "Example: reads on replicas"
+  let seeds := clusterConfig.seeds.map (·.withReadPreference .replica)
+  match ← Cluster.connect { clusterConfig with seeds } with
+  | .error e => Log.error s!"Cannot connect to the cluster: {e}"
+  | .ok c =>
+    try
+      let result ← c.run do
+        set "replicated" "hello"
+        -- replication is asynchronous: the first reads may not see the write
+        (Array.range 20).mapM fun _ => do
+          try some <$> getAs String "replicated" catch _ => pure none
+      match result with
+      | .ok values => Log.info s!"  {values.size} reads, {(values.filter (· == some "hello")).size} saw the write"
+      | .error e => Log.error s!"Error: {e}"
+      for (node, us) in ← c.metrics.nodeLatencies do
+        Log.info s!"  {node}: {us.round}us"
+    finally
+      c.close
+
+/-- Example: metrics shared by all nodes -/
+def exMetrics (c : Cluster) : IO Unit := do
+  Log.info "Example: cluster metrics"
+  let _ ← c.run do
+    for i in [:100] do
+      set s!"counter:{i}" i
+  let nodes ← c.nodes
+  Log.info s!"  pools opened on {nodes.size} nodes: {nodes.map toString}"
+  c.metrics.printSummary
+
+/-- Run all cluster examples -/
+def runAllExamples : IO Unit := do
+  Log.info "=== Redis Cluster Examples ==="
+  match ← Cluster.connect clusterConfig with
+  | .error e => Log.error s!"Cannot connect to the cluster: {e}"
+  | .ok c =>
+    try
+      exRouting c
+      exHashTags c
+      exFanOut c
+      exMetrics c
+    finally
+      c.close
+  exReplicaReads
+  Log.info "=== Redis Cluster Examples Complete ==="
+
+end FeaturesClusterExample
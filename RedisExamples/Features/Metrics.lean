@@ -116,7 +116,10 @@ def exCommandTracing : IO Unit := do
   Log.info s!"Recent traces ({traces.size}):"
   for trace in traces do
     let status := if trace.success then "OK" else "FAILED"
-    Log.info s!"  [{status}] {trace.command}: {trace.durationUs}μs"
+    Log.info s!"  [{status}] {trace.idString} {trace.command}: {trace.durationUs}μs"
+
+  -- In production, keep failures and a sample of the slow commands only
+  metrics.setTraceSampling { rate := 0.01, minDurationUs := 5000 }
 
 /-- Example: withTrace helper -/
 def exWithTrace : IO Unit := do
@@ -39,8 +39,7 @@ def exBasicPipeline (ctx : FFI.Ctx) : EIO Error Unit := do
 
   for h : i in [:replies.size] do
     let reply := replies[i]
-    let replyStr := String.fromUTF8! reply
-    Log.EIO.info s!"  Reply {i}: {replyStr}"
+    Log.EIO.info s!"  Reply {i}: {reply}"
 
   -- Cleanup
   FFI.appendCommand ctx "DEL pipeline:key1 pipeline:key2 pipeline:key3"
@@ -58,7 +57,7 @@ def exWithPipeline (ctx : FFI.Ctx) : EIO Error Unit := do
       |>.incr "wp:counter"
       |>.get "wp:counter"
 
-  Log.EIO.info s!"  Final counter value: {String.fromUTF8! replies[4]!}"
+  Log.EIO.info s!"  Final counter value: {replies[4]!}"
 
   -- Cleanup
   FFI.appendCommand ctx "DEL wp:counter"
@@ -89,11 +88,11 @@ def exManualPipeline (ctx : FFI.Ctx) : EIO Error Unit := do
   let reply4 ← FFI.getReply ctx
   let reply5 ← FFI.getReply ctx
 
-  Log.EIO.info s!"  SET manual:a -> {String.fromUTF8! reply1}"
-  Log.EIO.info s!"  SET manual:b -> {String.fromUTF8! reply2}"
-  Log.EIO.info s!"  APPEND result -> {String.fromUTF8! reply3}"
-  Log.EIO.info s!"  GET manual:a -> {String.fromUTF8! reply4}"
-  Log.EIO.info s!"  GET manual:b -> {String.fromUTF8! reply5}"
+  Log.EIO.info s!"  SET manual:a -> {reply1}"
+  Log.EIO.info s!"  SET manual:b -> {reply2}"
+  Log.EIO.info s!"  APPEND result -> {reply3}"
+  Log.EIO.info s!"  GET manual:a -> {reply4}"
+  Log.EIO.info s!"  GET manual:b -> {reply5}"
 
   -- Cleanup
   FFI.appendCommand ctx "DEL manual:a manual:b"
@@ -112,8 +111,8 @@ def exHashPipeline (ctx : FFI.Ctx) : EIO Error Unit := do
       |>.hget "user:1000" "email"
 
   Log.EIO.info s!"  Created user with 3 fields"
-  Log.EIO.info s!"  Name: {String.fromUTF8! replies[3]!}"
-  Log.EIO.info s!"  Email: {String.fromUTF8! replies[4]!}"
+  Log.EIO.info s!"  Name: {replies[3]!}"
+  Log.EIO.info s!"  Email: {replies[4]!}"
 
   -- Cleanup
   FFI.appendCommand ctx "DEL user:1000"
@@ -127,7 +126,7 @@ def exBulkInsert (ctx : FFI.Ctx) : EIO Error Unit := do
   -- Build pipeline with 100 SET commands
   let mut pb := FFI.PipelineBuilder.empty
   for i in [:100] do
-    pb := pb.add s!"SET bulk:{i} value_{i}"
+    pb := pb.set s!"bulk:{i}" s!"value_{i}"
 
   Log.EIO.info s!"  Built pipeline with {pb.size} commands"
 
@@ -144,6 +143,46 @@ def exBulkInsert (ctx : FFI.Ctx) : EIO Error Unit := do
   let _ ← FFI.executePipeline ctx cleanupPb
   Log.EIO.info "  Cleanup complete"
 
+/-- Example: Binary-safe argv commands (values with spaces and quotes) -/
+def exArgvCommands (ctx : FFI.Ctx) : EIO Error Unit := do
+  Log.EIO.info "Example: argv-based commands"
+
+  let value := "a value with \"quotes\" and spaces"
+  let _ ← FFI.commandArgv ctx #["SET".toUTF8, "argv:key".toUTF8, value.toUTF8]
+  let reply ← FFI.commandArgv ctx #["GET".toUTF8, "argv:key".toUTF8]
+  Log.EIO.info s!"  GET argv:key -> {reply}"
+
+  let replies ← FFI.withPipeline ctx fun pb =>
+    pb.addArgs #["SET", "argv:other", "hello world"]
+      |>.addArgs #["GET", "argv:other"]
+      |>.addArgs #["DEL", "argv:key", "argv:other"]
+  Log.EIO.info s!"  Pipelined GET argv:other -> {replies[1]!}"
+
+/-- Example: Multi-element replies (LRANGE, HGETALL, MGET, EXEC) in one pipeline -/
+def exCollectionPipeline (ctx : FFI.Ctx) : EIO Error Unit := do
+  Log.EIO.info "Example: Collection commands in pipeline"
+
+  let replies ← FFI.withPipeline ctx fun pb =>
+    pb.addArgs #["RPUSH", "coll:list", "a", "b", "c"]
+      |>.hset "coll:hash" "f1" "v1"
+      |>.set "coll:str" "x"
+      |>.lrange "coll:list" 0 (-1)
+      |>.hgetall "coll:hash"
+      |>.mget #["coll:str", "coll:missing"]
+      |>.multi
+      |>.incr "coll:counter"
+      |>.get "coll:str"
+      |>.exec
+      |>.addArgs #["DEL", "coll:list", "coll:hash", "coll:str", "coll:counter"]
+
+  Log.EIO.info s!"  LRANGE -> {replies[3]!}"
+  Log.EIO.info s!"  HGETALL -> {replies[4]!}"
+  Log.EIO.info s!"  MGET -> {replies[5]!}"
+  Log.EIO.info s!"  EXEC -> {replies[9]!}"
+  match replies[3]!.bytesArray? with
+  | some items => Log.EIO.info s!"  list has {items.size} items"
+  | none => Log.EIO.info "  unexpected LRANGE reply"
+
 /-- Run all pipeline examples -/
 def runPipelineExamples : IO Unit := do
   let logOk ← Log.initZlog "config/zlog.conf" "pipeline-examples"
@@ -161,6 +200,8 @@ def runPipelineExamples : IO Unit := do
   FFI.toIO <| exManualPipeline ctx
   FFI.toIO <| exHashPipeline ctx
   FFI.toIO <| exBulkInsert ctx
+  FFI.toIO <| exArgvCommands ctx
+  FFI.toIO <| exCollectionPipeline ctx
 
   -- Disconnect
   FFI.toIO <| FFI.free ctx
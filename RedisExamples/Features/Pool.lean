@@ -30,19 +30,19 @@ def exBasicPool : IO Unit := do
     idleTimeoutMs := 60000
   }
 
-  let pool ← Pool.create redisConfig poolConfig
-  Log.info s!"Created pool with max {poolConfig.maxConnections} connections"
+  Pool.withPool redisConfig poolConfig fun pool => do
+    Log.info s!"Created pool with max {poolConfig.maxConnections} connections"
 
-  -- Use a connection from the pool with RedisM action
-  let result ← pool.withConnection do
-    set "pool:test" "Hello from pool"
-    getAs String "pool:test"
+    -- Use a connection from the pool with RedisM action
+    let result ← pool.withConnection do
+      set "pool:test" "Hello from pool"
+      getAs String "pool:test"
 
-  match result with
-  | .ok value => Log.info s!"Result: {value}"
-  | .error e => Log.info s!"Error: {e}"
+    match result with
+    | .ok value => Log.info s!"Result: {value}"
+    | .error e => Log.info s!"Error: {e}"
 
-  -- Connection is automatically returned to pool
+    -- Connection is automatically returned to pool
 
 /-- Example: Pool statistics -/
 def exPoolStats : IO Unit := do
@@ -56,27 +56,43 @@ def exPoolStats : IO Unit := do
     idleTimeoutMs := 60000
   }
 
-  let pool ← Pool.create redisConfig poolConfig
-
-  -- Get initial stats
-  let (created1, acquired1, released1, timeouts1, failed1) ← pool.getStats
-  Log.info s!"Initial stats:"
-  Log.info s!"  Created: {created1}, Acquired: {acquired1}, Released: {released1}"
-  Log.info s!"  Timeouts: {timeouts1}, Failed: {failed1}"
-
-  -- Use a connection
-  let _ ← pool.withConnection do
-    set "stats:test" "value"
-
-  let (created2, acquired2, released2, _, _) ← pool.getStats
-  Log.info s!"After withConnection:"
-  Log.info s!"  Created: {created2}, Acquired: {acquired2}, Released: {released2}"
-
-  -- Get pool size info
-  let total ← pool.size
-  let available ← pool.availableCount
-  let inUse ← pool.inUseCount
-  Log.info s!"Pool size: total={total}, available={available}, inUse={inUse}"
+  Pool.withPool redisConfig poolConfig fun pool => do
+    -- Get initial stats
+    let (created1, acquired1, released1, timeouts1, failed1) ← pool.getStats
+    Log.info s!"Initial stats:"
+    Log.info s!"  Created: {created1}, Acquired: {acquired1}, Released: {released1}"
+    Log.info s!"  Timeouts: {timeouts1}, Failed: {failed1}"
+
+    -- Use a connection
+    let _ ← pool.withConnection do
+      set "stats:test" "value"
+
+    let (created2, acquired2, released2, _, _) ← pool.getStats
+    Log.info s!"After withConnection:"
+    Log.info s!"  Created: {created2}, Acquired: {acquired2}, Released: {released2}"
+
+    -- Get pool size info
+    let total ← pool.size
+    let available ← pool.availableCount
+    let inUse ← pool.inUseCount
+    Log.info s!"Pool size: total={total}, available={available}, inUse={inUse}"
+
+    -- Commands of every connection, merged from the per-connection shards
+    let metrics ← pool.metricsSnapshot
+    let counts ← metrics.getCommandCounts
+    Log.info s!"Commands recorded by the pool: {counts.toList}"
+    if let some w ← pool.acquireWaitStats then
+      Log.info s!"Acquire wait: avg={w.avg}μs, max={w.max}μs over {w.count} acquires"
+
+    -- Prometheus exposition, as served on the scrape endpoint
+    match ← (pool.serveMetrics (port := 0)).toBaseIO with
+    | .ok server =>
+      Log.info s!"Scrape endpoint: http://127.0.0.1:{← server.port}/metrics"
+      server.stop
+    | .error e => Log.error s!"Cannot start the scrape endpoint: {e}"
+    let text ← pool.toPrometheus "example"
+    for line in text.splitOn "\n" do
+      if line.startsWith "redis_pool_" then Log.info s!"  {line}"
 
 /-- Example: Concurrent pool access -/
 def exConcurrentAccess : IO Unit := do
@@ -88,23 +104,22 @@ def exConcurrentAccess : IO Unit := do
     minConnections := 1
   }
 
-  let pool ← Pool.create redisConfig poolConfig
-
-  -- Run multiple operations (simplified - not truly concurrent)
-  let _ ← pool.withConnection do
-    set "concurrent:1" "Value 1"
-  Log.info "  Task 1 done"
+  Pool.withPool redisConfig poolConfig fun pool => do
+    -- Run multiple operations (simplified - not truly concurrent)
+    let _ ← pool.withConnection do
+      set "concurrent:1" "Value 1"
+    Log.info "  Task 1 done"
 
-  let _ ← pool.withConnection do
-    set "concurrent:2" "Value 2"
-  Log.info "  Task 2 done"
+    let _ ← pool.withConnection do
+      set "concurrent:2" "Value 2"
+    Log.info "  Task 2 done"
 
-  let _ ← pool.withConnection do
-    set "concurrent:3" "Value 3"
-  Log.info "  Task 3 done"
+    let _ ← pool.withConnection do
+      set "concurrent:3" "Value 3"
+    Log.info "  Task 3 done"
 
-  let (_, acquired, released, _, _) ← pool.getStats
-  Log.info s!"Final stats: acquired={acquired}, released={released}"
+    let (_, acquired, released, _, _) ← pool.getStats
+    Log.info s!"Final stats: acquired={acquired}, released={released}"
 
 /-- Example: Pool configuration options -/
 def exPoolConfiguration : IO Unit := do
@@ -118,7 +133,10 @@ def exPoolConfiguration : IO Unit := do
     minConnections := 10      -- Keep connections warm
     acquireTimeoutMs := 1000  -- Fast timeout
     idleTimeoutMs := 300000   -- 5 minutes idle timeout
-    validateOnAcquire := true -- Validate connections
+    validateOnAcquire := true -- PING idle connections in the background
+    minIdle := 5              -- Keep spare connections ready
+    warmupConcurrency := 10   -- Open the first 10 in parallel
+    maintenanceIntervalMs := 2000
   }
   Log.info s!"High-throughput config: max={highThroughputConfig.maxConnections}, min={highThroughputConfig.minConnections}"
 
@@ -132,15 +150,14 @@ def exPoolConfiguration : IO Unit := do
   Log.info s!"Low-resource config: max={lowResourceConfig.maxConnections}, min={lowResourceConfig.minConnections}"
 
   -- Create and test the low-resource pool
-  let pool ← Pool.create redisConfig lowResourceConfig
+  Pool.withPool redisConfig lowResourceConfig fun pool => do
+    let result ← pool.withConnection do
+      set "config:test" "test"
+      pure "Configuration test successful"
 
-  let result ← pool.withConnection do
-    set "config:test" "test"
-    pure "Configuration test successful"
-
-  match result with
-  | .ok msg => Log.info s!"  {msg}"
-  | .error e => Log.info s!"  Error: {e}"
+    match result with
+    | .ok msg => Log.info s!"  {msg}"
+    | .error e => Log.info s!"  Error: {e}"
 
 /-- Example: Pool status printing -/
 def exPoolStatus : IO Unit := do
@@ -152,16 +169,15 @@ def exPoolStatus : IO Unit := do
     minConnections := 2
   }
 
-  let pool ← Pool.create redisConfig poolConfig
-
-  -- Do some work
-  let _ ← pool.withConnection do
-    set "status:key1" "value1"
-  let _ ← pool.withConnection do
-    set "status:key2" "value2"
+  Pool.withPool redisConfig poolConfig fun pool => do
+    -- Do some work
+    let _ ← pool.withConnection do
+      set "status:key1" "value1"
+    let _ ← pool.withConnection do
+      set "status:key2" "value2"
 
-  -- Print pool status
-  pool.printStatus
+    -- Print pool status
+    pool.printStatus
 
 /-- Example: Pruning idle connections -/
 def exPruneConnections : IO Unit := do
@@ -174,24 +190,23 @@ def exPruneConnections : IO Unit := do
     idleTimeoutMs := 100  -- Very short for testing
   }
 
-  let pool ← Pool.create redisConfig poolConfig
+  Pool.withPool redisConfig poolConfig fun pool => do
+    -- Create some connections
+    let _ ← pool.withConnection do
+      set "prune:test" "value"
 
-  -- Create some connections
-  let _ ← pool.withConnection do
-    set "prune:test" "value"
+    let sizeBefore ← pool.size
+    Log.info s!"Pool size before prune: {sizeBefore}"
 
-  let sizeBefore ← pool.size
-  Log.info s!"Pool size before prune: {sizeBefore}"
+    -- Wait for connections to become idle
+    IO.sleep 150
 
-  -- Wait for connections to become idle
-  IO.sleep 150
+    -- Prune idle connections
+    let pruned ← pool.pruneIdleConnections
+    Log.info s!"Pruned {pruned} idle connections"
 
-  -- Prune idle connections
-  let pruned ← pool.pruneIdleConnections
-  Log.info s!"Pruned {pruned} idle connections"
-
-  let sizeAfter ← pool.size
-  Log.info s!"Pool size after prune: {sizeAfter}"
+    let sizeAfter ← pool.size
+    Log.info s!"Pool size after prune: {sizeAfter}"
 
 /-- Example: Closing the pool -/
 def exClosePool : IO Unit := do
@@ -212,7 +227,8 @@ def exClosePool : IO Unit := do
   let sizeBefore ← pool.size
   Log.info s!"Pool size before close: {sizeBefore}"
 
-  -- Close all connections
+  -- Close all connections and stop the pool's background threads; a pool
+  -- created with `Pool.create` must always be closed (`Pool.withPool` does it)
   pool.close
   Log.info "Pool closed"
 
@@ -1,6 +1,7 @@
 import RedisLean.Ops
 import RedisLean.Log
 import RedisLean.Monad
+import RedisLean.PubSub
 
 namespace FeaturesPubSubExample
 
@@ -14,6 +15,7 @@ Demonstrates Redis Publish/Subscribe for:
 - Event broadcasting
 - Notifications
 - Inter-service communication
+- Receiving messages on a dedicated subscriber thread
 -/
 
 /-- Example: Basic publish -/
@@ -170,6 +172,32 @@ def exCacheInvalidation : RedisM Unit := do
   let _ ← publish (α := String) invalidationChannel ("{\"action\":\"flush\",\"namespace\":\"session\"}" : String)
   Log.info "Published flush for session namespace"
 
+/-- Example: Receiving messages with a subscriber thread -/
+def exSubscriber : RedisM Unit := do
+  Log.info "Example: Subscriber thread"
+
+  let config ← getConfig
+  let sub ← ExceptT.mk (EIO.toIO' (Subscriber.start config { capacity := 1000, overflow := .dropOldest }))
+  try
+    ExceptT.mk (EIO.toIO' (sub.subscribe #["events:orders"]))
+    ExceptT.mk (EIO.toIO' (sub.psubscribe #["events:user:*"]))
+    -- Give the subscriber thread a moment to register the subscriptions
+    IO.sleep 100
+
+    let _ ← publish (α := String) "events:orders" ("order 1" : String)
+    let _ ← publish (α := String) "events:user:101" ("login" : String)
+
+    for _ in [0:2] do
+      if let some m ← sub.recv then
+        let ch := String.fromUTF8! m.channel
+        let payload := String.fromUTF8! m.payload
+        Log.info s!"  received on {ch}: {payload}"
+
+    let st ← sub.stats
+    Log.info s!"  replies: {st.received}, dropped: {st.dropped}, reconnects: {st.reconnects}"
+  finally
+    sub.close
+
 /-- Run all pub/sub examples -/
 def runAllExamples : RedisM Unit := do
   Log.info "=== Redis Pub/Sub Examples ==="
@@ -182,6 +210,7 @@ def runAllExamples : RedisM Unit := do
   exEventDriven
   exMonitoringMetrics
   exCacheInvalidation
+  exSubscriber
   Log.info "=== Redis Pub/Sub Examples Complete ==="
 
 end FeaturesPubSubExample
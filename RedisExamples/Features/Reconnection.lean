@@ -189,7 +189,7 @@ def exResilientConnection : IO Unit := do
     | none => Log.error "  Operation failed even after reconnect"
 
     -- Cleanup
-    let _ ← (FFI.del rc.ctx ["resilient:key".toUTF8]).toBaseIO
+    let _ ← (FFI.del rc.ctx #["resilient:key".toUTF8]).toBaseIO
     rc.close
 
 /-- Example: Connection health monitoring -/
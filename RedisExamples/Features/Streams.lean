@@ -232,7 +232,11 @@ def exMultiStreamRead : RedisM Unit := do
 
   -- Read from both streams
   let results ← xread [(stream1, "0"), (stream2, "0")] (some 10) none
-  Log.info s!"Multi-stream results: {String.fromUTF8! results}"
+  for (stream, entries) in results do
+    Log.info s!"Stream {String.fromUTF8! stream}: {entries.size} entries"
+    for (id, fields) in entries do
+      let rendered := fields.map fun (f, v) => s!"{String.fromUTF8! f}={String.fromUTF8! v}"
+      Log.info s!"  {String.fromUTF8! id}: {rendered}"
 
   -- Cleanup
   let _ ← del [stream1, stream2]
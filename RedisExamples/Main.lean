@@ -19,6 +19,7 @@ import RedisExamples.Mathlib.DistProof
 import RedisExamples.Features.TypedKeys
 import RedisExamples.Features.Caching
 import RedisExamples.Features.Pool
+import RedisExamples.Features.Cluster
 import RedisExamples.Features.Metrics
 import RedisExamples.Features.Lists
 import RedisExamples.Features.SortedSets
@@ -44,6 +45,7 @@ inductive ExampleType where
   | Monadic  : ExampleType
   | Mathlib  : ExampleType
   | Features : ExampleType
+  | Cluster  : ExampleType
   deriving Repr, BEq
 
 def runFFIExamples : IO Unit := do
@@ -255,6 +257,8 @@ def getExampleType (p : Parsed) : ExampleType :=
     ExampleType.Mathlib
   else if p.hasFlag "features" then
     ExampleType.Features
+  else if p.hasFlag "cluster" then
+    ExampleType.Cluster
   else
     ExampleType.All
 
@@ -287,6 +291,10 @@ def runExamplesCmd (p : Parsed) : IO UInt32 := do
     Log.info "Running Features examples only..."
     runFeaturesExamples
 
+  | ExampleType.Cluster =>
+    Log.info "Running Redis Cluster examples (needs a cluster on ports 7000-7005)..."
+    FeaturesClusterExample.runAllExamples
+
   | ExampleType.All =>
     Log.info "Running all examples (FFI + Monadic + Mathlib + Features)..."
     runFFIExamples
@@ -311,6 +319,7 @@ def examplesCmd : Cmd := `[Cli|
     monadic;  "Run only Monadic client examples"
     mathlib;  "Run only Mathlib integration examples"
     features; "Run only Features examples (TypedKeys, Caching, Pool, Metrics, Data Structures)"
+    cluster;  "Run the Redis Cluster examples (not part of the default run)"
 
   ARGS:
     ...args : String; "Additional arguments (currently unused)"
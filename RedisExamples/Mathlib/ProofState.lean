@@ -106,7 +106,7 @@ def exNavigateHistory (sessionId : String) : RedisM Unit := do
 
   -- Get all steps
   let allSteps ← ProofState.getAllSteps config sessionId
-  Log.info s!"Total steps in proof: {allSteps.length}"
+  Log.info s!"Total steps in proof: {allSteps.size}"
 
   -- Get a specific step
   let step1 ← ProofState.getStep config sessionId 1
@@ -2,15 +2,26 @@ import RedisLean.Codec
 import RedisLean.Config
 import RedisLean.Enums
 import RedisLean.Error
+import RedisLean.Reply
 import RedisLean.FFI
 import RedisLean.Log
+import RedisLean.Histogram
+import RedisLean.Prometheus
+import RedisLean.ServerStats
 import RedisLean.Metrics
+import RedisLean.StatsCollector
+import RedisLean.NearCache
+import RedisLean.AutoPipeline
+import RedisLean.PubSub
+import RedisLean.ClusterSlots
+import RedisLean.Replicas
 import RedisLean.Monad
 import RedisLean.Ops
 -- New modules
 import RedisLean.TypedKey
 import RedisLean.Cache
 import RedisLean.Pool
+import RedisLean.Cluster
 import RedisLean.Expr
 -- Mathlib integration
 import RedisLean.Mathlib
@@ -0,0 +1,126 @@
+import RedisLean.Error
+import RedisLean.Reply
+
+namespace Redis
+
+/-!
+# Auto-Pipelining
+
+With `Read.autoPipeline` set, the common single-key commands are sent over a
+shared multiplexed connection (`FFI.Async`) instead of the blocking one.
+Every RedisM computation running from the same `State`, on any number of
+tasks, submits to the same I/O thread: commands queued while it is busy are
+appended to the output buffer together and go out in one write, and replies
+are routed back in FIFO order. Concurrent callers therefore share round trips
+instead of paying one each, without needing more connections.
+
+The multiplexed connection is shared, so it carries no per-computation session
+state: it stays on the initial database and never enters MULTI or WATCH. Once
+a computation runs `selectDb` or takes the raw context with `getContext` (to
+open a transaction or WATCH keys), its state is pinned and its remaining
+commands go over the blocking connection, which holds that session state.
+
+The blocking C wrappers decode replies in C; over the multiplexed connection
+the generic `Reply` comes back, error replies included, so the decoders below
+reproduce their results and error cases: a nil GET raises `keyNotFoundError`,
+a WRONGTYPE from HGET a `nullReplyError`, and so on, with the same messages.
+-/
+
+namespace AutoPipeline
+
+/-- hiredis reply type (`REDIS_REPLY_*`), printed by the wrappers that read
+    `redisReply` in their "unexpected reply type" messages -/
+private def typeCode : Reply → Nat
+  | .bulk _ => 1
+  | .array _ => 2
+  | .int _ => 3
+  | .nil => 4
+  | .simple _ => 5
+  | .error _ => 6
+  | .double _ => 7
+  | .bool _ => 8
+  | .map _ => 9
+  | .set _ => 10
+  | .push _ => 12
+  | .bignum _ => 13
+
+private def unexpectedType (cmd : String) (r : Reply) : String :=
+  s!"{cmd} returned unexpected reply type {typeCode r}"
+
+/-- Error reply of a hash or set command: a WRONGTYPE is a `nullReplyError`
+    naming the expected `type`, anything else goes to `other` -/
+private def wrongTypeOr (type : String) (other : String → Error) (msg : String) : Error :=
+  if (msg.splitOn "WRONGTYPE").length > 1 then .nullReplyError s!"WRONGTYPE - key is not a {type}"
+  else other msg
+
+/-- Error reply of the counting and flag commands: a `replyError`, or for the
+    hash and set ones (`type`) always a `nullReplyError` -/
+private def countError (type : Option String) (msg : String) : Error :=
+  match type with
+  | some t => wrongTypeOr t .nullReplyError msg
+  | none => .replyError msg
+
+private def notFound (key : ByteArray) : Error :=
+  .keyNotFoundError ((String.fromUTF8? key).getD s!"<{key.size} bytes>")
+
+/-- Bulk value of GET; nil raises `keyNotFoundError` -/
+def bytes (cmd : String) (key : ByteArray) (r : Reply) : Except Error ByteArray :=
+  match r with
+  | .nil => .error (notFound key)
+  | .bulk data => .ok data
+  | .simple msg => .ok msg.toUTF8
+  | .error msg => .error (.replyError msg)
+  | _ => .error (.unexpectedReplyTypeError s!"{cmd} returned unexpected reply type {r.typeName}")
+
+/-- Value of HGET; nil raises `keyNotFoundError`, a key that is not a hash
+    `nullReplyError` -/
+def field (key : ByteArray) (r : Reply) : Except Error ByteArray :=
+  match r with
+  | .nil => .error (notFound key)
+  | .bulk data => .ok data
+  | .simple msg => .ok msg.toUTF8
+  | .error msg => .error (wrongTypeOr "hash" .replyError msg)
+  | _ => .error (.unexpectedReplyTypeError (unexpectedType "HGET" r))
+
+/-- `OK` status of SET; nil (NX/XX not met) raises `nullReplyError` -/
+def ok (cmd : String) (r : Reply) : Except Error Unit :=
+  match r with
+  | .simple "OK" => .ok ()
+  | .nil => .error (.nullReplyError s!"{cmd} condition not met (NX/XX)")
+  | .error msg => .error (.replyError msg)
+  | _ => .error (.unexpectedReplyTypeError (unexpectedType cmd r))
+
+private def count (cmd : String) (type : Option String) (r : Reply) : Except Error UInt64 :=
+  match r with
+  | .int v => .ok v.toUInt64
+  | .error msg => .error (countError type msg)
+  | _ => .error (.nullReplyError (unexpectedType cmd r))
+
+private def flag (cmd : String) (type : Option String) (r : Reply) : Except Error Bool :=
+  match r with
+  | .int v => .ok (v > 0)
+  | .error msg => .error (countError type msg)
+  | _ => .error (.nullReplyError (unexpectedType cmd r))
+
+/-- Integer reply as returned by the counting commands (DEL, INCR, INCRBY) -/
+def uint64 (cmd : String) (r : Reply) : Except Error UInt64 := count cmd none r
+
+/-- Integer reply of a counting command on a hash or set (HSET, SADD) -/
+def uint64On (type cmd : String) (r : Reply) : Except Error UInt64 := count cmd (some type) r
+
+/-- Integer reply read as a flag (EXISTS, SISMEMBER) -/
+def bool (cmd : String) (r : Reply) : Except Error Bool := flag cmd none r
+
+/-- Integer reply read as a flag, on a hash (HEXISTS) -/
+def boolOn (type cmd : String) (r : Reply) : Except Error Bool := flag cmd (some type) r
+
+/-- Reply of EXPIRE: whether the timeout was set -/
+def expire (r : Reply) : Except Error Bool :=
+  match r with
+  | .int v => .ok (v == 1)
+  | .error msg => .error (.replyError msg)
+  | _ => .error (.unexpectedReplyTypeError (unexpectedType "EXPIRE" r))
+
+end AutoPipeline
+
+end Redis
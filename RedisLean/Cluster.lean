@@ -0,0 +1,250 @@
+import Std.Data.HashMap
+import Std.Sync.Mutex
+import RedisLean.Config
+import RedisLean.Error
+import RedisLean.FFI
+import RedisLean.Metrics
+import RedisLean.Monad
+import RedisLean.Pool
+import RedisLean.ClusterSlots
+import RedisLean.Replicas
+
+namespace Redis
+
+/-!
+# Redis Cluster
+
+`Cluster` keeps the slot map of a Redis Cluster (loaded with CLUSTER SHARDS,
+or CLUSTER SLOTS on servers older than 7.0) and one connection `Pool` per
+node. `Cluster.run` executes any `RedisM` computation with a `Router` in its
+state, so every command of `Ops` is sent to the primary serving the slot of
+its (first) key:
+
+- MOVED: the slot map is reloaded and the command retried on the new owner;
+- ASK (slot being migrated): the command is retried once on the target node,
+  preceded by ASKING, without touching the map;
+- a node that cannot be reached triggers a reload before giving up.
+
+MGET, MSET, DEL, UNLINK, EXISTS and TOUCH may span slots: they are split
+into one sub-command per slot, pipelined per node, sent to all nodes in
+parallel and their results merged in key order (`Router.fanOut`). Other
+commands on several keys must keep them in one slot (use hashtags, e.g.
+`{user:1}:name`, `{user:1}:email`): they are routed on their first key and the
+server answers CROSSSLOT otherwise. Keyless commands (PING, DBSIZE, KEYS,
+FLUSHALL, ...) run on a single primary. The raw context of `getContext` is
+not meaningful in cluster mode.
+
+## Replicas
+
+The `readPreference` of the first seed decides where read-only commands
+(`RedisCmd.isReadOnly`) go: `.primary` (default), `.replica` or `.nearest`.
+Among the candidates of the slot the node with the lowest smoothed latency
+(`Metrics.nodeLatencies`, fed by every routed command) wins; a node that could
+not be reached is skipped for `nodeRetryMs`. Connections of every pool send
+READONLY so that cluster replicas accept reads.
+
+A seed without cluster support is treated as a primary and its replicas: the
+layout comes from ROLE (or INFO replication) and a single shard owns every
+slot, so the same routing applies.
+-/
+
+structure ClusterConfig where
+  /-- Nodes tried in order to load the slot map; the first one also provides
+      the SSL settings used for every node -/
+  seeds : Array Config := #[{ port := 7000 }]
+  /-- Pool settings applied to each node -/
+  pool : PoolConfig := {}
+  /-- MOVED/ASK redirections followed per command -/
+  maxRedirects : Nat := 5
+  /-- How long a replica that could not be reached is left out of read routing -/
+  nodeRetryMs : Nat := 5000
+  enableMetrics : Bool := true
+  deriving Repr
+
+structure Cluster where
+  config : ClusterConfig
+  slots : IO.Ref Cluster.SlotMap
+  /-- One pool per node, created on first use -/
+  pools : Std.Mutex (Std.HashMap Cluster.NodeAddr Pool)
+  /-- Node each borrowed connection comes from, so it goes back to its pool -/
+  lent : Std.Mutex (Std.HashMap FFI.Ctx Cluster.NodeAddr)
+  /-- Time of the last successful slot map load (monotonic ns); held while
+      loading so that concurrent MOVED replies cause a single reload -/
+  lastRefresh : Std.Mutex Nat
+  /-- Nodes that failed to connect, with the time (monotonic ms) of the failure -/
+  down : Std.Mutex (Std.HashMap Cluster.NodeAddr Nat)
+  metrics : Metrics
+
+namespace Cluster
+
+private def baseConfig (c : Cluster) : Config :=
+  c.config.seeds[0]?.getD {}
+
+/-- Pool of a node, created on first use. The pool is created outside the
+    lock, since it connects to the node: a node slow to answer does not hold
+    up the threads routing to the others. Of two threads creating the pool of
+    the same node, the first to insert it wins and the other closes its own. -/
+def nodePool (c : Cluster) (addr : NodeAddr) : IO Pool := do
+  if let some p ← c.pools.atomically (return (← get)[addr]?) then return p
+  let base := c.baseConfig
+  -- a redirection to an unknown endpoint leaves the host empty
+  let host := if addr.host.isEmpty then base.host else addr.host
+  let poolCfg := { c.config.pool with readOnly := base.readPreference != .primary }
+  let p ← Pool.create { base with host, port := addr.port, database := 0 } poolCfg
+  let first ← c.pools.atomically (modifyGet fun m =>
+    match m[addr]? with
+    | some q => (some q, m)
+    | none => (none, m.insert addr p))
+  match first with
+  | some q =>
+    p.close
+    return q
+  | none => return p
+
+/-- Borrow a connection to a given node; a node that cannot be reached is
+    marked down for read routing -/
+def acquireAt (c : Cluster) (addr : NodeAddr) : IO (Except Error FFI.Ctx) := do
+  let pool ← c.nodePool addr
+  match ← pool.acquire with
+  | .ok ctx =>
+    c.lent.atomically (modify (·.insert ctx addr))
+    c.down.atomically (modify (·.erase addr))
+    return .ok ctx
+  | .error e =>
+    let now ← IO.monoMsNow
+    c.down.atomically (modify (·.insert addr now))
+    return .error e
+
+/-- Return a connection borrowed with `acquireAt` -/
+def release (c : Cluster) (ctx : FFI.Ctx) : IO Unit := do
+  let addr? ← c.lent.atomically (modifyGet fun m => (m[ctx]?, m.erase ctx))
+  if let some addr := addr? then
+    (← c.nodePool addr).release ctx
+
+/-- Node for a command on `slot` (the first primary for `none`): the primary,
+    or for a read-only command the node chosen by the read preference among
+    the replicas that are not down -/
+def route (c : Cluster) (slot : Option Nat) (readOnly : Bool) : IO (Option NodeAddr) := do
+  let m ← c.slots.get
+  let shard? := match slot with
+    | some s => m.shard? s
+    | none => m.shards[0]?
+  let some shard := shard? | return none
+  let pref := c.baseConfig.readPreference
+  if !readOnly || pref == .primary || shard.replicas.isEmpty then return some shard.primary
+  let now ← IO.monoMsNow
+  let down ← c.down.atomically get
+  let healthy := shard.replicas.filter fun a =>
+    match down[a]? with
+    | some at_ => now - at_ >= c.config.nodeRetryMs
+    | none => true
+  let latencies ← c.metrics.nodeLatencies
+  return some (Replicas.choose pref shard.primary healthy (latencies[toString ·]?))
+
+private def unexpectedLayout (cmd : String) : Error :=
+  .unexpectedReplyTypeError s!"{cmd} returned unexpected reply"
+
+/-- Layout of a server without cluster support: ROLE, or INFO replication
+    where ROLE is not allowed -/
+private def fetchReplication (ctx : FFI.Ctx) (addr : NodeAddr) : IO (Except Error (Array Shard)) := do
+  match ← (FFI.commandArgv ctx #["ROLE".toUTF8]).toBaseIO with
+  | .ok r => return (Replicas.ofRole? addr r).elim (.error (unexpectedLayout "ROLE")) (.ok #[·])
+  | .error (.replyError _) =>
+    let r ← (FFI.commandArgv ctx #["INFO".toUTF8, "replication".toUTF8]).toBaseIO
+    return r.bind fun r =>
+      (r.str? >>= Replicas.ofInfo? addr).elim (.error (unexpectedLayout "INFO replication")) (.ok #[·])
+  | .error e => return .error e
+
+/-- Ask a node for the shard layout -/
+private def fetchShards (c : Cluster) (addr : NodeAddr) : IO (Except Error (Array Shard)) := do
+  match ← c.acquireAt addr with
+  | .error e => return .error e
+  | .ok ctx =>
+    try
+      match ← (FFI.commandArgv ctx #["CLUSTER".toUTF8, "SHARDS".toUTF8]).toBaseIO with
+      | .ok r =>
+        return (parseShards? r).elim (.error (unexpectedLayout "CLUSTER SHARDS")) .ok
+      | .error (.replyError _) =>
+        -- servers before 7.0 only know CLUSTER SLOTS
+        match ← (FFI.commandArgv ctx #["CLUSTER".toUTF8, "SLOTS".toUTF8]).toBaseIO with
+        | .ok r => return (parseSlots? r).elim (.error (unexpectedLayout "CLUSTER SLOTS")) .ok
+        -- cluster support disabled: a primary and its replicas
+        | .error (.replyError _) => fetchReplication ctx addr
+        | .error e => return .error e
+      | .error e => return .error e
+    finally
+      c.release ctx
+
+/-- Reload the slot map from the known primaries, then from the seeds. A
+    reload already completed after this call started is reused. -/
+def refresh (c : Cluster) : IO (Except Error Unit) := do
+  let requested ← IO.monoNanosNow
+  c.lastRefresh.atomically do
+    if (← get) >= requested then return .ok ()
+    let seeds := c.config.seeds.map fun cfg => ({ host := cfg.host, port := cfg.port } : NodeAddr)
+    let mut lastError := Error.otherError "no cluster seed configured"
+    for addr in (← c.slots.get).primaries ++ seeds do
+      match ← c.fetchShards addr with
+      | .ok shards =>
+        c.slots.set (SlotMap.ofShards shards)
+        set (← IO.monoNanosNow)
+        if c.config.enableMetrics then Metrics.recordEvent c.metrics "cluster_slots_loaded"
+        return .ok ()
+      | .error e => lastError := e
+    return .error lastError
+
+/-- Connect to a cluster: load the slot map from the first reachable seed -/
+def connect (config : ClusterConfig := {}) : IO (Except Error Cluster) := do
+  let slots ← IO.mkRef ({} : SlotMap)
+  let pools ← Std.Mutex.new ({} : Std.HashMap NodeAddr Pool)
+  let lent ← Std.Mutex.new ({} : Std.HashMap FFI.Ctx NodeAddr)
+  let lastRefresh ← Std.Mutex.new 0
+  let down ← Std.Mutex.new ({} : Std.HashMap NodeAddr Nat)
+  let metrics ← Metrics.make
+  let c : Cluster := { config, slots, pools, lent, lastRefresh, down, metrics }
+  match ← c.refresh with
+  | .ok () => return .ok c
+  | .error e =>
+    for (_, p) in ← c.pools.atomically get do p.close
+    return .error e
+
+/-- The router installed in the state of `run` -/
+def router (c : Cluster) : Router := {
+  route := c.route,
+  acquireAt := c.acquireAt,
+  release := c.release,
+  observe := fun addr micros =>
+    if c.config.enableMetrics then Metrics.recordNodeLatency c.metrics (toString addr) micros else pure (),
+  refresh := discard c.refresh,
+  maxRedirects := c.config.maxRedirects
+}
+
+/-- Run a computation against the cluster: each command borrows a connection
+    from the pool of the node it is routed to -/
+def run (c : Cluster) (action : RedisM α) : IO (Except Error α) := do
+  let state : State := {
+    ctx := 0,
+    isConnected := true,
+    metrics := c.metrics,
+    recordLatency := fun cmd micros =>
+      if c.config.enableMetrics then Metrics.recordCommand c.metrics cmd micros else pure (),
+    router := some c.router
+  }
+  runRedisFromState { config := c.baseConfig, enableMetrics := c.config.enableMetrics } state action
+
+/-- Current slot map -/
+def slotMap (c : Cluster) : IO SlotMap :=
+  c.slots.get
+
+/-- Nodes with a pool -/
+def nodes (c : Cluster) : IO (Array NodeAddr) :=
+  c.pools.atomically do return (← get).toArray.map (·.1)
+
+/-- Close the pools of all nodes -/
+def close (c : Cluster) : IO Unit := do
+  let pools ← c.pools.atomically (modifyGet fun m => (m, {}))
+  for (_, p) in pools do p.close
+
+end Cluster
+
+end Redis
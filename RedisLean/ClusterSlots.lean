@@ -0,0 +1,251 @@
+import Std.Data.HashMap
+import RedisLean.Error
+import RedisLean.Reply
+
+namespace Redis
+
+/-!
+# Cluster Slots
+
+Pure building blocks of the cluster client (`Cluster`): the key → hash slot
+function, the parsing of MOVED/ASK redirections and of the CLUSTER SHARDS
+(or CLUSTER SLOTS) reply, the slot map built from it, and the splitting of
+multi-key commands into one sub-command per slot.
+
+A key belongs to slot `CRC16(key) mod 16384`, where only the part between the
+first `{` and the next `}` is hashed when it is non-empty (a *hashtag*), so
+`{user:1}:name` and `{user:1}:email` always live on the same node.
+-/
+
+namespace Cluster
+
+/-- Number of hash slots in a Redis Cluster -/
+def slotCount : Nat := 16384
+
+private def crc16Entry (i : Nat) : UInt16 := Id.run do
+  let mut crc : UInt16 := (UInt16.ofNat i) <<< 8
+  for _ in [:8] do
+    crc := if crc &&& 0x8000 != 0 then (crc <<< 1) ^^^ 0x1021 else crc <<< 1
+  return crc
+
+/-- Lookup table of CRC16-CCITT (XMODEM), the variant used by Redis Cluster -/
+def crc16Table : Array UInt16 := (Array.range 256).map crc16Entry
+
+def crc16 (data : ByteArray) : UInt16 :=
+  data.foldl (init := 0) fun crc b =>
+    (crc <<< 8) ^^^ crc16Table[(((crc >>> 8) ^^^ b.toUInt16) &&& 0xFF).toNat]!
+
+/-- The part of the key that is hashed: the content of the first `{...}` if
+    non-empty, the whole key otherwise -/
+def hashTag (key : ByteArray) : ByteArray := Id.run do
+  let mut start : Option Nat := none
+  for i in [:key.size] do
+    match start with
+    | none => if key[i]! == '{'.toUInt8 then start := some i
+    | some s =>
+      if key[i]! == '}'.toUInt8 then
+        return if i > s + 1 then key.extract (s + 1) i else key
+  return key
+
+/-- Hash slot of a key -/
+def keySlot (key : ByteArray) : Nat :=
+  (crc16 (hashTag key)).toNat % slotCount
+
+/-- Address of a cluster node -/
+structure NodeAddr where
+  host : String
+  port : Nat
+  deriving Repr, BEq, Hashable, Inhabited
+
+namespace NodeAddr
+
+instance : ToString NodeAddr := ⟨fun a => s!"{a.host}:{a.port}"⟩
+
+/-- Parse `host:port` (the host may itself contain colons, e.g. IPv6) -/
+def parse? (s : String) : Option NodeAddr := do
+  let parts := s.splitOn ":"
+  let port ← parts.getLast? >>= String.toNat?
+  return { host := ":".intercalate parts.dropLast, port }
+
+end NodeAddr
+
+/-- Redirection returned by a cluster node for a key it does not serve -/
+inductive Redirect where
+  /-- The slot has moved permanently: the slot map is stale -/
+  | moved (slot : Nat) (addr : NodeAddr)
+  /-- The slot is being migrated: retry this command only, after ASKING -/
+  | ask (slot : Nat) (addr : NodeAddr)
+  deriving Repr, BEq
+
+namespace Redirect
+
+/-- Parse a `MOVED 3999 127.0.0.1:6381` / `ASK 3999 127.0.0.1:6381` error.
+    An empty host means the host of the node that answered. -/
+def parse? (msg : String) : Option Redirect := do
+  let [kind, slot, addr] := msg.splitOn " " | none
+  let slot ← slot.toNat?
+  let addr ← NodeAddr.parse? addr
+  match kind with
+  | "MOVED" => return .moved slot addr
+  | "ASK" => return .ask slot addr
+  | _ => none
+
+def addr : Redirect → NodeAddr
+  | moved _ a => a
+  | ask _ a => a
+
+end Redirect
+
+/-- A primary, its replicas and the slot ranges they serve -/
+structure Shard where
+  /-- Inclusive slot ranges -/
+  ranges : Array (Nat × Nat)
+  primary : NodeAddr
+  replicas : Array NodeAddr := #[]
+  deriving Repr, Inhabited
+
+namespace Shard
+
+private def field? (entries : Array (Reply × Reply)) (name : String) : Option Reply :=
+  entries.findSome? fun (k, v) => if k.str? == some name then some v else none
+
+private def nat? (r : Reply) : Option Nat :=
+  r.int?.map (·.toInt.toNat)
+
+/-- A node entry of CLUSTER SHARDS: address, role and health -/
+private def node? (r : Reply) : Option (NodeAddr × String × String) := do
+  let es ← r.entries?
+  let ip := (field? es "ip") >>= Reply.str?
+  -- `endpoint` honours cluster-preferred-endpoint-type; "?" means unknown
+  let host ← match (field? es "endpoint") >>= Reply.str? with
+    | some h => if h.isEmpty || h == "?" then ip else some h
+    | none => ip
+  let port ← (field? es "port") >>= nat?
+  let role := ((field? es "role") >>= Reply.str?).getD "master"
+  let health := ((field? es "health") >>= Reply.str?).getD "online"
+  return ({ host, port }, role, health)
+
+/-- Decode one entry of CLUSTER SHARDS. Failed nodes are left out; a shard
+    without a live primary yields `none`. -/
+def ofReply? (r : Reply) : Option Shard := do
+  let es ← r.entries?
+  let bounds ← (field? es "slots") >>= Reply.elems? >>= (·.mapM nat?)
+  let ranges := (Array.range (bounds.size / 2)).map fun i => (bounds[2 * i]!, bounds[2 * i + 1]!)
+  let nodes ← (field? es "nodes") >>= Reply.elems?
+  let live := (nodes.filterMap node?).filter fun (_, _, health) => health != "fail"
+  let (primary, _, _) ← live.find? fun (_, role, _) => role == "master"
+  let replicas := live.filterMap fun (a, role, _) => if role == "replica" then some a else none
+  return { ranges, primary, replicas }
+
+/-- Decode one entry of CLUSTER SLOTS (`start end [ip port id] [ip port id]...`),
+    the pre-7.0 equivalent of CLUSTER SHARDS -/
+def ofSlotsReply? (r : Reply) : Option Shard := do
+  let es ← r.elems?
+  let lo ← es[0]? >>= nat?
+  let hi ← es[1]? >>= nat?
+  let nodes ← (es.extract 2 es.size).mapM fun n => do
+    let ns ← n.elems?
+    return { host := ← ns[0]? >>= Reply.str?, port := ← ns[1]? >>= nat? : NodeAddr }
+  let primary ← nodes[0]?
+  return { ranges := #[(lo, hi)], primary, replicas := nodes.extract 1 nodes.size }
+
+end Shard
+
+/-- Decode a CLUSTER SHARDS reply -/
+def parseShards? (r : Reply) : Option (Array Shard) :=
+  r.elems?.map (·.filterMap Shard.ofReply?)
+
+/-- Decode a CLUSTER SLOTS reply -/
+def parseSlots? (r : Reply) : Option (Array Shard) :=
+  r.elems?.map (·.filterMap Shard.ofSlotsReply?)
+
+/-- Owner of every hash slot -/
+structure SlotMap where
+  shards : Array Shard := #[]
+  /-- Index into `shards` of the owner of each slot, `none` if unassigned -/
+  owner : Array (Option Nat) := Array.replicate slotCount none
+  deriving Inhabited
+
+namespace SlotMap
+
+def ofShards (shards : Array Shard) : SlotMap := Id.run do
+  let mut owner : Array (Option Nat) := Array.replicate slotCount none
+  for i in [:shards.size] do
+    for (lo, hi) in shards[i]!.ranges do
+      for s in [lo:Nat.min (hi + 1) slotCount] do
+        owner := owner.set! s (some i)
+  return { shards, owner }
+
+def shard? (m : SlotMap) (slot : Nat) : Option Shard := do
+  let i ← m.owner[slot]?.join
+  m.shards[i]?
+
+/-- Primary serving `slot` -/
+def primary? (m : SlotMap) (slot : Nat) : Option NodeAddr :=
+  (m.shard? slot).map (·.primary)
+
+def primaries (m : SlotMap) : Array NodeAddr :=
+  m.shards.map (·.primary)
+
+/-- Number of slots with an owner (16384 on a healthy cluster) -/
+def coveredSlots (m : SlotMap) : Nat :=
+  m.owner.foldl (fun n o => if o.isSome then n + 1 else n) 0
+
+end SlotMap
+
+/-! ## Cross-slot fan-out
+
+A command on keys of different slots fails with CROSSSLOT, so MGET, MSET,
+DEL, UNLINK, EXISTS and TOUCH are split into one sub-command per slot. The
+sub-commands of each node are pipelined together, the nodes are queried in
+parallel (`Router.fanOut`) and the replies are put back together here. -/
+
+/-- Positions of the keys of each slot, slots in order of first appearance -/
+def groupBySlot (keys : Array ByteArray) : Array (Nat × Array Nat) := Id.run do
+  let mut index : Std.HashMap Nat Nat := {}
+  let mut groups : Array (Nat × Array Nat) := #[]
+  for i in [:keys.size] do
+    let slot := keySlot keys[i]!
+    match index[slot]? with
+    | some g => groups := groups.modify g fun (s, is) => (s, is.push i)
+    | none =>
+      index := index.insert slot groups.size
+      groups := groups.push (slot, #[i])
+  return groups
+
+/-- `cmd` followed by the keys at the given positions -/
+def subCommand (cmd : String) (keys : Array ByteArray) (positions : Array Nat) : Array ByteArray :=
+  positions.foldl (fun argv i => argv.push keys[i]!) #[cmd.toUTF8]
+
+private def unexpected (cmd : String) (r : Reply) : Error :=
+  .unexpectedReplyTypeError s!"{cmd} returned unexpected reply type {r.typeName}"
+
+/-- Total of the integer replies of DEL/UNLINK/EXISTS/TOUCH sub-commands -/
+def sumReplies (cmd : String) (replies : Array Reply) : Except Error UInt64 :=
+  replies.foldlM (init := 0) fun n r =>
+    match r.int? with
+    | some v => .ok (n + v.toUInt64)
+    | none => .error (unexpected cmd r)
+
+/-- Check that every sub-command answered OK (MSET) -/
+def allOk (cmd : String) (replies : Array Reply) : Except Error Unit :=
+  replies.forM fun
+    | .simple "OK" => .ok ()
+    | r => .error (unexpected cmd r)
+
+/-- Put the values of MGET sub-commands back in the caller's key order;
+    `groups` gives the key positions of each sub-command -/
+def scatterValues (size : Nat) (groups : Array (Array Nat)) (replies : Array Reply) :
+    Except Error (Array (Option ByteArray)) := do
+  let mut out : Array (Option ByteArray) := Array.replicate size none
+  for (positions, r) in groups.zip replies do
+    let some values := r.optBytesArray? | throw (unexpected "MGET" r)
+    if values.size != positions.size then
+      throw (.unexpectedReplyTypeError s!"MGET returned {values.size} values for {positions.size} keys")
+    for (i, v) in positions.zip values do
+      out := out.set! i v
+  return out
+
+end Cluster
+
+end Redis
@@ -41,11 +41,22 @@ def insecure : SSLConfig := { verifyMode := .none }
 
 end SSLConfig
 
+/-- Where read-only commands go when replicas are known (see `Cluster`) -/
+inductive ReadPreference where
+  /-- Always the primary (read-your-writes) -/
+  | primary
+  /-- The fastest healthy replica, the primary when none is available -/
+  | replica
+  /-- The fastest healthy node, primary included -/
+  | nearest
+  deriving Repr, BEq, Inhabited
+
 structure Config where
   host : String := "127.0.0.1"
   port : Nat := 6379
   database : Nat := 0
   ssl : Option SSLConfig := none
+  readPreference : ReadPreference := .primary
   deriving Repr
 
 namespace Config
@@ -66,6 +77,10 @@ def withSSL (config : Config) (sslConfig : SSLConfig) : Config :=
 def withSSLCert (config : Config) (cacertPath : String) : Config :=
   { config with ssl := some (SSLConfig.oneWay cacertPath) }
 
+/-- Send read-only commands according to `pref` -/
+def withReadPreference (config : Config) (pref : ReadPreference) : Config :=
+  { config with readPreference := pref }
+
 /-- Check if SSL is enabled -/
 def isSSLEnabled (config : Config) : Bool :=
   config.ssl.isSome
@@ -466,4 +466,58 @@ def RedisCmd.toString : RedisCmd → String
 
 instance : ToString RedisCmd := ⟨RedisCmd.toString⟩
 
+/-- Commands that never write, and may therefore be served by a replica -/
+def RedisCmd.isReadOnly : RedisCmd → Bool
+  | .GET | .GETRANGE | .MGET | .STRLEN | .LCS
+  | .EXISTS | .TYPE | .TTL | .PTTL | .EXPIRETIME | .KEYS | .SCAN | .RANDOMKEY
+  | .SISMEMBER | .SCARD | .SMEMBERS | .SRANDMEMBER | .SMISMEMBER | .SDIFF | .SINTER
+  | .SINTERCARD | .SUNION | .SSCAN
+  | .LRANGE | .LINDEX | .LLEN | .LPOS
+  | .HGET | .HGETALL | .HEXISTS | .HKEYS | .HLEN | .HVALS | .HMGET | .HSTRLEN
+  | .HRANDFIELD | .HSCAN
+  | .ZCARD | .ZRANGE | .ZSCORE | .ZRANK | .ZREVRANK | .ZCOUNT | .ZLEXCOUNT | .ZMSCORE
+  | .ZRANDMEMBER | .ZSCAN | .ZRANGEBYSCORE | .ZREVRANGE | .ZREVRANGEBYSCORE
+  | .ZRANGEBYLEX | .ZREVRANGEBYLEX | .ZUNION | .ZINTER | .ZDIFF | .ZINTERCARD
+  | .XREAD | .XRANGE | .XLEN
+  | .GEODIST | .GEOHASH | .GEOPOS | .GEOSEARCH
+  | .GETBIT | .BITCOUNT | .BITPOS
+  | .DBSIZE => true
+  | _ => false
+
+/-- Dense index of a command (its position in the declaration), used to keep
+    per-command counters in arrays instead of maps keyed by name -/
+def RedisCmd.index (cmd : RedisCmd) : Nat := cmd.ctorIdx
+
+/-- Every command, in declaration order: `RedisCmd.all[cmd.index] = cmd` -/
+def RedisCmd.all : Array RedisCmd := #[
+  .SET, .SETEX, .GET, .APPEND, .GETDEL, .GETEX, .GETRANGE, .GETSET, .INCR, .INCRBY,
+  .INCRBYFLOAT, .DECR, .DECRBY, .MGET, .MSET, .MSETNX, .SETNX, .SETRANGE, .STRLEN,
+  .PSETEX, .LCS, .DEL, .EXISTS, .TYPE, .TTL, .PTTL, .KEYS, .SCAN, .EXPIRE, .EXPIREAT,
+  .PEXPIRE, .PEXPIREAT, .PERSIST, .RENAME, .RENAMENX, .COPY, .UNLINK, .TOUCH,
+  .EXPIRETIME, .RANDOMKEY, .SISMEMBER, .SCARD, .SADD, .SMEMBERS, .SREM, .SPOP,
+  .SRANDMEMBER, .SMOVE, .SMISMEMBER, .SDIFF, .SDIFFSTORE, .SINTER, .SINTERSTORE,
+  .SINTERCARD, .SUNION, .SUNIONSTORE, .SSCAN, .LPUSH, .RPUSH, .LPUSHX, .RPUSHX, .LPOP,
+  .RPOP, .LRANGE, .LINDEX, .LLEN, .LSET, .LINSERT, .LTRIM, .LREM, .LPOS, .LMOVE, .LMPOP,
+  .BLPOP, .BRPOP, .BLMOVE, .BLMPOP, .RPOPLPUSH, .BRPOPLPUSH, .HSET, .HGET, .HGETALL,
+  .HDEL, .HEXISTS, .HINCRBY, .HKEYS, .HLEN, .HVALS, .HSETNX, .HMGET, .HMSET,
+  .HINCRBYFLOAT, .HSTRLEN, .HRANDFIELD, .HSCAN, .ZADD, .ZCARD, .ZRANGE, .ZSCORE, .ZRANK,
+  .ZREVRANK, .ZCOUNT, .ZINCRBY, .ZREM, .ZLEXCOUNT, .ZMSCORE, .ZRANDMEMBER, .ZSCAN,
+  .ZRANGEBYSCORE, .ZREVRANGE, .ZREVRANGEBYSCORE, .ZRANGEBYLEX, .ZREVRANGEBYLEX,
+  .ZREMRANGEBYRANK, .ZREMRANGEBYSCORE, .ZREMRANGEBYLEX, .ZPOPMIN, .ZPOPMAX, .BZPOPMIN,
+  .BZPOPMAX, .ZUNIONSTORE, .ZINTERSTORE, .ZDIFFSTORE, .ZUNION, .ZINTER, .ZDIFF,
+  .ZINTERCARD, .ZRANGESTORE, .XADD, .XREAD, .XREADGROUP, .XRANGE, .XLEN, .XDEL, .XTRIM,
+  .PFADD, .PFCOUNT, .PFMERGE, .GEOADD, .GEODIST, .GEOHASH, .GEOPOS, .GEOSEARCH,
+  .GEOSEARCHSTORE, .SETBIT, .GETBIT, .BITCOUNT, .BITOP, .BITPOS, .MULTI, .EXEC, .DISCARD,
+  .WATCH, .UNWATCH, .EVAL, .EVALSHA, .SCRIPTLOAD, .SCRIPTEXISTS, .SCRIPTFLUSH,
+  .SCRIPTKILL, .PUBLISH, .SUBSCRIBE, .AUTH, .HELLO, .PING, .CLIENTID, .CLIENTGETNAME,
+  .CLIENTSETNAME, .CLIENTLIST, .CLIENTINFO, .CLIENTKILL, .CLIENTPAUSE, .CLIENTUNPAUSE,
+  .SELECT, .ECHO, .QUIT, .RESET, .INFO, .DBSIZE, .LASTSAVE, .BGSAVE, .BGREWRITEAOF,
+  .TIME, .CONFIGGET, .CONFIGSET, .CONFIGREWRITE, .CONFIGRESETSTAT, .MEMORYUSAGE,
+  .OBJECTENCODING, .OBJECTIDLETIME, .OBJECTFREQ, .SLOWLOGGET, .SLOWLOGLEN, .SLOWLOGRESET,
+  .FLUSHALL, .COMMAND
+]
+
+/-- Number of commands, the size of arrays indexed by `RedisCmd.index` -/
+def RedisCmd.count : Nat := RedisCmd.all.size
+
 end Redis
@@ -1,6 +1,7 @@
 -- FFI layer wrapping the hiredis C library
 import RedisLean.Error
 import RedisLean.Config
+import RedisLean.Reply
 
 namespace Redis
 
@@ -22,6 +23,36 @@ def SetExistsOption.toUInt8 : SetExistsOption → UInt8
   | .nx   => 1
   | .xx   => 2
 
+/-- Decoded XREAD/XREADGROUP reply: for each stream, its entries as
+    `(id, field/value pairs)`, in server order. Built directly by the C side;
+    field values are binary safe. -/
+abbrev StreamRead := Array (ByteArray × Array (ByteArray × Array (ByteArray × ByteArray)))
+
+opaque AsyncEnginePointed : NonemptyType
+
+/-- Handle to an async engine (C external object). Closing it stops its I/O
+    thread, and sends on a closed engine fail; the engine is freed once the
+    handle is unreachable. -/
+def AsyncEngine : Type := AsyncEnginePointed.type
+
+instance : Nonempty AsyncEngine := AsyncEnginePointed.property
+
+opaque SubscriberPointed : NonemptyType
+
+/-- Handle to a Pub/Sub subscriber thread (C external object), with the same
+    lifetime rules as `AsyncEngine` -/
+def SubscriberHandle : Type := SubscriberPointed.type
+
+instance : Nonempty SubscriberHandle := SubscriberPointed.property
+
+opaque MetricsServerPointed : NonemptyType
+
+/-- Handle to a metrics scrape endpoint thread (C external object). Stopping
+    it twice is harmless; an unreachable server is stopped and freed. -/
+def MetricsServerHandle : Type := MetricsServerPointed.type
+
+instance : Nonempty MetricsServerHandle := MetricsServerPointed.property
+
 /-!
 ## Internal FFI Declarations
 
@@ -78,7 +109,7 @@ opaque setex (ctx : @& Ctx) (k : @& ByteArray) (v : @& ByteArray) (msec : @& UIn
 opaque get (ctx : @& Ctx) (k : @& ByteArray) : EIO Error ByteArray
 
 @[extern "l_hiredis_del"]
-opaque del (ctx : @& Ctx) (keys : @& List ByteArray) : EIO Error UInt64
+opaque del (ctx : @& Ctx) (keys : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_exists"]
 opaque existsKey (ctx : @& Ctx) (key : @& ByteArray) : EIO Error Bool
@@ -110,6 +141,9 @@ opaque sadd (ctx : @& Ctx) (key : @& ByteArray) (member : @& ByteArray) : EIO Er
 @[extern "l_hiredis_smembers"]
 opaque smembers (ctx : @& Ctx) (key : @& ByteArray) : EIO Error (List ByteArray)
 
+@[extern "l_hiredis_smembers_array"]
+opaque smembersArray (ctx : @& Ctx) (key : @& ByteArray) : EIO Error (Array ByteArray)
+
 @[extern "l_hiredis_flushall"]
 opaque flushall (ctx : @& Ctx) (mode : @& String) : EIO Error Bool
 
@@ -120,7 +154,10 @@ opaque publish (ctx : @& Ctx) (channel : @& String) (message : @& ByteArray) : E
 opaque subscribe (ctx : @& Ctx) (channel : @& String) : EIO Error Bool
 
 @[extern "l_hiredis_command"]
-opaque command (ctx : @& Ctx) (command_str : @& String) : EIO Error ByteArray
+opaque command (ctx : @& Ctx) (command_str : @& String) : EIO Error Reply
+
+@[extern "l_hiredis_command_argv"]
+opaque commandArgv (ctx : @& Ctx) (args : @& Array ByteArray) : EIO Error Reply
 
 @[extern "l_hiredis_ttl"]
 opaque ttl (ctx : @& Ctx) (key : @& ByteArray) : EIO Error UInt64
@@ -131,6 +168,9 @@ opaque pttl (ctx : @& Ctx) (key : @& ByteArray) : EIO Error UInt64
 @[extern "l_hiredis_keys"]
 opaque keys (ctx : @& Ctx) (pattern : @& ByteArray) : EIO Error (List ByteArray)
 
+@[extern "l_hiredis_keys_array"]
+opaque keysArray (ctx : @& Ctx) (pattern : @& ByteArray) : EIO Error (Array ByteArray)
+
 @[extern "l_hiredis_hset"]
 opaque hset (ctx : @& Ctx) (key : @& ByteArray) (field : @& ByteArray) (value : @& ByteArray) : EIO Error UInt64
 
@@ -140,6 +180,9 @@ opaque hget (ctx : @& Ctx) (key : @& ByteArray) (field : @& ByteArray) : EIO Err
 @[extern "l_hiredis_hgetall"]
 opaque hgetall (ctx : @& Ctx) (key : @& ByteArray) : EIO Error (List ByteArray)
 
+@[extern "l_hiredis_hgetall_array"]
+opaque hgetallArray (ctx : @& Ctx) (key : @& ByteArray) : EIO Error (Array ByteArray)
+
 @[extern "l_hiredis_hdel"]
 opaque hdel (ctx : @& Ctx) (key : @& ByteArray) (field : @& ByteArray) : EIO Error UInt64
 
@@ -161,6 +204,9 @@ opaque zcard (ctx : @& Ctx) (key : @& ByteArray) : EIO Error UInt64
 @[extern "l_hiredis_zrange"]
 opaque zrange (ctx : @& Ctx) (key : @& ByteArray) (start : @& Int64) (stop : @& Int64) : EIO Error (List ByteArray)
 
+@[extern "l_hiredis_zrange_array"]
+opaque zrangeArray (ctx : @& Ctx) (key : @& ByteArray) (start : @& Int64) (stop : @& Int64) : EIO Error (Array ByteArray)
+
 @[extern "l_hiredis_zscore"]
 opaque zscore (ctx : @& Ctx) (key : @& ByteArray) (member : @& ByteArray) : EIO Error (Option Float)
 
@@ -177,13 +223,13 @@ opaque zcount (ctx : @& Ctx) (key : @& ByteArray) (min : @& ByteArray) (max : @&
 opaque zincrby (ctx : @& Ctx) (key : @& ByteArray) (increment : @& Float) (member : @& ByteArray) : EIO Error Float
 
 @[extern "l_hiredis_zrem"]
-opaque zrem (ctx : @& Ctx) (key : @& ByteArray) (members : @& List ByteArray) : EIO Error UInt64
+opaque zrem (ctx : @& Ctx) (key : @& ByteArray) (members : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_zlexcount"]
 opaque zlexcount (ctx : @& Ctx) (key : @& ByteArray) (min : @& ByteArray) (max : @& ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_zmscore"]
-opaque zmscore (ctx : @& Ctx) (key : @& ByteArray) (members : @& List ByteArray) : EIO Error (List (Option Float))
+opaque zmscore (ctx : @& Ctx) (key : @& ByteArray) (members : @& Array ByteArray) : EIO Error (List (Option Float))
 
 @[extern "l_hiredis_zrandmember"]
 opaque zrandmember (ctx : @& Ctx) (key : @& ByteArray) (count : @& Option Int64) (withscores : @& UInt8) : EIO Error (List ByteArray)
@@ -222,57 +268,57 @@ opaque zpopmin (ctx : @& Ctx) (key : @& ByteArray) (count : @& Option UInt64) :
 opaque zpopmax (ctx : @& Ctx) (key : @& ByteArray) (count : @& Option UInt64) : EIO Error (List ByteArray)
 
 @[extern "l_hiredis_bzpopmin"]
-opaque bzpopmin (ctx : @& Ctx) (keys : @& List ByteArray) (timeout : @& Float) : EIO Error (Option (ByteArray × ByteArray × ByteArray))
+opaque bzpopmin (ctx : @& Ctx) (keys : @& Array ByteArray) (timeout : @& Float) : EIO Error (Option (ByteArray × ByteArray × ByteArray))
 
 @[extern "l_hiredis_bzpopmax"]
-opaque bzpopmax (ctx : @& Ctx) (keys : @& List ByteArray) (timeout : @& Float) : EIO Error (Option (ByteArray × ByteArray × ByteArray))
+opaque bzpopmax (ctx : @& Ctx) (keys : @& Array ByteArray) (timeout : @& Float) : EIO Error (Option (ByteArray × ByteArray × ByteArray))
 
 @[extern "l_hiredis_zunionstore"]
-opaque zunionstore (ctx : @& Ctx) (dest : @& ByteArray) (keys : @& List ByteArray) : EIO Error UInt64
+opaque zunionstore (ctx : @& Ctx) (dest : @& ByteArray) (keys : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_zinterstore"]
-opaque zinterstore (ctx : @& Ctx) (dest : @& ByteArray) (keys : @& List ByteArray) : EIO Error UInt64
+opaque zinterstore (ctx : @& Ctx) (dest : @& ByteArray) (keys : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_zdiffstore"]
-opaque zdiffstore (ctx : @& Ctx) (dest : @& ByteArray) (keys : @& List ByteArray) : EIO Error UInt64
+opaque zdiffstore (ctx : @& Ctx) (dest : @& ByteArray) (keys : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_zunion"]
-opaque zunion (ctx : @& Ctx) (keys : @& List ByteArray) (withscores : @& UInt8) : EIO Error (List ByteArray)
+opaque zunion (ctx : @& Ctx) (keys : @& Array ByteArray) (withscores : @& UInt8) : EIO Error (List ByteArray)
 
 @[extern "l_hiredis_zinter"]
-opaque zinter (ctx : @& Ctx) (keys : @& List ByteArray) (withscores : @& UInt8) : EIO Error (List ByteArray)
+opaque zinter (ctx : @& Ctx) (keys : @& Array ByteArray) (withscores : @& UInt8) : EIO Error (List ByteArray)
 
 @[extern "l_hiredis_zdiff"]
-opaque zdiff (ctx : @& Ctx) (keys : @& List ByteArray) (withscores : @& UInt8) : EIO Error (List ByteArray)
+opaque zdiff (ctx : @& Ctx) (keys : @& Array ByteArray) (withscores : @& UInt8) : EIO Error (List ByteArray)
 
 @[extern "l_hiredis_zintercard"]
-opaque zintercard (ctx : @& Ctx) (keys : @& List ByteArray) (limit : @& Option UInt64) : EIO Error UInt64
+opaque zintercard (ctx : @& Ctx) (keys : @& Array ByteArray) (limit : @& Option UInt64) : EIO Error UInt64
 
 @[extern "l_hiredis_zrangestore"]
 opaque zrangestore (ctx : @& Ctx) (dst : @& ByteArray) (src : @& ByteArray) (min : @& ByteArray) (max : @& ByteArray) (rangeType : @& ByteArray) (rev : @& UInt8) : EIO Error UInt64
 
 -- HyperLogLog commands
 @[extern "l_hiredis_pfadd"]
-opaque pfadd (ctx : @& Ctx) (key : @& ByteArray) (elements : @& List ByteArray) : EIO Error Bool
+opaque pfadd (ctx : @& Ctx) (key : @& ByteArray) (elements : @& Array ByteArray) : EIO Error Bool
 
 @[extern "l_hiredis_pfcount"]
-opaque pfcount (ctx : @& Ctx) (keys : @& List ByteArray) : EIO Error UInt64
+opaque pfcount (ctx : @& Ctx) (keys : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_pfmerge"]
-opaque pfmerge (ctx : @& Ctx) (dest : @& ByteArray) (sources : @& List ByteArray) : EIO Error Unit
+opaque pfmerge (ctx : @& Ctx) (dest : @& ByteArray) (sources : @& Array ByteArray) : EIO Error Unit
 
 -- Geospatial commands
 @[extern "l_hiredis_geoadd"]
-opaque geoadd (ctx : @& Ctx) (key : @& ByteArray) (items : @& List (Float × Float × ByteArray)) : EIO Error UInt64
+opaque geoadd (ctx : @& Ctx) (key : @& ByteArray) (items : @& Array (Float × Float × ByteArray)) : EIO Error UInt64
 
 @[extern "l_hiredis_geodist"]
 opaque geodist (ctx : @& Ctx) (key : @& ByteArray) (member1 : @& ByteArray) (member2 : @& ByteArray) (unit : @& Option ByteArray) : EIO Error (Option Float)
 
 @[extern "l_hiredis_geohash"]
-opaque geohash (ctx : @& Ctx) (key : @& ByteArray) (members : @& List ByteArray) : EIO Error (List (Option ByteArray))
+opaque geohash (ctx : @& Ctx) (key : @& ByteArray) (members : @& Array ByteArray) : EIO Error (List (Option ByteArray))
 
 @[extern "l_hiredis_geopos"]
-opaque geopos (ctx : @& Ctx) (key : @& ByteArray) (members : @& List ByteArray) : EIO Error (List (Option (Float × Float)))
+opaque geopos (ctx : @& Ctx) (key : @& ByteArray) (members : @& Array ByteArray) : EIO Error (List (Option (Float × Float)))
 
 @[extern "l_hiredis_geosearch"]
 opaque geosearch (ctx : @& Ctx) (key : @& ByteArray) (fromType : @& ByteArray) (fromValue : @& ByteArray) (byType : @& ByteArray) (radius : @& Float) (unit : @& ByteArray) (count : @& Option UInt64) : EIO Error (List ByteArray)
@@ -291,7 +337,7 @@ opaque getbit (ctx : @& Ctx) (key : @& ByteArray) (offset : @& UInt64) : EIO Err
 opaque bitcount (ctx : @& Ctx) (key : @& ByteArray) (start : @& Option Int64) (stop : @& Option Int64) : EIO Error UInt64
 
 @[extern "l_hiredis_bitop"]
-opaque bitop (ctx : @& Ctx) (operation : @& ByteArray) (destkey : @& ByteArray) (keys : @& List ByteArray) : EIO Error UInt64
+opaque bitop (ctx : @& Ctx) (operation : @& ByteArray) (destkey : @& ByteArray) (keys : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_bitpos"]
 opaque bitpos (ctx : @& Ctx) (key : @& ByteArray) (bit : @& UInt8) (start : @& Option Int64) (stop : @& Option Int64) : EIO Error Int64
@@ -307,23 +353,23 @@ opaque exec (ctx : @& Ctx) : EIO Error (Option (List ByteArray))
 opaque discard (ctx : @& Ctx) : EIO Error Unit
 
 @[extern "l_hiredis_watch"]
-opaque watch (ctx : @& Ctx) (keys : @& List ByteArray) : EIO Error Unit
+opaque watch (ctx : @& Ctx) (keys : @& Array ByteArray) : EIO Error Unit
 
 @[extern "l_hiredis_unwatch"]
 opaque unwatch (ctx : @& Ctx) : EIO Error Unit
 
 -- Scripting commands
 @[extern "l_hiredis_eval"]
-opaque eval (ctx : @& Ctx) (script : @& ByteArray) (keys : @& List ByteArray) (args : @& List ByteArray) : EIO Error ByteArray
+opaque eval (ctx : @& Ctx) (script : @& ByteArray) (keys : @& Array ByteArray) (args : @& Array ByteArray) : EIO Error ByteArray
 
 @[extern "l_hiredis_evalsha"]
-opaque evalsha (ctx : @& Ctx) (sha1 : @& ByteArray) (keys : @& List ByteArray) (args : @& List ByteArray) : EIO Error ByteArray
+opaque evalsha (ctx : @& Ctx) (sha1 : @& ByteArray) (keys : @& Array ByteArray) (args : @& Array ByteArray) : EIO Error ByteArray
 
 @[extern "l_hiredis_scriptload"]
 opaque scriptload (ctx : @& Ctx) (script : @& ByteArray) : EIO Error ByteArray
 
 @[extern "l_hiredis_scriptexists"]
-opaque scriptexists (ctx : @& Ctx) (sha1s : @& List ByteArray) : EIO Error (List Bool)
+opaque scriptexists (ctx : @& Ctx) (sha1s : @& Array ByteArray) : EIO Error (List Bool)
 
 @[extern "l_hiredis_scriptflush"]
 opaque scriptflush (ctx : @& Ctx) : EIO Error Unit
@@ -422,10 +468,10 @@ opaque slowlogreset (ctx : @& Ctx) : EIO Error Unit
 
 -- Redis Streams commands
 @[extern "l_hiredis_xadd"]
-opaque xadd (ctx : @& Ctx) (key : @& ByteArray) (stream_id : @& ByteArray) (field_values : @& List (ByteArray × ByteArray)) (maxlen_opt : @& Option UInt64) : EIO Error ByteArray
+opaque xadd (ctx : @& Ctx) (key : @& ByteArray) (stream_id : @& ByteArray) (field_values : @& Array (ByteArray × ByteArray)) (maxlen_opt : @& Option UInt64) : EIO Error ByteArray
 
 @[extern "l_hiredis_xread"]
-opaque xread (ctx : @& Ctx) (streams : @& List (ByteArray × ByteArray)) (count_opt : @& Option UInt64) (block_opt : @& Option UInt64) : EIO Error ByteArray
+opaque xread (ctx : @& Ctx) (streams : @& Array (ByteArray × ByteArray)) (count_opt : @& Option UInt64) (block_opt : @& Option UInt64) : EIO Error StreamRead
 
 @[extern "l_hiredis_xrange"]
 opaque xrange (ctx : @& Ctx) (key : @& ByteArray) (start_id : @& ByteArray) (end_id : @& ByteArray) (count_opt : @& Option UInt64) : EIO Error ByteArray
@@ -434,14 +480,14 @@ opaque xrange (ctx : @& Ctx) (key : @& ByteArray) (start_id : @& ByteArray) (end
 opaque xlen (ctx : @& Ctx) (key : @& ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_xdel"]
-opaque xdel (ctx : @& Ctx) (key : @& ByteArray) (entry_ids : @& List ByteArray) : EIO Error UInt64
+opaque xdel (ctx : @& Ctx) (key : @& ByteArray) (entry_ids : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_xtrim"]
 opaque xtrim (ctx : @& Ctx) (key : @& ByteArray) (strategy : @& ByteArray) (max_len : @& UInt64) : EIO Error UInt64
 
 -- Consumer group commands
 @[extern "l_hiredis_xreadgroup"]
-opaque xreadgroup (ctx : @& Ctx) (group : @& String) (consumer : @& String) (stream : @& String) (count : UInt64) : EIO Error ByteArray
+opaque xreadgroup (ctx : @& Ctx) (group : @& String) (consumer : @& String) (stream : @& String) (count : UInt64) : EIO Error StreamRead
 
 @[extern "l_hiredis_xack"]
 opaque xack (ctx : @& Ctx) (stream : @& String) (group : @& String) (msgid : @& String) : EIO Error UInt64
@@ -451,16 +497,16 @@ opaque xgroup_create (ctx : @& Ctx) (stream : @& String) (group : @& String) (st
 
 -- List commands
 @[extern "l_hiredis_lpush"]
-opaque lpush (ctx : @& Ctx) (key : @& ByteArray) (elements : @& List ByteArray) : EIO Error UInt64
+opaque lpush (ctx : @& Ctx) (key : @& ByteArray) (elements : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_rpush"]
-opaque rpush (ctx : @& Ctx) (key : @& ByteArray) (elements : @& List ByteArray) : EIO Error UInt64
+opaque rpush (ctx : @& Ctx) (key : @& ByteArray) (elements : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_lpushx"]
-opaque lpushx (ctx : @& Ctx) (key : @& ByteArray) (elements : @& List ByteArray) : EIO Error UInt64
+opaque lpushx (ctx : @& Ctx) (key : @& ByteArray) (elements : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_rpushx"]
-opaque rpushx (ctx : @& Ctx) (key : @& ByteArray) (elements : @& List ByteArray) : EIO Error UInt64
+opaque rpushx (ctx : @& Ctx) (key : @& ByteArray) (elements : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_lpop"]
 opaque lpop (ctx : @& Ctx) (key : @& ByteArray) (count : @& Option UInt64) : EIO Error (List ByteArray)
@@ -471,6 +517,9 @@ opaque rpop (ctx : @& Ctx) (key : @& ByteArray) (count : @& Option UInt64) : EIO
 @[extern "l_hiredis_lrange"]
 opaque lrange (ctx : @& Ctx) (key : @& ByteArray) (start : @& Int64) (stop : @& Int64) : EIO Error (List ByteArray)
 
+@[extern "l_hiredis_lrange_array"]
+opaque lrangeArray (ctx : @& Ctx) (key : @& ByteArray) (start : @& Int64) (stop : @& Int64) : EIO Error (Array ByteArray)
+
 @[extern "l_hiredis_lindex"]
 opaque lindex (ctx : @& Ctx) (key : @& ByteArray) (index : @& Int64) : EIO Error ByteArray
 
@@ -496,19 +545,19 @@ opaque lpos (ctx : @& Ctx) (key : @& ByteArray) (element : @& ByteArray) (rank :
 opaque lmove (ctx : @& Ctx) (src : @& ByteArray) (dst : @& ByteArray) (srcDir : @& UInt8) (dstDir : @& UInt8) : EIO Error ByteArray
 
 @[extern "l_hiredis_lmpop"]
-opaque lmpop (ctx : @& Ctx) (keys : @& List ByteArray) (direction : @& UInt8) (count : @& Option UInt64) : EIO Error (Option (ByteArray × List ByteArray))
+opaque lmpop (ctx : @& Ctx) (keys : @& Array ByteArray) (direction : @& UInt8) (count : @& Option UInt64) : EIO Error (Option (ByteArray × List ByteArray))
 
 @[extern "l_hiredis_blpop"]
-opaque blpop (ctx : @& Ctx) (keys : @& List ByteArray) (timeout : @& Float) : EIO Error (Option (ByteArray × ByteArray))
+opaque blpop (ctx : @& Ctx) (keys : @& Array ByteArray) (timeout : @& Float) : EIO Error (Option (ByteArray × ByteArray))
 
 @[extern "l_hiredis_brpop"]
-opaque brpop (ctx : @& Ctx) (keys : @& List ByteArray) (timeout : @& Float) : EIO Error (Option (ByteArray × ByteArray))
+opaque brpop (ctx : @& Ctx) (keys : @& Array ByteArray) (timeout : @& Float) : EIO Error (Option (ByteArray × ByteArray))
 
 @[extern "l_hiredis_blmove"]
 opaque blmove (ctx : @& Ctx) (src : @& ByteArray) (dst : @& ByteArray) (srcDir : @& UInt8) (dstDir : @& UInt8) (timeout : @& Float) : EIO Error (Option ByteArray)
 
 @[extern "l_hiredis_blmpop"]
-opaque blmpop (ctx : @& Ctx) (timeout : @& Float) (keys : @& List ByteArray) (direction : @& UInt8) (count : @& Option UInt64) : EIO Error (Option (ByteArray × List ByteArray))
+opaque blmpop (ctx : @& Ctx) (timeout : @& Float) (keys : @& Array ByteArray) (direction : @& UInt8) (count : @& Option UInt64) : EIO Error (Option (ByteArray × List ByteArray))
 
 @[extern "l_hiredis_rpoplpush"]
 opaque rpoplpush (ctx : @& Ctx) (src : @& ByteArray) (dst : @& ByteArray) : EIO Error ByteArray
@@ -536,13 +585,16 @@ opaque getset (ctx : @& Ctx) (key : @& ByteArray) (value : @& ByteArray) : EIO E
 opaque incrbyfloat (ctx : @& Ctx) (key : @& ByteArray) (increment : @& Float) : EIO Error Float
 
 @[extern "l_hiredis_mget"]
-opaque mget (ctx : @& Ctx) (keys : @& List ByteArray) : EIO Error (List (Option ByteArray))
+opaque mget (ctx : @& Ctx) (keys : @& Array ByteArray) : EIO Error (List (Option ByteArray))
+
+@[extern "l_hiredis_mget_array"]
+opaque mgetArray (ctx : @& Ctx) (keys : @& Array ByteArray) : EIO Error (Array (Option ByteArray))
 
 @[extern "l_hiredis_mset"]
-opaque mset (ctx : @& Ctx) (pairs : @& List (ByteArray × ByteArray)) : EIO Error Unit
+opaque mset (ctx : @& Ctx) (pairs : @& Array (ByteArray × ByteArray)) : EIO Error Unit
 
 @[extern "l_hiredis_msetnx"]
-opaque msetnx (ctx : @& Ctx) (pairs : @& List (ByteArray × ByteArray)) : EIO Error Bool
+opaque msetnx (ctx : @& Ctx) (pairs : @& Array (ByteArray × ByteArray)) : EIO Error Bool
 
 @[extern "l_hiredis_setnx"]
 opaque setnx (ctx : @& Ctx) (key : @& ByteArray) (value : @& ByteArray) : EIO Error Bool
@@ -561,7 +613,7 @@ opaque lcs (ctx : @& Ctx) (key1 : @& ByteArray) (key2 : @& ByteArray) (getLen :
 
 -- Set commands (additional)
 @[extern "l_hiredis_srem"]
-opaque srem (ctx : @& Ctx) (key : @& ByteArray) (members : @& List ByteArray) : EIO Error UInt64
+opaque srem (ctx : @& Ctx) (key : @& ByteArray) (members : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_spop"]
 opaque spop (ctx : @& Ctx) (key : @& ByteArray) (count : @& Option UInt64) : EIO Error (List ByteArray)
@@ -573,28 +625,28 @@ opaque srandmember (ctx : @& Ctx) (key : @& ByteArray) (count : @& Option UInt64
 opaque smove (ctx : @& Ctx) (src : @& ByteArray) (dst : @& ByteArray) (member : @& ByteArray) : EIO Error Bool
 
 @[extern "l_hiredis_smismember"]
-opaque smismember (ctx : @& Ctx) (key : @& ByteArray) (members : @& List ByteArray) : EIO Error (List Bool)
+opaque smismember (ctx : @& Ctx) (key : @& ByteArray) (members : @& Array ByteArray) : EIO Error (List Bool)
 
 @[extern "l_hiredis_sdiff"]
-opaque sdiff (ctx : @& Ctx) (keys : @& List ByteArray) : EIO Error (List ByteArray)
+opaque sdiff (ctx : @& Ctx) (keys : @& Array ByteArray) : EIO Error (List ByteArray)
 
 @[extern "l_hiredis_sdiffstore"]
-opaque sdiffstore (ctx : @& Ctx) (dst : @& ByteArray) (keys : @& List ByteArray) : EIO Error UInt64
+opaque sdiffstore (ctx : @& Ctx) (dst : @& ByteArray) (keys : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_sinter"]
-opaque sinter (ctx : @& Ctx) (keys : @& List ByteArray) : EIO Error (List ByteArray)
+opaque sinter (ctx : @& Ctx) (keys : @& Array ByteArray) : EIO Error (List ByteArray)
 
 @[extern "l_hiredis_sinterstore"]
-opaque sinterstore (ctx : @& Ctx) (dst : @& ByteArray) (keys : @& List ByteArray) : EIO Error UInt64
+opaque sinterstore (ctx : @& Ctx) (dst : @& ByteArray) (keys : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_sintercard"]
-opaque sintercard (ctx : @& Ctx) (keys : @& List ByteArray) (limit : @& Option UInt64) : EIO Error UInt64
+opaque sintercard (ctx : @& Ctx) (keys : @& Array ByteArray) (limit : @& Option UInt64) : EIO Error UInt64
 
 @[extern "l_hiredis_sunion"]
-opaque sunion (ctx : @& Ctx) (keys : @& List ByteArray) : EIO Error (List ByteArray)
+opaque sunion (ctx : @& Ctx) (keys : @& Array ByteArray) : EIO Error (List ByteArray)
 
 @[extern "l_hiredis_sunionstore"]
-opaque sunionstore (ctx : @& Ctx) (dst : @& ByteArray) (keys : @& List ByteArray) : EIO Error UInt64
+opaque sunionstore (ctx : @& Ctx) (dst : @& ByteArray) (keys : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_sscan"]
 opaque sscan (ctx : @& Ctx) (key : @& ByteArray) (cursor : @& UInt64) (pattern : @& Option ByteArray) (count : @& Option UInt64) : EIO Error (UInt64 × List ByteArray)
@@ -628,10 +680,10 @@ opaque renamenx (ctx : @& Ctx) (key : @& ByteArray) (newkey : @& ByteArray) : EI
 opaque copyKey (ctx : @& Ctx) (src : @& ByteArray) (dst : @& ByteArray) (replace : @& UInt8) : EIO Error Bool
 
 @[extern "l_hiredis_unlink"]
-opaque unlink (ctx : @& Ctx) (keys : @& List ByteArray) : EIO Error UInt64
+opaque unlink (ctx : @& Ctx) (keys : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_touch"]
-opaque touch (ctx : @& Ctx) (keys : @& List ByteArray) : EIO Error UInt64
+opaque touch (ctx : @& Ctx) (keys : @& Array ByteArray) : EIO Error UInt64
 
 @[extern "l_hiredis_expiretime"]
 opaque expiretime (ctx : @& Ctx) (key : @& ByteArray) : EIO Error Int64
@@ -650,10 +702,10 @@ opaque hvals (ctx : @& Ctx) (key : @& ByteArray) : EIO Error (List ByteArray)
 opaque hsetnx (ctx : @& Ctx) (key : @& ByteArray) (field : @& ByteArray) (value : @& ByteArray) : EIO Error Bool
 
 @[extern "l_hiredis_hmget"]
-opaque hmget (ctx : @& Ctx) (key : @& ByteArray) (fields : @& List ByteArray) : EIO Error (List (Option ByteArray))
+opaque hmget (ctx : @& Ctx) (key : @& ByteArray) (fields : @& Array ByteArray) : EIO Error (List (Option ByteArray))
 
 @[extern "l_hiredis_hmset"]
-opaque hmset (ctx : @& Ctx) (key : @& ByteArray) (pairs : @& List (ByteArray × ByteArray)) : EIO Error Unit
+opaque hmset (ctx : @& Ctx) (key : @& ByteArray) (pairs : @& Array (ByteArray × ByteArray)) : EIO Error Unit
 
 @[extern "l_hiredis_hincrbyfloat"]
 opaque hincrbyfloat (ctx : @& Ctx) (key : @& ByteArray) (field : @& ByteArray) (increment : @& Float) : EIO Error Float
@@ -706,19 +758,39 @@ opaque getError (ctx : @& Ctx) : EIO Error (Option String)
 @[extern "l_hiredis_clear_error"]
 opaque clearError (ctx : @& Ctx) : EIO Error Unit
 
+-- Connection management: byte accounting
+@[extern "l_hiredis_io_stats"]
+opaque ioStats (ctx : @& Ctx) : BaseIO (UInt64 × UInt64)
+
+@[extern "l_hiredis_io_take_written"]
+opaque ioTakeWritten (ctx : @& Ctx) : BaseIO UInt64
+
+@[extern "l_hiredis_io_take_read"]
+opaque ioTakeRead (ctx : @& Ctx) : BaseIO UInt64
+
+-- Connection management: latency phases
+@[extern "l_hiredis_io_phase_start"]
+opaque ioPhaseStart (ctx : @& Ctx) : BaseIO Unit
+
+@[extern "l_hiredis_io_phase_take"]
+opaque ioPhaseTake (ctx : @& Ctx) : BaseIO (UInt64 × UInt64 × UInt64 × UInt64)
+
 -- Pipeline support
 @[extern "l_hiredis_append_command"]
 opaque appendCommand (ctx : @& Ctx) (command : @& String) : EIO Error Unit
 
 @[extern "l_hiredis_append_command_argv"]
-opaque appendCommandArgv (ctx : @& Ctx) (args : @& List ByteArray) : EIO Error Unit
+opaque appendCommandArgv (ctx : @& Ctx) (args : @& Array ByteArray) : EIO Error Unit
 
 @[extern "l_hiredis_get_reply"]
-opaque getReply (ctx : @& Ctx) : EIO Error ByteArray
+opaque getReply (ctx : @& Ctx) : EIO Error Reply
 
 @[extern "l_hiredis_flush_pipeline"]
 opaque flushPipeline (ctx : @& Ctx) : EIO Error Unit
 
+@[extern "l_hiredis_pipeline_exec"]
+opaque pipelineExec (ctx : @& Ctx) (commands : @& Array (Array ByteArray)) : EIO Error (Array Reply)
+
 -- Async support
 @[extern "l_hiredis_connect_nonblock"]
 opaque connectNonBlock (host : @& String) (port : @& UInt32) : EIO Error Ctx
@@ -736,7 +808,43 @@ opaque bufferWrite (ctx : @& Ctx) : EIO Error Bool
 opaque bufferRead (ctx : @& Ctx) : EIO Error Unit
 
 @[extern "l_hiredis_get_reply_nonblock"]
-opaque getReplyNonBlock (ctx : @& Ctx) : EIO Error (Option ByteArray)
+opaque getReplyNonBlock (ctx : @& Ctx) : EIO Error (Option Reply)
+
+-- Async engine (redisAsyncContext + I/O thread)
+@[extern "l_hiredis_async_connect"]
+opaque asyncConnect (host : @& String) (port : @& UInt32) : EIO Error AsyncEngine
+
+@[extern "l_hiredis_async_send"]
+opaque asyncSend (engine : @& AsyncEngine) (args : @& Array ByteArray) (onReply : Except Error Reply → BaseIO Unit) : EIO Error Unit
+
+@[extern "l_hiredis_async_close"]
+opaque asyncClose (engine : @& AsyncEngine) : BaseIO Unit
+
+-- Pub/Sub subscriber thread
+@[extern "l_hiredis_subscriber_start"]
+opaque subscriberStart (host : @& String) (port : @& UInt32) (onBatch : Array Reply → BaseIO Unit) (batchMax : @& UInt64) : EIO Error SubscriberHandle
+
+@[extern "l_hiredis_subscriber_command"]
+opaque subscriberCommand (handle : @& SubscriberHandle) (kind : @& UInt8) (unsubscribe : @& UInt8) (names : @& Array ByteArray) : EIO Error Unit
+
+@[extern "l_hiredis_subscriber_stats"]
+opaque subscriberStats (handle : @& SubscriberHandle) : BaseIO (UInt64 × UInt64)
+
+@[extern "l_hiredis_subscriber_stop"]
+opaque subscriberStop (handle : @& SubscriberHandle) : BaseIO Unit
+
+-- Metrics scrape endpoint thread
+@[extern "l_hiredis_metrics_server_start"]
+opaque metricsServerStart (host : @& String) (port : @& UInt32) (render : BaseIO String) : EIO Error MetricsServerHandle
+
+@[extern "l_hiredis_metrics_server_port"]
+opaque metricsServerPort (handle : @& MetricsServerHandle) : BaseIO UInt32
+
+@[extern "l_hiredis_metrics_server_scrapes"]
+opaque metricsServerScrapes (handle : @& MetricsServerHandle) : BaseIO UInt64
+
+@[extern "l_hiredis_metrics_server_stop"]
+opaque metricsServerStop (handle : @& MetricsServerHandle) : BaseIO Unit
 
 end Internal
 
@@ -778,7 +886,7 @@ def setex (ctx : Ctx) (k v : ByteArray) (msec : UInt64) (existsOption : SetExist
 
 def get (ctx : Ctx) (k : ByteArray) : EIO Error ByteArray := Internal.get ctx k
 
-def del (ctx : Ctx) (keys : List ByteArray) : EIO Error UInt64 := Internal.del ctx keys
+def del (ctx : Ctx) (keys : Array ByteArray) : EIO Error UInt64 := Internal.del ctx keys
 
 def existsKey (ctx : Ctx) (key : ByteArray) : EIO Error Bool := Internal.existsKey ctx key
 
@@ -800,13 +908,22 @@ def sadd (ctx : Ctx) (key member : ByteArray) : EIO Error UInt64 := Internal.sad
 
 def smembers (ctx : Ctx) (key : ByteArray) : EIO Error (List ByteArray) := Internal.smembers ctx key
 
+def smembersArray (ctx : Ctx) (key : ByteArray) : EIO Error (Array ByteArray) := Internal.smembersArray ctx key
+
 def flushall (ctx : Ctx) (mode : String := "SYNC") : EIO Error Bool := Internal.flushall ctx mode
 
 def publish (ctx : Ctx) (channel : String) (message : ByteArray) : EIO Error UInt64 := Internal.publish ctx channel message
 
 def subscribe (ctx : Ctx) (channel : String) : EIO Error Bool := Internal.subscribe ctx channel
 
-def command (ctx : Ctx) (command_str : String) : EIO Error ByteArray := Internal.command ctx command_str
+/-- Run an arbitrary command given as a string (arguments split on whitespace,
+    double quotes group). Returns the fully decoded reply; an error reply is
+    raised as `Error.replyError`. -/
+def command (ctx : Ctx) (command_str : String) : EIO Error Reply := Internal.command ctx command_str
+
+/-- Run an arbitrary command given as an argument vector. Binary safe: each
+    ByteArray is passed to hiredis as one argument, without tokenizing or copying. -/
+def commandArgv (ctx : Ctx) (args : Array ByteArray) : EIO Error Reply := Internal.commandArgv ctx args
 
 def ttl (ctx : Ctx) (key : ByteArray) : EIO Error UInt64 := Internal.ttl ctx key
 
@@ -814,12 +931,16 @@ def pttl (ctx : Ctx) (key : ByteArray) : EIO Error UInt64 := Internal.pttl ctx k
 
 def keys (ctx : Ctx) (pattern : ByteArray) : EIO Error (List ByteArray) := Internal.keys ctx pattern
 
+def keysArray (ctx : Ctx) (pattern : ByteArray) : EIO Error (Array ByteArray) := Internal.keysArray ctx pattern
+
 def hset (ctx : Ctx) (key field value : ByteArray) : EIO Error UInt64 := Internal.hset ctx key field value
 
 def hget (ctx : Ctx) (key field : ByteArray) : EIO Error ByteArray := Internal.hget ctx key field
 
 def hgetall (ctx : Ctx) (key : ByteArray) : EIO Error (List ByteArray) := Internal.hgetall ctx key
 
+def hgetallArray (ctx : Ctx) (key : ByteArray) : EIO Error (Array ByteArray) := Internal.hgetallArray ctx key
+
 def hdel (ctx : Ctx) (key field : ByteArray) : EIO Error UInt64 := Internal.hdel ctx key field
 
 def hexists (ctx : Ctx) (key field : ByteArray) : EIO Error Bool := Internal.hexists ctx key field
@@ -834,6 +955,8 @@ def zcard (ctx : Ctx) (key : ByteArray) : EIO Error UInt64 := Internal.zcard ctx
 
 def zrange (ctx : Ctx) (key : ByteArray) (start stop : Int64) : EIO Error (List ByteArray) := Internal.zrange ctx key start stop
 
+def zrangeArray (ctx : Ctx) (key : ByteArray) (start stop : Int64) : EIO Error (Array ByteArray) := Internal.zrangeArray ctx key start stop
+
 def zscore (ctx : Ctx) (key member : ByteArray) : EIO Error (Option Float) := Internal.zscore ctx key member
 
 def zrank (ctx : Ctx) (key member : ByteArray) : EIO Error (Option UInt64) := Internal.zrank ctx key member
@@ -844,11 +967,11 @@ def zcount (ctx : Ctx) (key min max : ByteArray) : EIO Error UInt64 := Internal.
 
 def zincrby (ctx : Ctx) (key : ByteArray) (increment : Float) (member : ByteArray) : EIO Error Float := Internal.zincrby ctx key increment member
 
-def zrem (ctx : Ctx) (key : ByteArray) (members : List ByteArray) : EIO Error UInt64 := Internal.zrem ctx key members
+def zrem (ctx : Ctx) (key : ByteArray) (members : Array ByteArray) : EIO Error UInt64 := Internal.zrem ctx key members
 
 def zlexcount (ctx : Ctx) (key min max : ByteArray) : EIO Error UInt64 := Internal.zlexcount ctx key min max
 
-def zmscore (ctx : Ctx) (key : ByteArray) (members : List ByteArray) : EIO Error (List (Option Float)) := Internal.zmscore ctx key members
+def zmscore (ctx : Ctx) (key : ByteArray) (members : Array ByteArray) : EIO Error (List (Option Float)) := Internal.zmscore ctx key members
 
 def zrandmember (ctx : Ctx) (key : ByteArray) (count : Option Int64 := none) (withscores : Bool := false) : EIO Error (List ByteArray) :=
   Internal.zrandmember ctx key count (if withscores then 1 else 0)
@@ -881,48 +1004,48 @@ def zpopmin (ctx : Ctx) (key : ByteArray) (count : Option UInt64 := none) : EIO
 
 def zpopmax (ctx : Ctx) (key : ByteArray) (count : Option UInt64 := none) : EIO Error (List ByteArray) := Internal.zpopmax ctx key count
 
-def bzpopmin (ctx : Ctx) (keys : List ByteArray) (timeout : Float) : EIO Error (Option (ByteArray × ByteArray × ByteArray)) :=
+def bzpopmin (ctx : Ctx) (keys : Array ByteArray) (timeout : Float) : EIO Error (Option (ByteArray × ByteArray × ByteArray)) :=
   Internal.bzpopmin ctx keys timeout
 
-def bzpopmax (ctx : Ctx) (keys : List ByteArray) (timeout : Float) : EIO Error (Option (ByteArray × ByteArray × ByteArray)) :=
+def bzpopmax (ctx : Ctx) (keys : Array ByteArray) (timeout : Float) : EIO Error (Option (ByteArray × ByteArray × ByteArray)) :=
   Internal.bzpopmax ctx keys timeout
 
-def zunionstore (ctx : Ctx) (dest : ByteArray) (keys : List ByteArray) : EIO Error UInt64 := Internal.zunionstore ctx dest keys
+def zunionstore (ctx : Ctx) (dest : ByteArray) (keys : Array ByteArray) : EIO Error UInt64 := Internal.zunionstore ctx dest keys
 
-def zinterstore (ctx : Ctx) (dest : ByteArray) (keys : List ByteArray) : EIO Error UInt64 := Internal.zinterstore ctx dest keys
+def zinterstore (ctx : Ctx) (dest : ByteArray) (keys : Array ByteArray) : EIO Error UInt64 := Internal.zinterstore ctx dest keys
 
-def zdiffstore (ctx : Ctx) (dest : ByteArray) (keys : List ByteArray) : EIO Error UInt64 := Internal.zdiffstore ctx dest keys
+def zdiffstore (ctx : Ctx) (dest : ByteArray) (keys : Array ByteArray) : EIO Error UInt64 := Internal.zdiffstore ctx dest keys
 
-def zunion (ctx : Ctx) (keys : List ByteArray) (withscores : Bool := false) : EIO Error (List ByteArray) :=
+def zunion (ctx : Ctx) (keys : Array ByteArray) (withscores : Bool := false) : EIO Error (List ByteArray) :=
   Internal.zunion ctx keys (if withscores then 1 else 0)
 
-def zinter (ctx : Ctx) (keys : List ByteArray) (withscores : Bool := false) : EIO Error (List ByteArray) :=
+def zinter (ctx : Ctx) (keys : Array ByteArray) (withscores : Bool := false) : EIO Error (List ByteArray) :=
   Internal.zinter ctx keys (if withscores then 1 else 0)
 
-def zdiff (ctx : Ctx) (keys : List ByteArray) (withscores : Bool := false) : EIO Error (List ByteArray) :=
+def zdiff (ctx : Ctx) (keys : Array ByteArray) (withscores : Bool := false) : EIO Error (List ByteArray) :=
   Internal.zdiff ctx keys (if withscores then 1 else 0)
 
-def zintercard (ctx : Ctx) (keys : List ByteArray) (limit : Option UInt64 := none) : EIO Error UInt64 := Internal.zintercard ctx keys limit
+def zintercard (ctx : Ctx) (keys : Array ByteArray) (limit : Option UInt64 := none) : EIO Error UInt64 := Internal.zintercard ctx keys limit
 
 def zrangestore (ctx : Ctx) (dst src min max : ByteArray) (rangeType : ByteArray := "".toUTF8) (rev : Bool := false) : EIO Error UInt64 :=
   Internal.zrangestore ctx dst src min max rangeType (if rev then 1 else 0)
 
 -- HyperLogLog operations
-def pfadd (ctx : Ctx) (key : ByteArray) (elements : List ByteArray) : EIO Error Bool := Internal.pfadd ctx key elements
+def pfadd (ctx : Ctx) (key : ByteArray) (elements : Array ByteArray) : EIO Error Bool := Internal.pfadd ctx key elements
 
-def pfcount (ctx : Ctx) (keys : List ByteArray) : EIO Error UInt64 := Internal.pfcount ctx keys
+def pfcount (ctx : Ctx) (keys : Array ByteArray) : EIO Error UInt64 := Internal.pfcount ctx keys
 
-def pfmerge (ctx : Ctx) (dest : ByteArray) (sources : List ByteArray) : EIO Error Unit := Internal.pfmerge ctx dest sources
+def pfmerge (ctx : Ctx) (dest : ByteArray) (sources : Array ByteArray) : EIO Error Unit := Internal.pfmerge ctx dest sources
 
 -- Geospatial operations
-def geoadd (ctx : Ctx) (key : ByteArray) (items : List (Float × Float × ByteArray)) : EIO Error UInt64 := Internal.geoadd ctx key items
+def geoadd (ctx : Ctx) (key : ByteArray) (items : Array (Float × Float × ByteArray)) : EIO Error UInt64 := Internal.geoadd ctx key items
 
 def geodist (ctx : Ctx) (key member1 member2 : ByteArray) (unit : Option ByteArray := none) : EIO Error (Option Float) :=
   Internal.geodist ctx key member1 member2 unit
 
-def geohash (ctx : Ctx) (key : ByteArray) (members : List ByteArray) : EIO Error (List (Option ByteArray)) := Internal.geohash ctx key members
+def geohash (ctx : Ctx) (key : ByteArray) (members : Array ByteArray) : EIO Error (List (Option ByteArray)) := Internal.geohash ctx key members
 
-def geopos (ctx : Ctx) (key : ByteArray) (members : List ByteArray) : EIO Error (List (Option (Float × Float))) := Internal.geopos ctx key members
+def geopos (ctx : Ctx) (key : ByteArray) (members : Array ByteArray) : EIO Error (List (Option (Float × Float))) := Internal.geopos ctx key members
 
 def geosearch (ctx : Ctx) (key fromType fromValue byType : ByteArray) (radius : Float) (unit : ByteArray) (count : Option UInt64 := none) : EIO Error (List ByteArray) :=
   Internal.geosearch ctx key fromType fromValue byType radius unit count
@@ -942,7 +1065,7 @@ def getbit' (ctx : Ctx) (key : ByteArray) (offset : UInt64) : EIO Error Bool :=
 def bitcount (ctx : Ctx) (key : ByteArray) (start : Option Int64 := none) (stop : Option Int64 := none) : EIO Error UInt64 :=
   Internal.bitcount ctx key start stop
 
-def bitop (ctx : Ctx) (operation destkey : ByteArray) (keys : List ByteArray) : EIO Error UInt64 :=
+def bitop (ctx : Ctx) (operation destkey : ByteArray) (keys : Array ByteArray) : EIO Error UInt64 :=
   Internal.bitop ctx operation destkey keys
 
 def bitpos (ctx : Ctx) (key : ByteArray) (bit : Bool) (start : Option Int64 := none) (stop : Option Int64 := none) : EIO Error Int64 :=
@@ -955,20 +1078,20 @@ def exec (ctx : Ctx) : EIO Error (Option (List ByteArray)) := Internal.exec ctx
 
 def discard (ctx : Ctx) : EIO Error Unit := Internal.discard ctx
 
-def watch (ctx : Ctx) (keys : List ByteArray) : EIO Error Unit := Internal.watch ctx keys
+def watch (ctx : Ctx) (keys : Array ByteArray) : EIO Error Unit := Internal.watch ctx keys
 
 def unwatch (ctx : Ctx) : EIO Error Unit := Internal.unwatch ctx
 
 -- Scripting operations
-def eval (ctx : Ctx) (script : ByteArray) (keys : List ByteArray := []) (args : List ByteArray := []) : EIO Error ByteArray :=
+def eval (ctx : Ctx) (script : ByteArray) (keys : Array ByteArray := #[]) (args : Array ByteArray := #[]) : EIO Error ByteArray :=
   Internal.eval ctx script keys args
 
-def evalsha (ctx : Ctx) (sha1 : ByteArray) (keys : List ByteArray := []) (args : List ByteArray := []) : EIO Error ByteArray :=
+def evalsha (ctx : Ctx) (sha1 : ByteArray) (keys : Array ByteArray := #[]) (args : Array ByteArray := #[]) : EIO Error ByteArray :=
   Internal.evalsha ctx sha1 keys args
 
 def scriptload (ctx : Ctx) (script : ByteArray) : EIO Error ByteArray := Internal.scriptload ctx script
 
-def scriptexists (ctx : Ctx) (sha1s : List ByteArray) : EIO Error (List Bool) := Internal.scriptexists ctx sha1s
+def scriptexists (ctx : Ctx) (sha1s : Array ByteArray) : EIO Error (List Bool) := Internal.scriptexists ctx sha1s
 
 def scriptflush (ctx : Ctx) : EIO Error Unit := Internal.scriptflush ctx
 
@@ -1035,10 +1158,10 @@ def slowloglen (ctx : Ctx) : EIO Error UInt64 := Internal.slowloglen ctx
 def slowlogreset (ctx : Ctx) : EIO Error Unit := Internal.slowlogreset ctx
 
 -- Redis Streams operations
-def xadd (ctx : Ctx) (key stream_id : ByteArray) (field_values : List (ByteArray × ByteArray)) (maxlen_opt : Option UInt64 := none) : EIO Error ByteArray :=
+def xadd (ctx : Ctx) (key stream_id : ByteArray) (field_values : Array (ByteArray × ByteArray)) (maxlen_opt : Option UInt64 := none) : EIO Error ByteArray :=
   Internal.xadd ctx key stream_id field_values maxlen_opt
 
-def xread (ctx : Ctx) (streams : List (ByteArray × ByteArray)) (count_opt : Option UInt64 := none) (block_opt : Option UInt64 := none) : EIO Error ByteArray :=
+def xread (ctx : Ctx) (streams : Array (ByteArray × ByteArray)) (count_opt : Option UInt64 := none) (block_opt : Option UInt64 := none) : EIO Error StreamRead :=
   Internal.xread ctx streams count_opt block_opt
 
 def xrange (ctx : Ctx) (key start_id end_id : ByteArray) (count_opt : Option UInt64 := none) : EIO Error ByteArray :=
@@ -1046,12 +1169,12 @@ def xrange (ctx : Ctx) (key start_id end_id : ByteArray) (count_opt : Option UIn
 
 def xlen (ctx : Ctx) (key : ByteArray) : EIO Error UInt64 := Internal.xlen ctx key
 
-def xdel (ctx : Ctx) (key : ByteArray) (entry_ids : List ByteArray) : EIO Error UInt64 := Internal.xdel ctx key entry_ids
+def xdel (ctx : Ctx) (key : ByteArray) (entry_ids : Array ByteArray) : EIO Error UInt64 := Internal.xdel ctx key entry_ids
 
 def xtrim (ctx : Ctx) (key strategy : ByteArray) (max_len : UInt64) : EIO Error UInt64 := Internal.xtrim ctx key strategy max_len
 
 -- Consumer group operations
-def xreadgroup (ctx : Ctx) (group consumer stream : String) (count : UInt64) : EIO Error ByteArray :=
+def xreadgroup (ctx : Ctx) (group consumer stream : String) (count : UInt64) : EIO Error StreamRead :=
   Internal.xreadgroup ctx group consumer stream count
 
 def xack (ctx : Ctx) (stream group msgid : String) : EIO Error UInt64 :=
@@ -1082,16 +1205,16 @@ def InsertPosition.toUInt8 : InsertPosition → UInt8
   | .before => 0
   | .after => 1
 
-def lpush (ctx : Ctx) (key : ByteArray) (elements : List ByteArray) : EIO Error UInt64 :=
+def lpush (ctx : Ctx) (key : ByteArray) (elements : Array ByteArray) : EIO Error UInt64 :=
   Internal.lpush ctx key elements
 
-def rpush (ctx : Ctx) (key : ByteArray) (elements : List ByteArray) : EIO Error UInt64 :=
+def rpush (ctx : Ctx) (key : ByteArray) (elements : Array ByteArray) : EIO Error UInt64 :=
   Internal.rpush ctx key elements
 
-def lpushx (ctx : Ctx) (key : ByteArray) (elements : List ByteArray) : EIO Error UInt64 :=
+def lpushx (ctx : Ctx) (key : ByteArray) (elements : Array ByteArray) : EIO Error UInt64 :=
   Internal.lpushx ctx key elements
 
-def rpushx (ctx : Ctx) (key : ByteArray) (elements : List ByteArray) : EIO Error UInt64 :=
+def rpushx (ctx : Ctx) (key : ByteArray) (elements : Array ByteArray) : EIO Error UInt64 :=
   Internal.rpushx ctx key elements
 
 def lpop (ctx : Ctx) (key : ByteArray) (count : Option UInt64 := none) : EIO Error (List ByteArray) :=
@@ -1103,6 +1226,9 @@ def rpop (ctx : Ctx) (key : ByteArray) (count : Option UInt64 := none) : EIO Err
 def lrange (ctx : Ctx) (key : ByteArray) (start stop : Int64) : EIO Error (List ByteArray) :=
   Internal.lrange ctx key start stop
 
+def lrangeArray (ctx : Ctx) (key : ByteArray) (start stop : Int64) : EIO Error (Array ByteArray) :=
+  Internal.lrangeArray ctx key start stop
+
 def lindex (ctx : Ctx) (key : ByteArray) (index : Int64) : EIO Error ByteArray :=
   Internal.lindex ctx key index
 
@@ -1127,19 +1253,19 @@ def lpos (ctx : Ctx) (key element : ByteArray) (rank : Option UInt64 := none) (c
 def lmove (ctx : Ctx) (src dst : ByteArray) (srcDir dstDir : ListDirection) : EIO Error ByteArray :=
   Internal.lmove ctx src dst srcDir.toUInt8 dstDir.toUInt8
 
-def lmpop (ctx : Ctx) (keys : List ByteArray) (direction : ListDirection) (count : Option UInt64 := none) : EIO Error (Option (ByteArray × List ByteArray)) :=
+def lmpop (ctx : Ctx) (keys : Array ByteArray) (direction : ListDirection) (count : Option UInt64 := none) : EIO Error (Option (ByteArray × List ByteArray)) :=
   Internal.lmpop ctx keys direction.toUInt8 count
 
-def blpop (ctx : Ctx) (keys : List ByteArray) (timeout : Float) : EIO Error (Option (ByteArray × ByteArray)) :=
+def blpop (ctx : Ctx) (keys : Array ByteArray) (timeout : Float) : EIO Error (Option (ByteArray × ByteArray)) :=
   Internal.blpop ctx keys timeout
 
-def brpop (ctx : Ctx) (keys : List ByteArray) (timeout : Float) : EIO Error (Option (ByteArray × ByteArray)) :=
+def brpop (ctx : Ctx) (keys : Array ByteArray) (timeout : Float) : EIO Error (Option (ByteArray × ByteArray)) :=
   Internal.brpop ctx keys timeout
 
 def blmove (ctx : Ctx) (src dst : ByteArray) (srcDir dstDir : ListDirection) (timeout : Float) : EIO Error (Option ByteArray) :=
   Internal.blmove ctx src dst srcDir.toUInt8 dstDir.toUInt8 timeout
 
-def blmpop (ctx : Ctx) (timeout : Float) (keys : List ByteArray) (direction : ListDirection) (count : Option UInt64 := none) : EIO Error (Option (ByteArray × List ByteArray)) :=
+def blmpop (ctx : Ctx) (timeout : Float) (keys : Array ByteArray) (direction : ListDirection) (count : Option UInt64 := none) : EIO Error (Option (ByteArray × List ByteArray)) :=
   Internal.blmpop ctx timeout keys direction.toUInt8 count
 
 def rpoplpush (ctx : Ctx) (src dst : ByteArray) : EIO Error ByteArray :=
@@ -1169,13 +1295,16 @@ def getset (ctx : Ctx) (key value : ByteArray) : EIO Error ByteArray :=
 def incrByFloat (ctx : Ctx) (key : ByteArray) (increment : Float) : EIO Error Float :=
   Internal.incrbyfloat ctx key increment
 
-def mget (ctx : Ctx) (keys : List ByteArray) : EIO Error (List (Option ByteArray)) :=
+def mget (ctx : Ctx) (keys : Array ByteArray) : EIO Error (List (Option ByteArray)) :=
   Internal.mget ctx keys
 
-def mset (ctx : Ctx) (pairs : List (ByteArray × ByteArray)) : EIO Error Unit :=
+def mgetArray (ctx : Ctx) (keys : Array ByteArray) : EIO Error (Array (Option ByteArray)) :=
+  Internal.mgetArray ctx keys
+
+def mset (ctx : Ctx) (pairs : Array (ByteArray × ByteArray)) : EIO Error Unit :=
   Internal.mset ctx pairs
 
-def msetnx (ctx : Ctx) (pairs : List (ByteArray × ByteArray)) : EIO Error Bool :=
+def msetnx (ctx : Ctx) (pairs : Array (ByteArray × ByteArray)) : EIO Error Bool :=
   Internal.msetnx ctx pairs
 
 def setnx (ctx : Ctx) (key value : ByteArray) : EIO Error Bool :=
@@ -1196,7 +1325,7 @@ def lcs (ctx : Ctx) (key1 key2 : ByteArray) (getLen : Bool := false) (getIdx : B
 
 -- Set operations (additional)
 
-def srem (ctx : Ctx) (key : ByteArray) (members : List ByteArray) : EIO Error UInt64 :=
+def srem (ctx : Ctx) (key : ByteArray) (members : Array ByteArray) : EIO Error UInt64 :=
   Internal.srem ctx key members
 
 def spop (ctx : Ctx) (key : ByteArray) (count : Option UInt64 := none) : EIO Error (List ByteArray) :=
@@ -1208,28 +1337,28 @@ def srandmember (ctx : Ctx) (key : ByteArray) (count : Option UInt64 := none) :
 def smove (ctx : Ctx) (src dst member : ByteArray) : EIO Error Bool :=
   Internal.smove ctx src dst member
 
-def smismember (ctx : Ctx) (key : ByteArray) (members : List ByteArray) : EIO Error (List Bool) :=
+def smismember (ctx : Ctx) (key : ByteArray) (members : Array ByteArray) : EIO Error (List Bool) :=
   Internal.smismember ctx key members
 
-def sdiff (ctx : Ctx) (keys : List ByteArray) : EIO Error (List ByteArray) :=
+def sdiff (ctx : Ctx) (keys : Array ByteArray) : EIO Error (List ByteArray) :=
   Internal.sdiff ctx keys
 
-def sdiffstore (ctx : Ctx) (dst : ByteArray) (keys : List ByteArray) : EIO Error UInt64 :=
+def sdiffstore (ctx : Ctx) (dst : ByteArray) (keys : Array ByteArray) : EIO Error UInt64 :=
   Internal.sdiffstore ctx dst keys
 
-def sinter (ctx : Ctx) (keys : List ByteArray) : EIO Error (List ByteArray) :=
+def sinter (ctx : Ctx) (keys : Array ByteArray) : EIO Error (List ByteArray) :=
   Internal.sinter ctx keys
 
-def sinterstore (ctx : Ctx) (dst : ByteArray) (keys : List ByteArray) : EIO Error UInt64 :=
+def sinterstore (ctx : Ctx) (dst : ByteArray) (keys : Array ByteArray) : EIO Error UInt64 :=
   Internal.sinterstore ctx dst keys
 
-def sintercard (ctx : Ctx) (keys : List ByteArray) (limit : Option UInt64 := none) : EIO Error UInt64 :=
+def sintercard (ctx : Ctx) (keys : Array ByteArray) (limit : Option UInt64 := none) : EIO Error UInt64 :=
   Internal.sintercard ctx keys limit
 
-def sunion (ctx : Ctx) (keys : List ByteArray) : EIO Error (List ByteArray) :=
+def sunion (ctx : Ctx) (keys : Array ByteArray) : EIO Error (List ByteArray) :=
   Internal.sunion ctx keys
 
-def sunionstore (ctx : Ctx) (dst : ByteArray) (keys : List ByteArray) : EIO Error UInt64 :=
+def sunionstore (ctx : Ctx) (dst : ByteArray) (keys : Array ByteArray) : EIO Error UInt64 :=
   Internal.sunionstore ctx dst keys
 
 def sscan (ctx : Ctx) (key : ByteArray) (cursor : UInt64) (pattern : Option ByteArray := none) (count : Option UInt64 := none) : EIO Error (UInt64 × List ByteArray) :=
@@ -1264,10 +1393,10 @@ def renamenx (ctx : Ctx) (key newkey : ByteArray) : EIO Error Bool :=
 def copy (ctx : Ctx) (src dst : ByteArray) (replace : Bool := false) : EIO Error Bool :=
   Internal.copyKey ctx src dst (if replace then 1 else 0)
 
-def unlink (ctx : Ctx) (keys : List ByteArray) : EIO Error UInt64 :=
+def unlink (ctx : Ctx) (keys : Array ByteArray) : EIO Error UInt64 :=
   Internal.unlink ctx keys
 
-def touch (ctx : Ctx) (keys : List ByteArray) : EIO Error UInt64 :=
+def touch (ctx : Ctx) (keys : Array ByteArray) : EIO Error UInt64 :=
   Internal.touch ctx keys
 
 def expiretime (ctx : Ctx) (key : ByteArray) : EIO Error Int64 :=
@@ -1287,10 +1416,10 @@ def hvals (ctx : Ctx) (key : ByteArray) : EIO Error (List ByteArray) :=
 def hsetnx (ctx : Ctx) (key field value : ByteArray) : EIO Error Bool :=
   Internal.hsetnx ctx key field value
 
-def hmget (ctx : Ctx) (key : ByteArray) (fields : List ByteArray) : EIO Error (List (Option ByteArray)) :=
+def hmget (ctx : Ctx) (key : ByteArray) (fields : Array ByteArray) : EIO Error (List (Option ByteArray)) :=
   Internal.hmget ctx key fields
 
-def hmset (ctx : Ctx) (key : ByteArray) (pairs : List (ByteArray × ByteArray)) : EIO Error Unit :=
+def hmset (ctx : Ctx) (key : ByteArray) (pairs : Array (ByteArray × ByteArray)) : EIO Error Unit :=
   Internal.hmset ctx key pairs
 
 def hincrByFloat (ctx : Ctx) (key field : ByteArray) (increment : Float) : EIO Error Float :=
@@ -1383,83 +1512,144 @@ def getError (ctx : Ctx) : EIO Error (Option String) :=
 def clearError (ctx : Ctx) : EIO Error Unit :=
   Internal.clearError ctx
 
+/-- Bytes written to and read from the socket since the connection was opened -/
+def ioStats (ctx : Ctx) : BaseIO (Nat × Nat) := do
+  let (written, read) ← Internal.ioStats ctx
+  return (written.toNat, read.toNat)
+
+/-- Bytes written and read since the previous call, to charge them to the
+    command that just ran -/
+def ioTake (ctx : Ctx) : BaseIO (Nat × Nat) := do
+  let written ← Internal.ioTakeWritten ctx
+  let read ← Internal.ioTakeRead ctx
+  return (written.toNat, read.toNat)
+
+/-- Start timing the phases of the next command on the connection (see
+    `ioPhaseTake`). Timing stays on for the connection once started. -/
+def ioPhaseStart (ctx : Ctx) : BaseIO Unit :=
+  Internal.ioPhaseStart ctx
+
+/-- Stamps left by the command since `ioPhaseStart`, on the clock of
+    `IO.monoNanosNow`: start of its first write, end of its reply parsing
+    (0 when it did not happen), then nanoseconds spent in socket reads and
+    writes and in building reply objects -/
+def ioPhaseTake (ctx : Ctx) : BaseIO (Nat × Nat × Nat × Nat) := do
+  let (firstWrite, parseEnd, ioNs, objectNs) ← Internal.ioPhaseTake ctx
+  return (firstWrite.toNat, parseEnd.toNat, ioNs.toNat, objectNs.toNat)
+
 /-! ## Pipeline Support -/
 
 /-- Append a command to the output buffer (no network round-trip yet) -/
 def appendCommand (ctx : Ctx) (command : String) : EIO Error Unit :=
   Internal.appendCommand ctx command
 
-/-- Append a command with arguments to the output buffer -/
-def appendCommandArgv (ctx : Ctx) (args : List ByteArray) : EIO Error Unit :=
+/-- Append a command with arguments to the output buffer (binary safe) -/
+def appendCommandArgv (ctx : Ctx) (args : Array ByteArray) : EIO Error Unit :=
   Internal.appendCommandArgv ctx args
 
-/-- Get the next reply from the pipeline -/
-def getReply (ctx : Ctx) : EIO Error ByteArray :=
+/-- Get the next reply from the pipeline (an error reply is raised as `Error.replyError`) -/
+def getReply (ctx : Ctx) : EIO Error Reply :=
   Internal.getReply ctx
 
 /-- Flush the output buffer (send all pending commands) -/
 def flushPipeline (ctx : Ctx) : EIO Error Unit :=
   Internal.flushPipeline ctx
 
-/-- Pipeline builder for batching commands -/
+/-- Send a batch of commands and collect their replies in a single FFI call
+    (append all, flush once, read all). Error replies are returned in place
+    as `Reply.error`; only I/O and protocol errors fail the whole batch. -/
+def pipelineExec (ctx : Ctx) (commands : Array (Array ByteArray)) : EIO Error (Array Reply) :=
+  Internal.pipelineExec ctx commands
+
+/-- Pipeline builder for batching commands.
+    Commands are stored as argument vectors, so keys and values may contain
+    spaces, quotes or arbitrary bytes. -/
 structure PipelineBuilder where
-  commands : Array String
-  deriving Repr
+  commands : Array (Array ByteArray)
 
 namespace PipelineBuilder
 
 /-- Create an empty pipeline builder -/
 def empty : PipelineBuilder := ⟨#[]⟩
 
-/-- Add a command to the pipeline -/
+/-- Add a command given as an argument vector -/
+def addArgv (pb : PipelineBuilder) (args : Array ByteArray) : PipelineBuilder :=
+  ⟨pb.commands.push args⟩
+
+/-- Add a command given as string arguments -/
+def addArgs (pb : PipelineBuilder) (args : Array String) : PipelineBuilder :=
+  pb.addArgv (args.map String.toUTF8)
+
+/-- Add a command written as a single string, split on runs of whitespace
+    (spaces, tabs, newlines; use `addArgs`/`addArgv` for values containing
+    whitespace) -/
 def add (pb : PipelineBuilder) (cmd : String) : PipelineBuilder :=
-  ⟨pb.commands.push cmd⟩
+  pb.addArgs ((cmd.split Char.isWhitespace |>.toList).map (·.toString)
+    |>.filter (· ≠ "")).toArray
 
 /-- Add SET command to pipeline -/
 def set (pb : PipelineBuilder) (key value : String) : PipelineBuilder :=
-  pb.add s!"SET {key} {value}"
+  pb.addArgs #["SET", key, value]
 
 /-- Add GET command to pipeline -/
 def get (pb : PipelineBuilder) (key : String) : PipelineBuilder :=
-  pb.add s!"GET {key}"
+  pb.addArgs #["GET", key]
 
 /-- Add INCR command to pipeline -/
 def incr (pb : PipelineBuilder) (key : String) : PipelineBuilder :=
-  pb.add s!"INCR {key}"
+  pb.addArgs #["INCR", key]
 
 /-- Add DEL command to pipeline -/
 def del (pb : PipelineBuilder) (key : String) : PipelineBuilder :=
-  pb.add s!"DEL {key}"
+  pb.addArgs #["DEL", key]
 
 /-- Add HSET command to pipeline -/
 def hset (pb : PipelineBuilder) (key field value : String) : PipelineBuilder :=
-  pb.add s!"HSET {key} {field} {value}"
+  pb.addArgs #["HSET", key, field, value]
 
 /-- Add HGET command to pipeline -/
 def hget (pb : PipelineBuilder) (key field : String) : PipelineBuilder :=
-  pb.add s!"HGET {key} {field}"
+  pb.addArgs #["HGET", key, field]
+
+/-- Add MGET command to pipeline (decode the reply with `Reply.optBytesArray?`) -/
+def mget (pb : PipelineBuilder) (keys : Array String) : PipelineBuilder :=
+  pb.addArgs (#["MGET"] ++ keys)
+
+/-- Add LRANGE command to pipeline (decode the reply with `Reply.bytesArray?`) -/
+def lrange (pb : PipelineBuilder) (key : String) (start stop : Int) : PipelineBuilder :=
+  pb.addArgs #["LRANGE", key, toString start, toString stop]
+
+/-- Add SMEMBERS command to pipeline (decode the reply with `Reply.bytesArray?`) -/
+def smembers (pb : PipelineBuilder) (key : String) : PipelineBuilder :=
+  pb.addArgs #["SMEMBERS", key]
+
+/-- Add HGETALL command to pipeline (decode the reply with `Reply.bytesPairs?`) -/
+def hgetall (pb : PipelineBuilder) (key : String) : PipelineBuilder :=
+  pb.addArgs #["HGETALL", key]
+
+/-- Add ZRANGE command to pipeline (decode the reply with `Reply.bytesArray?`) -/
+def zrange (pb : PipelineBuilder) (key : String) (start stop : Int) : PipelineBuilder :=
+  pb.addArgs #["ZRANGE", key, toString start, toString stop]
+
+/-- Add MULTI to pipeline -/
+def multi (pb : PipelineBuilder) : PipelineBuilder :=
+  pb.addArgs #["MULTI"]
+
+/-- Add EXEC to pipeline; its reply is the array of the queued commands' replies -/
+def exec (pb : PipelineBuilder) : PipelineBuilder :=
+  pb.addArgs #["EXEC"]
 
 /-- Number of commands in pipeline -/
 def size (pb : PipelineBuilder) : Nat := pb.commands.size
 
 end PipelineBuilder
 
-/-- Execute a pipeline and return all replies -/
-def executePipeline (ctx : Ctx) (pb : PipelineBuilder) : EIO Error (Array ByteArray) := do
-  -- Send all commands
-  for cmd in pb.commands do
-    appendCommand ctx cmd
-  -- Flush to send
-  flushPipeline ctx
-  -- Collect all replies
-  let mut replies : Array ByteArray := #[]
-  for _ in [:pb.commands.size] do
-    let reply ← getReply ctx
-    replies := replies.push reply
-  return replies
+/-- Execute a pipeline and return all replies (see `pipelineExec`) -/
+def executePipeline (ctx : Ctx) (pb : PipelineBuilder) : EIO Error (Array Reply) :=
+  pipelineExec ctx pb.commands
 
 /-- Execute pipeline with a builder function -/
-def withPipeline (ctx : Ctx) (build : PipelineBuilder → PipelineBuilder) : EIO Error (Array ByteArray) := do
+def withPipeline (ctx : Ctx) (build : PipelineBuilder → PipelineBuilder) : EIO Error (Array Reply) := do
   let pb := build PipelineBuilder.empty
   executePipeline ctx pb
 
@@ -1486,11 +1676,11 @@ def bufferRead (ctx : Ctx) : EIO Error Unit :=
   Internal.bufferRead ctx
 
 /-- Try to get a reply from input buffer (non-blocking, returns None if not ready) -/
-def getReplyNonBlock (ctx : Ctx) : EIO Error (Option ByteArray) :=
+def getReplyNonBlock (ctx : Ctx) : EIO Error (Option Reply) :=
   Internal.getReplyNonBlock ctx
 
 /-- Poll for a reply with timeout (milliseconds). Returns None on timeout. -/
-def pollReply (ctx : Ctx) (timeoutMs : UInt64) : EIO Error (Option ByteArray) := do
+def pollReply (ctx : Ctx) (timeoutMs : UInt64) : EIO Error (Option Reply) := do
   -- Check if data is available
   let readable ← canRead ctx timeoutMs
   if !readable then
@@ -1500,6 +1690,64 @@ def pollReply (ctx : Ctx) (timeoutMs : UInt64) : EIO Error (Option ByteArray) :=
   -- Try to get reply
   getReplyNonBlock ctx
 
+/-! ## Async Engine
+
+A connection driven by a dedicated C I/O thread (epoll over a hiredis
+`redisAsyncContext`). `sendAsync` queues the command and returns at once with
+a task that completes when the reply arrives, so a single Lean thread can keep
+many requests in flight on one connection. Replies come back in command order.
+-/
+
+namespace Async
+
+/-- Handle to an async engine (distinct from the blocking `FFI.Ctx`) -/
+abbrev Ctx := AsyncEngine
+
+/-- Open an async connection and start its I/O thread. The TCP connect itself
+    completes in the background; commands sent meanwhile are queued. -/
+def connect (host := "127.0.0.1") (port : UInt32 := 6379) : EIO Error Ctx :=
+  Internal.asyncConnect host port
+
+/-- Send a command without waiting for the reply. A top-level error reply
+    completes the task with `Error.replyError`. -/
+def sendAsync (ctx : Ctx) (args : Array ByteArray) : IO (Task (Except Error Reply)) := do
+  let promise ← IO.Promise.new
+  match ← (Internal.asyncSend ctx args fun r => promise.resolve r).toBaseIO with
+  | .ok () =>
+    return promise.result?.map fun
+      | some r => r
+      | none => .error (.otherError "async request dropped")
+  | .error e => return .pure (.error e)
+
+/-- Send a command and wait for its reply -/
+def send (ctx : Ctx) (args : Array ByteArray) : EIO Error Reply := do
+  let task ← IO.toEIO (fun e => .otherError (toString e)) (sendAsync ctx args)
+  match ← IO.wait task with
+  | .ok r => return r
+  | .error e => throw e
+
+/-- Send a batch of commands back to back and wait for all replies -/
+def sendAll (ctx : Ctx) (commands : Array (Array ByteArray)) : EIO Error (Array Reply) := do
+  let tasks ← commands.mapM fun args => IO.toEIO (fun e => .otherError (toString e)) (sendAsync ctx args)
+  tasks.mapM fun t => do
+    match ← IO.wait t with
+    | .ok r => return r
+    | .error e => throw e
+
+/-- Wait for in-flight replies and stop the I/O thread. Closing twice is
+    harmless; commands sent afterwards fail. -/
+def close (ctx : Ctx) : IO Unit :=
+  Internal.asyncClose ctx
+
+/-- Run an action with an async connection, closing it afterwards -/
+def withAsync (host := "127.0.0.1") (port : UInt32 := 6379) (f : Ctx → EIO Error α) : EIO Error α := do
+  let ctx ← connect host port
+  try f ctx
+  finally
+    let _ ← (close ctx).toBaseIO
+
+end Async
+
 end FFI
 
 end Redis
@@ -0,0 +1,124 @@
+namespace Redis
+
+/-!
+# Histogram
+
+Log-linear latency histogram in the style of HdrHistogram: values below
+`subBuckets` get a bucket each, then every power of two `[2^m, 2^(m+1))` is
+split into `subBuckets` equal buckets. A bucket is therefore never wider than
+`1 / subBuckets` of its values (about 3%), whatever the magnitude, and a
+histogram of microsecond latencies up to an hour needs about a thousand
+counters.
+
+Recording is O(1), two histograms merge by adding their counters and
+percentiles are read in one pass over the buckets. Count, sum, min and max
+are kept exactly.
+-/
+
+/-- Bits of sub-bucket resolution: `2^precisionBits` buckets per power of two -/
+def Histogram.precisionBits : Nat := 5
+
+structure Histogram where
+  /-- Samples per bucket; grows up to the highest bucket used -/
+  counts : Array Nat := #[]
+  count : Nat := 0
+  sum : Nat := 0
+  /-- Smallest and largest sample (meaningful when `count > 0`) -/
+  min : Nat := 0
+  max : Nat := 0
+  deriving Repr, Inhabited
+
+namespace Histogram
+
+def subBuckets : Nat := 2 ^ precisionBits
+
+def empty : Histogram := {}
+
+/-- Bucket holding `v` -/
+def bucketOf (v : Nat) : Nat :=
+  if v < subBuckets then v
+  else
+    let shift := Nat.log2 v - precisionBits
+    (shift + 1) * subBuckets + ((v >>> shift) - subBuckets)
+
+/-- Smallest value of a bucket -/
+def lowerBound (bucket : Nat) : Nat :=
+  if bucket < subBuckets then bucket
+  else
+    let shift := bucket / subBuckets - 1
+    (subBuckets + bucket % subBuckets) <<< shift
+
+/-- Largest value of a bucket -/
+def upperBound (bucket : Nat) : Nat :=
+  if bucket < subBuckets then bucket
+  else lowerBound bucket + (1 <<< (bucket / subBuckets - 1)) - 1
+
+/-- Add a sample. The fields are taken apart first so that an unshared
+    histogram is updated in place. -/
+def record (h : Histogram) (v : Nat) : Histogram :=
+  let ⟨counts, count, sum, lo, hi⟩ := h
+  let b := bucketOf v
+  let counts := if b < counts.size then counts
+    else counts ++ Array.replicate (b + 1 - counts.size) 0
+  { counts := counts.modify b (· + 1),
+    count := count + 1,
+    sum := sum + v,
+    min := if count == 0 then v else Nat.min lo v,
+    max := if count == 0 then v else Nat.max hi v }
+
+/-- Histogram of both sets of samples -/
+def merge (a b : Histogram) : Histogram :=
+  if a.count == 0 then b
+  else if b.count == 0 then a
+  else
+    let (big, small) := if a.counts.size >= b.counts.size then (a.counts, b.counts) else (b.counts, a.counts)
+    { counts := (Array.range small.size).foldl (fun cs i => cs.modify i (· + small[i]!)) big,
+      count := a.count + b.count,
+      sum := a.sum + b.sum,
+      min := Nat.min a.min b.min,
+      max := Nat.max a.max b.max }
+
+instance : Append Histogram := ⟨merge⟩
+
+def mean (h : Histogram) : Float :=
+  if h.count == 0 then 0 else h.sum.toFloat / h.count.toFloat
+
+/-- Value at quantile `q` (between 0 and 1): the largest value of the bucket
+    holding the sample of that rank, within the exact min and max; 0 when
+    empty -/
+def quantile (h : Histogram) (q : Float) : Nat := Id.run do
+  if h.count == 0 then return 0
+  let rank := Nat.max 1 (Nat.min h.count (q * h.count.toFloat).ceil.toUInt64.toNat)
+  let mut seen := 0
+  for i in [:h.counts.size] do
+    seen := seen + h.counts[i]!
+    if seen >= rank then
+      return Nat.max h.min (Nat.min h.max (upperBound i))
+  return h.max
+
+/-- Value at percentile `p` (between 0 and 100) -/
+def percentile (h : Histogram) (p : Nat) : Nat :=
+  h.quantile (p.toFloat / 100)
+
+/-- Non-empty buckets as (upper bound, count), in increasing order -/
+def buckets (h : Histogram) : Array (Nat × Nat) :=
+  (Array.range h.counts.size).filterMap fun i =>
+    if h.counts[i]! > 0 then some (upperBound i, h.counts[i]!) else none
+
+/-- Samples at or below each of the increasing `bounds`, counting the bucket
+    that holds a bound as below it (so within the bucket precision) -/
+def cumulative (h : Histogram) (bounds : Array Nat) : Array Nat := Id.run do
+  let mut out := #[]
+  let mut seen := 0
+  let mut i := 0
+  for bound in bounds do
+    let last := bucketOf bound
+    while i < h.counts.size && i <= last do
+      seen := seen + h.counts[i]!
+      i := i + 1
+    out := out.push seen
+  return out
+
+end Histogram
+
+end Redis
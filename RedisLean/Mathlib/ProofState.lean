@@ -282,24 +282,18 @@ def getStep (config : ProofStateConfig) (sessionId : String) (stepId : Nat) : Re
   | .ok s => return some s
   | .error _ => return none
 
-/-- Get all steps for a session -/
-def getAllSteps (config : ProofStateConfig) (sessionId : String) : RedisM (List ProofSnapshot) := do
+/-- Get all steps for a session (step snapshots are fetched with a single MGET) -/
+def getAllSteps (config : ProofStateConfig) (sessionId : String) : RedisM (Array ProofSnapshot) := do
   let stepsKey := s!"{config.keyPrefix}:proof:steps:{sessionId}"
-  let stepNums ← zrange stepsKey 0 (-1)
-
-  let mut snapshots : List ProofSnapshot := []
-  for numBs in stepNums do
-    match String.fromUTF8? numBs with
-    | some numStr =>
-      match numStr.toNat? with
-      | some n =>
-        match ← getStep config sessionId n with
-        | some s => snapshots := s :: snapshots
-        | none => pure ()
-      | none => pure ()
-    | none => pure ()
-
-  return snapshots.reverse
+  let stepNums ← zrangeArray stepsKey 0 (-1)
+  let stepKeys := stepNums.filterMap fun numBs => do
+    let n ← (← String.fromUTF8? numBs).toNat?
+    return proofStepKey config.keyPrefix sessionId n
+
+  let values ← mgetArray stepKeys
+  return values.filterMap fun
+    | some bs => (Codec.dec (α := ProofSnapshot) bs).toOption
+    | none => none
 
 /-- Get the tactic trace for a session -/
 def getTrace (config : ProofStateConfig) (sessionId : String) : RedisM (List TacticTraceEntry) := do
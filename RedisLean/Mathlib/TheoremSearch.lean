@@ -166,28 +166,29 @@ def searchByHypothesis (search : TheoremSearch) (pattern : TypePattern) (limit :
   return searchResults.reverse
 
 /-- Search theorems by name pattern (prefix match) -/
-def searchByName (search : TheoremSearch) (pattern : String) (limit : Nat := 20) : RedisM (List SearchResult) := do
+def searchByName (search : TheoremSearch) (pattern : String) (limit : Nat := 20) : RedisM (Array SearchResult) := do
   -- Get all theorem names
-  let allNames ← smembers s!"{search.keyPrefix}:thm:all"
+  let allNames ← smembersArray s!"{search.keyPrefix}:thm:all"
   let nameStrs := allNames.filterMap String.fromUTF8?
 
   -- Filter by pattern
   let matching := nameStrs.filter fun name =>
     containsSubstr name pattern || containsSubstr name.toLower pattern.toLower
-
-  -- Load theorem info for matching names
-  let mut searchResults : List SearchResult := []
-  for name in matching.take limit do
-    let nameKey := theoremNameKey search.keyPrefix name
-    let keyExists ← existsKey nameKey
-    if keyExists then
-      let bs ← get nameKey
+  let matching := matching.extract 0 limit
+
+  -- Load theorem info for matching names in one round trip
+  let values ← mgetArray (matching.map (theoremNameKey search.keyPrefix))
+  let mut searchResults : Array SearchResult := #[]
+  for (name, value) in matching.zip values do
+    match value with
+    | some bs =>
       match Codec.dec (α := TheoremInfo) bs with
       | .ok thm =>
         -- Score based on name length and match
         let score := 1000.0 - Float.ofNat name.length
-        searchResults := { theoremInfo := thm, score } :: searchResults
+        searchResults := searchResults.push { theoremInfo := thm, score }
       | .error _ => pure ()
+    | none => pure ()
 
   return searchResults
 
@@ -1,6 +1,10 @@
 import Std.Data.HashMap
 import Lean.Data.Json
+import RedisLean.Enums
 import RedisLean.Log
+import RedisLean.Histogram
+import RedisLean.Prometheus
+import RedisLean.ServerStats
 
 namespace Redis
 
@@ -13,8 +17,8 @@ structure LatencyStats where
 
 /-- Trace record for individual command execution -/
 structure Trace where
-  /-- Unique trace identifier -/
-  traceId : String
+  /-- Trace identifier, unique within a `Metrics` (see `idString`) -/
+  traceId : UInt64
   /-- Command name -/
   command : String
   /-- Start time in nanoseconds -/
@@ -43,8 +47,101 @@ def durationMs (t : Trace) : Nat :=
 def isSlow (t : Trace) (thresholdMs : Nat) : Bool :=
   t.durationMs > thresholdMs
 
+/-- Trace identifier as 16 hexadecimal digits -/
+def idString (t : Trace) : String :=
+  let digits := Nat.toDigits 16 t.traceId.toNat
+  digits.foldl (·.push ·) ("".pushn '0' (16 - digits.length))
+
+def toJson (t : Trace) : Lean.Json :=
+  Lean.Json.mkObj [
+    ("traceId", Lean.Json.str t.idString),
+    ("command", Lean.Json.str t.command),
+    ("startTimeNs", Lean.Json.num t.startTimeNs),
+    ("durationUs", Lean.Json.num t.durationUs),
+    ("success", Lean.Json.bool t.success),
+    ("error", match t.errorMsg with | some e => Lean.Json.str e | none => Lean.Json.null),
+    ("tags", Lean.Json.mkObj (t.tags.map fun (k, v) => (k, Lean.Json.str v)))
+  ]
+
 end Trace
 
+/-- Most recent traces in preallocated slots: once full, each new trace
+    overwrites the oldest in place -/
+structure TraceRing where
+  slots : Array (Option Trace)
+  /-- Traces pushed so far; the next one goes to slot `pushed % capacity` -/
+  pushed : Nat := 0
+
+namespace TraceRing
+
+def create (capacity : Nat) : TraceRing :=
+  { slots := Array.replicate capacity none }
+
+def capacity (r : TraceRing) : Nat := r.slots.size
+
+/-- Traces held -/
+def size (r : TraceRing) : Nat := Nat.min r.pushed r.capacity
+
+def push (r : TraceRing) (t : Trace) : TraceRing :=
+  let ⟨slots, pushed⟩ := r
+  if slots.size == 0 then ⟨slots, pushed⟩
+  else ⟨slots.set! (pushed % slots.size) (some t), pushed + 1⟩
+
+/-- The `n` most recent traces, oldest first -/
+def recent (r : TraceRing) (n : Nat) : Array Trace := Id.run do
+  let k := Nat.min n r.size
+  let mut out := Array.emptyWithCapacity k
+  for i in [r.pushed - k : r.pushed] do
+    if let some t := r.slots[i % r.capacity]! then
+      out := out.push t
+  return out
+
+/-- Ring of another capacity with the most recent traces of `r` -/
+def resize (r : TraceRing) (capacity : Nat) : TraceRing :=
+  (r.recent capacity).foldl push (create capacity)
+
+end TraceRing
+
+/-- Which traces are kept. Head sampling keeps a `rate` fraction of the
+    commands, chosen from the trace id so the decision is free and the same
+    wherever it is taken; tail sampling looks at the outcome: errors can be
+    kept whatever the rate, and fast commands dropped. -/
+structure TraceSampling where
+  /-- Fraction of commands traced, between 0 and 1 -/
+  rate : Float := 1.0
+  /-- Keep every failed command -/
+  keepErrors : Bool := true
+  /-- Keep successful commands only when at least this slow (0: all) -/
+  minDurationUs : Nat := 0
+  deriving Repr
+
+namespace TraceSampling
+
+/-- Keep only failed commands -/
+def errorsOnly : TraceSampling := { rate := 0 }
+
+/-- Keep commands at least `us` microseconds long, and failed ones -/
+def slowOnly (us : Nat) : TraceSampling := { minDurationUs := us }
+
+/-- Keep a `rate` fraction of the commands, and failed ones -/
+def ratio (rate : Float) : TraceSampling := { rate }
+
+-- finalizer of splitmix64: spreads consecutive ids over the whole range
+private def mix (x : UInt64) : UInt64 :=
+  let x := (x ^^^ (x >>> 30)) * 0xbf58476d1ce4e5b9
+  let x := (x ^^^ (x >>> 27)) * 0x94d049bb133111eb
+  x ^^^ (x >>> 31)
+
+/-- Head decision for a trace id -/
+def sampled (s : TraceSampling) (traceId : UInt64) : Bool :=
+  s.rate >= 1.0 || (s.rate > 0 && (mix traceId).toFloat < s.rate * 18446744073709551616.0)
+
+/-- Whether a finished command is kept -/
+def keep (s : TraceSampling) (traceId : UInt64) (success : Bool) (durationUs : Nat) : Bool :=
+  (!success && s.keepErrors) || (durationUs >= s.minDurationUs && s.sampled traceId)
+
+end TraceSampling
+
 /-- Metrics snapshot at a point in time -/
 structure MetricsSnapshot where
   /-- Timestamp in nanoseconds -/
@@ -61,61 +158,141 @@ structure MetricsSnapshot where
   bytesWritten : Nat
   /-- Total bytes read -/
   bytesRead : Nat
+  /-- P99 bytes written per command -/
+  p99RequestBytes : Nat
+  /-- P99 bytes read per reply -/
+  p99ReplyBytes : Nat
   deriving Repr
 
+/-- Where the time of a command goes on the client side -/
+inductive LatencyPhase where
+  /-- From the call to the first socket write: Lean→C argument conversion and
+      command formatting -/
+  | marshal
+  /-- Inside socket writes and reads: the network and the server -/
+  | network
+  /-- Reply parsing, outside socket calls and object building -/
+  | decode
+  /-- Building the reply objects and the result handed back to Lean -/
+  | alloc
+  deriving Repr, BEq, Inhabited
+
+namespace LatencyPhase
+
+def all : Array LatencyPhase := #[.marshal, .network, .decode, .alloc]
+
+def index : LatencyPhase → Nat
+  | .marshal => 0
+  | .network => 1
+  | .decode => 2
+  | .alloc => 3
+
+instance : ToString LatencyPhase where
+  toString
+    | .marshal => "marshal"
+    | .network => "network"
+    | .decode => "decode"
+    | .alloc => "alloc"
+
+/-- Nanoseconds spent in each phase (by `index`) by a command that ran from
+    `startNs` to `endNs`, given the stamps its connection took (see
+    `FFI.ioPhaseTake`); `none` when it wrote nothing -/
+def split (startNs endNs : Nat) (stamps : Nat × Nat × Nat × Nat) : Option (Array Nat) :=
+  let (firstWrite, parseEnd, ioNs, objectNs) := stamps
+  if firstWrite == 0 then none
+  else
+    -- no reply parsed (an I/O error): the rest after writing counts as decoding
+    let parseEnd := if parseEnd == 0 then endNs else parseEnd
+    some #[firstWrite - startNs, ioNs, parseEnd - firstWrite - ioNs - objectNs,
+      objectNs + (endNs - parseEnd)]
+
+end LatencyPhase
+
+/-- Per-command histograms of one shard, indexed by `RedisCmd.index` -/
+structure CommandShard where
+  /-- Latency in microseconds -/
+  latency : Array Histogram := Array.replicate RedisCmd.count .empty
+  /-- Bytes written for the command -/
+  requestBytes : Array Histogram := Array.replicate RedisCmd.count .empty
+  /-- Bytes read for its reply -/
+  replyBytes : Array Histogram := Array.replicate RedisCmd.count .empty
+  /-- Nanoseconds in each `LatencyPhase` (by its index), all commands together -/
+  phases : Array Histogram := Array.replicate LatencyPhase.all.size .empty
+
 -- metrics collection for Redis operations
 structure Metrics where
-  -- command latency buckets (command name -> array of latencies in microseconds)
-  latencyBuckets : IO.Ref (Std.HashMap String (Array Nat))
+  -- command latency histograms (command name -> latencies in microseconds)
+  latencyBuckets : IO.Ref (Std.HashMap String Histogram)
   -- command counters (command name -> count)
   commandCounts : IO.Ref (Std.HashMap String Nat)
   -- error counts (error type -> count)
   errorCounts : IO.Ref (Std.HashMap String Nat)
   -- connection events (event_type, timestamp_us)
   connectionEvents : IO.Ref (Array (String × Nat))
-  -- traces (recent command traces)
-  traces : IO.Ref (Array Trace)
-  -- bytes written
+  -- traces (recent command traces, capacity set with `setMaxTraces`)
+  traces : IO.Ref TraceRing
+  -- which commands are traced
+  traceSampling : IO.Ref TraceSampling
+  -- last trace id: a random prefix in the high 32 bits and a sequence number
+  traceSeq : IO.Ref UInt64
+  -- bytes written, besides those of the command shards
   bytesWritten : IO.Ref Nat
-  -- bytes read
+  -- bytes read, besides those of the command shards
   bytesRead : IO.Ref Nat
   -- slow commands (command name, duration_us) for commands exceeding threshold
   slowCommands : IO.Ref (Array (String × Nat))
   -- slow command threshold in milliseconds
   slowThresholdMs : IO.Ref Nat
-  -- maximum traces to retain
-  maxTraces : IO.Ref Nat
+  -- smoothed command latency per node (host:port -> EWMA in microseconds)
+  nodeLatency : IO.Ref (Std.HashMap String Float)
+  -- latency and size histograms of `RedisCmd`s by `RedisCmd.index`; a thread
+  -- records in the shard picked by its id (see `recordCommand`)
+  commandShards : Array (IO.Ref CommandShard)
+  -- what the server reports about its own latency (see `StatsCollector`)
+  server : IO.Ref ServerStats
 
 namespace Metrics
 
+-- shards of the per-command histograms: enough for the worker threads of a
+-- process to rarely share one
+def commandShardCount : Nat := 16
+
 def make : IO Metrics := do
   let latency ← IO.mkRef (Std.HashMap.emptyWithCapacity 32)
   let counts ← IO.mkRef (Std.HashMap.emptyWithCapacity 32)
   let errors ← IO.mkRef (Std.HashMap.emptyWithCapacity 16)
   let events ← IO.mkRef #[]
-  let traces ← IO.mkRef #[]
+  let traces ← IO.mkRef (TraceRing.create 1000)  -- default keep last 1000 traces
+  let traceSampling ← IO.mkRef {}
+  let traceSeq ← IO.mkRef ((← IO.rand 0 0xffffffff).toUInt64 <<< 32)
   let bytesWritten ← IO.mkRef 0
   let bytesRead ← IO.mkRef 0
   let slowCommands ← IO.mkRef #[]
   let slowThresholdMs ← IO.mkRef 100  -- default 100ms
-  let maxTraces ← IO.mkRef 1000  -- default keep last 1000 traces
+  let nodeLatency ← IO.mkRef (Std.HashMap.emptyWithCapacity 8)
+  let commandShards ← (Array.range commandShardCount).mapM fun _ => IO.mkRef ({} : CommandShard)
+  let server ← IO.mkRef {}
   pure {
     latencyBuckets := latency,
     commandCounts := counts,
     errorCounts := errors,
     connectionEvents := events,
     traces,
+    traceSampling,
+    traceSeq,
     bytesWritten,
     bytesRead,
     slowCommands,
     slowThresholdMs,
-    maxTraces
+    nodeLatency,
+    commandShards,
+    server
   }
 
 -- record latency for a command
 def recordLatency (m : Metrics) (cmd : String) (microseconds : Nat) : IO Unit := do
   m.latencyBuckets.modify fun h =>
-    h.insert cmd ((h.getD cmd #[]).push microseconds)
+    h.alter cmd fun hist => some ((hist.getD .empty).record microseconds)
   m.commandCounts.modify fun h =>
     h.insert cmd ((h.getD cmd 0) + 1)
   -- Check if this is a slow command
@@ -123,6 +300,59 @@ def recordLatency (m : Metrics) (cmd : String) (microseconds : Nat) : IO Unit :=
   if microseconds > threshold * 1000 then
     m.slowCommands.modify (·.push (cmd, microseconds))
 
+-- record latency for a command run by the calling thread: the sample goes to
+-- the histogram of the command in the shard of the thread, without building
+-- the command name or hashing it
+def recordCommand (m : Metrics) (cmd : RedisCmd) (microseconds : Nat) : IO Unit := do
+  let tid ← IO.getTID
+  if let some shard := m.commandShards[tid.toNat % m.commandShards.size]? then
+    shard.modify fun ⟨latency, requests, replies, phases⟩ =>
+      ⟨latency.modify cmd.index (·.record microseconds), requests, replies, phases⟩
+  let threshold ← m.slowThresholdMs.get
+  if microseconds > threshold * 1000 then
+    m.slowCommands.modify (·.push (toString cmd, microseconds))
+
+-- record the bytes a command wrote and read on its connection (see
+-- `FFI.ioTake`), in the shard of the calling thread
+def recordCommandBytes (m : Metrics) (cmd : RedisCmd) (written read : Nat) : BaseIO Unit := do
+  let tid ← IO.getTID
+  if let some shard := m.commandShards[tid.toNat % m.commandShards.size]? then
+    shard.modify fun ⟨latency, requests, replies, phases⟩ =>
+      ⟨latency, requests.modify cmd.index (·.record written), replies.modify cmd.index (·.record read), phases⟩
+
+-- record how long a command spent in each phase (nanoseconds by
+-- `LatencyPhase.index`, see `LatencyPhase.split`), in the shard of the
+-- calling thread
+def recordPhases (m : Metrics) (ns : Array Nat) : BaseIO Unit := do
+  let tid ← IO.getTID
+  if let some shard := m.commandShards[tid.toNat % m.commandShards.size]? then
+    shard.modify fun ⟨latency, requests, replies, phases⟩ =>
+      ⟨latency, requests, replies,
+        (Array.range (Nat.min ns.size phases.size)).foldl (fun ps i => ps.modify i (·.record ns[i]!)) phases⟩
+
+-- add a collection of server stats
+def recordServerSample (m : Metrics) (sample : ServerSample) : IO Unit := do
+  let now ← IO.monoNanosNow
+  m.server.modify (·.ingest sample now)
+
+def getServerStats (m : Metrics) : IO ServerStats :=
+  m.server.get
+
+-- weight of the newest sample in the per-node latency average
+def nodeLatencyAlpha : Float := 0.2
+
+-- record the latency of a command on a node (exponentially weighted average)
+def recordNodeLatency (m : Metrics) (node : String) (microseconds : Nat) : IO Unit :=
+  m.nodeLatency.modify fun h =>
+    let sample := microseconds.toFloat
+    h.insert node <| match h.get? node with
+      | some avg => avg + nodeLatencyAlpha * (sample - avg)
+      | none => sample
+
+-- smoothed latency of every node seen so far, in microseconds
+def nodeLatencies (m : Metrics) : IO (Std.HashMap String Float) :=
+  m.nodeLatency.get
+
 -- record an error
 def recordError (m : Metrics) (errorType : String) : IO Unit := do
   m.errorCounts.modify fun h =>
@@ -143,17 +373,17 @@ def recordBytesWritten (m : Metrics) (bytes : Nat) : IO Unit := do
 def recordBytesRead (m : Metrics) (bytes : Nat) : IO Unit := do
   m.bytesRead.modify (· + bytes)
 
--- generate a unique trace ID
-private def generateTraceId : IO String := do
-  let timestamp ← IO.monoNanosNow
-  let random ← IO.rand 0 999999
-  return s!"trace-{timestamp}-{random}"
+-- next trace id
+private def nextTraceId (m : Metrics) : IO UInt64 :=
+  m.traceSeq.modifyGet fun n => (n + 1, n + 1)
 
--- record a trace
+-- record a trace, if the sampling policy keeps it
 def recordTrace (m : Metrics) (cmd : String) (startNs endNs : Nat)
     (success : Bool) (errorMsg : Option String := none)
     (tags : List (String × String) := []) : IO Unit := do
-  let traceId ← generateTraceId
+  let traceId ← nextTraceId m
+  let sampling ← m.traceSampling.get
+  if !sampling.keep traceId success ((endNs - startNs) / 1000) then return
   let trace : Trace := {
     traceId,
     command := cmd,
@@ -163,13 +393,7 @@ def recordTrace (m : Metrics) (cmd : String) (startNs endNs : Nat)
     success,
     errorMsg
   }
-  let maxTraces ← m.maxTraces.get
-  m.traces.modify fun traces =>
-    let newTraces := traces.push trace
-    if newTraces.size > maxTraces then
-      newTraces.extract (newTraces.size - maxTraces) newTraces.size
-    else
-      newTraces
+  m.traces.modify (·.push trace)
 
 -- execute an action with tracing
 def withTrace (m : Metrics) (name : String) (tags : List (String × String) := [])
@@ -188,30 +412,76 @@ def withTrace (m : Metrics) (name : String) (tags : List (String × String) := [
     recordError m (toString e)
     return .error (toString e)
 
+-- latency histograms by command name: those recorded by name and the
+-- command shards merged
+def getCommandHistograms (m : Metrics) : IO (Std.HashMap String Histogram) := do
+  let mut out ← m.latencyBuckets.get
+  for shard in m.commandShards do
+    let hs := (← shard.get).latency
+    for h in hs, cmd in RedisCmd.all do
+      if h.count > 0 then
+        out := out.alter (toString cmd) fun prev => some (prev.getD .empty ++ h)
+  return out
+
+-- request and reply size histograms by command name, for the commands that
+-- went over a connection with byte accounting
+def getCommandSizeHistograms (m : Metrics) : IO (Std.HashMap String (Histogram × Histogram)) := do
+  let mut out : Std.HashMap String (Histogram × Histogram) := {}
+  for shard in m.commandShards do
+    let s ← shard.get
+    for req in s.requestBytes, reply in s.replyBytes, cmd in RedisCmd.all do
+      if req.count > 0 then
+        out := out.alter (toString cmd) fun prev =>
+          let (r, p) := prev.getD (.empty, .empty)
+          some (r ++ req, p ++ reply)
+  return out
+
+private def addHistograms (into more : Array Histogram) : Array Histogram :=
+  (Array.range (Nat.min into.size more.size)).foldl (fun acc i => acc.modify i (· ++ more[i]!)) into
+
+-- nanoseconds per latency phase, over the commands timed with
+-- `Read.latencyPhases`
+def getPhaseHistograms (m : Metrics) : IO (Array (LatencyPhase × Histogram)) := do
+  let mut out := Array.replicate LatencyPhase.all.size Histogram.empty
+  for shard in m.commandShards do
+    out := addHistograms out (← shard.get).phases
+  return LatencyPhase.all.zip out
+
+-- latency histogram of one command
+def getCommandHistogram (m : Metrics) (cmd : String) : IO (Option Histogram) := do
+  return (← getCommandHistograms m)[cmd]?
+
+-- latency histogram of all commands together
+def getLatencyHistogram (m : Metrics) : IO Histogram := do
+  return (← getCommandHistograms m).fold (fun all _ h => all ++ h) .empty
+
 def getLatencyStats (m : Metrics) (cmd : String) : IO (Option LatencyStats) := do
-  let buckets ← m.latencyBuckets.get
-  match buckets.get? cmd with
+  match ← getCommandHistogram m cmd with
+  | some h =>
+    if h.count == 0 then return none
+    return some { count := h.count, min := h.min, max := h.max, avg := h.mean }
   | none => return none
-  | some times =>
-    if times.size == 0 then return none
-    else
-      let min := times.foldl Nat.min times[0]!
-      let max := times.foldl Nat.max 0
-      let sum := times.foldl (·+·) 0
-      let avg := (Float.ofNat sum / Float.ofNat times.size)
-      return some { count := times.size, min, max, avg }
-
--- calculate percentile latency
+
+-- commands seen by both sides, by name: mean latency observed by the client
+-- and mean server time per call over the same period (see
+-- `ServerStats.window`), in microseconds; the difference is the network and
+-- the client
+def serverGaps (m : Metrics) : IO (Array (String × Float × Float)) := do
+  let server ← m.server.get
+  let client ← getCommandHistograms m
+  let gaps := client.toArray.filterMap fun (cmd, h) => do
+    let stat ← server.window cmd
+    if h.count == 0 || stat.calls == 0 then none
+    return (cmd, h.mean, stat.usecPerCall)
+  return gaps.qsort (·.1 < ·.1)
+
+-- calculate percentile latency over all commands
 def getPercentileLatency (m : Metrics) (percentile : Nat) : IO Nat := do
-  let buckets ← m.latencyBuckets.get
-  let mut allLatencies : Array Nat := #[]
-  for (_, times) in buckets.toList do
-    allLatencies := allLatencies ++ times
-  if allLatencies.size == 0 then return 0
-  let sorted := allLatencies.qsort (· < ·)
-  let idx := (sorted.size * percentile) / 100
-  let safeIdx := min idx (sorted.size - 1)
-  return sorted[safeIdx]!
+  return (← getLatencyHistogram m).percentile percentile
+
+-- calculate percentile latency of one command
+def getCommandPercentile (m : Metrics) (cmd : String) (percentile : Nat) : IO (Option Nat) := do
+  return (← getCommandHistogram m cmd).map (·.percentile percentile)
 
 -- get P99 latency
 def getP99Latency (m : Metrics) : IO Nat :=
@@ -225,8 +495,14 @@ def getP95Latency (m : Metrics) : IO Nat :=
 def getP50Latency (m : Metrics) : IO Nat :=
   getPercentileLatency m 50
 
-def getCommandCounts (m : Metrics) : IO (Std.HashMap String Nat) :=
-  m.commandCounts.get
+def getCommandCounts (m : Metrics) : IO (Std.HashMap String Nat) := do
+  let mut out ← m.commandCounts.get
+  for shard in m.commandShards do
+    let hs := (← shard.get).latency
+    for h in hs, cmd in RedisCmd.all do
+      if h.count > 0 then
+        out := out.alter (toString cmd) fun prev => some (prev.getD 0 + h.count)
+  return out
 
 def getErrorCounts (m : Metrics) : IO (Std.HashMap String Nat) :=
   m.errorCounts.get
@@ -240,12 +516,11 @@ def getRecentEvents (m : Metrics) (lastN : Nat := 100) : IO (Array (String × Na
     return events.extract (totalEvents - lastN) totalEvents
 
 def getRecentTraces (m : Metrics) (lastN : Nat := 100) : IO (Array Trace) := do
-  let traces ← m.traces.get
-  let totalTraces := traces.size
-  if totalTraces <= lastN then
-    return traces
-  else
-    return traces.extract (totalTraces - lastN) totalTraces
+  return (← m.traces.get).recent lastN
+
+-- recent traces as JSON, trace ids rendered here
+def tracesToJson (m : Metrics) (lastN : Nat := 100) : IO Lean.Json := do
+  return Lean.Json.arr ((← getRecentTraces m lastN).map Trace.toJson)
 
 def getSlowCommands (m : Metrics) (lastN : Nat := 100) : IO (Array (String × Nat)) := do
   let slow ← m.slowCommands.get
@@ -255,53 +530,111 @@ def getSlowCommands (m : Metrics) (lastN : Nat := 100) : IO (Array (String × Na
   else
     return slow.extract (total - lastN) total
 
+-- bytes written and read: those recorded directly and the sums of the
+-- command size histograms
+def getTotalBytes (m : Metrics) : IO (Nat × Nat) := do
+  let mut written ← m.bytesWritten.get
+  let mut read ← m.bytesRead.get
+  for shard in m.commandShards do
+    let s ← shard.get
+    written := s.requestBytes.foldl (· + ·.sum) written
+    read := s.replyBytes.foldl (· + ·.sum) read
+  return (written, read)
+
 def getBytesWritten (m : Metrics) : IO Nat :=
-  m.bytesWritten.get
+  return (← getTotalBytes m).1
 
 def getBytesRead (m : Metrics) : IO Nat :=
-  m.bytesRead.get
-
-def getTotalBytes (m : Metrics) : IO (Nat × Nat) := do
-  let written ← m.bytesWritten.get
-  let read ← m.bytesRead.get
-  return (written, read)
+  return (← getTotalBytes m).2
 
 def setSlowThreshold (m : Metrics) (thresholdMs : Nat) : IO Unit :=
   m.slowThresholdMs.set thresholdMs
 
+-- keep the last `max` traces (the most recent ones are carried over)
 def setMaxTraces (m : Metrics) (max : Nat) : IO Unit :=
-  m.maxTraces.set max
+  m.traces.modify (·.resize max)
+
+def setTraceSampling (m : Metrics) (sampling : TraceSampling) : IO Unit :=
+  m.traceSampling.set sampling
+
+def getTraceSampling (m : Metrics) : IO TraceSampling :=
+  m.traceSampling.get
 
 def clear (m : Metrics) : IO Unit := do
   m.latencyBuckets.set (Std.HashMap.emptyWithCapacity 32)
   m.commandCounts.set (Std.HashMap.emptyWithCapacity 32)
   m.errorCounts.set (Std.HashMap.emptyWithCapacity 16)
   m.connectionEvents.set #[]
-  m.traces.set #[]
+  m.traces.modify fun r => TraceRing.create r.capacity
   m.bytesWritten.set 0
   m.bytesRead.set 0
   m.slowCommands.set #[]
+  for shard in m.commandShards do
+    shard.set {}
+  m.server.set {}
+
+private def addCounts (into : Std.HashMap String Nat) (counts : Std.HashMap String Nat) :
+    Std.HashMap String Nat :=
+  counts.fold (fun h k n => h.insert k (h.getD k 0 + n)) into
+
+-- combine several metrics (e.g. the shards of a pool) into a new one:
+-- samples and counters are added up, events, traces and slow commands
+-- concatenated; settings come from the first
+def merge (ms : Array Metrics) : IO Metrics := do
+  let out ← make
+  if let some first := ms[0]? then
+    out.slowThresholdMs.set (← first.slowThresholdMs.get)
+    out.traces.set (TraceRing.create (← first.traces.get).capacity)
+    out.traceSampling.set (← first.traceSampling.get)
+  let mut traces : Array Trace := #[]
+  for m in ms do
+    let latencies ← getCommandHistograms m
+    out.latencyBuckets.modify fun h =>
+      latencies.fold (fun h k hist => h.insert k (h.getD k .empty ++ hist)) h
+    let counts ← getCommandCounts m
+    out.commandCounts.modify (addCounts · counts)
+    let errors ← m.errorCounts.get
+    out.errorCounts.modify (addCounts · errors)
+    let events ← m.connectionEvents.get
+    out.connectionEvents.modify (· ++ events)
+    let ring ← m.traces.get
+    traces := traces ++ ring.recent ring.capacity
+    let written ← m.bytesWritten.get
+    out.bytesWritten.modify (· + written)
+    let read ← m.bytesRead.get
+    out.bytesRead.modify (· + read)
+    if let some target := out.commandShards[0]? then
+      for shard in m.commandShards do
+        let s ← shard.get
+        target.modify fun ⟨latency, requests, replies, phases⟩ =>
+          ⟨latency, addHistograms requests s.requestBytes, addHistograms replies s.replyBytes,
+            addHistograms phases s.phases⟩
+    let slow ← m.slowCommands.get
+    out.slowCommands.modify (· ++ slow)
+    let nodes ← m.nodeLatency.get
+    out.nodeLatency.modify fun h => nodes.fold (fun h k v => h.insert k v) h
+    -- the shards talk to the same server: keep its latest collection
+    let server ← m.server.get
+    out.server.modify fun s => if server.collectedAt > s.collectedAt then server else s
+  out.connectionEvents.modify (·.qsort (·.2 < ·.2))
+  let traces := traces.qsort (·.startTimeNs < ·.startTimeNs)
+  out.traces.modify fun r => traces.foldl TraceRing.push r
+  return out
 
 -- create a snapshot of current metrics
 def snapshot (m : Metrics) : IO MetricsSnapshot := do
   let timestamp ← IO.monoNanosNow
-  let counts ← m.commandCounts.get
+  let counts ← getCommandCounts m
   let totalCommands := counts.toList.foldl (fun acc (_, c) => acc + c) 0
   let errors ← m.errorCounts.get
   let totalErrors := errors.toList.foldl (fun acc (_, c) => acc + c) 0
-  -- Calculate average latency
-  let buckets ← m.latencyBuckets.get
-  let mut totalLatency : Nat := 0
-  let mut latencyCount : Nat := 0
-  for (_, times) in buckets.toList do
-    totalLatency := totalLatency + times.foldl (·+·) 0
-    latencyCount := latencyCount + times.size
-  let avgLatencyMs := if latencyCount > 0
-    then Float.ofNat totalLatency / Float.ofNat latencyCount / 1000.0
-    else 0.0
-  let p99 ← getP99Latency m
-  let bytesWritten ← m.bytesWritten.get
-  let bytesRead ← m.bytesRead.get
+  let latency ← getLatencyHistogram m
+  let avgLatencyMs := latency.mean / 1000.0
+  let p99 := latency.percentile 99
+  let (bytesWritten, bytesRead) ← getTotalBytes m
+  let sizes ← getCommandSizeHistograms m
+  let (requests, replies) := sizes.fold (fun (r, p) _ (req, reply) => (r ++ req, p ++ reply))
+    (Histogram.empty, Histogram.empty)
   return {
     timestamp,
     totalCommands,
@@ -309,62 +642,102 @@ def snapshot (m : Metrics) : IO MetricsSnapshot := do
     avgLatencyMs,
     p99LatencyUs := p99,
     bytesWritten,
-    bytesRead
+    bytesRead,
+    p99RequestBytes := requests.percentile 99,
+    p99ReplyBytes := replies.percentile 99
   }
 
--- export metrics in Prometheus format
-def toPrometheus (m : Metrics) : IO String := do
-  let mut lines : Array String := #[]
-
-  -- Command counts
-  let counts ← m.commandCounts.get
-  lines := lines.push "# HELP redis_command_total Total number of Redis commands executed"
-  lines := lines.push "# TYPE redis_command_total counter"
-  for (cmd, count) in counts.toList do
-    lines := lines.push s!"redis_command_total\{command=\"{cmd}\"} {count}"
-
-  -- Error counts
+/-- Metric families in Prometheus exposition format: command and error
+    counters, latency and request/reply size histograms per command (fixed
+    `le` bounds, see `Prometheus.defaultBounds` and `Prometheus.byteBounds`),
+    latency phase histograms (`Prometheus.nanosecondBounds`) and byte
+    counters; once server stats were collected, the server's own counters
+    and percentiles per command and the gap between client and server -/
+def prometheusFamilies (m : Metrics) (extraLabels : List (String × String) := []) :
+    IO (Array (Array String)) := do
+  let counts ← getCommandCounts m
   let errors ← m.errorCounts.get
-  lines := lines.push "# HELP redis_error_total Total number of Redis errors"
-  lines := lines.push "# TYPE redis_error_total counter"
-  for (errType, count) in errors.toList do
-    lines := lines.push s!"redis_error_total\{error_type=\"{errType}\"} {count}"
-
-  -- Latency stats
-  lines := lines.push "# HELP redis_command_latency_microseconds Command latency in microseconds"
-  lines := lines.push "# TYPE redis_command_latency_microseconds summary"
-  let buckets ← m.latencyBuckets.get
-  for (cmd, _) in buckets.toList do
-    let stats ← getLatencyStats m cmd
-    match stats with
-    | some s =>
-      lines := lines.push s!"redis_command_latency_microseconds\{command=\"{cmd}\",quantile=\"0.5\"} {s.avg}"
-      lines := lines.push s!"redis_command_latency_microseconds\{command=\"{cmd}\",quantile=\"1\"} {s.max}"
-      lines := lines.push s!"redis_command_latency_microseconds_count\{command=\"{cmd}\"} {s.count}"
-    | none => pure ()
-
-  -- Bytes transferred
-  let bytesWritten ← m.bytesWritten.get
-  let bytesRead ← m.bytesRead.get
-  lines := lines.push "# HELP redis_bytes_written_total Total bytes written to Redis"
-  lines := lines.push "# TYPE redis_bytes_written_total counter"
-  lines := lines.push s!"redis_bytes_written_total {bytesWritten}"
-  lines := lines.push "# HELP redis_bytes_read_total Total bytes read from Redis"
-  lines := lines.push "# TYPE redis_bytes_read_total counter"
-  lines := lines.push s!"redis_bytes_read_total {bytesRead}"
-
-  return String.intercalate "\n" lines.toList
+  let latency ← getCommandHistograms m
+  let sizes ← getCommandSizeHistograms m
+  let phases ← getPhaseHistograms m
+  let (bytesWritten, bytesRead) ← getTotalBytes m
+  let server ← m.server.get
+  let gaps ← serverGaps m
+  let serverFamilies := if server.collections == 0 then #[] else #[
+    Prometheus.counter "redis_server_command_calls_total" "Calls per command reported by INFO commandstats"
+      (server.commands.toList.map fun (cmd, c) => (extraLabels ++ [("command", cmd)], c.calls)),
+    Prometheus.counter "redis_server_command_duration_microseconds_total"
+      "Server time per command reported by INFO commandstats"
+      (server.commands.toList.map fun (cmd, c) => (extraLabels ++ [("command", cmd)], c.usec)),
+    Prometheus.gauge "redis_server_command_latency_microseconds"
+      "Server latency percentiles per command reported by INFO latencystats"
+      (server.latencies.toList.flatMap fun (cmd, l) => l.percentiles.toList.map fun (p, v) =>
+        (extraLabels ++ [("command", cmd), ("percentile", p)], v)),
+    Prometheus.gauge "redis_command_server_gap_microseconds"
+      "Mean client latency minus mean server time per call: network and client overhead"
+      (gaps.toList.map fun (cmd, client, srv) => (extraLabels ++ [("command", cmd)], client - srv)),
+    Prometheus.gauge "redis_server_latency_event_milliseconds" "Latest latency spike per event (LATENCY HISTORY)"
+      (server.latestEvents.toList.map fun (e, ms) => (extraLabels ++ [("event", e)], ms)),
+    Prometheus.counter "redis_server_slowlog_entries_total" "Slow log entries seen by the collector"
+      [(extraLabels, server.slowlogSeen)]
+  ]
+  let families := #[
+    Prometheus.counter "redis_command_total" "Total number of Redis commands executed"
+      (counts.toList.map fun (cmd, n) => (extraLabels ++ [("command", cmd)], n)),
+    Prometheus.counter "redis_error_total" "Total number of Redis errors"
+      (errors.toList.map fun (errType, n) => (extraLabels ++ [("error_type", errType)], n)),
+    Prometheus.histogram "redis_command_latency_microseconds" "Command latency in microseconds"
+      (latency.toList.map fun (cmd, h) => (extraLabels ++ [("command", cmd)], h)),
+    Prometheus.histogram "redis_command_request_bytes" "Bytes written per command"
+      (sizes.toList.map fun (cmd, (h, _)) => (extraLabels ++ [("command", cmd)], h)) Prometheus.byteBounds,
+    Prometheus.histogram "redis_command_reply_bytes" "Bytes read per reply"
+      (sizes.toList.map fun (cmd, (_, h)) => (extraLabels ++ [("command", cmd)], h)) Prometheus.byteBounds,
+    Prometheus.histogram "redis_command_phase_nanoseconds" "Client-side command time per phase in nanoseconds"
+      (phases.toList.filterMap fun (phase, h) =>
+        if h.count > 0 then some (extraLabels ++ [("phase", toString phase)], h) else none)
+      Prometheus.nanosecondBounds,
+    Prometheus.counter "redis_bytes_written_total" "Total bytes written to Redis"
+      [(extraLabels, bytesWritten)],
+    Prometheus.counter "redis_bytes_read_total" "Total bytes read from Redis"
+      [(extraLabels, bytesRead)]
+  ]
+  return families ++ serverFamilies
+
+-- export metrics in Prometheus format
+def toPrometheus (m : Metrics) : IO String :=
+  return Prometheus.render (← m.prometheusFamilies)
 
 -- export metrics as JSON
 def toJson (m : Metrics) : IO Lean.Json := do
   let snap ← snapshot m
-  let counts ← m.commandCounts.get
+  let counts ← getCommandCounts m
   let errors ← m.errorCounts.get
-  let p95 ← getP95Latency m
-  let p50 ← getP50Latency m
+  let latency ← getLatencyHistogram m
+  let p95 := latency.percentile 95
+  let p50 := latency.percentile 50
 
   let commandCountsJson := Lean.Json.mkObj (counts.toList.map fun (k, v) => (k, Lean.Json.num v))
   let errorCountsJson := Lean.Json.mkObj (errors.toList.map fun (k, v) => (k, Lean.Json.num v))
+  let phasesJson := Lean.Json.mkObj ((← getPhaseHistograms m).toList.map fun (phase, h) =>
+    (toString phase, Lean.Json.mkObj [
+      ("count", Lean.Json.num h.count),
+      ("p50Ns", Lean.Json.num (h.percentile 50)),
+      ("p99Ns", Lean.Json.num (h.percentile 99))
+    ]))
+  let server ← m.server.get
+  let gapsJson := Lean.Json.mkObj ((← serverGaps m).toList.map fun (cmd, client, srv) =>
+    (cmd, Lean.Json.mkObj [
+      ("clientAvgUs", Lean.Json.num client.toUInt64.toNat),
+      ("serverAvgUs", Lean.Json.num srv.toUInt64.toNat),
+      ("gapUs", Lean.Json.num (client - srv).toUInt64.toNat)
+    ]))
+  let slowlogJson := Lean.Json.arr (server.slowlog.map fun e => Lean.Json.mkObj [
+    ("id", Lean.Json.num e.id),
+    ("timestamp", Lean.Json.num e.timestamp),
+    ("durationUs", Lean.Json.num e.durationUs),
+    ("command", Lean.Json.str e.command),
+    ("client", Lean.Json.str e.client)
+  ])
 
   -- Convert avgLatencyMs Float to integer microseconds for JSON compatibility
   let avgLatencyUs := snap.avgLatencyMs * 1000.0
@@ -379,8 +752,17 @@ def toJson (m : Metrics) : IO Lean.Json := do
     ("p99LatencyUs", Lean.Json.num snap.p99LatencyUs),
     ("bytesWritten", Lean.Json.num snap.bytesWritten),
     ("bytesRead", Lean.Json.num snap.bytesRead),
+    ("p99RequestBytes", Lean.Json.num snap.p99RequestBytes),
+    ("p99ReplyBytes", Lean.Json.num snap.p99ReplyBytes),
     ("commandCounts", commandCountsJson),
-    ("errorCounts", errorCountsJson)
+    ("errorCounts", errorCountsJson),
+    ("latencyPhases", phasesJson),
+    ("server", Lean.Json.mkObj [
+      ("collections", Lean.Json.num server.collections),
+      ("commandGaps", gapsJson),
+      ("latencyEvents", Lean.Json.mkObj (server.latestEvents.toList.map fun (e, ms) => (e, Lean.Json.num ms))),
+      ("slowlog", slowlogJson)
+    ])
   ]
 
 def printSummary (m : Metrics) : IO Unit := do
@@ -396,7 +778,8 @@ def printSummary (m : Metrics) : IO Unit := do
     let stats ← getLatencyStats m cmd
     match stats with
     | some s =>
-      Log.info s!"  {cmd}: avg={s.avg}μs, min={s.min}μs, max={s.max}μs, count={s.count}"
+      let p99 := (← getCommandPercentile m cmd 99).getD 0
+      Log.info s!"  {cmd}: avg={s.avg}μs, min={s.min}μs, max={s.max}μs, p99={p99}μs, count={s.count}"
     | none => Log.info s!"  {cmd}: no latency data"
 
   let p50 ← getP50Latency m
@@ -406,6 +789,23 @@ def printSummary (m : Metrics) : IO Unit := do
 
   let (bytesWritten, bytesRead) ← getTotalBytes m
   Log.info s!"Bytes Transferred: written={bytesWritten}, read={bytesRead}"
+  let sizes ← getCommandSizeHistograms m
+  if not sizes.isEmpty then
+    Log.info "Request/Reply Sizes (bytes):"
+    for (cmd, (req, reply)) in sizes.toList do
+      Log.info s!"  {cmd}: request avg={req.mean} max={req.max}, reply avg={reply.mean} p99={reply.percentile 99} max={reply.max}"
+
+  let phases ← getPhaseHistograms m
+  if phases.any (·.2.count > 0) then
+    Log.info "Latency Phases (nanoseconds):"
+    for (phase, h) in phases do
+      Log.info s!"  {phase}: avg={h.mean}, p50={h.percentile 50}, p99={h.percentile 99}, count={h.count}"
+
+  let gaps ← serverGaps m
+  if not gaps.isEmpty then
+    Log.info "Client vs Server Latency (microseconds):"
+    for (cmd, client, srv) in gaps do
+      Log.info s!"  {cmd}: client avg={client}, server avg={srv}, gap={client - srv}"
 
   let errors ← getErrorCounts m
   if not errors.isEmpty then
@@ -3,6 +3,9 @@ import RedisLean.Error
 import RedisLean.Config
 import RedisLean.FFI
 import RedisLean.Enums
+import RedisLean.NearCache
+import RedisLean.AutoPipeline
+import RedisLean.ClusterSlots
 
 namespace Redis
 
@@ -10,14 +13,143 @@ namespace Redis
 structure Read where
   config : Config := Config.default
   enableMetrics : Bool := true
+  /-- Also split the time of every command into client-side phases
+      (`LatencyPhase`): costs a few clock reads per command and per reply
+      object, so it is off by default -/
+  latencyPhases : Bool := false
+  /-- Serve GET/HGET from an in-process cache kept fresh by CLIENT TRACKING -/
+  nearCache : Option NearCacheConfig := none
+  /-- Send the common single-key commands over a shared multiplexed connection,
+      coalescing commands from concurrent tasks (see `AutoPipeline`) -/
+  autoPipeline : Bool := false
   deriving Repr
 
+/-- Picks the connection each command runs on when talking to a Redis Cluster,
+    or to a primary and its replicas (built by `Cluster.router`) -/
+structure Router where
+  /-- Node for a command on `slot` (any primary for `none`): the primary, or
+      for a read-only command the node chosen by the read preference -/
+  route : Option Nat → Bool → IO (Option Cluster.NodeAddr)
+  /-- Borrow a connection to a node -/
+  acquireAt : Cluster.NodeAddr → IO (Except Error FFI.Ctx)
+  release : FFI.Ctx → IO Unit
+  /-- Record how long a command took on a node (microseconds) -/
+  observe : Cluster.NodeAddr → Nat → IO Unit := fun _ _ => pure ()
+  /-- Reload the slot map -/
+  refresh : IO Unit
+  /-- MOVED/ASK redirections followed per command -/
+  maxRedirects : Nat := 5
+
+namespace Router
+
+/-- Run `f` on a connection borrowed from `addr` (sending ASKING first when
+    following an ASK redirection) and hand the connection back -/
+private def runOn {α} (r : Router) (addr : Cluster.NodeAddr) (ctx : Except Error FFI.Ctx)
+    (asking : Bool) (f : FFI.Ctx → EIO Error α) : IO (Except Error α) := do
+  match ctx with
+  | .error e => return .error e
+  | .ok c =>
+    try
+      if asking then
+        match ← (FFI.commandArgv c #["ASKING".toUTF8]).toBaseIO with
+        | .error e => return .error e
+        | .ok _ => pure ()
+      let start ← IO.monoNanosNow
+      let result ← (f c).toBaseIO
+      r.observe addr (((← IO.monoNanosNow) - start) / 1000)
+      return result
+    finally
+      r.release c
+
+private def unrouted (slot : Option Nat) : Error :=
+  .otherError s!"no node serves slot {slot.getD 0}"
+
+/-- Run `f` on the node `route` picks, reloading the slot map and retrying on
+    MOVED, retrying once on the target on ASK -/
+def run {α} (r : Router) (slot : Option Nat) (readOnly : Bool) (f : FFI.Ctx → EIO Error α) :
+    IO (Except Error α) := do
+  let some addr ← r.route slot readOnly | return .error (unrouted slot)
+  let mut addr := addr
+  let mut ctx ← r.acquireAt addr
+  if ctx matches .error _ then
+    -- the node may be down or gone: reload the map and route again
+    r.refresh
+    let some next ← r.route slot readOnly | return .error (unrouted slot)
+    addr := next
+    ctx ← r.acquireAt addr
+  let mut result ← r.runOn addr ctx false f
+  for _ in [:r.maxRedirects] do
+    let .error (.replyError msg) := result | return result
+    match Cluster.Redirect.parse? msg with
+    | some (.moved _ target) =>
+      r.refresh
+      result ← r.runOn target (← r.acquireAt target) false f
+    | some (.ask _ target) =>
+      result ← r.runOn target (← r.acquireAt target) true f
+    | none => return result
+  return result
+
+/-- Send commands on the keys of one slot each: the commands of a node are
+    pipelined on one connection and the nodes are queried in parallel.
+    Replies come back in command order. A command that was redirected, or
+    whose node could not be reached, is retried alone through `run`. -/
+def fanOut (r : Router) (readOnly : Bool) (cmds : Array (Nat × Array ByteArray)) :
+    IO (Except Error (Array Reply)) := do
+  let mut byNode : Array (Option Cluster.NodeAddr × Array Nat) := #[]
+  for i in [:cmds.size] do
+    let node ← r.route (some cmds[i]!.1) readOnly
+    match byNode.findIdx? (·.1 == node) with
+    | some j => byNode := byNode.modify j fun (n, is) => (n, is.push i)
+    | none => byNode := byNode.push (node, #[i])
+  let runGroup (group : Option Cluster.NodeAddr × Array Nat) : IO (Array (Nat × Except Error Reply)) := do
+    let (node, positions) := group
+    let piped : Except Error (Array Reply) ← match node with
+      | some addr => do r.runOn addr (← r.acquireAt addr) false (FFI.pipelineExec · (positions.map (cmds[·]!.2)))
+      | none => pure (.error (.otherError "slot not served"))
+    let mut out : Array (Nat × Except Error Reply) := #[]
+    for j in [:positions.size] do
+      let i := positions[j]!
+      let (slot, argv) := cmds[i]!
+      let retry := r.run (some slot) readOnly (FFI.commandArgv · argv)
+      let reply ← match piped with
+        | .ok replies =>
+          match replies[j]? with
+          | some (.error msg) =>
+            if (Cluster.Redirect.parse? msg).isSome then retry else pure (.error (.replyError msg))
+          | some reply => pure (.ok reply)
+          | none => retry
+        | .error _ => retry
+      out := out.push (i, reply)
+    return out
+  let groups ← if byNode.size == 1 then (#[·]) <$> runGroup byNode[0]! else do
+    let tasks ← byNode.mapM fun g => IO.asTask (runGroup g)
+    tasks.mapM fun t => do IO.ofExcept (← IO.wait t)
+  let mut replies : Array Reply := Array.replicate cmds.size .nil
+  for group in groups do
+    for (i, reply) in group do
+      match reply with
+      | .ok v => replies := replies.set! i v
+      | .error e => return .error e
+  return .ok replies
+
+end Router
+
 -- State maintained during Redis operations
 structure State where
   ctx : FFI.Ctx
   isConnected : Bool := false
   metrics : Metrics
-  recordLatency : String → Nat → IO Unit := fun _ _ => pure ()
+  recordLatency : RedisCmd → Nat → IO Unit := fun _ _ => pure ()
+  nearCache : Option NearCache := none
+  /-- Multiplexed connection used when `Read.autoPipeline` is set -/
+  mux : Option FFI.Async.Ctx := none
+  /-- Set once the blocking connection carries session state the multiplexed
+      one does not share (SELECT, or MULTI/WATCH through `getContext`): the
+      rest of the computation stays on the blocking connection -/
+  pinned : Bool := false
+  /-- Set when running against a cluster: commands are routed by key slot
+      instead of going to `ctx` -/
+  router : Option Router := none
 
 abbrev RedisM := ReaderT Read $ StateRefT State $ ExceptT Error IO
 abbrev StateRef := ST.Ref IO.RealWorld State
@@ -36,31 +168,143 @@ def isConnected : RedisM Bool := do
   let s ← get
   return s.isConnected
 
+-- the raw context may open a transaction or WATCH keys, so commands after it
+-- no longer go over the auto-pipelining connection
 def getContext : RedisM FFI.Ctx := do
+  modify fun s => { s with pinned := true }
   let s ← get
   return s.ctx
 
--- lift an EIO operation that uses the Redis context with latency recording
-def liftRedisEIO {α}
-  (cmd : RedisCmd) (f : FFI.Ctx → EIO Error α) : RedisM α := do
+-- run a command with latency and error recording
+private def timed {α} (cmd : RedisCmd) (act : RedisM α) : RedisM α := do
   let r ← read
   let s ← get
   if r.enableMetrics then
     let start ← IO.monoNanosNow
     try
-      let result ← ExceptT.mk (EIO.toIO' (f s.ctx))
+      let result ← act
       let stop ← IO.monoNanosNow
       let micros := (stop - start) / 1000
-      s.recordLatency (toString cmd) micros
+      s.recordLatency cmd micros
       return result
     catch e =>
       let stop ← IO.monoNanosNow
       let micros := (stop - start) / 1000
-      s.recordLatency (toString cmd) micros
+      s.recordLatency cmd micros
       Metrics.recordError s.metrics (toString e)
       throw e
   else
-    ExceptT.mk (EIO.toIO' (f s.ctx))
+    act
+
+-- charge `cmd` with the bytes `f` wrote to and read from `ctx`, and with
+-- `phases` record how its time split into latency phases
+private def metered {α} (m : Metrics) (phases : Bool) (cmd : RedisCmd) (f : FFI.Ctx → EIO Error α)
+    (ctx : FFI.Ctx) : EIO Error α := do
+  if phases then FFI.ioPhaseStart ctx
+  let start ← if phases then IO.monoNanosNow else pure 0
+  let result ← (f ctx).toBaseIO
+  if phases then
+    let stop ← IO.monoNanosNow
+    if let some ns := LatencyPhase.split start stop (← FFI.ioPhaseTake ctx) then
+      m.recordPhases ns
+  let (written, read) ← FFI.ioTake ctx
+  if written + read > 0 then
+    m.recordCommandBytes cmd written read
+  MonadExcept.ofExcept result
+
+-- run `f` on the connection: the State's own, or in cluster mode the node
+-- serving `slot` (any primary for `none`), possibly a replica for a read
+private def onConnection {α} (cmd : RedisCmd) (slot : Option Nat) (f : FFI.Ctx → EIO Error α) : RedisM α := do
+  let s ← get
+  let r ← read
+  let f := if r.enableMetrics then metered s.metrics r.latencyPhases cmd f else f
+  match s.router with
+  | some router => ExceptT.mk (router.run slot cmd.isReadOnly f)
+  | none => ExceptT.mk (EIO.toIO' (f s.ctx))
+
+-- lift an EIO operation that uses the Redis context with latency recording
+def liftRedisEIO {α}
+  (cmd : RedisCmd) (f : FFI.Ctx → EIO Error α) : RedisM α :=
+  timed cmd (onConnection cmd none f)
+
+-- lift an EIO operation on `keys`; in cluster mode it runs on the node
+-- serving the slot of the first key
+def liftRedisKeyed {α}
+  (keys : Array ByteArray) (cmd : RedisCmd) (f : FFI.Ctx → EIO Error α) : RedisM α :=
+  timed cmd (onConnection cmd (keys[0]?.map Cluster.keySlot) f)
+
+-- lift a command on several keys. Without a cluster router this is `single`,
+-- one request. In cluster mode the keys are split by slot (see `Router.fanOut`):
+-- `argv` builds the sub-command for the key positions of one slot and `merge`
+-- combines the replies, given with the key positions of each sub-command.
+def liftRedisMultiKey {α}
+  (cmd : RedisCmd) (keys : Array ByteArray) (argv : Array Nat → Array ByteArray)
+  (merge : Array (Array Nat) → Array Reply → Except Error α) (single : RedisM α) : RedisM α := do
+  let some router := (← get).router | single
+  timed cmd do
+    let groups := Cluster.groupBySlot keys
+    let replies ← ExceptT.mk (router.fanOut cmd.isReadOnly (groups.map fun (slot, positions) => (slot, argv positions)))
+    MonadExcept.ofExcept (merge (groups.map (·.2)) replies)
+
+-- lift a command that may go over the auto-pipelining connection: `args` and
+-- `decode` are used when it is enabled and the state is not pinned, the
+-- blocking wrapper `f` otherwise. Error replies are handed to `decode` too,
+-- which maps them as `f` would.
+def liftRedisPipelined {α}
+  (cmd : RedisCmd) (args : Array ByteArray) (decode : Reply → Except Error α)
+  (f : FFI.Ctx → EIO Error α) : RedisM α := do
+  let s ← get
+  match s.mux, s.pinned with
+  | some mux, false =>
+    liftRedisEIO cmd fun _ => do
+      let r ← tryCatch (FFI.Async.send mux args) fun
+        | .replyError msg => pure (.error msg)
+        | e => throw e
+      MonadExcept.ofExcept (decode r)
+  | _, _ => liftRedisKeyed (args.extract 1 2) cmd f
+
+/-- Serve a string value (`field = none`) or hash field from the near cache,
+    or run `fetch` and cache its result. Plain `fetch` without a near cache. -/
+def nearCached (key : ByteArray) (field : Option ByteArray) (fetch : RedisM ByteArray) : RedisM ByteArray := do
+  let some nc := (← get).nearCache | fetch
+  if !nc.cacheable key then return ← fetch
+  if let some v ← nc.lookup key field then return v
+  let some token ← nc.reserve key field | fetch
+  try
+    let v ← fetch
+    nc.fill key field token v
+    return v
+  catch e =>
+    nc.cancel key field token
+    throw e
+
+/-- Drop keys written through this connection from the near cache right away
+    (the server's invalidation push arrives asynchronously) -/
+def nearInvalidate (keys : Array ByteArray) : RedisM Unit := do
+  if let some nc := (← get).nearCache then
+    for k in keys do nc.invalidate k
+
+/-- Empty the near cache (after FLUSHALL) -/
+def nearClear : RedisM Unit := do
+  if let some nc := (← get).nearCache then nc.clear
+
+-- run a write on `keys`, keeping the near cache read-your-writes consistent
+def nearWrite {α} (keys : Array ByteArray) (act : RedisM α) : RedisM α := do
+  try
+    act
+  finally
+    nearInvalidate keys
+
+-- lift a write on `keys` (see `nearWrite`)
+def liftRedisWrite {α}
+  (keys : Array ByteArray) (cmd : RedisCmd) (f : FFI.Ctx → EIO Error α) : RedisM α :=
+  nearWrite keys (liftRedisKeyed keys cmd f)
+
+/-- Close the multiplexed and invalidation connections, then the data connection -/
+def disconnect (s : State) : IO Unit := do
+  if let some mux := s.mux then FFI.Async.close mux
+  if let some nc := s.nearCache then nc.close
+  discard $ EIO.toIO (fun _ => IO.userError "Failed to free Redis context") (FFI.free s.ctx)
 
 def connect (r : Read) : ExceptT Error IO State := do
   let ctxResult ← ExceptT.mk (EIO.toIO' (FFI.connect r.config.host (UInt32.ofNat r.config.port) r.config.ssl))
@@ -69,12 +313,43 @@ def connect (r : Read) : ExceptT Error IO State := do
     Metrics.recordEvent metrics "connection_established"
     if r.config.ssl.isSome then
       Metrics.recordEvent metrics "ssl_connection"
+  let mux ← if !r.autoPipeline then pure none else do
+    if r.config.ssl.isSome then
+      let _ ← (FFI.free ctxResult).toBaseIO
+      throw (Error.otherError "auto-pipelining is not available on SSL connections")
+    try
+      let m ← ExceptT.mk (EIO.toIO' (FFI.Async.connect r.config.host (UInt32.ofNat r.config.port)))
+      pure (some m)
+    catch e =>
+      let _ ← (FFI.free ctxResult).toBaseIO
+      throw e
+  let nearCache ← match r.nearCache with
+    | none => pure none
+    | some cfg => do
+      try
+        let nc ← ExceptT.mk (EIO.toIO' (NearCache.start ctxResult cfg r.config.host r.config.port r.config.ssl))
+        -- reads over the multiplexed connection must be tracked as well
+        if let some m := mux then
+          try
+            let _ ← ExceptT.mk (EIO.toIO' (FFI.Async.send m (NearCache.trackingArgs cfg.mode nc.redirectId)))
+          catch e =>
+            nc.close
+            throw e
+        pure (some nc)
+      catch e =>
+        if let some m := mux then FFI.Async.close m
+        let _ ← (FFI.free ctxResult).toBaseIO
+        throw e
+  -- the setup traffic is not charged to the first command
+  let _ ← FFI.ioTake ctxResult
   let s : State := {
     ctx := ctxResult,
     isConnected := true,
     metrics,
     recordLatency := fun cmd microseconds =>
-      if r.enableMetrics then Metrics.recordLatency metrics cmd microseconds else pure ()
+      if r.enableMetrics then Metrics.recordCommand metrics cmd microseconds else pure (),
+    nearCache,
+    mux
   }
   return s
 
@@ -123,6 +398,6 @@ def runRedisNoState
     try
       runRedisFromState r s comp
     finally
-      discard $ EIO.toIO (fun _ => IO.userError "Failed to free Redis context") (FFI.free s.ctx)
+      disconnect s
 
 end Redis
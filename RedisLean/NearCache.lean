@@ -0,0 +1,316 @@
+import Std.Data.HashMap
+import Std.Sync.Mutex
+import RedisLean.Error
+import RedisLean.FFI
+
+namespace Redis
+
+/-!
+# Near Cache
+
+In-process cache for string values and hash fields, kept fresh with Redis
+client-side caching (CLIENT TRACKING).
+
+A second connection speaks RESP3 and receives the `invalidate` pushes; the data
+connection enables tracking with `REDIRECT <id>` to it, so command replies on
+the data connection are never interleaved with pushes. A background task reads
+the invalidation connection and evicts keys as the server reports them.
+
+Races between a read and a concurrent invalidation are handled by reserving
+the slot before the read is sent: an invalidation that arrives before the
+reply drops the reservation, and the reply is then not cached.
+-/
+
+/-- Which keys the server reports invalidations for -/
+inductive TrackingMode where
+  /-- Keys this client has read (the server keeps a tracking table) -/
+  | default
+  /-- Every key under one of the prefixes (BCAST); only those keys are cached -/
+  | bcast (prefixes : List String)
+  deriving Repr, BEq
+
+/-- Near cache configuration (opt-in via `Read.nearCache`) -/
+structure NearCacheConfig where
+  mode : TrackingMode := .default
+  /-- Maximum number of cached values (strings and hash fields) -/
+  maxEntries : Nat := 10000
+  /-- How often the invalidation reader checks for shutdown, in milliseconds -/
+  pollIntervalMs : Nat := 100
+  deriving Repr
+
+namespace NearCache
+
+/-- A cache slot. `pending` reserves the slot while a read is in flight. -/
+inductive Slot where
+  | pending (token : Nat)
+  | value (data : ByteArray) (seq : Nat)
+
+/-- Cache contents: key → (hash field, or `none` for the string value) → slot -/
+structure Entries where
+  slots : Std.HashMap ByteArray (Std.HashMap (Option ByteArray) Slot) := {}
+  /-- Number of filled slots -/
+  size : Nat := 0
+  /-- Fill order for eviction (oldest first, from `head`); records whose slot
+      was invalidated or refilled since are skipped -/
+  order : Array (ByteArray × Option ByteArray × Nat) := #[]
+  head : Nat := 0
+
+namespace Entries
+
+def lookup (e : Entries) (key : ByteArray) (field : Option ByteArray) : Option ByteArray :=
+  match e.slots.get? key >>= (·.get? field) with
+  | some (.value data _) => some data
+  | _ => none
+
+private def isLive (e : Entries) (key : ByteArray) (field : Option ByteArray) (seq : Nat) : Bool :=
+  match e.slots.get? key >>= (·.get? field) with
+  | some (.value _ s) => s == seq
+  | _ => false
+
+/-- Reserve a slot for an upcoming read (keeps an existing value) -/
+def reserve (e : Entries) (key : ByteArray) (field : Option ByteArray) (token : Nat) : Entries :=
+  let fields := e.slots.getD key {}
+  match fields.get? field with
+  | some (.value _ _) => e
+  | _ => { e with slots := e.slots.insert key (fields.insert field (.pending token)) }
+
+/-- Drop a reservation (the read failed) -/
+def cancel (e : Entries) (key : ByteArray) (field : Option ByteArray) (token : Nat) : Entries :=
+  match e.slots.get? key with
+  | none => e
+  | some fields =>
+    match fields.get? field with
+    | some (.pending t) =>
+      if t != token then e else
+      let fields := fields.erase field
+      { e with slots := if fields.isEmpty then e.slots.erase key else e.slots.insert key fields }
+    | _ => e
+
+/-- Drop every slot of a key -/
+def invalidate (e : Entries) (key : ByteArray) : Entries :=
+  match e.slots.get? key with
+  | none => e
+  | some fields =>
+    let filled := fields.fold (init := 0) fun n _ slot =>
+      match slot with
+      | .value _ _ => n + 1
+      | .pending _ => n
+    { e with slots := e.slots.erase key, size := e.size - filled }
+
+/-- Evict the oldest live value -/
+partial def evictOldest (e : Entries) : Entries :=
+  if h : e.head < e.order.size then
+    let (key, field, seq) := e.order[e.head]
+    let e := { e with head := e.head + 1 }
+    if e.isLive key field seq then
+      let fields := (e.slots.getD key {}).erase field
+      { e with
+        slots := if fields.isEmpty then e.slots.erase key else e.slots.insert key fields
+        size := e.size - 1 }
+    else evictOldest e
+  else e
+
+/-- Drop consumed and stale order records once they dominate the queue -/
+private def compact (e : Entries) (maxEntries : Nat) : Entries :=
+  if e.order.size - e.head <= 2 * maxEntries + 16 then e
+  else
+    let live := (e.order.extract e.head e.order.size).filter fun (k, f, s) => e.isLive k f s
+    { e with order := live, head := 0 }
+
+/-- Complete a reservation with the value read from the server. Ignored if
+    the reservation was invalidated meanwhile. -/
+def fill (e : Entries) (key : ByteArray) (field : Option ByteArray) (token : Nat)
+    (data : ByteArray) (seq : Nat) (maxEntries : Nat) : Entries := Id.run do
+  let fields := e.slots.getD key {}
+  match fields.get? field with
+  | some (.pending t) =>
+    if t != token then return e
+    let mut e := { e with
+      slots := e.slots.insert key (fields.insert field (.value data seq))
+      size := e.size + 1
+      order := e.order.push (key, field, seq) }
+    while e.size > maxEntries do
+      e := e.evictOldest
+    return compact e maxEntries
+  | _ => return e
+
+end Entries
+
+end NearCache
+
+/-- A near cache attached to one data connection -/
+structure NearCache where
+  config : NearCacheConfig
+  entries : Std.Mutex NearCache.Entries
+  /-- Source of reservation tokens and fill sequence numbers -/
+  counter : IO.Ref Nat
+  /-- Connection receiving the invalidation pushes -/
+  invalidationCtx : FFI.Ctx
+  /-- CLIENT ID of the invalidation connection (the REDIRECT target) -/
+  redirectId : UInt64
+  /-- Cleared when the invalidation connection is lost: without it the
+      cache cannot stay fresh, so nothing is served or stored any more -/
+  enabled : IO.Ref Bool
+  stopFlag : IO.Ref Bool
+  reader : IO.Ref (Option (Task (Except IO.Error Unit)))
+  hits : IO.Ref Nat
+  misses : IO.Ref Nat
+  invalidations : IO.Ref Nat
+
+namespace NearCache
+
+/-- Byte-wise prefix test -/
+def bytesHasPrefix (data pre : ByteArray) : Bool := Id.run do
+  if pre.size > data.size then return false
+  for i in [0:pre.size] do
+    if data[i]! != pre[i]! then return false
+  return true
+
+/-- Whether a key may be cached (in BCAST mode only keys under a tracked prefix
+    are invalidated by the server) -/
+def cacheable (nc : NearCache) (key : ByteArray) : Bool :=
+  match nc.config.mode with
+  | .default => true
+  | .bcast prefixes => prefixes.any fun p => bytesHasPrefix key p.toUTF8
+
+private def nextId (nc : NearCache) : IO Nat :=
+  nc.counter.modifyGet fun n => (n, n + 1)
+
+/-- Cached value of a string key (`field = none`) or hash field -/
+def lookup (nc : NearCache) (key : ByteArray) (field : Option ByteArray) : IO (Option ByteArray) := do
+  if !(← nc.enabled.get) then return none
+  let v ← nc.entries.atomically do return (← get).lookup key field
+  if v.isSome then nc.hits.modify (· + 1) else nc.misses.modify (· + 1)
+  return v
+
+/-- Reserve the slot before reading from the server; `none` if caching is off -/
+def reserve (nc : NearCache) (key : ByteArray) (field : Option ByteArray) : IO (Option Nat) := do
+  if !(← nc.enabled.get) then return none
+  let token ← nc.nextId
+  nc.entries.atomically (modify (·.reserve key field token))
+  return some token
+
+def fill (nc : NearCache) (key : ByteArray) (field : Option ByteArray) (token : Nat) (data : ByteArray) : IO Unit := do
+  let seq ← nc.nextId
+  nc.entries.atomically (modify (·.fill key field token data seq nc.config.maxEntries))
+
+def cancel (nc : NearCache) (key : ByteArray) (field : Option ByteArray) (token : Nat) : IO Unit :=
+  nc.entries.atomically (modify (·.cancel key field token))
+
+def invalidate (nc : NearCache) (key : ByteArray) : IO Unit :=
+  nc.entries.atomically (modify (·.invalidate key))
+
+def clear (nc : NearCache) : IO Unit :=
+  nc.entries.atomically (set ({} : Entries))
+
+/-- Number of cached values -/
+def size (nc : NearCache) : IO Nat :=
+  nc.entries.atomically do return (← get).size
+
+/-- (hits, misses, invalidations) -/
+def stats (nc : NearCache) : IO (Nat × Nat × Nat) := do
+  return (← nc.hits.get, ← nc.misses.get, ← nc.invalidations.get)
+
+private def disable (nc : NearCache) : IO Unit := do
+  nc.enabled.set false
+  nc.clear
+
+/-- Apply one message from the invalidation connection.
+    `>2 invalidate [key ...]` drops the keys; a nil key list means the
+    server flushed everything (FLUSHALL, or tracking was reset). -/
+def handlePush (nc : NearCache) (r : Reply) : IO Unit := do
+  match r with
+  | .push es =>
+    if es.size != 2 || es[0]!.str? != some "invalidate" then return
+    match es[1]! with
+    | .nil =>
+      nc.invalidations.modify (· + 1)
+      nc.clear
+    | keys =>
+      for key in keys.bytesArray?.getD #[] do
+        nc.invalidations.modify (· + 1)
+        nc.invalidate key
+  | _ => pure ()
+
+/-- Apply the pushes already read into the reader's buffer, up to the first
+    one still incomplete; false if the connection failed -/
+private partial def drainBuffered (nc : NearCache) : IO Bool := do
+  match ← (FFI.getReplyNonBlock nc.invalidationCtx).toBaseIO with
+  | .ok (some r) =>
+    nc.handlePush r
+    drainBuffered nc
+  | .ok none => return true
+  | .error _ => return false
+
+-- One socket read can bring several pushes: all of them are applied before
+-- waiting for the socket again, so no invalidation sits in the buffer while
+-- a stale value is served
+private def readerLoop (nc : NearCache) : IO Unit := do
+  let timeout := nc.config.pollIntervalMs.toUInt64
+  while !(← nc.stopFlag.get) do
+    match ← (FFI.canRead nc.invalidationCtx timeout).toBaseIO with
+    | .error _ =>
+      nc.disable
+      return
+    | .ok false => pure ()
+    | .ok true =>
+      match ← (FFI.getReply nc.invalidationCtx).toBaseIO with
+      | .ok r =>
+        nc.handlePush r
+        if !(← nc.drainBuffered) then
+          nc.disable
+          return
+      | .error _ =>
+        nc.disable
+        return
+
+/-- `CLIENT TRACKING ON REDIRECT <id> [BCAST PREFIX p ...]` -/
+def trackingArgs (mode : TrackingMode) (redirectId : UInt64) : Array ByteArray :=
+  let base := #["CLIENT", "TRACKING", "ON", "REDIRECT", toString redirectId].map String.toUTF8
+  match mode with
+  | .default => base
+  | .bcast prefixes =>
+    prefixes.foldl (init := base.push "BCAST".toUTF8) fun acc p =>
+      (acc.push "PREFIX".toUTF8).push p.toUTF8
+
+/-- Open the invalidation connection, enable tracking on `ctx` and start the
+    background reader -/
+def start (ctx : FFI.Ctx) (config : NearCacheConfig) (host : String) (port : Nat)
+    (ssl : Option SSLConfig := none) : EIO Error NearCache := do
+  let invCtx ← FFI.connect host (UInt32.ofNat port) ssl
+  let redirectId ← try
+    let _ ← FFI.hello invCtx 3
+    let redirectId ← FFI.clientid invCtx
+    let _ ← FFI.commandArgv ctx (trackingArgs config.mode redirectId)
+    pure redirectId
+  catch e =>
+    let _ ← (FFI.free invCtx).toBaseIO
+    throw e
+  let nc : NearCache := {
+    config
+    entries := ← Std.Mutex.new ({} : Entries)
+    counter := ← IO.mkRef 0
+    invalidationCtx := invCtx
+    redirectId
+    enabled := ← IO.mkRef true
+    stopFlag := ← IO.mkRef false
+    reader := ← IO.mkRef none
+    hits := ← IO.mkRef 0
+    misses := ← IO.mkRef 0
+    invalidations := ← IO.mkRef 0
+  }
+  let task ← IO.asTask (prio := .dedicated) (readerLoop nc)
+  nc.reader.set (some task)
+  return nc
+
+/-- Stop the reader and close the invalidation connection -/
+def close (nc : NearCache) : IO Unit := do
+  nc.stopFlag.set true
+  if let some t ← nc.reader.get then
+    let _ ← IO.wait t
+  nc.disable
+  let _ ← (FFI.free nc.invalidationCtx).toBaseIO
+
+end NearCache
+
+end Redis
@@ -30,8 +30,12 @@ class Ops (α: Type) [Codec α] (m : Type → Type) where
   -- operations on keys
   del : List α → m Nat
   existsKey : α → m Bool
+  existsCount : List α → m Nat
   typeKey : α → m RedisValue
   keys : ByteArray → m (List ByteArray)
+  keysArray : ByteArray → m (Array ByteArray)
+  mgetArray : Array α → m (Array (Option ByteArray))
+  msetArray {β : Type} [Codec β] : Array (α × β) → m Unit
   scan : Nat → Option ByteArray → Option Nat → m (Nat × List ByteArray)
   expire : α → Nat → m Bool
   expireAt : α → Nat → m Bool
@@ -55,6 +59,7 @@ class Ops (α: Type) [Codec α] (m : Type → Type) where
   scard : α → m Nat
   sadd {β : Type} [Codec β] : α → β → m Nat
   smembers : α → m (List ByteArray)
+  smembersArray : α → m (Array ByteArray)
   srem {β : Type} [Codec β] : α → List β → m Nat
   spop : α → Option Nat → m (List ByteArray)
   srandmember : α → Option Nat → m (List ByteArray)
@@ -75,6 +80,7 @@ class Ops (α: Type) [Codec α] (m : Type → Type) where
   lpop : α → Option Nat → m (List ByteArray)
   rpop : α → Option Nat → m (List ByteArray)
   lrange : α → Int → Int → m (List ByteArray)
+  lrangeArray : α → Int → Int → m (Array ByteArray)
   lindex : α → Int → m ByteArray
   llen : α → m Nat
   lset {β : Type} [Codec β] : α → Int → β → m Unit
@@ -88,6 +94,7 @@ class Ops (α: Type) [Codec α] (m : Type → Type) where
   hget {β : Type} [Codec β] : α → β → m ByteArray
   hgetAs (β γ : Type) [Codec β] [Codec γ] : α → β → m γ
   hgetall : α → m (List ByteArray)
+  hgetallArray : α → m (Array ByteArray)
   hdel {β : Type} [Codec β] : α → β → m Nat
   hexists {β : Type} [Codec β] : α → β → m Bool
   hincrby {β : Type} [Codec β] : α → β → Int → m Nat
@@ -103,6 +110,7 @@ class Ops (α: Type) [Codec α] (m : Type → Type) where
   zadd {β : Type} [Codec β] : α → Float → β → m Nat
   zcard : α → m Nat
   zrange : α → Int → Int → m (List ByteArray)
+  zrangeArray : α → Int → Int → m (Array ByteArray)
   zscore {β : Type} [Codec β] : α → β → m (Option Float)
   zrank {β : Type} [Codec β] : α → β → m (Option Nat)
   zrevrank {β : Type} [Codec β] : α → β → m (Option Nat)
@@ -142,7 +150,7 @@ class Ops (α: Type) [Codec α] (m : Type → Type) where
 
   -- Redis Streams operations
   xadd {β : Type} [Codec β] : α → String → List (α × β) → Option Nat → m String
-  xread : List (α × String) → Option Nat → Option Nat → m ByteArray
+  xread : List (α × String) → Option Nat → Option Nat → m FFI.StreamRead
   xrange : α → String → String → Option Nat → m ByteArray
   xlen : α → m Nat
   xdel : α → List String → m Nat
@@ -160,219 +168,292 @@ class Ops (α: Type) [Codec α] (m : Type → Type) where
 -- implementation for the RedisM monad using FFI.hiredis
 instance [Codec α] : Ops α RedisM where
   -- String operations
-  set := fun k v => liftRedisEIO RedisCmd.SET (fun ctx => FFI.Internal.set ctx (Codec.enc k) (Codec.enc v) FFI.SetExistsOption.none.toUInt8)
-  setnx := fun k v => liftRedisEIO RedisCmd.SET (fun ctx => FFI.Internal.set ctx (Codec.enc k) (Codec.enc v) FFI.SetExistsOption.nx.toUInt8)
-  setxx := fun k v => liftRedisEIO RedisCmd.SET (fun ctx => FFI.Internal.set ctx (Codec.enc k) (Codec.enc v) FFI.SetExistsOption.xx.toUInt8)
-  setex := fun k v msec => liftRedisEIO RedisCmd.SETEX (fun ctx => FFI.Internal.setex ctx (Codec.enc k) (Codec.enc v) (UInt64.ofNat msec) FFI.SetExistsOption.none.toUInt8)
-  setexnx := fun k v msec => liftRedisEIO RedisCmd.SETEX (fun ctx => FFI.Internal.setex ctx (Codec.enc k) (Codec.enc v) (UInt64.ofNat msec) FFI.SetExistsOption.nx.toUInt8)
-  setexxx := fun k v msec => liftRedisEIO RedisCmd.SETEX (fun ctx => FFI.Internal.setex ctx (Codec.enc k) (Codec.enc v) (UInt64.ofNat msec) FFI.SetExistsOption.xx.toUInt8)
+  set := fun k v => do
+    let (key, val) := (Codec.enc k, Codec.enc v)
+    nearWrite #[key] (liftRedisPipelined RedisCmd.SET #["SET".toUTF8, key, val] (AutoPipeline.ok "SET")
+      (fun ctx => FFI.Internal.set ctx key val FFI.SetExistsOption.none.toUInt8))
+  setnx := fun k v => do
+    let (key, val) := (Codec.enc k, Codec.enc v)
+    nearWrite #[key] (liftRedisPipelined RedisCmd.SET #["SET".toUTF8, key, val, "NX".toUTF8] (AutoPipeline.ok "SET")
+      (fun ctx => FFI.Internal.set ctx key val FFI.SetExistsOption.nx.toUInt8))
+  setxx := fun k v => do
+    let (key, val) := (Codec.enc k, Codec.enc v)
+    nearWrite #[key] (liftRedisPipelined RedisCmd.SET #["SET".toUTF8, key, val, "XX".toUTF8] (AutoPipeline.ok "SET")
+      (fun ctx => FFI.Internal.set ctx key val FFI.SetExistsOption.xx.toUInt8))
+  setex := fun k v msec => liftRedisWrite #[Codec.enc k] RedisCmd.SETEX (fun ctx => FFI.Internal.setex ctx (Codec.enc k) (Codec.enc v) (UInt64.ofNat msec) FFI.SetExistsOption.none.toUInt8)
+  setexnx := fun k v msec => liftRedisWrite #[Codec.enc k] RedisCmd.SETEX (fun ctx => FFI.Internal.setex ctx (Codec.enc k) (Codec.enc v) (UInt64.ofNat msec) FFI.SetExistsOption.nx.toUInt8)
+  setexxx := fun k v msec => liftRedisWrite #[Codec.enc k] RedisCmd.SETEX (fun ctx => FFI.Internal.setex ctx (Codec.enc k) (Codec.enc v) (UInt64.ofNat msec) FFI.SetExistsOption.xx.toUInt8)
   get := fun k => do
-    let tmp ← liftRedisEIO RedisCmd.GET (fun ctx => FFI.Internal.get ctx (Codec.enc k))
-    return tmp
+    let key := Codec.enc k
+    nearCached key none (liftRedisPipelined RedisCmd.GET #["GET".toUTF8, key] (AutoPipeline.bytes "GET" key)
+      (fun ctx => FFI.Internal.get ctx key))
   getAs := fun β [Codec β] k => do
-    let tmp ← liftRedisEIO RedisCmd.GET (fun ctx => FFI.Internal.get ctx (Codec.enc k))
+    let key := Codec.enc k
+    let tmp ← nearCached key none (liftRedisPipelined RedisCmd.GET #["GET".toUTF8, key] (AutoPipeline.bytes "GET" key)
+      (fun ctx => FFI.Internal.get ctx key))
     match Codec.dec tmp with
     | .ok value => return value
     | .error msg => throw (Error.otherError s!"Codec decoding failed: {msg}")
   append := fun k v => do
-    let result ← liftRedisEIO RedisCmd.APPEND (fun ctx => FFI.Internal.append ctx (Codec.enc k) (Codec.enc v))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.APPEND (fun ctx => FFI.Internal.append ctx (Codec.enc k) (Codec.enc v))
     return result.toNat
-  getdel := fun k => liftRedisEIO RedisCmd.GETDEL (fun ctx => FFI.Internal.getdel ctx (Codec.enc k))
-  getrange := fun k start end_ => liftRedisEIO RedisCmd.GETRANGE (fun ctx => FFI.Internal.getrange ctx (Codec.enc k) (Int64.ofInt start) (Int64.ofInt end_))
+  getdel := fun k => liftRedisWrite #[Codec.enc k] RedisCmd.GETDEL (fun ctx => FFI.Internal.getdel ctx (Codec.enc k))
+  getrange := fun k start end_ => liftRedisKeyed #[Codec.enc k] RedisCmd.GETRANGE (fun ctx => FFI.Internal.getrange ctx (Codec.enc k) (Int64.ofInt start) (Int64.ofInt end_))
   strlen := fun k => do
-    let result ← liftRedisEIO RedisCmd.STRLEN (fun ctx => FFI.Internal.strlen ctx (Codec.enc k))
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.STRLEN (fun ctx => FFI.Internal.strlen ctx (Codec.enc k))
     return result.toNat
-  incrByFloat := fun k increment => liftRedisEIO RedisCmd.INCRBYFLOAT (fun ctx => FFI.Internal.incrbyfloat ctx (Codec.enc k) increment)
+  incrByFloat := fun k increment => liftRedisWrite #[Codec.enc k] RedisCmd.INCRBYFLOAT (fun ctx => FFI.Internal.incrbyfloat ctx (Codec.enc k) increment)
 
   -- Key operations
   del := fun ks => do
-    let result ← liftRedisEIO RedisCmd.DEL (fun ctx => FFI.Internal.del ctx (ks.map Codec.enc))
+    let keys := ks.toArray.map Codec.enc
+    let result ← nearWrite keys (liftRedisMultiKey RedisCmd.DEL keys (Cluster.subCommand "DEL" keys)
+      (fun _ => Cluster.sumReplies "DEL")
+      (liftRedisPipelined RedisCmd.DEL (#["DEL".toUTF8] ++ keys) (AutoPipeline.uint64 "DEL")
+        (fun ctx => FFI.Internal.del ctx keys)))
+    return result.toNat
+  existsKey := fun k => do
+    let key := Codec.enc k
+    liftRedisPipelined RedisCmd.EXISTS #["EXISTS".toUTF8, key] (AutoPipeline.bool "EXISTS")
+      (fun ctx => FFI.Internal.existsKey ctx key)
+  existsCount := fun ks => do
+    let keys := ks.toArray.map Codec.enc
+    let result ← liftRedisMultiKey RedisCmd.EXISTS keys (Cluster.subCommand "EXISTS" keys)
+      (fun _ => Cluster.sumReplies "EXISTS")
+      (liftRedisKeyed keys RedisCmd.EXISTS (fun ctx => do
+        let r ← FFI.commandArgv ctx (#["EXISTS".toUTF8] ++ keys)
+        MonadExcept.ofExcept (AutoPipeline.uint64 "EXISTS" r)))
     return result.toNat
-  existsKey := fun k => liftRedisEIO RedisCmd.EXISTS (fun ctx => FFI.Internal.existsKey ctx (Codec.enc k))
   typeKey := fun k => do
-    let typeString ← liftRedisEIO RedisCmd.TYPE (fun ctx => FFI.Internal.typeKey ctx (Codec.enc k))
+    let typeString ← liftRedisKeyed #[Codec.enc k] RedisCmd.TYPE (fun ctx => FFI.Internal.typeKey ctx (Codec.enc k))
     return RedisValue.fromString typeString
   keys := fun pattern => liftRedisEIO RedisCmd.KEYS (fun ctx => FFI.Internal.keys ctx pattern)
+  keysArray := fun pattern => liftRedisEIO RedisCmd.KEYS (fun ctx => FFI.Internal.keysArray ctx pattern)
+  mgetArray := fun ks => do
+    let keys := ks.map Codec.enc
+    liftRedisMultiKey RedisCmd.MGET keys (Cluster.subCommand "MGET" keys)
+      (Cluster.scatterValues keys.size)
+      (liftRedisKeyed keys RedisCmd.MGET (fun ctx => FFI.Internal.mgetArray ctx keys))
+  msetArray := fun {β} [Codec β] kvs => do
+    let pairs := kvs.map fun (k, v) => (Codec.enc k, Codec.enc v)
+    let keys := pairs.map (·.1)
+    nearWrite keys (liftRedisMultiKey RedisCmd.MSET keys
+      (fun positions => positions.foldl (fun argv i => (argv.push pairs[i]!.1).push pairs[i]!.2) #["MSET".toUTF8])
+      (fun _ => Cluster.allOk "MSET")
+      (liftRedisKeyed keys RedisCmd.MSET (fun ctx => FFI.Internal.mset ctx pairs)))
   scan := fun cursor pattern count => do
     let count_u64 := count.map UInt64.ofNat
     let result ← liftRedisEIO RedisCmd.SCAN (fun ctx => FFI.Internal.scan ctx (UInt64.ofNat cursor) pattern count_u64 none)
     return (result.1.toNat, result.2)
-  expire := fun k seconds => liftRedisEIO RedisCmd.EXPIRE (fun ctx => FFI.Internal.expire ctx (Codec.enc k) (UInt64.ofNat seconds))
-  expireAt := fun k timestamp => liftRedisEIO RedisCmd.EXPIREAT (fun ctx => FFI.Internal.expireat ctx (Codec.enc k) (UInt64.ofNat timestamp))
-  pexpire := fun k milliseconds => liftRedisEIO RedisCmd.PEXPIRE (fun ctx => FFI.Internal.pexpire ctx (Codec.enc k) (UInt64.ofNat milliseconds))
-  pexpireAt := fun k timestamp => liftRedisEIO RedisCmd.PEXPIREAT (fun ctx => FFI.Internal.pexpireat ctx (Codec.enc k) (UInt64.ofNat timestamp))
-  persist := fun k => liftRedisEIO RedisCmd.PERSIST (fun ctx => FFI.Internal.persistKey ctx (Codec.enc k))
-  rename := fun k newkey => liftRedisEIO RedisCmd.RENAME (fun ctx => FFI.Internal.renameKey ctx (Codec.enc k) (Codec.enc newkey))
-  renamenx := fun k newkey => liftRedisEIO RedisCmd.RENAMENX (fun ctx => FFI.Internal.renamenx ctx (Codec.enc k) (Codec.enc newkey))
-  copy := fun src dst replace => liftRedisEIO RedisCmd.COPY (fun ctx => FFI.Internal.copyKey ctx (Codec.enc src) (Codec.enc dst) (if replace then 1 else 0))
+  expire := fun k seconds => do
+    let key := Codec.enc k
+    nearWrite #[key] (liftRedisPipelined RedisCmd.EXPIRE #["EXPIRE".toUTF8, key, (toString seconds).toUTF8] AutoPipeline.expire
+      (fun ctx => FFI.Internal.expire ctx key (UInt64.ofNat seconds)))
+  expireAt := fun k timestamp => liftRedisWrite #[Codec.enc k] RedisCmd.EXPIREAT (fun ctx => FFI.Internal.expireat ctx (Codec.enc k) (UInt64.ofNat timestamp))
+  pexpire := fun k milliseconds => liftRedisWrite #[Codec.enc k] RedisCmd.PEXPIRE (fun ctx => FFI.Internal.pexpire ctx (Codec.enc k) (UInt64.ofNat milliseconds))
+  pexpireAt := fun k timestamp => liftRedisWrite #[Codec.enc k] RedisCmd.PEXPIREAT (fun ctx => FFI.Internal.pexpireat ctx (Codec.enc k) (UInt64.ofNat timestamp))
+  persist := fun k => liftRedisWrite #[Codec.enc k] RedisCmd.PERSIST (fun ctx => FFI.Internal.persistKey ctx (Codec.enc k))
+  rename := fun k newkey => liftRedisWrite #[Codec.enc k, Codec.enc newkey] RedisCmd.RENAME (fun ctx => FFI.Internal.renameKey ctx (Codec.enc k) (Codec.enc newkey))
+  renamenx := fun k newkey => liftRedisWrite #[Codec.enc k, Codec.enc newkey] RedisCmd.RENAMENX (fun ctx => FFI.Internal.renamenx ctx (Codec.enc k) (Codec.enc newkey))
+  copy := fun src dst replace => liftRedisWrite #[Codec.enc dst] RedisCmd.COPY (fun ctx => FFI.Internal.copyKey ctx (Codec.enc src) (Codec.enc dst) (if replace then 1 else 0))
   unlink := fun ks => do
-    let result ← liftRedisEIO RedisCmd.UNLINK (fun ctx => FFI.Internal.unlink ctx (ks.map Codec.enc))
+    let keys := ks.toArray.map Codec.enc
+    let result ← nearWrite keys (liftRedisMultiKey RedisCmd.UNLINK keys (Cluster.subCommand "UNLINK" keys)
+      (fun _ => Cluster.sumReplies "UNLINK")
+      (liftRedisKeyed keys RedisCmd.UNLINK (fun ctx => FFI.Internal.unlink ctx keys)))
     return result.toNat
   touch := fun ks => do
-    let result ← liftRedisEIO RedisCmd.TOUCH (fun ctx => FFI.Internal.touch ctx (ks.map Codec.enc))
+    let keys := ks.toArray.map Codec.enc
+    let result ← liftRedisMultiKey RedisCmd.TOUCH keys (Cluster.subCommand "TOUCH" keys)
+      (fun _ => Cluster.sumReplies "TOUCH")
+      (liftRedisKeyed keys RedisCmd.TOUCH (fun ctx => FFI.Internal.touch ctx keys))
     return result.toNat
 
   -- Numeric string operations
   incr := fun k => do
-    let result ← liftRedisEIO RedisCmd.INCR (fun ctx => FFI.Internal.incr ctx (Codec.enc k))
+    let key := Codec.enc k
+    let result ← nearWrite #[key] (liftRedisPipelined RedisCmd.INCR #["INCR".toUTF8, key] (AutoPipeline.uint64 "INCR")
+      (fun ctx => FFI.Internal.incr ctx key))
     return Int.ofNat result.toNat
   incrBy := fun k n => do
-    let result ← liftRedisEIO RedisCmd.INCRBY (fun ctx => FFI.Internal.incrby ctx (Codec.enc k) (Int64.ofInt n))
+    let key := Codec.enc k
+    let result ← nearWrite #[key] (liftRedisPipelined RedisCmd.INCRBY #["INCRBY".toUTF8, key, (toString n).toUTF8] (AutoPipeline.uint64 "INCRBY")
+      (fun ctx => FFI.Internal.incrby ctx key (Int64.ofInt n)))
     return Int.ofNat result.toNat
   decr := fun k => do
-    let result ← liftRedisEIO RedisCmd.DECR (fun ctx => FFI.Internal.decr ctx (Codec.enc k))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.DECR (fun ctx => FFI.Internal.decr ctx (Codec.enc k))
     return Int.ofNat result.toNat
   decrBy := fun k decrement => do
-    let result ← liftRedisEIO RedisCmd.DECRBY (fun ctx => FFI.Internal.decrby ctx (Codec.enc k) (Int64.ofInt decrement))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.DECRBY (fun ctx => FFI.Internal.decrby ctx (Codec.enc k) (Int64.ofInt decrement))
     return Int.ofNat result.toNat
 
   -- Set operations
-  sismember := fun k member => liftRedisEIO RedisCmd.SISMEMBER (fun ctx => FFI.Internal.sismember ctx (Codec.enc k) (Codec.enc member))
+  sismember := fun k member => do
+    let (key, m) := (Codec.enc k, Codec.enc member)
+    liftRedisPipelined RedisCmd.SISMEMBER #["SISMEMBER".toUTF8, key, m] (AutoPipeline.bool "SISMEMBER")
+      (fun ctx => FFI.Internal.sismember ctx key m)
   scard := fun k => do
-    let result ← liftRedisEIO RedisCmd.SCARD (fun ctx => FFI.Internal.scard ctx (Codec.enc k))
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.SCARD (fun ctx => FFI.Internal.scard ctx (Codec.enc k))
     return result.toNat
   sadd := fun k member => do
-    let result ← liftRedisEIO RedisCmd.SADD (fun ctx => FFI.Internal.sadd ctx (Codec.enc k) (Codec.enc member))
+    let (key, m) := (Codec.enc k, Codec.enc member)
+    let result ← nearWrite #[key] (liftRedisPipelined RedisCmd.SADD #["SADD".toUTF8, key, m] (AutoPipeline.uint64On "set" "SADD")
+      (fun ctx => FFI.Internal.sadd ctx key m))
     return result.toNat
-  smembers := fun k => liftRedisEIO RedisCmd.SMEMBERS (fun ctx => FFI.Internal.smembers ctx (Codec.enc k))
+  smembers := fun k => liftRedisKeyed #[Codec.enc k] RedisCmd.SMEMBERS (fun ctx => FFI.Internal.smembers ctx (Codec.enc k))
+  smembersArray := fun k => liftRedisKeyed #[Codec.enc k] RedisCmd.SMEMBERS (fun ctx => FFI.Internal.smembersArray ctx (Codec.enc k))
   srem := fun k members => do
-    let result ← liftRedisEIO RedisCmd.SREM (fun ctx => FFI.Internal.srem ctx (Codec.enc k) (members.map Codec.enc))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.SREM (fun ctx => FFI.Internal.srem ctx (Codec.enc k) (members.toArray.map Codec.enc))
     return result.toNat
-  spop := fun k count => liftRedisEIO RedisCmd.SPOP (fun ctx => FFI.Internal.spop ctx (Codec.enc k) (count.map UInt64.ofNat))
-  srandmember := fun k count => liftRedisEIO RedisCmd.SRANDMEMBER (fun ctx => FFI.Internal.srandmember ctx (Codec.enc k) (count.map UInt64.ofNat))
-  smove := fun src dst member => liftRedisEIO RedisCmd.SMOVE (fun ctx => FFI.Internal.smove ctx (Codec.enc src) (Codec.enc dst) (Codec.enc member))
-  sdiff := fun keys => liftRedisEIO RedisCmd.SDIFF (fun ctx => FFI.Internal.sdiff ctx (keys.map Codec.enc))
+  spop := fun k count => liftRedisWrite #[Codec.enc k] RedisCmd.SPOP (fun ctx => FFI.Internal.spop ctx (Codec.enc k) (count.map UInt64.ofNat))
+  srandmember := fun k count => liftRedisKeyed #[Codec.enc k] RedisCmd.SRANDMEMBER (fun ctx => FFI.Internal.srandmember ctx (Codec.enc k) (count.map UInt64.ofNat))
+  smove := fun src dst member =>
+    nearWrite #[Codec.enc src, Codec.enc dst] (liftRedisKeyed #[Codec.enc src] RedisCmd.SMOVE (fun ctx => FFI.Internal.smove ctx (Codec.enc src) (Codec.enc dst) (Codec.enc member)))
+  sdiff := fun keys => liftRedisKeyed (keys.toArray.map Codec.enc) RedisCmd.SDIFF (fun ctx => FFI.Internal.sdiff ctx (keys.toArray.map Codec.enc))
   sdiffstore := fun dst keys => do
-    let result ← liftRedisEIO RedisCmd.SDIFFSTORE (fun ctx => FFI.Internal.sdiffstore ctx (Codec.enc dst) (keys.map Codec.enc))
+    let result ← liftRedisWrite #[Codec.enc dst] RedisCmd.SDIFFSTORE (fun ctx => FFI.Internal.sdiffstore ctx (Codec.enc dst) (keys.toArray.map Codec.enc))
     return result.toNat
-  sinter := fun keys => liftRedisEIO RedisCmd.SINTER (fun ctx => FFI.Internal.sinter ctx (keys.map Codec.enc))
+  sinter := fun keys => liftRedisKeyed (keys.toArray.map Codec.enc) RedisCmd.SINTER (fun ctx => FFI.Internal.sinter ctx (keys.toArray.map Codec.enc))
   sinterstore := fun dst keys => do
-    let result ← liftRedisEIO RedisCmd.SINTERSTORE (fun ctx => FFI.Internal.sinterstore ctx (Codec.enc dst) (keys.map Codec.enc))
+    let result ← liftRedisWrite #[Codec.enc dst] RedisCmd.SINTERSTORE (fun ctx => FFI.Internal.sinterstore ctx (Codec.enc dst) (keys.toArray.map Codec.enc))
     return result.toNat
-  sunion := fun keys => liftRedisEIO RedisCmd.SUNION (fun ctx => FFI.Internal.sunion ctx (keys.map Codec.enc))
+  sunion := fun keys => liftRedisKeyed (keys.toArray.map Codec.enc) RedisCmd.SUNION (fun ctx => FFI.Internal.sunion ctx (keys.toArray.map Codec.enc))
   sunionstore := fun dst keys => do
-    let result ← liftRedisEIO RedisCmd.SUNIONSTORE (fun ctx => FFI.Internal.sunionstore ctx (Codec.enc dst) (keys.map Codec.enc))
+    let result ← liftRedisWrite #[Codec.enc dst] RedisCmd.SUNIONSTORE (fun ctx => FFI.Internal.sunionstore ctx (Codec.enc dst) (keys.toArray.map Codec.enc))
     return result.toNat
   sscan := fun k cursor pattern count => do
     let count_u64 := count.map UInt64.ofNat
-    let result ← liftRedisEIO RedisCmd.SSCAN (fun ctx => FFI.Internal.sscan ctx (Codec.enc k) (UInt64.ofNat cursor) pattern count_u64)
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.SSCAN (fun ctx => FFI.Internal.sscan ctx (Codec.enc k) (UInt64.ofNat cursor) pattern count_u64)
     return (result.1.toNat, result.2)
 
   -- List operations
   lpush := fun k values => do
-    let result ← liftRedisEIO RedisCmd.LPUSH (fun ctx => FFI.Internal.lpush ctx (Codec.enc k) (values.map Codec.enc))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.LPUSH (fun ctx => FFI.Internal.lpush ctx (Codec.enc k) (values.toArray.map Codec.enc))
     return result.toNat
   rpush := fun k values => do
-    let result ← liftRedisEIO RedisCmd.RPUSH (fun ctx => FFI.Internal.rpush ctx (Codec.enc k) (values.map Codec.enc))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.RPUSH (fun ctx => FFI.Internal.rpush ctx (Codec.enc k) (values.toArray.map Codec.enc))
     return result.toNat
   lpushx := fun k values => do
-    let result ← liftRedisEIO RedisCmd.LPUSHX (fun ctx => FFI.Internal.lpushx ctx (Codec.enc k) (values.map Codec.enc))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.LPUSHX (fun ctx => FFI.Internal.lpushx ctx (Codec.enc k) (values.toArray.map Codec.enc))
     return result.toNat
   rpushx := fun k values => do
-    let result ← liftRedisEIO RedisCmd.RPUSHX (fun ctx => FFI.Internal.rpushx ctx (Codec.enc k) (values.map Codec.enc))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.RPUSHX (fun ctx => FFI.Internal.rpushx ctx (Codec.enc k) (values.toArray.map Codec.enc))
     return result.toNat
-  lpop := fun k count => liftRedisEIO RedisCmd.LPOP (fun ctx => FFI.Internal.lpop ctx (Codec.enc k) (count.map UInt64.ofNat))
-  rpop := fun k count => liftRedisEIO RedisCmd.RPOP (fun ctx => FFI.Internal.rpop ctx (Codec.enc k) (count.map UInt64.ofNat))
-  lrange := fun k start stop => liftRedisEIO RedisCmd.LRANGE (fun ctx => FFI.Internal.lrange ctx (Codec.enc k) (Int64.ofInt start) (Int64.ofInt stop))
-  lindex := fun k index => liftRedisEIO RedisCmd.LINDEX (fun ctx => FFI.Internal.lindex ctx (Codec.enc k) (Int64.ofInt index))
+  lpop := fun k count => liftRedisWrite #[Codec.enc k] RedisCmd.LPOP (fun ctx => FFI.Internal.lpop ctx (Codec.enc k) (count.map UInt64.ofNat))
+  rpop := fun k count => liftRedisWrite #[Codec.enc k] RedisCmd.RPOP (fun ctx => FFI.Internal.rpop ctx (Codec.enc k) (count.map UInt64.ofNat))
+  lrange := fun k start stop => liftRedisKeyed #[Codec.enc k] RedisCmd.LRANGE (fun ctx => FFI.Internal.lrange ctx (Codec.enc k) (Int64.ofInt start) (Int64.ofInt stop))
+  lrangeArray := fun k start stop => liftRedisKeyed #[Codec.enc k] RedisCmd.LRANGE (fun ctx => FFI.Internal.lrangeArray ctx (Codec.enc k) (Int64.ofInt start) (Int64.ofInt stop))
+  lindex := fun k index => liftRedisKeyed #[Codec.enc k] RedisCmd.LINDEX (fun ctx => FFI.Internal.lindex ctx (Codec.enc k) (Int64.ofInt index))
   llen := fun k => do
-    let result ← liftRedisEIO RedisCmd.LLEN (fun ctx => FFI.Internal.llen ctx (Codec.enc k))
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.LLEN (fun ctx => FFI.Internal.llen ctx (Codec.enc k))
     return result.toNat
-  lset := fun k index value => liftRedisEIO RedisCmd.LSET (fun ctx => FFI.Internal.lset ctx (Codec.enc k) (Int64.ofInt index) (Codec.enc value))
+  lset := fun k index value => liftRedisWrite #[Codec.enc k] RedisCmd.LSET (fun ctx => FFI.Internal.lset ctx (Codec.enc k) (Int64.ofInt index) (Codec.enc value))
   linsertBefore := fun k pivot value => do
-    let result ← liftRedisEIO RedisCmd.LINSERT (fun ctx => FFI.Internal.linsert ctx (Codec.enc k) 0 (Codec.enc pivot) (Codec.enc value))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.LINSERT (fun ctx => FFI.Internal.linsert ctx (Codec.enc k) 0 (Codec.enc pivot) (Codec.enc value))
     return result.toInt
   linsertAfter := fun k pivot value => do
-    let result ← liftRedisEIO RedisCmd.LINSERT (fun ctx => FFI.Internal.linsert ctx (Codec.enc k) 1 (Codec.enc pivot) (Codec.enc value))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.LINSERT (fun ctx => FFI.Internal.linsert ctx (Codec.enc k) 1 (Codec.enc pivot) (Codec.enc value))
     return result.toInt
-  ltrim := fun k start stop => liftRedisEIO RedisCmd.LTRIM (fun ctx => FFI.Internal.ltrim ctx (Codec.enc k) (Int64.ofInt start) (Int64.ofInt stop))
+  ltrim := fun k start stop => liftRedisWrite #[Codec.enc k] RedisCmd.LTRIM (fun ctx => FFI.Internal.ltrim ctx (Codec.enc k) (Int64.ofInt start) (Int64.ofInt stop))
   lrem := fun k count element => do
-    let result ← liftRedisEIO RedisCmd.LREM (fun ctx => FFI.Internal.lrem ctx (Codec.enc k) (Int64.ofInt count) (Codec.enc element))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.LREM (fun ctx => FFI.Internal.lrem ctx (Codec.enc k) (Int64.ofInt count) (Codec.enc element))
     return result.toNat
 
   -- Hash operations
   hset := fun {β γ} [Codec β] [Codec γ] k field value => do
-    let result ← liftRedisEIO RedisCmd.HSET (fun ctx => FFI.Internal.hset ctx (Codec.enc k) (Codec.enc field) (Codec.enc value))
-    return result.toNat
-  hget := fun {β} [Codec β] k field => liftRedisEIO RedisCmd.HGET (fun ctx => FFI.Internal.hget ctx (Codec.enc k) (Codec.enc field))
+    let (key, f, v) := (Codec.enc k, Codec.enc field, Codec.enc value)
+    let result ← nearWrite #[key] (liftRedisPipelined RedisCmd.HSET #["HSET".toUTF8, key, f, v] (AutoPipeline.uint64On "hash" "HSET")
+      (fun ctx => FFI.Internal.hset ctx key f v))
+    return result.toNat
+  hget := fun {β} [Codec β] k field => do
+    let (key, f) := (Codec.enc k, Codec.enc field)
+    nearCached key (some f) (liftRedisPipelined RedisCmd.HGET #["HGET".toUTF8, key, f] (AutoPipeline.field key)
+      (fun ctx => FFI.Internal.hget ctx key f))
   hgetAs := fun β γ [Codec β] [Codec γ] k field => do
-    let tmp ← liftRedisEIO RedisCmd.HGET (fun ctx => FFI.Internal.hget ctx (Codec.enc k) (Codec.enc field))
+    let (key, f) := (Codec.enc k, Codec.enc field)
+    let tmp ← nearCached key (some f) (liftRedisPipelined RedisCmd.HGET #["HGET".toUTF8, key, f] (AutoPipeline.field key)
+      (fun ctx => FFI.Internal.hget ctx key f))
     match Codec.dec tmp with
     | .ok value => return value
     | .error msg => throw (Error.otherError s!"Codec decoding failed: {msg}")
-  hgetall := fun k => liftRedisEIO RedisCmd.HGETALL (fun ctx => FFI.Internal.hgetall ctx (Codec.enc k))
+  hgetall := fun k => liftRedisKeyed #[Codec.enc k] RedisCmd.HGETALL (fun ctx => FFI.Internal.hgetall ctx (Codec.enc k))
+  hgetallArray := fun k => liftRedisKeyed #[Codec.enc k] RedisCmd.HGETALL (fun ctx => FFI.Internal.hgetallArray ctx (Codec.enc k))
   hdel := fun {β} [Codec β] k field => do
-    let result ← liftRedisEIO RedisCmd.HDEL (fun ctx => FFI.Internal.hdel ctx (Codec.enc k) (Codec.enc field))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.HDEL (fun ctx => FFI.Internal.hdel ctx (Codec.enc k) (Codec.enc field))
     return result.toNat
-  hexists := fun {β} [Codec β] k field => liftRedisEIO RedisCmd.HEXISTS (fun ctx => FFI.Internal.hexists ctx (Codec.enc k) (Codec.enc field))
+  hexists := fun {β} [Codec β] k field => do
+    let (key, f) := (Codec.enc k, Codec.enc field)
+    liftRedisPipelined RedisCmd.HEXISTS #["HEXISTS".toUTF8, key, f] (AutoPipeline.boolOn "hash" "HEXISTS")
+      (fun ctx => FFI.Internal.hexists ctx key f)
   hincrby := fun {β} [Codec β] k field increment => do
-    let result ← liftRedisEIO RedisCmd.HINCRBY (fun ctx => FFI.Internal.hincrby ctx (Codec.enc k) (Codec.enc field) (Int64.ofInt increment))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.HINCRBY (fun ctx => FFI.Internal.hincrby ctx (Codec.enc k) (Codec.enc field) (Int64.ofInt increment))
     return result.toNat
-  hkeys := fun k => liftRedisEIO RedisCmd.HKEYS (fun ctx => FFI.Internal.hkeys ctx (Codec.enc k))
+  hkeys := fun k => liftRedisKeyed #[Codec.enc k] RedisCmd.HKEYS (fun ctx => FFI.Internal.hkeys ctx (Codec.enc k))
   hlen := fun k => do
-    let result ← liftRedisEIO RedisCmd.HLEN (fun ctx => FFI.Internal.hlen ctx (Codec.enc k))
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.HLEN (fun ctx => FFI.Internal.hlen ctx (Codec.enc k))
     return result.toNat
-  hvals := fun k => liftRedisEIO RedisCmd.HVALS (fun ctx => FFI.Internal.hvals ctx (Codec.enc k))
-  hsetnx := fun {β γ} [Codec β] [Codec γ] k field value => liftRedisEIO RedisCmd.HSETNX (fun ctx => FFI.Internal.hsetnx ctx (Codec.enc k) (Codec.enc field) (Codec.enc value))
-  hmget := fun {β} [Codec β] k fields => liftRedisEIO RedisCmd.HMGET (fun ctx => FFI.Internal.hmget ctx (Codec.enc k) (fields.map Codec.enc))
-  hincrbyfloat := fun {β} [Codec β] k field increment => liftRedisEIO RedisCmd.HINCRBYFLOAT (fun ctx => FFI.hincrByFloat ctx (Codec.enc k) (Codec.enc field) increment)
+  hvals := fun k => liftRedisKeyed #[Codec.enc k] RedisCmd.HVALS (fun ctx => FFI.Internal.hvals ctx (Codec.enc k))
+  hsetnx := fun {β γ} [Codec β] [Codec γ] k field value => liftRedisWrite #[Codec.enc k] RedisCmd.HSETNX (fun ctx => FFI.Internal.hsetnx ctx (Codec.enc k) (Codec.enc field) (Codec.enc value))
+  hmget := fun {β} [Codec β] k fields => liftRedisKeyed #[Codec.enc k] RedisCmd.HMGET (fun ctx => FFI.Internal.hmget ctx (Codec.enc k) (fields.toArray.map Codec.enc))
+  hincrbyfloat := fun {β} [Codec β] k field increment => liftRedisWrite #[Codec.enc k] RedisCmd.HINCRBYFLOAT (fun ctx => FFI.hincrByFloat ctx (Codec.enc k) (Codec.enc field) increment)
   hscan := fun {β} [Codec β] k cursor pattern count => do
     let count_u64 := count.map UInt64.ofNat
-    let result ← liftRedisEIO RedisCmd.HSCAN (fun ctx => FFI.Internal.hscan ctx (Codec.enc k) (UInt64.ofNat cursor) pattern count_u64)
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.HSCAN (fun ctx => FFI.Internal.hscan ctx (Codec.enc k) (UInt64.ofNat cursor) pattern count_u64)
     return (result.1.toNat, result.2)
 
   -- Sorted set operations
   zadd := fun {β} [Codec β] k score member => do
-    let result ← liftRedisEIO RedisCmd.ZADD (fun ctx => FFI.Internal.zadd ctx (Codec.enc k) score (Codec.enc member))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.ZADD (fun ctx => FFI.Internal.zadd ctx (Codec.enc k) score (Codec.enc member))
     return result.toNat
   zcard := fun k => do
-    let result ← liftRedisEIO RedisCmd.ZCARD (fun ctx => FFI.Internal.zcard ctx (Codec.enc k))
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.ZCARD (fun ctx => FFI.Internal.zcard ctx (Codec.enc k))
     return result.toNat
-  zrange := fun k start stop => liftRedisEIO RedisCmd.ZRANGE (fun ctx => FFI.Internal.zrange ctx (Codec.enc k) (Int64.ofInt start) (Int64.ofInt stop))
-  zscore := fun {β} [Codec β] k member => liftRedisEIO RedisCmd.ZSCORE (fun ctx => FFI.Internal.zscore ctx (Codec.enc k) (Codec.enc member))
+  zrange := fun k start stop => liftRedisKeyed #[Codec.enc k] RedisCmd.ZRANGE (fun ctx => FFI.Internal.zrange ctx (Codec.enc k) (Int64.ofInt start) (Int64.ofInt stop))
+  zrangeArray := fun k start stop => liftRedisKeyed #[Codec.enc k] RedisCmd.ZRANGE (fun ctx => FFI.Internal.zrangeArray ctx (Codec.enc k) (Int64.ofInt start) (Int64.ofInt stop))
+  zscore := fun {β} [Codec β] k member => liftRedisKeyed #[Codec.enc k] RedisCmd.ZSCORE (fun ctx => FFI.Internal.zscore ctx (Codec.enc k) (Codec.enc member))
   zrank := fun {β} [Codec β] k member => do
-    let result ← liftRedisEIO RedisCmd.ZRANK (fun ctx => FFI.Internal.zrank ctx (Codec.enc k) (Codec.enc member))
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.ZRANK (fun ctx => FFI.Internal.zrank ctx (Codec.enc k) (Codec.enc member))
     return result.map UInt64.toNat
   zrevrank := fun {β} [Codec β] k member => do
-    let result ← liftRedisEIO RedisCmd.ZREVRANK (fun ctx => FFI.Internal.zrevrank ctx (Codec.enc k) (Codec.enc member))
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.ZREVRANK (fun ctx => FFI.Internal.zrevrank ctx (Codec.enc k) (Codec.enc member))
     return result.map UInt64.toNat
   zcount := fun k min max => do
-    let result ← liftRedisEIO RedisCmd.ZCOUNT (fun ctx => FFI.Internal.zcount ctx (Codec.enc k) (String.toUTF8 min) (String.toUTF8 max))
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.ZCOUNT (fun ctx => FFI.Internal.zcount ctx (Codec.enc k) (String.toUTF8 min) (String.toUTF8 max))
     return result.toNat
-  zincrby := fun {β} [Codec β] k increment member => liftRedisEIO RedisCmd.ZINCRBY (fun ctx => FFI.Internal.zincrby ctx (Codec.enc k) increment (Codec.enc member))
+  zincrby := fun {β} [Codec β] k increment member => liftRedisWrite #[Codec.enc k] RedisCmd.ZINCRBY (fun ctx => FFI.Internal.zincrby ctx (Codec.enc k) increment (Codec.enc member))
   zrem := fun {β} [Codec β] k members => do
-    let result ← liftRedisEIO RedisCmd.ZREM (fun ctx => FFI.Internal.zrem ctx (Codec.enc k) (members.map Codec.enc))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.ZREM (fun ctx => FFI.Internal.zrem ctx (Codec.enc k) (members.toArray.map Codec.enc))
     return result.toNat
-  zrangebyscore := fun k min max => liftRedisEIO RedisCmd.ZRANGEBYSCORE (fun ctx => FFI.zrangebyscore ctx (Codec.enc k) (String.toUTF8 min) (String.toUTF8 max))
-  zrevrange := fun k start stop => liftRedisEIO RedisCmd.ZREVRANGE (fun ctx => FFI.zrevrange ctx (Codec.enc k) (Int64.ofInt start) (Int64.ofInt stop))
-  zrevrangebyscore := fun k max min => liftRedisEIO RedisCmd.ZREVRANGEBYSCORE (fun ctx => FFI.zrevrangebyscore ctx (Codec.enc k) (String.toUTF8 max) (String.toUTF8 min))
+  zrangebyscore := fun k min max => liftRedisKeyed #[Codec.enc k] RedisCmd.ZRANGEBYSCORE (fun ctx => FFI.zrangebyscore ctx (Codec.enc k) (String.toUTF8 min) (String.toUTF8 max))
+  zrevrange := fun k start stop => liftRedisKeyed #[Codec.enc k] RedisCmd.ZREVRANGE (fun ctx => FFI.zrevrange ctx (Codec.enc k) (Int64.ofInt start) (Int64.ofInt stop))
+  zrevrangebyscore := fun k max min => liftRedisKeyed #[Codec.enc k] RedisCmd.ZREVRANGEBYSCORE (fun ctx => FFI.zrevrangebyscore ctx (Codec.enc k) (String.toUTF8 max) (String.toUTF8 min))
   zremrangebyrank := fun k start stop => do
-    let result ← liftRedisEIO RedisCmd.ZREMRANGEBYRANK (fun ctx => FFI.Internal.zremrangebyrank ctx (Codec.enc k) (Int64.ofInt start) (Int64.ofInt stop))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.ZREMRANGEBYRANK (fun ctx => FFI.Internal.zremrangebyrank ctx (Codec.enc k) (Int64.ofInt start) (Int64.ofInt stop))
     return result.toNat
   zremrangebyscore := fun k min max => do
-    let result ← liftRedisEIO RedisCmd.ZREMRANGEBYSCORE (fun ctx => FFI.Internal.zremrangebyscore ctx (Codec.enc k) (String.toUTF8 min) (String.toUTF8 max))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.ZREMRANGEBYSCORE (fun ctx => FFI.Internal.zremrangebyscore ctx (Codec.enc k) (String.toUTF8 min) (String.toUTF8 max))
     return result.toNat
-  zpopmin := fun k count => liftRedisEIO RedisCmd.ZPOPMIN (fun ctx => FFI.Internal.zpopmin ctx (Codec.enc k) (count.map UInt64.ofNat))
-  zpopmax := fun k count => liftRedisEIO RedisCmd.ZPOPMAX (fun ctx => FFI.Internal.zpopmax ctx (Codec.enc k) (count.map UInt64.ofNat))
+  zpopmin := fun k count => liftRedisWrite #[Codec.enc k] RedisCmd.ZPOPMIN (fun ctx => FFI.Internal.zpopmin ctx (Codec.enc k) (count.map UInt64.ofNat))
+  zpopmax := fun k count => liftRedisWrite #[Codec.enc k] RedisCmd.ZPOPMAX (fun ctx => FFI.Internal.zpopmax ctx (Codec.enc k) (count.map UInt64.ofNat))
   zscan := fun k cursor pattern count => do
     let count_u64 := count.map UInt64.ofNat
-    let result ← liftRedisEIO RedisCmd.ZSCAN (fun ctx => FFI.Internal.zscan ctx (Codec.enc k) (UInt64.ofNat cursor) pattern count_u64)
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.ZSCAN (fun ctx => FFI.Internal.zscan ctx (Codec.enc k) (UInt64.ofNat cursor) pattern count_u64)
     return (result.1.toNat, result.2)
 
   -- HyperLogLog operations
-  pfadd := fun k elements => liftRedisEIO RedisCmd.PFADD (fun ctx => FFI.Internal.pfadd ctx (Codec.enc k) (elements.map Codec.enc))
+  pfadd := fun k elements => liftRedisWrite #[Codec.enc k] RedisCmd.PFADD (fun ctx => FFI.Internal.pfadd ctx (Codec.enc k) (elements.toArray.map Codec.enc))
   pfcount := fun keys => do
-    let result ← liftRedisEIO RedisCmd.PFCOUNT (fun ctx => FFI.Internal.pfcount ctx (keys.map Codec.enc))
+    let result ← liftRedisKeyed (keys.toArray.map Codec.enc) RedisCmd.PFCOUNT (fun ctx => FFI.Internal.pfcount ctx (keys.toArray.map Codec.enc))
     return result.toNat
-  pfmerge := fun destkey sourcekeys => liftRedisEIO RedisCmd.PFMERGE (fun ctx => FFI.Internal.pfmerge ctx (Codec.enc destkey) (sourcekeys.map Codec.enc))
+  pfmerge := fun destkey sourcekeys => liftRedisWrite #[Codec.enc destkey] RedisCmd.PFMERGE (fun ctx => FFI.Internal.pfmerge ctx (Codec.enc destkey) (sourcekeys.toArray.map Codec.enc))
 
   -- Bitmap operations
-  setbit := fun k offset value => liftRedisEIO RedisCmd.SETBIT (fun ctx => FFI.setbit' ctx (Codec.enc k) (UInt64.ofNat offset) value)
-  getbit := fun k offset => liftRedisEIO RedisCmd.GETBIT (fun ctx => FFI.getbit' ctx (Codec.enc k) (UInt64.ofNat offset))
+  setbit := fun k offset value => liftRedisWrite #[Codec.enc k] RedisCmd.SETBIT (fun ctx => FFI.setbit' ctx (Codec.enc k) (UInt64.ofNat offset) value)
+  getbit := fun k offset => liftRedisKeyed #[Codec.enc k] RedisCmd.GETBIT (fun ctx => FFI.getbit' ctx (Codec.enc k) (UInt64.ofNat offset))
   bitcount := fun k start end_ => do
     let start_i64 := start.map Int64.ofInt
     let end_i64 := end_.map Int64.ofInt
-    let result ← liftRedisEIO RedisCmd.BITCOUNT (fun ctx => FFI.Internal.bitcount ctx (Codec.enc k) start_i64 end_i64)
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.BITCOUNT (fun ctx => FFI.Internal.bitcount ctx (Codec.enc k) start_i64 end_i64)
     return result.toNat
 
   -- Pub/Sub operations
@@ -387,49 +468,55 @@ instance [Codec α] : Ops α RedisM where
 
   -- TTL operations
   ttl := fun k => do
-    let result ← liftRedisEIO RedisCmd.TTL (fun ctx => FFI.Internal.ttl ctx (Codec.enc k))
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.TTL (fun ctx => FFI.Internal.ttl ctx (Codec.enc k))
     return result.toNat
   pttl := fun k => do
-    let result ← liftRedisEIO RedisCmd.PTTL (fun ctx => FFI.Internal.pttl ctx (Codec.enc k))
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.PTTL (fun ctx => FFI.Internal.pttl ctx (Codec.enc k))
     return result.toNat
 
   -- Redis Streams operations
   xadd := fun {β} [Codec β] k stream_id field_values maxlen_opt => do
-    let encoded_fv := field_values.map (fun (f, v) => (Codec.enc f, Codec.enc v))
+    let encoded_fv := field_values.toArray.map (fun (f, v) => (Codec.enc f, Codec.enc v))
     let maxlen_u64 := maxlen_opt.map UInt64.ofNat
-    let result ← liftRedisEIO RedisCmd.XADD (fun ctx => FFI.Internal.xadd ctx (Codec.enc k) (String.toUTF8 stream_id) encoded_fv maxlen_u64)
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.XADD (fun ctx => FFI.Internal.xadd ctx (Codec.enc k) (String.toUTF8 stream_id) encoded_fv maxlen_u64)
     match String.fromUTF8? result with
     | some str => return str
     | none => throw (Error.otherError "Invalid UTF-8 in XADD response")
   xread := fun streams count_opt block_opt => do
-    let encoded_streams := streams.map (fun (stream, id) => (Codec.enc stream, String.toUTF8 id))
+    let encoded_streams := streams.toArray.map (fun (stream, id) => (Codec.enc stream, String.toUTF8 id))
     let count_u64 := count_opt.map (fun n => UInt64.ofNat n)
     let block_u64 := block_opt.map (fun n => UInt64.ofNat n)
-    liftRedisEIO RedisCmd.XREAD (fun ctx => FFI.Internal.xread ctx encoded_streams count_u64 block_u64)
+    liftRedisKeyed (encoded_streams.map (·.1)) RedisCmd.XREAD (fun ctx => FFI.Internal.xread ctx encoded_streams count_u64 block_u64)
   xrange := fun k start_id end_id count_opt => do
     let count_u64 := count_opt.map (fun n => UInt64.ofNat n)
-    liftRedisEIO RedisCmd.XRANGE (fun ctx => FFI.Internal.xrange ctx (Codec.enc k) (String.toUTF8 start_id) (String.toUTF8 end_id) count_u64)
+    liftRedisKeyed #[Codec.enc k] RedisCmd.XRANGE (fun ctx => FFI.Internal.xrange ctx (Codec.enc k) (String.toUTF8 start_id) (String.toUTF8 end_id) count_u64)
   xlen := fun k => do
-    let result ← liftRedisEIO RedisCmd.XLEN (fun ctx => FFI.Internal.xlen ctx (Codec.enc k))
+    let result ← liftRedisKeyed #[Codec.enc k] RedisCmd.XLEN (fun ctx => FFI.Internal.xlen ctx (Codec.enc k))
     return result.toNat
   xdel := fun k entry_ids => do
-    let encoded_ids := entry_ids.map String.toUTF8
-    let result ← liftRedisEIO RedisCmd.XDEL (fun ctx => FFI.Internal.xdel ctx (Codec.enc k) encoded_ids)
+    let encoded_ids := entry_ids.toArray.map String.toUTF8
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.XDEL (fun ctx => FFI.Internal.xdel ctx (Codec.enc k) encoded_ids)
     return result.toNat
   xtrim := fun k strategy max_len => do
-    let result ← liftRedisEIO RedisCmd.XTRIM (fun ctx => FFI.Internal.xtrim ctx (Codec.enc k) (String.toUTF8 strategy) (UInt64.ofNat max_len))
+    let result ← liftRedisWrite #[Codec.enc k] RedisCmd.XTRIM (fun ctx => FFI.Internal.xtrim ctx (Codec.enc k) (String.toUTF8 strategy) (UInt64.ofNat max_len))
     return result.toNat
 
   -- Connection operations
   ping := fun msg => liftRedisEIO RedisCmd.PING (fun ctx => FFI.Internal.ping ctx (Codec.enc msg))
-  selectDb := fun db => liftRedisEIO RedisCmd.SELECT (fun ctx => FFI.Internal.selectDb ctx (UInt64.ofNat db))
+  selectDb := fun db => do
+    liftRedisEIO RedisCmd.SELECT (fun ctx => FFI.Internal.selectDb ctx (UInt64.ofNat db))
+    -- the multiplexed connection stays on the initial database
+    modify fun s => { s with pinned := true }
   echoMsg := fun msg => liftRedisEIO RedisCmd.ECHO (fun ctx => FFI.Internal.echo ctx msg)
 
   -- Server operations
   dbsize := do
     let result ← liftRedisEIO RedisCmd.DBSIZE (fun ctx => FFI.Internal.dbsize ctx)
     return result.toNat
-  flushall := fun mode => liftRedisEIO RedisCmd.FLUSHALL (fun ctx => FFI.Internal.flushall ctx mode)
+  flushall := fun mode => do
+    let result ← liftRedisEIO RedisCmd.FLUSHALL (fun ctx => FFI.Internal.flushall ctx mode)
+    nearClear
+    return result
 
 -- Redis command operations
 
@@ -453,8 +540,12 @@ def incrByFloat (k : α) (increment : Float) : m Float := Ops.incrByFloat k incr
 -- Key operations
 def del (ks : List α) : m Nat := Ops.del ks
 def existsKey (k : α) : m Bool := Ops.existsKey k
+def existsCount (ks : List α) : m Nat := Ops.existsCount ks
 def typeKey (k : α) : m RedisValue := Ops.typeKey k
 def keys [inst : Ops α m] (pattern : ByteArray) : m (List ByteArray) := inst.keys pattern
+def keysArray [inst : Ops α m] (pattern : ByteArray) : m (Array ByteArray) := inst.keysArray pattern
+def mgetArray (ks : Array α) : m (Array (Option ByteArray)) := Ops.mgetArray ks
+def msetArray (kvs : Array (α × β)) : m Unit := Ops.msetArray kvs
 def scan [inst : Ops α m] (cursor : Nat) (pattern : Option ByteArray := none) (count : Option Nat := none) : m (Nat × List ByteArray) := inst.scan cursor pattern count
 def expire (k : α) (seconds : Nat) : m Bool := Ops.expire k seconds
 def expireAt (k : α) (timestamp : Nat) : m Bool := Ops.expireAt k timestamp
@@ -478,6 +569,7 @@ def sismember (k : α) (member : α) : m Bool := Ops.sismember k member
 def scard (k : α) : m Nat := Ops.scard k
 def sadd (k : α) (member : α) : m Nat := Ops.sadd k member
 def smembers (k : α) : m (List ByteArray) := Ops.smembers k
+def smembersArray (k : α) : m (Array ByteArray) := Ops.smembersArray k
 def srem (k : α) (members : List α) : m Nat := Ops.srem k members
 def spop (k : α) (count : Option Nat := none) : m (List ByteArray) := Ops.spop k count
 def srandmember (k : α) (count : Option Nat := none) : m (List ByteArray) := Ops.srandmember k count
@@ -498,6 +590,7 @@ def rpushx (k : α) (values : List α) : m Nat := Ops.rpushx k values
 def lpop (k : α) (count : Option Nat := none) : m (List ByteArray) := Ops.lpop k count
 def rpop (k : α) (count : Option Nat := none) : m (List ByteArray) := Ops.rpop k count
 def lrange (k : α) (start stop : Int) : m (List ByteArray) := Ops.lrange k start stop
+def lrangeArray (k : α) (start stop : Int) : m (Array ByteArray) := Ops.lrangeArray k start stop
 def lindex (k : α) (index : Int) : m ByteArray := Ops.lindex k index
 def llen (k : α) : m Nat := Ops.llen k
 def lset (k : α) (index : Int) (value : α) : m Unit := Ops.lset k index value
@@ -511,6 +604,7 @@ def hset {γ : Type} [Codec γ] (k : α) (field : α) (value : γ) : m Nat := Op
 def hget (k : α) (field : α) : m ByteArray := Ops.hget k field
 def hgetAs (γ : Type) [Codec γ] (k : α) (field : α) : m γ := Ops.hgetAs α γ k field
 def hgetall (k : α) : m (List ByteArray) := Ops.hgetall k
+def hgetallArray (k : α) : m (Array ByteArray) := Ops.hgetallArray k
 def hdel (k : α) (field : α) : m Nat := Ops.hdel k field
 def hexists (k : α) (field : α) : m Bool := Ops.hexists k field
 def hincrby (k : α) (field : α) (increment : Int) : m Nat := Ops.hincrby k field increment
@@ -526,6 +620,7 @@ def hscan (k : α) (cursor : Nat) (pattern : Option ByteArray := none) (count :
 def zadd (k : α) (score : Float) (member : α) : m Nat := Ops.zadd k score member
 def zcard (k : α) : m Nat := Ops.zcard k
 def zrange (k : α) (start stop : Int) : m (List ByteArray) := Ops.zrange k start stop
+def zrangeArray (k : α) (start stop : Int) : m (Array ByteArray) := Ops.zrangeArray k start stop
 def zscore (k : α) (member : α) : m (Option Float) := Ops.zscore k member
 def zrank (k : α) (member : α) : m (Option Nat) := Ops.zrank k member
 def zrevrank (k : α) (member : α) : m (Option Nat) := Ops.zrevrank k member
@@ -570,7 +665,7 @@ def pttl (k : α) : m Nat := Ops.pttl k
 -- Redis Streams operations
 def xadd [Codec β] (k : α) (stream_id : String) (field_values : List (α × β)) (maxlen : Option Nat := none) : m String :=
   Ops.xadd k stream_id field_values maxlen
-def xread (streams : List (α × String)) (count_opt : Option Nat := none) (block_opt : Option Nat := none) : m ByteArray :=
+def xread (streams : List (α × String)) (count_opt : Option Nat := none) (block_opt : Option Nat := none) : m FFI.StreamRead :=
   Ops.xread streams count_opt block_opt
 def xrange (k : α) (start_id end_id : String) (count_opt : Option Nat := none) : m ByteArray :=
   Ops.xrange k start_id end_id count_opt
@@ -612,9 +707,10 @@ def mget [Codec α] [Codec β] (ks : List α) : RedisM (List β) := do
   let results ← ks.mapM (getAs β)
   return results
 
-/-- Multi-set operation -/
-def mset [Codec α] [Codec β] (pairs : List (α × β)) : RedisM Unit := do
-  pairs.forM (fun (k, v) => set k v)
+/-- Multi-set operation (one MSET, split by slot in cluster mode); nothing
+    to set is a no-op, not a server error -/
+def mset [Codec α] [Codec β] (pairs : List (α × β)) : RedisM Unit :=
+  if pairs.isEmpty then return () else msetArray pairs.toArray
 
 -- DSL-style combinators
 
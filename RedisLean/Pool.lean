@@ -1,3 +1,5 @@
+import Std.Data.HashMap
+import Std.Sync.Mutex
 import RedisLean.Config
 import RedisLean.Error
 import RedisLean.FFI
@@ -16,52 +18,41 @@ structure PoolConfig where
   acquireTimeoutMs : Nat := 5000
   /-- Time in milliseconds before an idle connection is closed -/
   idleTimeoutMs : Nat := 60000
-  /-- Whether to validate connections before use -/
+  /-- Whether the maintainer checks idle connections with PING, so that
+      broken ones are replaced before they are handed out -/
   validateOnAcquire : Bool := true
+  /-- Idle connections the maintainer keeps ready (within `maxConnections`) -/
+  minIdle : Nat := 0
+  /-- Connections opened in parallel at startup and by the maintainer -/
+  warmupConcurrency : Nat := 8
+  /-- Period of the background maintainer in milliseconds (0 disables it) -/
+  maintenanceIntervalMs : Nat := 5000
+  /-- Time the maintainer waits for the PING replies, in milliseconds; a
+      connection that has not answered by then counts as broken -/
+  pingTimeoutMs : Nat := 1000
+  /-- Send READONLY on each new connection so that a cluster replica serves
+      reads (see `ReadPreference`) -/
+  readOnly : Bool := false
   deriving Repr
 
-/-- Connection slot in the pool -/
+/-- An open connection of the pool -/
 structure PooledConnection where
   /-- The underlying FFI context -/
   ctx : FFI.Ctx
-  /-- When this connection was created (nanoseconds) -/
+  /-- When this connection was created (monotonic ms) -/
   createdAt : Nat
-  /-- When this connection was last used (nanoseconds) -/
-  lastUsedAt : IO.Ref Nat
-  /-- Whether this connection is currently in use -/
-  inUse : IO.Ref Bool
+  /-- When this connection was last handed back (monotonic ms) -/
+  lastUsedAt : Nat
+  /-- Rank of the connection among those opened by the pool; picks the
+      metrics shard it records into -/
+  shard : Nat := 0
+  deriving Inhabited
 
 namespace PooledConnection
 
-/-- Create a new pooled connection -/
-def create (ctx : FFI.Ctx) : IO PooledConnection := do
-  let now ← IO.monoNanosNow
-  let lastUsedAt ← IO.mkRef now
-  let inUse ← IO.mkRef false
-  return { ctx, createdAt := now, lastUsedAt, inUse }
-
-/-- Mark connection as in use -/
-def acquire (conn : PooledConnection) : IO Unit := do
-  conn.inUse.set true
-  let now ← IO.monoNanosNow
-  conn.lastUsedAt.set now
-
-/-- Mark connection as available -/
-def release (conn : PooledConnection) : IO Unit := do
-  conn.inUse.set false
-  let now ← IO.monoNanosNow
-  conn.lastUsedAt.set now
-
-/-- Check if connection is available -/
-def isAvailable (conn : PooledConnection) : IO Bool := do
-  let inUse ← conn.inUse.get
-  return !inUse
-
-/-- Get idle time in milliseconds -/
-def getIdleTimeMs (conn : PooledConnection) : IO Nat := do
-  let now ← IO.monoNanosNow
-  let lastUsed ← conn.lastUsedAt.get
-  return (now - lastUsed) / 1000000
+/-- Idle time in milliseconds at `now` -/
+def idleTimeMs (conn : PooledConnection) (now : Nat) : Nat :=
+  now - conn.lastUsedAt
 
 end PooledConnection
 
@@ -113,160 +104,487 @@ def getSnapshot (stats : PoolStats) : IO (Nat × Nat × Nat × Nat × Nat) := do
 
 end PoolStats
 
+/-- Metrics of a pool: one `Metrics` shard per connection slot, so that
+    connections used in parallel record without contending. Reads merge the
+    shards (`snapshot`). -/
+structure PoolMetrics where
+  shards : Array Metrics
+  /-- Time spent in `acquire`, in microseconds, recorded as `acquire` -/
+  acquireWait : Metrics
+
+namespace PoolMetrics
+
+/-- Shards for a pool of at most `maxConnections` -/
+def shardCount (maxConnections : Nat) : Nat :=
+  Nat.max 1 (Nat.min maxConnections 64)
+
+def create (maxConnections : Nat) : IO PoolMetrics := do
+  let shards ← (Array.range (shardCount maxConnections)).mapM fun _ => Metrics.make
+  let acquireWait ← Metrics.make
+  return { shards, acquireWait }
+
+/-- Shard written by the connection of rank `shard` -/
+def shard (pm : PoolMetrics) (shard : Nat) : Metrics :=
+  pm.shards[shard % pm.shards.size]?.getD pm.acquireWait
+
+/-- All shards merged -/
+def snapshot (pm : PoolMetrics) : IO Metrics :=
+  Metrics.merge pm.shards
+
+def recordAcquireWait (pm : PoolMetrics) (microseconds : Nat) : IO Unit :=
+  Metrics.recordLatency pm.acquireWait "acquire" microseconds
+
+def acquireWaitStats (pm : PoolMetrics) : IO (Option LatencyStats) :=
+  Metrics.getLatencyStats pm.acquireWait "acquire"
+
+end PoolMetrics
+
+namespace Pool
+
+/-- Book-keeping of a pool, guarded by its mutex. `ω` is what wakes a waiting
+    acquirer. Idle connections form a stack (the most recently used is reused
+    first, so the oldest ones age out); waiters get increasing tickets and
+    are served in ticket order. A waiter that timed out is removed from
+    `waiters` and its ticket skipped when its turn comes. -/
+structure Slots (ω : Type) where
+  /-- Idle connections, the most recently released last -/
+  idle : Array PooledConnection := #[]
+  /-- Every open connection, idle or lent -/
+  conns : Std.HashMap FFI.Ctx PooledConnection := {}
+  /-- Connections opened so far -/
+  created : Nat := 0
+  /-- Connections being opened, counted against `maxConnections` -/
+  opening : Nat := 0
+  /-- Waiting acquirers by ticket, with their deadline (monotonic ms) -/
+  waiters : Std.HashMap Nat (Nat × ω) := {}
+  /-- Oldest ticket that may still be waiting -/
+  head : Nat := 0
+  /-- Ticket of the next waiter -/
+  tail : Nat := 0
+  closed : Bool := false
+
+namespace Slots
+
+variable {ω : Type}
+
+/-- Connections open or being opened -/
+def size (s : Slots ω) : Nat :=
+  s.conns.size + s.opening
+
+/-- Register a connection opened at `now` -/
+private def register (s : Slots ω) (ctx : FFI.Ctx) (now : Nat) : PooledConnection × Slots ω :=
+  let conn := { ctx, createdAt := now, lastUsedAt := now, shard := s.created }
+  (conn, { s with conns := s.conns.insert ctx conn, created := s.created + 1 })
+
+/-- Add an idle connection opened at `now` -/
+def add (s : Slots ω) (ctx : FFI.Ctx) (now : Nat) : Slots ω :=
+  let (conn, s) := s.register ctx now
+  { s with idle := s.idle.push conn }
+
+/-- Pop the most recently released idle connection -/
+def take? (s : Slots ω) : Option PooledConnection × Slots ω :=
+  match s.idle.back? with
+  | some conn => (some conn, { s with idle := s.idle.pop })
+  | none => (none, s)
+
+/-- Reserve room for a new connection while below `max` -/
+def reserve? (s : Slots ω) (max : Nat) : Option (Slots ω) :=
+  if s.size < max then some { s with opening := s.opening + 1 } else none
+
+/-- A reserved connection is open (and lent) -/
+def opened (s : Slots ω) (ctx : FFI.Ctx) (now : Nat) : PooledConnection × Slots ω :=
+  { s with opening := s.opening - 1 }.register ctx now
+
+/-- Queue a waiter, returning its ticket -/
+def enqueue (s : Slots ω) (deadline : Nat) (w : ω) : Nat × Slots ω :=
+  (s.tail, { s with waiters := s.waiters.insert s.tail (deadline, w), tail := s.tail + 1 })
+
+/-- Take the oldest waiter out of the queue -/
+def dequeue? (s : Slots ω) : Option ω × Slots ω := Id.run do
+  let mut head := s.head
+  for t in [s.head:s.tail] do
+    if let some (_, w) := s.waiters[t]? then
+      return (some w, { s with waiters := s.waiters.erase t, head := t + 1 })
+    head := t + 1
+  return (none, { s with head })
+
+/-- Hand back a lent connection: to the oldest waiter if any (the caller
+    passes it on), to the idle stack otherwise -/
+def put (s : Slots ω) (conn : PooledConnection) : Option ω × Slots ω :=
+  match s.dequeue? with
+  | (some w, s) => (some w, s)
+  | (none, s) => (none, { s with idle := s.idle.push conn })
+
+/-- A reserved connection could not be opened: the oldest waiter, if any,
+    may try in its place -/
+def openFailed (s : Slots ω) : Option ω × Slots ω :=
+  { s with opening := s.opening - 1 }.dequeue?
+
+/-- Remove the waiters whose deadline is not after `now`; also gives the
+    nearest remaining deadline -/
+def expire (s : Slots ω) (now : Nat) : Array ω × Option Nat × Slots ω :=
+  let (expired, next) := s.waiters.fold (init := ((#[] : Array (Nat × ω)), (none : Option Nat)))
+    fun (expired, next) t (deadline, w) =>
+      if deadline ≤ now then (expired.push (t, w), next)
+      else (expired, some (next.elim deadline (Nat.min deadline)))
+  (expired.map (·.2), next, { s with waiters := expired.foldl (·.erase ·.1) s.waiters })
+
+/-- Take out the idle connections unused for more than `timeoutMs`, oldest
+    first, keeping at least `min` connections open -/
+def prune (s : Slots ω) (now timeoutMs min : Nat) : Array PooledConnection × Slots ω := Id.run do
+  let mut budget := s.conns.size - min
+  let mut stale := #[]
+  let mut keep := #[]
+  for conn in s.idle do
+    if budget > 0 && conn.idleTimeMs now > timeoutMs then
+      stale := stale.push conn
+      budget := budget - 1
+    else keep := keep.push conn
+  return (stale, { s with idle := keep, conns := stale.foldl (·.erase ·.ctx) s.conns })
+
+/-- Take out the idle connections unused for at least `minIdleMs`, to be
+    checked; they stay counted as open -/
+def checkout (s : Slots ω) (now minIdleMs : Nat) : Array PooledConnection × Slots ω :=
+  let (due, keep) := s.idle.partition (·.idleTimeMs now ≥ minIdleMs)
+  (due, { s with idle := keep })
+
+/-- Give back a connection that was checked out, keeping its last use time.
+    `false` if the pool was closed meanwhile: the caller closes it. -/
+def restore (s : Slots ω) (conn : PooledConnection) : (Option ω × Bool) × Slots ω :=
+  if s.closed then ((none, false), { s with conns := s.conns.erase conn.ctx })
+  else
+    let (w, s) := s.put conn
+    ((w, true), s)
+
+/-- Forget a broken connection: the oldest waiter, if any, may open a new one -/
+def discard (s : Slots ω) (ctx : FFI.Ctx) : Option ω × Slots ω :=
+  { s with conns := s.conns.erase ctx }.dequeue?
+
+/-- Connections to open so that at least `minConns` are open and `minIdle`
+    idle, without exceeding `max` -/
+def deficit (s : Slots ω) (minConns minIdle max : Nat) : Nat :=
+  Nat.min (max - s.size) (Nat.max (minConns - s.size) (minIdle - s.idle.size))
+
+/-- Reserve room for up to `n` new connections below `max`; gives the number reserved -/
+def reserveUpTo (s : Slots ω) (n max : Nat) : Nat × Slots ω :=
+  let k := Nat.min n (max - s.size)
+  (k, { s with opening := s.opening + k })
+
+/-- A connection opened on a reservation by the maintainer: to the oldest
+    waiter, or idle -/
+def ready (s : Slots ω) (ctx : FFI.Ctx) (now : Nat) : Option (ω × PooledConnection) × Slots ω :=
+  let (conn, s) := s.opened ctx now
+  let (w, s) := s.put conn
+  (w.map (·, conn), s)
+
+/-- Mark the pool closed, taking out the idle connections and every waiter.
+    Lent connections are closed when they come back. -/
+def close (s : Slots ω) : Array PooledConnection × Array ω × Slots ω :=
+  (s.idle, s.waiters.fold (fun ws _ (_, w) => ws.push w) #[],
+    { s with idle := #[], conns := s.idle.foldl (·.erase ·.ctx) s.conns, waiters := {}, head := s.tail,
+             closed := true })
+
+end Slots
+
+/-- Wakes a waiting acquirer: with a connection, or `none` to look again
+    (deadline passed, pool closed, or room freed by a failed connect) -/
+abbrev Waiter := IO.Promise (Option PooledConnection)
+
+end Pool
+
 /-- Connection pool for managing multiple Redis connections.
-    Note: This implementation uses a simple spin-lock approach for thread safety.
-    For high-concurrency scenarios, consider using external synchronization. -/
+    Acquire and release take one short critical section and are O(1): an idle
+    connection is popped from a stack, a released one goes straight to the
+    oldest waiter. When the pool is exhausted acquirers wait in FIFO order,
+    each until its deadline, without polling.
+
+    A pool runs background threads (the acquire deadline timer and the
+    maintainer) until it is closed: every pool must be closed with `close`,
+    or used through `withPool`, which closes it. -/
 structure Pool where
   /-- Pool configuration -/
   config : PoolConfig
   /-- Redis configuration for creating new connections -/
   redisConfig : Config
-  /-- All connections in the pool -/
-  connections : IO.Ref (Array PooledConnection)
-  /-- Simple lock flag for synchronization -/
-  lockFlag : IO.Ref Bool
+  /-- Idle stack, open connections and waiters -/
+  slots : Std.Mutex (Pool.Slots Pool.Waiter)
+  /-- Signalled when a waiter is queued and on close, for the deadline timer -/
+  waiting : Std.Condvar
   /-- Pool statistics -/
   stats : PoolStats
+  /-- Commands run through `withConnection`, and acquire waits -/
+  metrics : PoolMetrics
+  /-- Background tasks, waited for by `close` -/
+  workers : IO.Ref (Array (Task (Except IO.Error Unit)))
 
 namespace Pool
 
-/-- Acquire the lock (simple spin-lock) -/
-private def acquireLock (pool : Pool) : IO Unit := do
-  let mut acquired := false
-  while !acquired do
-    let current ← pool.lockFlag.get
-    if !current then
-      pool.lockFlag.set true
-      acquired := true
-    else
-      IO.sleep 1
-
-/-- Release the lock -/
-private def releaseLock (pool : Pool) : IO Unit :=
-  pool.lockFlag.set false
-
-/-- Create a new connection pool -/
+/-- Open a connection for the pool. READONLY is best effort: servers without
+    cluster support reject it and the connection is used as is. Its bytes are
+    not charged to the first command. -/
+private def openConnection (cfg : Config) (poolCfg : PoolConfig) : EIO Error FFI.Ctx := do
+  let ctx ← FFI.connect cfg.host (UInt32.ofNat cfg.port) cfg.ssl
+  if poolCfg.readOnly then
+    let _ ← (FFI.commandArgv ctx #["READONLY".toUTF8]).toBaseIO
+  let _ ← FFI.ioTake ctx
+  return ctx
+
+private def freeConnection (conn : PooledConnection) : IO Unit :=
+  discard (FFI.Internal.free conn.ctx).toBaseIO
+
+/-- Fail the waiters whose deadline has passed. Runs on a dedicated thread
+    that sleeps until the nearest deadline, blocks while nobody waits and
+    ends once the pool is closed. -/
+private partial def expireWaiters (slots : Std.Mutex (Slots Waiter)) (waiting : Std.Condvar) : IO Unit := do
+  let next ← slots.atomicallyOnce waiting
+    (do let s ← get; return s.closed || !s.waiters.isEmpty)
+    (do
+      let (expired, next, s) := (← get).expire (← IO.monoMsNow)
+      set s
+      for w in expired do w.resolve none
+      return if s.closed then none else some next)
+  match next with
+  | none => return
+  | some none => expireWaiters slots waiting
+  | some (some deadline) =>
+    IO.sleep (UInt32.ofNat (deadline - (← IO.monoMsNow)))
+    expireWaiters slots waiting
+
+/-- Open `n` connections, `warmupConcurrency` at a time; failures are counted -/
+private def openMany (cfg : Config) (poolCfg : PoolConfig) (stats : PoolStats) (n : Nat) :
+    IO (Array FFI.Ctx) := do
+  let width := Nat.min n (Nat.max 1 poolCfg.warmupConcurrency)
+  let workers ← (Array.range width).mapM fun i =>
+    IO.asTask (prio := .dedicated) do
+      let mut opened := #[]
+      for _ in [:n / width + (if i < n % width then 1 else 0)] do
+        match ← (openConnection cfg poolCfg).toBaseIO with
+        | .ok ctx =>
+          opened := opened.push ctx
+          PoolStats.incrementCreated stats
+        | .error _ => PoolStats.incrementFailed stats
+      return opened
+  workers.foldlM (init := #[]) fun all t => return all ++ (← IO.ofExcept (← IO.wait t))
+
+/-- Read the next reply of `ctx` without blocking past `deadline` (monotonic
+    ms); `none` on timeout or error -/
+private partial def replyBefore (ctx : FFI.Ctx) (deadline : Nat) : IO (Option Reply) := do
+  match ← (FFI.getReplyNonBlock ctx).toBaseIO with
+  | .ok (some r) => return some r
+  | .error _ => return none
+  | .ok none =>
+    let now ← IO.monoMsNow
+    if now >= deadline then return none
+    let readable ← (FFI.canRead ctx (UInt64.ofNat (deadline - now))).toBaseIO
+    unless readable matches .ok true do return none
+    unless (← (FFI.bufferRead ctx).toBaseIO) matches .ok _ do return none
+    replyBefore ctx deadline
+
+/-- PING every connection, pipelined across all of them: each PING is sent
+    before any reply is read, so checking n connections costs about one
+    round trip. Replies are awaited for `timeoutMs` in all, so a dead socket
+    cannot stall the check. Gives the connections that answered and those
+    that did not. -/
+private def pingAll (conns : Array PooledConnection) (timeoutMs : Nat) :
+    IO (Array PooledConnection × Array PooledConnection) := do
+  let ping := #["PING".toUTF8]
+  let sent ← conns.mapM fun conn => do
+    let r ← (FFI.appendCommandArgv conn.ctx ping *> FFI.flushPipeline conn.ctx).toBaseIO
+    return (conn, r matches .ok _)
+  let deadline := (← IO.monoMsNow) + timeoutMs
+  let mut healthy := #[]
+  let mut broken := #[]
+  for (conn, ok) in sent do
+    let alive ← if ok then
+        (fun r => r matches some (.simple "PONG")) <$> replyBefore conn.ctx deadline
+      else pure false
+    let _ ← FFI.ioTake conn.ctx
+    if alive then healthy := healthy.push conn else broken := broken.push conn
+  return (healthy, broken)
+
+/-- Open the missing connections (see `Slots.deficit`) and hand them to
+    waiters or to the idle stack -/
+private def topUp (slots : Std.Mutex (Slots Waiter)) (cfg : Config) (poolCfg : PoolConfig)
+    (stats : PoolStats) : IO Unit := do
+  let n ← slots.atomically (modifyGet fun s =>
+    s.reserveUpTo (s.deficit poolCfg.minConnections poolCfg.minIdle poolCfg.maxConnections)
+      poolCfg.maxConnections)
+  if n == 0 then return
+  let opened ← openMany cfg poolCfg stats n
+  let now ← IO.monoMsNow
+  for ctx in opened do
+    if let some (w, conn) ← slots.atomically (modifyGet (·.ready ctx now)) then
+      w.resolve (some conn)
+  for _ in [opened.size:n] do
+    if let some w ← slots.atomically (modifyGet (·.openFailed)) then w.resolve none
+
+/-- One maintenance pass: close connections idle for longer than
+    `idleTimeoutMs` (down to `minConnections`), check with PING the ones idle
+    for a whole period and close those that fail, then open connections up to
+    `minConnections` and `minIdle` -/
+def maintainSlots (slots : Std.Mutex (Slots Waiter)) (cfg : Config) (poolCfg : PoolConfig)
+    (stats : PoolStats) : IO Unit := do
+  let now ← IO.monoMsNow
+  let stale ← slots.atomically
+    (modifyGet (·.prune now poolCfg.idleTimeoutMs poolCfg.minConnections))
+  for conn in stale do freeConnection conn
+  if poolCfg.validateOnAcquire then
+    let due ← slots.atomically (modifyGet (·.checkout now poolCfg.maintenanceIntervalMs))
+    let (healthy, broken) ← pingAll due poolCfg.pingTimeoutMs
+    for conn in healthy do
+      match ← slots.atomically (modifyGet (·.restore conn)) with
+      | (some w, _) => w.resolve (some conn)
+      | (none, kept) => unless kept do freeConnection conn
+    for conn in broken do
+      if let some w ← slots.atomically (modifyGet (·.discard conn.ctx)) then w.resolve none
+      freeConnection conn
+  topUp slots cfg poolCfg stats
+
+/-- Sleep for `ms`, in steps of at most 100 ms; `false` as soon as the pool
+    is closed -/
+private partial def sleepOpen (slots : Std.Mutex (Slots Waiter)) (ms : Nat) : IO Bool := do
+  if ← slots.atomically (return (← get).closed) then return false
+  if ms == 0 then return true
+  let step := Nat.min ms 100
+  IO.sleep (UInt32.ofNat step)
+  sleepOpen slots (ms - step)
+
+/-- Run `maintainSlots` every `maintenanceIntervalMs` until the pool is
+    closed; a close is noticed within 100 ms -/
+private partial def maintainer (slots : Std.Mutex (Slots Waiter)) (cfg : Config) (poolCfg : PoolConfig)
+    (stats : PoolStats) : IO Unit := do
+  unless ← sleepOpen slots poolCfg.maintenanceIntervalMs do return
+  try maintainSlots slots cfg poolCfg stats catch _ => pure ()
+  maintainer slots cfg poolCfg stats
+
+/-- Create a new connection pool. The first `minConnections` connections are
+    opened in parallel (`warmupConcurrency` at a time). The pool must be
+    closed (see `close`), or its background threads never end. -/
 def create (cfg : Config) (poolCfg : PoolConfig := {}) : IO Pool := do
-  let connections ← IO.mkRef #[]
-  let lockFlag ← IO.mkRef false
+  let slots ← Std.Mutex.new ({} : Slots Waiter)
+  let waiting ← Std.Condvar.new
   let stats ← PoolStats.create
+  let metrics ← PoolMetrics.create poolCfg.maxConnections
+  let workers ← IO.mkRef #[]
   let pool : Pool := {
     config := poolCfg,
     redisConfig := cfg,
-    connections,
-    lockFlag,
-    stats
+    slots,
+    waiting,
+    stats,
+    metrics,
+    workers
   }
-  -- Initialize minimum connections
-  for _ in [:poolCfg.minConnections] do
-    let _ ← createConnectionInternal pool
+  let opened ← openMany cfg poolCfg stats (Nat.min poolCfg.minConnections poolCfg.maxConnections)
+  let now ← IO.monoMsNow
+  slots.atomically (modify fun s => opened.foldl (·.add · now) s)
+  workers.modify (·.push <| ← IO.asTask (prio := .dedicated) (expireWaiters slots waiting))
+  if poolCfg.maintenanceIntervalMs > 0 then
+    workers.modify (·.push <| ← IO.asTask (prio := .dedicated) (maintainer slots cfg poolCfg stats))
   return pool
-where
-  createConnectionInternal (pool : Pool) : IO (Option PooledConnection) := do
-    let conns ← pool.connections.get
-    if conns.size >= pool.config.maxConnections then
-      return none
-    try
-      let ctx ← EIO.toIO (fun e => IO.userError s!"Connection failed: {e}")
-        (FFI.connect pool.redisConfig.host (UInt32.ofNat pool.redisConfig.port) pool.redisConfig.ssl)
-      let conn ← PooledConnection.create ctx
-      pool.connections.modify (·.push conn)
+
+private inductive Claim where
+  | idle (conn : PooledConnection)
+  | fresh
+  | wait (w : Waiter)
+  | timeout
+  | closed
+
+private partial def acquireUntil (pool : Pool) (deadline : Nat) : IO (Except Error PooledConnection) := do
+  let claim ← pool.slots.atomically do
+    let s ← get
+    if s.closed then return Claim.closed
+    if let (some conn, s) := s.take? then
+      set s
+      return .idle conn
+    if let some s := s.reserve? pool.config.maxConnections then
+      set s
+      return .fresh
+    if (← IO.monoMsNow) >= deadline then return .timeout
+    let w : Waiter ← IO.Promise.new
+    set (s.enqueue deadline w).2
+    return .wait w
+  match claim with
+  | .idle conn =>
+    PoolStats.incrementAcquired pool.stats
+    return .ok conn
+  | .fresh =>
+    match ← (openConnection pool.redisConfig pool.config).toBaseIO with
+    | .ok ctx =>
+      let now ← IO.monoMsNow
+      let conn ← pool.slots.atomically (modifyGet (·.opened ctx now))
       PoolStats.incrementCreated pool.stats
-      return some conn
-    catch _ =>
+      PoolStats.incrementAcquired pool.stats
+      return .ok conn
+    | .error e =>
+      if let some w ← pool.slots.atomically (modifyGet (·.openFailed)) then w.resolve none
       PoolStats.incrementFailed pool.stats
-      return none
-
-/-- Create a new connection and add it to the pool -/
-private def createConnection (pool : Pool) : IO (Option PooledConnection) := do
-  let conns ← pool.connections.get
-  if conns.size >= pool.config.maxConnections then
-    return none
-  try
-    let ctx ← EIO.toIO (fun e => IO.userError s!"Connection failed: {e}")
-      (FFI.connect pool.redisConfig.host (UInt32.ofNat pool.redisConfig.port) pool.redisConfig.ssl)
-    let conn ← PooledConnection.create ctx
-    pool.connections.modify (·.push conn)
-    PoolStats.incrementCreated pool.stats
-    return some conn
-  catch _ =>
-    PoolStats.incrementFailed pool.stats
-    return none
-
-/-- Find an available connection in the pool -/
-private def findAvailable (pool : Pool) : IO (Option PooledConnection) := do
-  let conns ← pool.connections.get
-  for conn in conns do
-    let available ← conn.isAvailable
-    if available then
-      return some conn
-  return none
-
-/-- Acquire a connection from the pool -/
-def acquire (pool : Pool) : IO (Except Error FFI.Ctx) := do
-  let startTime ← IO.monoNanosNow
-  let timeoutNs := pool.config.acquireTimeoutMs * 1000000
-  acquireLock pool
-  try
-    -- Try to find an available connection
-    let mut result : Option PooledConnection := none
-    while result.isNone do
-      let available ← findAvailable pool
-      match available with
-      | some conn =>
-        conn.acquire
-        PoolStats.incrementAcquired pool.stats
-        result := some conn
-      | none =>
-        -- Try to create a new connection
-        let newConn ← createConnection pool
-        match newConn with
-        | some conn =>
-          conn.acquire
-          PoolStats.incrementAcquired pool.stats
-          result := some conn
-        | none =>
-          -- Check timeout
-          let now ← IO.monoNanosNow
-          if now - startTime > timeoutNs then
-            PoolStats.incrementTimeout pool.stats
-            releaseLock pool
-            return .error (.otherError "Connection pool acquire timeout")
-          -- Wait a bit and retry
-          releaseLock pool
-          IO.sleep 10
-          acquireLock pool
-    releaseLock pool
-    match result with
-    | some conn => return .ok conn.ctx
-    | none => return .error (.otherError "Failed to acquire connection")
-  catch e =>
-    releaseLock pool
-    return .error (.otherError s!"Pool acquire error: {e}")
+      return .error e
+  | .wait w =>
+    pool.waiting.notifyOne
+    match ← IO.wait w.result? with
+    | some (some conn) =>
+      PoolStats.incrementAcquired pool.stats
+      return .ok conn
+    | _ => acquireUntil pool deadline
+  | .timeout =>
+    PoolStats.incrementTimeout pool.stats
+    return .error (.otherError "Connection pool acquire timeout")
+  | .closed => return .error (.otherError "Connection pool is closed")
+
+/-- Acquire a connection and record how long it took -/
+private def acquireConn (pool : Pool) : IO (Except Error PooledConnection) := do
+  let start ← IO.monoNanosNow
+  let result ← acquireUntil pool (start / 1000000 + pool.config.acquireTimeoutMs)
+  pool.metrics.recordAcquireWait (((← IO.monoNanosNow) - start) / 1000)
+  return result
+
+/-- Acquire a connection from the pool: an idle one, a new one while below
+    `maxConnections`, otherwise the next one released, waiting in line for
+    at most `acquireTimeoutMs` -/
+def acquire (pool : Pool) : IO (Except Error FFI.Ctx) :=
+  (·.map (·.ctx)) <$> pool.acquireConn
+
+private inductive Returned where
+  | handOff (w : Waiter) (conn : PooledConnection)
+  | idle
+  | free
+  | unknown
 
 /-- Release a connection back to the pool -/
 def release (pool : Pool) (ctx : FFI.Ctx) : IO Unit := do
-  acquireLock pool
-  let conns ← pool.connections.get
-  for conn in conns do
-    if conn.ctx == ctx then
-      conn.release
-      PoolStats.incrementReleased pool.stats
-      break
-  releaseLock pool
-
-/-- Execute an action with a pooled connection -/
+  let now ← IO.monoMsNow
+  let returned ← pool.slots.atomically do
+    let s ← get
+    let some conn := s.conns[ctx]? | return Returned.unknown
+    if s.closed then
+      set { s with conns := s.conns.erase ctx }
+      return .free
+    let conn := { conn with lastUsedAt := now }
+    match s.put conn with
+    | (some w, s) => set s; return .handOff w conn
+    | (none, s) => set s; return .idle
+  match returned with
+  | .handOff w conn => w.resolve (some conn)
+  | .free => discard (FFI.Internal.free ctx).toBaseIO
+  | .idle | .unknown => pure ()
+  unless returned matches .unknown do
+    PoolStats.incrementReleased pool.stats
+
+/-- Execute an action with a pooled connection. Its commands are recorded in
+    the metrics shard of the connection (see `Pool.metricsSnapshot`). -/
 def withConnection (pool : Pool) (action : RedisM α) : IO (Except Error α) := do
-  let ctxResult ← pool.acquire
-  match ctxResult with
+  let connResult ← pool.acquireConn
+  match connResult with
   | .error e => return .error e
-  | .ok ctx =>
-    let metrics ← Metrics.make
+  | .ok conn =>
+    let ctx := conn.ctx
+    let metrics := pool.metrics.shard conn.shard
     let state : State := {
       ctx := ctx,
       isConnected := true,
       metrics := metrics,
-      recordLatency := fun cmd micros => Metrics.recordLatency metrics cmd micros
+      recordLatency := fun cmd micros => Metrics.recordCommand metrics cmd micros
     }
     let read : Read := { config := pool.redisConfig, enableMetrics := true }
     try
@@ -278,57 +596,92 @@ def withConnection (pool : Pool) (action : RedisM α) : IO (Except Error α) :=
       return .error (.otherError s!"Action failed: {e}")
 
 /-- Get the current pool size -/
-def size (pool : Pool) : IO Nat := do
-  let conns ← pool.connections.get
-  return conns.size
+def size (pool : Pool) : IO Nat :=
+  pool.slots.atomically do return (← get).conns.size
 
 /-- Get the number of available connections -/
-def availableCount (pool : Pool) : IO Nat := do
-  let conns ← pool.connections.get
-  let mut count := 0
-  for conn in conns do
-    let available ← conn.isAvailable
-    if available then count := count + 1
-  return count
+def availableCount (pool : Pool) : IO Nat :=
+  pool.slots.atomically do return (← get).idle.size
 
 /-- Get the number of connections in use -/
-def inUseCount (pool : Pool) : IO Nat := do
-  let total ← pool.size
-  let available ← pool.availableCount
-  return total - available
+def inUseCount (pool : Pool) : IO Nat :=
+  pool.slots.atomically do
+    let s ← get
+    return s.conns.size - s.idle.size
+
+/-- Get the number of acquirers waiting for a connection -/
+def waiterCount (pool : Pool) : IO Nat :=
+  pool.slots.atomically do return (← get).waiters.size
 
 /-- Close idle connections that exceed the idle timeout -/
 def pruneIdleConnections (pool : Pool) : IO Nat := do
-  acquireLock pool
-  let conns ← pool.connections.get
-  let mut pruned := 0
-  let mut newConns : Array PooledConnection := #[]
-  for conn in conns do
-    let available ← conn.isAvailable
-    let idleMs ← conn.getIdleTimeMs
-    if available && idleMs > pool.config.idleTimeoutMs && newConns.size >= pool.config.minConnections then
-      -- Close this connection
-      let _ ← EIO.toIO (fun _ => IO.userError "free failed") (FFI.Internal.free conn.ctx)
-      pruned := pruned + 1
-    else
-      newConns := newConns.push conn
-  pool.connections.set newConns
-  releaseLock pool
-  return pruned
-
-/-- Close all connections and reset the pool -/
+  let now ← IO.monoMsNow
+  let stale ← pool.slots.atomically
+    (modifyGet (·.prune now pool.config.idleTimeoutMs pool.config.minConnections))
+  for conn in stale do freeConnection conn
+  return stale.size
+
+/-- Run one maintenance pass now (see `maintainSlots`) -/
+def maintain (pool : Pool) : IO Unit :=
+  maintainSlots pool.slots pool.redisConfig pool.config pool.stats
+
+/-- Close the idle connections, fail the waiters and wait for the background
+    threads to end; connections still lent are closed when released -/
 def close (pool : Pool) : IO Unit := do
-  acquireLock pool
-  let conns ← pool.connections.get
-  for conn in conns do
-    let _ ← EIO.toIO (fun _ => IO.userError "free failed") (FFI.Internal.free conn.ctx)
-  pool.connections.set #[]
-  releaseLock pool
+  let (idle, waiters) ← pool.slots.atomically (modifyGet fun s =>
+    let (idle, waiters, s) := s.close
+    ((idle, waiters), s))
+  pool.waiting.notifyAll
+  for w in waiters do w.resolve none
+  for conn in idle do freeConnection conn
+  for t in ← pool.workers.modifyGet ((·, #[])) do
+    let _ ← IO.wait t
+
+/-- Create a pool, run `f` with it and close it, also when `f` throws -/
+def withPool (cfg : Config) (poolCfg : PoolConfig := {}) (f : Pool → IO α) : IO α := do
+  let pool ← create cfg poolCfg
+  try f pool finally pool.close
+
+/-- Metrics of all the connections of the pool, merged -/
+def metricsSnapshot (pool : Pool) : IO Metrics :=
+  pool.metrics.snapshot
+
+/-- Time spent acquiring connections, in microseconds -/
+def acquireWaitStats (pool : Pool) : IO (Option LatencyStats) :=
+  pool.metrics.acquireWaitStats
 
 /-- Get pool statistics -/
 def getStats (pool : Pool) : IO (Nat × Nat × Nat × Nat × Nat) :=
   PoolStats.getSnapshot pool.stats
 
+/-- Pool metrics in Prometheus exposition format, labelled `pool="name"`:
+    the merged command metrics, the acquire wait histogram and gauges of the
+    connections in use, idle and the waiting acquirers -/
+def toPrometheus (pool : Pool) (name := "default") : IO String := do
+  let ls := [("pool", name)]
+  let (inUse, idle, waiters) ← pool.slots.atomically do
+    let s ← get
+    return (s.conns.size - s.idle.size, s.idle.size, s.waiters.size)
+  let acquire ← pool.metrics.acquireWait.getCommandHistogram "acquire"
+  let commands ← (← pool.metricsSnapshot).prometheusFamilies ls
+  return Prometheus.render <| commands ++ #[
+    Prometheus.histogram "redis_pool_acquire_wait_microseconds" "Time spent acquiring a connection in microseconds"
+      [(ls, acquire.getD {})],
+    Prometheus.gauge "redis_pool_connections_in_use" "Connections lent out" [(ls, inUse)],
+    Prometheus.gauge "redis_pool_connections_idle" "Idle connections" [(ls, idle)],
+    Prometheus.gauge "redis_pool_waiters" "Acquirers waiting for a connection" [(ls, waiters)]
+  ]
+
+/-- Write the pool metrics to `path` for the node_exporter textfile collector -/
+def writeMetrics (pool : Pool) (path : System.FilePath) (name := "default") : IO Unit := do
+  Prometheus.writeTextfile path (← pool.toPrometheus name)
+
+/-- Serve the pool metrics on `http://host:port/metrics` from a background
+    thread until the returned server is stopped -/
+def serveMetrics (pool : Pool) (port : Nat := 9121) (host := "127.0.0.1") (name := "default") :
+    EIO Error Prometheus.Server :=
+  Prometheus.serve (pool.toPrometheus name) port host
+
 /-- Print pool status -/
 def printStatus (pool : Pool) : IO Unit := do
   let total ← pool.size
@@ -340,6 +693,8 @@ def printStatus (pool : Pool) : IO Unit := do
   IO.println s!"  Config: max={pool.config.maxConnections}, min={pool.config.minConnections}"
   IO.println s!"  Stats: created={created}, acquired={acquired}, released={released}"
   IO.println s!"  Errors: timeouts={timeouts}, failed={failed}"
+  if let some w ← pool.acquireWaitStats then
+    IO.println s!"  Acquire wait: avg={w.avg}μs, max={w.max}μs"
 
 end Pool
 
@@ -0,0 +1,124 @@
+import RedisLean.FFI
+import RedisLean.Histogram
+
+namespace Redis
+
+/-!
+# Prometheus
+
+Text exposition format (version 0.0.4) and the two ways of publishing it:
+
+- `writeTextfile` for the node_exporter textfile collector: the file is
+  written next to its final name and renamed, so the collector never reads a
+  partial file
+- `serve` for a scrape endpoint: a background thread answers
+  `GET /metrics` on a local port, rendering the text at every scrape
+
+Latencies are exported as histograms with the same fixed `le` bounds in every
+process, so `_bucket` series can be summed across workers before computing
+quantiles (`histogram_quantile(0.99, sum by (le) (rate(..._bucket[5m])))`).
+-/
+
+namespace Prometheus
+
+/-- Default `le` bounds for latencies in microseconds: 50μs to 10s -/
+def defaultBounds : Array Nat := #[
+  50, 100, 250, 500,
+  1000, 2500, 5000, 10000, 25000, 50000,
+  100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000
+]
+
+/-- Default `le` bounds for durations in nanoseconds: 250ns to 1s -/
+def nanosecondBounds : Array Nat := #[
+  250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+  100000, 250000, 500000, 1000000, 10000000, 100000000, 1000000000
+]
+
+/-- Default `le` bounds for sizes in bytes: 64B to 16MiB -/
+def byteBounds : Array Nat := #[
+  64, 256, 1024, 4096, 16384, 65536, 262144, 1048576, 4194304, 16777216
+]
+
+private def escape (v : String) : String :=
+  v.foldl (init := "") fun acc c =>
+    match c with
+    | '\\' => acc ++ "\\\\"
+    | '"' => acc ++ "\\\""
+    | '\n' => acc ++ "\\n"
+    | c => acc.push c
+
+/-- `{a="1",b="2"}`, or nothing without labels -/
+def labels (ls : List (String × String)) : String :=
+  if ls.isEmpty then ""
+  else "{" ++ ",".intercalate (ls.map fun (k, v) => s!"{k}=\"{escape v}\"") ++ "}"
+
+private def header (name help type : String) : Array String :=
+  #[s!"# HELP {name} {help}", s!"# TYPE {name} {type}"]
+
+/-- A counter family, one sample per label set -/
+def counter (name help : String) (series : List (List (String × String) × Nat)) : Array String :=
+  series.foldl (init := header name help "counter") fun out (ls, v) =>
+    out.push s!"{name}{labels ls} {v}"
+
+/-- A gauge family, one sample per label set -/
+def gauge [ToString α] (name help : String) (series : List (List (String × String) × α)) : Array String :=
+  series.foldl (init := header name help "gauge") fun out (ls, v) =>
+    out.push s!"{name}{labels ls} {v}"
+
+/-- A histogram family: cumulative `_bucket` lines at `bounds` and `+Inf`,
+    then `_sum` and `_count`, for every label set -/
+def histogram (name help : String) (series : List (List (String × String) × Histogram))
+    (bounds : Array Nat := defaultBounds) : Array String :=
+  series.foldl (init := header name help "histogram") fun out (ls, h) =>
+    let buckets := (bounds.zip (h.cumulative bounds)).foldl (init := out) fun out (le, n) =>
+      out.push s!"{name}_bucket{labels (ls ++ [("le", toString le)])} {n}"
+    buckets
+      |>.push s!"{name}_bucket{labels (ls ++ [("le", "+Inf")])} {h.count}"
+      |>.push s!"{name}_sum{labels ls} {h.sum}"
+      |>.push s!"{name}_count{labels ls} {h.count}"
+
+/-- Exposition text of metric families -/
+def render (families : Array (Array String)) : String :=
+  "\n".intercalate (families.foldl (· ++ ·) #[]).toList ++ "\n"
+
+/-- Replace `path` with `text` atomically, for the textfile collector
+    (which only reads `*.prom` files, so the temporary name is skipped) -/
+def writeTextfile (path : System.FilePath) (text : String) : IO Unit := do
+  let tmp := path.toString ++ ".tmp"
+  IO.FS.writeFile tmp text
+  IO.FS.rename tmp path
+
+/-- Running scrape endpoint; it is stopped by `stop`, or once unreachable -/
+structure Server where
+  handle : FFI.MetricsServerHandle
+
+/-- Serve `render` on `http://host:port/metrics` from a background thread.
+    Port 0 picks a free port (see `Server.port`). A failing `render` is
+    answered with a comment holding the error, so scrapes never hang. -/
+def serve (render : IO String) (port : Nat := 9121) (host := "127.0.0.1") : EIO Error Server := do
+  let body : BaseIO String := do
+    match ← EIO.toBaseIO render with
+    | .ok text => pure text
+    | .error e => pure s!"# error rendering metrics: {e}\n"
+  let handle ← FFI.Internal.metricsServerStart host (UInt32.ofNat port) body
+  return { handle }
+
+namespace Server
+
+/-- Port the endpoint listens on -/
+def port (s : Server) : BaseIO Nat :=
+  return (← FFI.Internal.metricsServerPort s.handle).toNat
+
+/-- Scrapes answered so far -/
+def scrapes (s : Server) : BaseIO Nat :=
+  return (← FFI.Internal.metricsServerScrapes s.handle).toNat
+
+/-- Stop the thread and close the socket; stopping again does nothing -/
+def stop (s : Server) : BaseIO Unit :=
+  FFI.Internal.metricsServerStop s.handle
+
+end Server
+
+end Prometheus
+
+end Redis
@@ -0,0 +1,223 @@
+import Std.Sync.Mutex
+import RedisLean.Error
+import RedisLean.Config
+import RedisLean.Reply
+import RedisLean.FFI
+
+namespace Redis
+
+/-!
+# Pub/Sub Subscriber
+
+A subscriber owns a dedicated connection driven by a C thread
+(`hiredis/subscriber.c`). The thread reads whatever the socket has, decodes
+the messages into `Reply` values in one go and hands them to Lean in batches;
+here they are turned into `PubSubMessage`s and stored in a bounded buffer that
+consumers drain with `recv` / `recvBatch`.
+
+When the buffer is full the `OverflowPolicy` decides: drop the incoming
+message, drop the oldest queued one, or block the subscriber thread (which
+stops reading, so the backlog stays on the server). Subscriptions are
+remembered on the C side and replayed after a reconnect.
+-/
+
+/-- What to do with a message that arrives while the buffer is full -/
+inductive OverflowPolicy where
+  /-- Discard the incoming message -/
+  | dropNewest
+  /-- Discard the oldest queued message to make room -/
+  | dropOldest
+  /-- Stop reading until a consumer makes room (backpressure) -/
+  | block
+  deriving Repr, BEq
+
+structure SubscriberConfig where
+  /-- Maximum number of queued messages -/
+  capacity : Nat := 10000
+  overflow : OverflowPolicy := .dropOldest
+  /-- Maximum number of replies per batch handed over by the C thread -/
+  batchSize : Nat := 256
+  deriving Repr
+
+/-- A message received on a subscribed connection -/
+inductive PubSubMessage where
+  /-- `message` from SUBSCRIBE -/
+  | message (channel payload : ByteArray)
+  /-- `pmessage` from PSUBSCRIBE, with the matching pattern -/
+  | pmessage (pattern channel payload : ByteArray)
+  /-- `smessage` from SSUBSCRIBE -/
+  | smessage (channel payload : ByteArray)
+
+namespace PubSubMessage
+
+/-- Decode a message reply (RESP2 array or RESP3 push). Subscription
+    confirmations and anything else yield `none`. -/
+def ofReply? (r : Reply) : Option PubSubMessage := do
+  let es ← r.elems?
+  let kind ← es[0]? >>= Reply.str?
+  match kind, es.size with
+  | "message", 3 => return .message (← es[1]!.bytes?) (← es[2]!.bytes?)
+  | "smessage", 3 => return .smessage (← es[1]!.bytes?) (← es[2]!.bytes?)
+  | "pmessage", 4 => return .pmessage (← es[1]!.bytes?) (← es[2]!.bytes?) (← es[3]!.bytes?)
+  | _, _ => none
+
+def channel : PubSubMessage → ByteArray
+  | message ch _ => ch
+  | pmessage _ ch _ => ch
+  | smessage ch _ => ch
+
+def payload : PubSubMessage → ByteArray
+  | message _ p => p
+  | pmessage _ _ p => p
+  | smessage _ p => p
+
+end PubSubMessage
+
+namespace Subscriber
+
+/-- Bounded message queue (oldest first, from `head`) -/
+structure Buffer where
+  items : Array PubSubMessage := #[]
+  head : Nat := 0
+  /-- Messages discarded by the overflow policy -/
+  dropped : Nat := 0
+  closed : Bool := false
+
+namespace Buffer
+
+def size (b : Buffer) : Nat := b.items.size - b.head
+
+/-- Drop consumed slots once they make up half the array -/
+private def compact (b : Buffer) : Buffer :=
+  if b.head > 64 && 2 * b.head > b.items.size then
+    { b with items := b.items.extract b.head b.items.size, head := 0 }
+  else b
+
+/-- Queue a message. When full, `.dropNewest` discards it; `.dropOldest` (and
+    `.block`, whose caller waits for room first) discard the oldest one. -/
+def push (b : Buffer) (m : PubSubMessage) (capacity : Nat) (policy : OverflowPolicy) : Buffer :=
+  if b.closed then b
+  else if b.size < capacity then { b with items := b.items.push m }
+  else match policy with
+    | .dropNewest => { b with dropped := b.dropped + 1 }
+    | .dropOldest | .block =>
+      if capacity == 0 then { b with dropped := b.dropped + 1 }
+      else compact { b with items := b.items.push m, head := b.head + 1, dropped := b.dropped + 1 }
+
+def pop? (b : Buffer) : Option PubSubMessage × Buffer :=
+  if h : b.head < b.items.size then
+    (some b.items[b.head], compact { b with head := b.head + 1 })
+  else (none, b)
+
+/-- Up to `max` messages, oldest first -/
+def popMany (b : Buffer) (max : Nat) : Array PubSubMessage × Buffer :=
+  let n := Nat.min max b.size
+  (b.items.extract b.head (b.head + n), compact { b with head := b.head + n })
+
+end Buffer
+
+/-- Subscriber counters -/
+structure Stats where
+  /-- Replies delivered by the subscriber thread (messages and confirmations) -/
+  received : Nat
+  reconnects : Nat
+  dropped : Nat
+  queued : Nat
+  deriving Repr
+
+end Subscriber
+
+structure Subscriber where
+  config : SubscriberConfig
+  handle : FFI.SubscriberHandle
+  buffer : Std.Mutex Subscriber.Buffer
+  /-- Signalled whenever messages are queued or consumed, and on close -/
+  cond : Std.Condvar
+
+namespace Subscriber
+
+private def deliver (config : SubscriberConfig) (buffer : Std.Mutex Buffer) (cond : Std.Condvar)
+    (batch : Array Reply) : BaseIO Unit := do
+  let msgs := batch.filterMap PubSubMessage.ofReply?
+  if msgs.isEmpty then return
+  match config.overflow with
+  | .block =>
+    for m in msgs do
+      buffer.atomicallyOnce cond
+        (do let b ← get; return b.closed || b.size < config.capacity)
+        (modify (·.push m config.capacity .block))
+      cond.notifyAll
+  | policy =>
+    buffer.atomically (modify fun b => msgs.foldl (·.push · config.capacity policy) b)
+    cond.notifyAll
+
+/-- Open the subscriber connection and start its thread -/
+def start (config : Config) (subConfig : SubscriberConfig := {}) : EIO Error Subscriber := do
+  if config.ssl.isSome then
+    throw (Error.otherError "the subscriber thread does not support SSL connections")
+  let buffer ← Std.Mutex.new ({} : Buffer)
+  let cond ← Std.Condvar.new
+  let handle ← FFI.Internal.subscriberStart config.host (UInt32.ofNat config.port)
+    (deliver subConfig buffer cond) (UInt64.ofNat subConfig.batchSize)
+  return { config := subConfig, handle, buffer, cond }
+
+private def command (s : Subscriber) (kind : UInt8) (unsubscribe : Bool) (names : Array String) : EIO Error Unit :=
+  FFI.Internal.subscriberCommand s.handle kind (if unsubscribe then 1 else 0) (names.map String.toUTF8)
+
+def subscribe (s : Subscriber) (channels : Array String) : EIO Error Unit := s.command 0 false channels
+def psubscribe (s : Subscriber) (patterns : Array String) : EIO Error Unit := s.command 1 false patterns
+def ssubscribe (s : Subscriber) (channels : Array String) : EIO Error Unit := s.command 2 false channels
+
+/-- Unsubscribe from the channels (all channels if empty) -/
+def unsubscribe (s : Subscriber) (channels : Array String := #[]) : EIO Error Unit := s.command 0 true channels
+def punsubscribe (s : Subscriber) (patterns : Array String := #[]) : EIO Error Unit := s.command 1 true patterns
+def sunsubscribe (s : Subscriber) (channels : Array String := #[]) : EIO Error Unit := s.command 2 true channels
+
+/-- Wait for the next message; `none` once the subscriber is closed and drained -/
+def recv (s : Subscriber) : IO (Option PubSubMessage) := do
+  let m ← s.buffer.atomicallyOnce s.cond
+    (do let b ← get; return b.closed || b.size > 0)
+    (modifyGet (·.pop?))
+  s.cond.notifyAll
+  return m
+
+/-- Wait for at least one message and take up to `max`; empty once closed and drained -/
+def recvBatch (s : Subscriber) (max : Nat := 1024) : IO (Array PubSubMessage) := do
+  let ms ← s.buffer.atomicallyOnce s.cond
+    (do let b ← get; return b.closed || b.size > 0)
+    (modifyGet (·.popMany max))
+  s.cond.notifyAll
+  return ms
+
+/-- Next message if one is queued -/
+def tryRecv (s : Subscriber) : IO (Option PubSubMessage) := do
+  let m ← s.buffer.atomically (modifyGet (·.pop?))
+  if m.isSome then s.cond.notifyAll
+  return m
+
+/-- Run `f` on every message until the subscriber is closed -/
+partial def forEach (s : Subscriber) (f : PubSubMessage → IO Unit) : IO Unit := do
+  let ms ← s.recvBatch
+  if ms.isEmpty then return
+  for m in ms do f m
+  s.forEach f
+
+def stats (s : Subscriber) : IO Stats := do
+  let (received, reconnects) ← FFI.Internal.subscriberStats s.handle
+  let (dropped, queued) ← s.buffer.atomically do
+    let b ← get
+    return (b.dropped, b.size)
+  return { received := received.toNat, reconnects := reconnects.toNat, dropped, queued }
+
+/-- Stop the thread and close the connection. Queued messages can still be
+    received; `recv` returns `none` afterwards. Closing twice is harmless;
+    subscribing afterwards fails. -/
+def close (s : Subscriber) : IO Unit := do
+  -- Release a subscriber thread blocked on a full buffer first
+  s.buffer.atomically (modify fun b => { b with closed := true })
+  s.cond.notifyAll
+  FFI.Internal.subscriberStop s.handle
+
+end Subscriber
+
+end Redis
@@ -0,0 +1,102 @@
+import RedisLean.Config
+import RedisLean.Reply
+import RedisLean.ClusterSlots
+
+namespace Redis
+
+/-!
+# Replicas
+
+Discovery of the replicas of a standalone primary and choice of the node a
+read-only command goes to.
+
+Without cluster support the deployment is described as a single shard that
+owns every slot: ROLE gives the primary and its replicas, INFO replication is
+used when ROLE is not allowed. Replicas that are not in sync are left out.
+
+`choose` applies the `ReadPreference` using the smoothed per-node latency
+recorded by `Metrics.recordNodeLatency`; nodes not measured yet are tried
+first so that every node gets a latency.
+-/
+
+namespace Replicas
+
+open Cluster (NodeAddr Shard slotCount)
+
+private def allSlots : Array (Nat × Nat) := #[(0, slotCount - 1)]
+
+/-- Port given as integer or string (ROLE uses both) -/
+private def port? (r : Reply) : Option Nat :=
+  (r.int?.map (·.toInt.toNat)) <|> (r.str? >>= String.toNat?)
+
+/-- Layout seen from the ROLE reply of `self`: a primary lists its replicas,
+    a replica names its primary (and counts itself while connected) -/
+def ofRole? (self : NodeAddr) (r : Reply) : Option Shard := do
+  let es ← r.elems?
+  match ← es[0]? >>= Reply.str? with
+  | "master" =>
+    let entries ← es[2]? >>= Reply.elems?
+    let replicas := entries.filterMap fun e => do
+      let fs ← e.elems?
+      return { host := ← fs[0]? >>= Reply.str?, port := ← fs[1]? >>= port? }
+    return { ranges := allSlots, primary := self, replicas }
+  | "slave" =>
+    let primary : NodeAddr := { host := ← es[1]? >>= Reply.str?, port := ← es[2]? >>= port? }
+    let connected := (es[3]? >>= Reply.str?) == some "connected"
+    return { ranges := allSlots, primary, replicas := if connected then #[self] else #[] }
+  | _ => none
+
+/-- `key:value` lines of an INFO section -/
+def infoFields (info : String) : List (String × String) :=
+  (info.replace "\r" "").splitOn "\n" |>.filterMap fun line =>
+    match line.splitOn ":" with
+    | key :: value :: rest => some (key, ":".intercalate (value :: rest))
+    | _ => none
+
+/-- `a=1,b=2` values of INFO (e.g. `slave0:ip=10.0.0.2,port=6380,state=online`) -/
+def infoPairs (value : String) : List (String × String) :=
+  value.splitOn "," |>.filterMap fun kv =>
+    match kv.splitOn "=" with
+    | [k, v] => some (k, v)
+    | _ => none
+
+private def isReplicaKey (key : String) : Bool :=
+  key.startsWith "slave" && key.length > 5 && (key.toList.drop 5).all Char.isDigit
+
+/-- Layout seen from the INFO replication section of `self` -/
+def ofInfo? (self : NodeAddr) (info : String) : Option Shard := do
+  let fields := infoFields info
+  match fields.lookup "role" with
+  | some "master" =>
+    let replicas := fields.filterMap fun (key, value) => do
+      if !isReplicaKey key then none
+      let kv := infoPairs value
+      if kv.lookup "state" != some "online" then none
+      return { host := ← kv.lookup "ip", port := ← kv.lookup "port" >>= String.toNat? : NodeAddr }
+    return { ranges := allSlots, primary := self, replicas := replicas.toArray }
+  | some "slave" =>
+    let primary : NodeAddr :=
+      { host := ← fields.lookup "master_host", port := ← fields.lookup "master_port" >>= String.toNat? }
+    let up := fields.lookup "master_link_status" == some "up"
+    return { ranges := allSlots, primary, replicas := if up then #[self] else #[] }
+  | _ => none
+
+/-- Node serving a read-only command. `replicas` are the healthy ones and
+    `latency` the smoothed latency of a node, if measured. Falls back to the
+    primary when no replica qualifies. -/
+def choose (pref : ReadPreference) (primary : NodeAddr) (replicas : Array NodeAddr)
+    (latency : NodeAddr → Option Float) : NodeAddr :=
+  let candidates := match pref with
+    | .primary => #[]
+    | .replica => replicas
+    | .nearest => #[primary] ++ replicas
+  let best := candidates.foldl (init := none) fun best a =>
+    let l := (latency a).getD 0
+    match best with
+    | some (_, bl) => if l < bl then some (a, l) else best
+    | none => some (a, l)
+  (best.map (·.1)).getD primary
+
+end Replicas
+
+end Redis
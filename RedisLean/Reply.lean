@@ -0,0 +1,147 @@
+import RedisLean.Codec
+
+namespace Redis
+
+/-- A decoded Redis reply (RESP2 and RESP3).
+
+    Values of this type are built directly by the hiredis reader in
+    `hiredis/reply_reader.c`, so constructor order is part of the FFI
+    contract: the C side refers to constructors by index (see the
+    `LEAN_REPLY_*` tags). Do not reorder. -/
+inductive Reply where
+  /-- Bulk string (binary safe); RESP3 verbatim strings are decoded here too -/
+  | bulk (data : ByteArray)
+  /-- Simple string / status reply, e.g. `OK` -/
+  | simple (msg : String)
+  /-- Integer reply -/
+  | int (value : Int64)
+  /-- RESP3 double -/
+  | double (value : Float)
+  /-- RESP3 boolean -/
+  | bool (value : Bool)
+  /-- RESP3 big number, kept in its decimal representation -/
+  | bignum (digits : String)
+  /-- Array reply -/
+  | array (elems : Array Reply)
+  /-- RESP3 map (also used for RESP3 attributes) -/
+  | map (entries : Array (Reply × Reply))
+  /-- RESP3 set -/
+  | set (elems : Array Reply)
+  /-- RESP3 out-of-band push message -/
+  | push (elems : Array Reply)
+  /-- Null reply (RESP2 nil bulk/array or RESP3 null) -/
+  | nil
+  /-- Error reply -/
+  | error (msg : String)
+  deriving Inhabited
+
+namespace Reply
+
+/-- Short name of the reply type, as used in error messages -/
+def typeName : Reply → String
+  | bulk _ => "bulk"
+  | simple _ => "simple"
+  | int _ => "int"
+  | double _ => "double"
+  | bool _ => "bool"
+  | bignum _ => "bignum"
+  | array _ => "array"
+  | map _ => "map"
+  | set _ => "set"
+  | push _ => "push"
+  | nil => "nil"
+  | error _ => "error"
+
+def isNil : Reply → Bool
+  | nil => true
+  | _ => false
+
+def isError : Reply → Bool
+  | error _ => true
+  | _ => false
+
+/-- Raw bytes of a string-like reply (bulk, simple, bignum) -/
+def bytes? : Reply → Option ByteArray
+  | bulk data => some data
+  | simple msg => some msg.toUTF8
+  | bignum digits => some digits.toUTF8
+  | _ => none
+
+/-- A string-like reply as UTF-8 text -/
+def str? (r : Reply) : Option String :=
+  r.bytes? >>= String.fromUTF8?
+
+/-- Integer value of an integer reply (RESP3 booleans count as 0/1) -/
+def int? : Reply → Option Int64
+  | int v => some v
+  | bool b => some (if b then 1 else 0)
+  | _ => none
+
+/-- Elements of an array-like reply (array, set, push).
+    Maps are flattened to key, value, key, value, ... like RESP2 does. -/
+def elems? : Reply → Option (Array Reply)
+  | array es => some es
+  | set es => some es
+  | push es => some es
+  | map kvs => some (kvs.foldl (fun acc (k, v) => (acc.push k).push v) #[])
+  | _ => none
+
+/-- Key/value entries of a map reply, or of a RESP2 flat array of pairs -/
+def entries? : Reply → Option (Array (Reply × Reply))
+  | map kvs => some kvs
+  | array es =>
+    if es.size % 2 != 0 then none
+    else some <| (Array.range (es.size / 2)).map fun i => (es[2 * i]!, es[2 * i + 1]!)
+  | _ => none
+
+/-- Bulk elements of an array-like reply (LRANGE, SMEMBERS, KEYS, ZRANGE, ...).
+    Fails if any element is not a string. -/
+def bytesArray? (r : Reply) : Option (Array ByteArray) := do
+  let es ← r.elems?
+  es.mapM bytes?
+
+/-- Elements of an MGET/HMGET-style reply: strings become `some`, nils `none` -/
+def optBytesArray? (r : Reply) : Option (Array (Option ByteArray)) := do
+  let es ← r.elems?
+  es.mapM fun
+    | .nil => some none
+    | e => e.bytes?.map some
+
+/-- Field/value pairs of an HGETALL-style reply (RESP3 map or RESP2 flat array) -/
+def bytesPairs? (r : Reply) : Option (Array (ByteArray × ByteArray)) := do
+  let kvs ← r.entries?
+  kvs.mapM fun (k, v) => do return (← k.bytes?, ← v.bytes?)
+
+/-- Decode a string-like reply with a codec -/
+def decode [Codec α] (r : Reply) : Except String α :=
+  match r with
+  | error msg => .error msg
+  | _ =>
+    match r.bytes? with
+    | some data => Codec.dec data
+    | none => .error s!"cannot decode {r.typeName} reply"
+
+/-- Render a reply the way `redis-cli` prints it (for logs and examples) -/
+partial def render : Reply → String
+  | bulk data => match String.fromUTF8? data with
+    | some s => s!"\"{s}\""
+    | none => s!"<{data.size} bytes>"
+  | simple msg => msg
+  | int v => s!"(integer) {v}"
+  | double v => s!"(double) {v}"
+  | bool b => if b then "(true)" else "(false)"
+  | bignum digits => s!"(bignum) {digits}"
+  | array es => "[" ++ ", ".intercalate (es.map render).toList ++ "]"
+  | set es => "{" ++ ", ".intercalate (es.map render).toList ++ "}"
+  | push es => ">[" ++ ", ".intercalate (es.map render).toList ++ "]"
+  | map kvs => "{" ++ ", ".intercalate (kvs.map fun (k, v) => s!"{render k}: {render v}").toList ++ "}"
+  | nil => "(nil)"
+  | error msg => s!"(error) {msg}"
+
+instance : ToString Reply := ⟨render⟩
+
+instance : Repr Reply := ⟨fun r _ => render r⟩
+
+end Reply
+
+end Redis
@@ -0,0 +1,237 @@
+import Std.Data.HashMap
+import RedisLean.Reply
+import RedisLean.Replicas
+
+namespace Redis
+
+/-!
+# Server Stats
+
+What the server reports about its own latency, in structured form:
+
+- `INFO commandstats`: calls and total time per command
+- `INFO latencystats` (Redis 7): latency percentiles per command
+- `LATENCY LATEST` / `LATENCY HISTORY`: latency spikes per event
+- `SLOWLOG GET`: the slowest recent commands with their arguments
+
+The parsers here are pure; `StatsCollector` runs the commands on a
+connection of its own and `Metrics` keeps the result next to the latencies
+the client observed, so the difference between the two (network and client
+overhead) can be read per command.
+
+Command names are normalised to the form `RedisCmd` prints: upper case, with
+a space between a container command and its subcommand (`CONFIG GET`).
+-/
+
+/-- Counters of one command from `INFO commandstats` -/
+structure CommandStat where
+  command : String
+  calls : Nat
+  /-- Total server time in microseconds -/
+  usec : Nat
+  rejectedCalls : Nat := 0
+  failedCalls : Nat := 0
+  deriving Repr, BEq, Inhabited
+
+namespace CommandStat
+
+/-- Server time per call in microseconds -/
+def usecPerCall (s : CommandStat) : Float :=
+  if s.calls == 0 then 0 else s.usec.toFloat / s.calls.toFloat
+
+/-- Counters accumulated since `base` was read; the whole of `s` when the
+    server was restarted or its stats reset in between -/
+def since (s base : CommandStat) : CommandStat :=
+  if s.calls < base.calls || s.usec < base.usec then s
+  else { s with
+    calls := s.calls - base.calls,
+    usec := s.usec - base.usec,
+    rejectedCalls := s.rejectedCalls - base.rejectedCalls,
+    failedCalls := s.failedCalls - base.failedCalls }
+
+end CommandStat
+
+/-- Latency percentiles of one command from `INFO latencystats` -/
+structure ServerLatency where
+  command : String
+  /-- Percentile as the server names it (`p50`, `p99`, `p99.9`) and its value
+      in microseconds -/
+  percentiles : Array (String × Float)
+  deriving Repr, Inhabited
+
+/-- One sample of `LATENCY HISTORY` -/
+structure LatencySample where
+  /-- Unix time in seconds -/
+  timestamp : Nat
+  latencyMs : Nat
+  deriving Repr, BEq, Inhabited
+
+/-- One entry of `SLOWLOG GET` -/
+structure SlowlogEntry where
+  id : Nat
+  /-- Unix time in seconds -/
+  timestamp : Nat
+  durationUs : Nat
+  args : Array String
+  /-- Client address and name (Redis 4.0 and later) -/
+  client : String := ""
+  clientName : String := ""
+  deriving Repr, BEq, Inhabited
+
+namespace SlowlogEntry
+
+/-- Command name of the entry, normalised like the other server stats -/
+def command (e : SlowlogEntry) : String :=
+  (e.args[0]?.map String.toUpper).getD ""
+
+end SlowlogEntry
+
+/-- One collection from the server -/
+structure ServerSample where
+  commands : Array CommandStat := #[]
+  latencies : Array ServerLatency := #[]
+  /-- Latency history by event name -/
+  events : Array (String × Array LatencySample) := #[]
+  /-- Slow log, newest first like the server returns it -/
+  slowlog : Array SlowlogEntry := #[]
+  deriving Inhabited
+
+/-- Server stats accumulated over the collections -/
+structure ServerStats where
+  /-- Latest counters by command -/
+  commands : Std.HashMap String CommandStat := {}
+  /-- Counters at the first collection, so that `window` covers the same
+      period as the client-side metrics; zero from a reset of the server's
+      counters on -/
+  baseline : Std.HashMap String CommandStat := {}
+  latencies : Std.HashMap String ServerLatency := {}
+  events : Std.HashMap String (Array LatencySample) := {}
+  /-- Most recent slow log entries, oldest first -/
+  slowlog : Array SlowlogEntry := #[]
+  /-- Slow log entries seen in total -/
+  slowlogSeen : Nat := 0
+  collections : Nat := 0
+  /-- `IO.monoNanosNow` of the last collection -/
+  collectedAt : Nat := 0
+
+namespace ServerStats
+
+/-- Slow log entries kept -/
+def slowlogCapacity : Nat := 128
+
+/-- Upper case, `|` between command and subcommand replaced by a space -/
+def normalizeCommand (name : String) : String :=
+  (name.map fun c => if c == '|' then ' ' else c).toUpper
+
+/-- Decimal number as printed by the server (`7.50`, `1.003`) -/
+def parseDecimal (s : String) : Option Float :=
+  match s.splitOn "." with
+  | [whole] => whole.toNat?.map Nat.toFloat
+  | [whole, frac] => do
+    let w ← whole.toNat?
+    let f ← if frac.isEmpty then some 0 else frac.toNat?
+    return w.toFloat + f.toFloat / (10 ^ frac.length).toFloat
+  | _ => none
+
+-- commands of the INFO lines `<pre><cmd>:k1=v1,k2=v2`, with their pairs
+private def commandFields (info pre : String) : Array (String × List (String × String)) :=
+  (Replicas.infoFields info).toArray.filterMap fun (key, value) =>
+    if key.startsWith pre then some (normalizeCommand (key.drop pre.length).toString, Replicas.infoPairs value)
+    else none
+
+/-- Lines `cmdstat_<cmd>:calls=..,usec=..,..` of `INFO commandstats` -/
+def parseCommandStats (info : String) : Array CommandStat :=
+  (commandFields info "cmdstat_").filterMap fun (command, kv) => do
+    return { command,
+             calls := ← kv.lookup "calls" >>= String.toNat?,
+             usec := ← kv.lookup "usec" >>= String.toNat?,
+             rejectedCalls := (kv.lookup "rejected_calls" >>= String.toNat?).getD 0,
+             failedCalls := (kv.lookup "failed_calls" >>= String.toNat?).getD 0 }
+
+/-- Lines `latency_percentiles_usec_<cmd>:p50=..,p99=..` of `INFO latencystats` -/
+def parseLatencyStats (info : String) : Array ServerLatency :=
+  (commandFields info "latency_percentiles_usec_").map fun (command, kv) =>
+    { command, percentiles := kv.toArray.filterMap fun (k, v) => (parseDecimal v).map (k, ·) }
+
+private def nat? (r : Reply) : Option Nat :=
+  r.int?.map (·.toInt.toNat)
+
+/-- Event names of `LATENCY LATEST` (`[event, time, latest, max]` entries) -/
+def parseLatencyLatest (r : Reply) : Array String :=
+  (r.elems?.getD #[]).filterMap fun e => e.elems? >>= (·[0]?) >>= Reply.str?
+
+/-- Samples of `LATENCY HISTORY <event>` (`[time, latency]` entries), oldest
+    first -/
+def parseLatencyHistory (r : Reply) : Array LatencySample :=
+  (r.elems?.getD #[]).filterMap fun e => do
+    let es ← e.elems?
+    return { timestamp := ← es[0]? >>= nat?, latencyMs := ← es[1]? >>= nat? }
+
+/-- Entries of `SLOWLOG GET`, newest first -/
+def parseSlowlog (r : Reply) : Array SlowlogEntry :=
+  (r.elems?.getD #[]).filterMap fun e => do
+    let es ← e.elems?
+    let args ← es[3]? >>= Reply.elems?
+    return {
+      id := ← es[0]? >>= nat?,
+      timestamp := ← es[1]? >>= nat?,
+      durationUs := ← es[2]? >>= nat?,
+      args := args.filterMap Reply.str?,
+      client := (es[4]? >>= Reply.str?).getD "",
+      clientName := (es[5]? >>= Reply.str?).getD ""
+    }
+
+/-- Slow log entries of `newestFirst` not seen yet, oldest first. Ids grow
+    on the server; a newest id below the last one seen means the server was
+    restarted, and everything is new again. -/
+def newSlowlog (s : ServerStats) (newestFirst : Array SlowlogEntry) : Array SlowlogEntry :=
+  let entries := newestFirst.reverse
+  match s.slowlog.back?, newestFirst[0]? with
+  | some last, some newest =>
+    if newest.id < last.id then entries else entries.filter (·.id > last.id)
+  | _, _ => entries
+
+/-- Whether the counters went down from `prev` to `c` (server restarted or
+    stats reset) -/
+private def wasReset (c prev : CommandStat) : Bool :=
+  c.calls < prev.calls || c.usec < prev.usec
+
+/-- Baseline after the collection `commands`: a command whose counters were
+    reset since the last collection (or are below its baseline) counts from
+    zero, so that later collections are not measured against stale counters -/
+private def rebase (s : ServerStats) (commands : Std.HashMap String CommandStat) :
+    Std.HashMap String CommandStat :=
+  commands.fold (init := s.baseline) fun baseline name c =>
+    let reset := (s.commands[name]?.any (wasReset c ·)) || (s.baseline[name]?.any (wasReset c ·))
+    if reset then baseline.insert name { command := name, calls := 0, usec := 0 } else baseline
+
+/-- Add a collection taken at `now` -/
+def ingest (s : ServerStats) (sample : ServerSample) (now : Nat) : ServerStats :=
+  let fresh := s.newSlowlog sample.slowlog
+  let slowlog := s.slowlog ++ fresh
+  let commands : Std.HashMap String CommandStat := sample.commands.foldl (fun h c => h.insert c.command c) {}
+  { s with
+    commands := commands,
+    baseline := if s.collections == 0 then commands else s.rebase commands,
+    latencies := sample.latencies.foldl (fun h l => h.insert l.command l) {},
+    events := sample.events.foldl (fun h (e, samples) => h.insert e samples) s.events,
+    slowlog := slowlog.extract (slowlog.size - slowlogCapacity) slowlog.size,
+    slowlogSeen := s.slowlogSeen + fresh.size,
+    collections := s.collections + 1,
+    collectedAt := now }
+
+/-- Counters of a command since the first collection (those of a command
+    first seen later are all in the window) -/
+def window (s : ServerStats) (command : String) : Option CommandStat :=
+  s.commands[command]?.map fun c =>
+    match s.baseline[command]? with
+    | some base => c.since base
+    | none => c
+
+/-- Latest latency of every event, in milliseconds -/
+def latestEvents (s : ServerStats) : Array (String × Nat) :=
+  s.events.toArray.filterMap fun (e, samples) => samples.back?.map (e, ·.latencyMs)
+
+end ServerStats
+
+end Redis
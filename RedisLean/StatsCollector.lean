@@ -0,0 +1,127 @@
+import RedisLean.Config
+import RedisLean.Error
+import RedisLean.FFI
+import RedisLean.Metrics
+import RedisLean.ServerStats
+
+namespace Redis
+
+/-!
+# Stats Collector
+
+Background task that reads the server's own view of its latency every
+`intervalMs` and adds it to a `Metrics` (see `ServerStats`), next to the
+latencies the client observed:
+
+- `INFO commandstats` and `INFO latencystats`
+- `SLOWLOG GET <slowlogCount>`
+- `LATENCY LATEST`, then `LATENCY HISTORY` of every event it lists
+
+Each collection is one or two pipelined round trips on a connection of the
+collector's own, so its commands never show up in the client-side metrics.
+A command the server refuses (LATENCY disabled, INFO latencystats before
+Redis 7) just leaves its part of the collection empty; a lost connection
+counts as a failed collection, is reopened, and the next collection is tried
+on schedule.
+-/
+
+/-- Stats collector configuration -/
+structure StatsCollectorConfig where
+  /-- Time between collections, in milliseconds -/
+  intervalMs : Nat := 10000
+  /-- Slow log entries asked for per collection -/
+  slowlogCount : Nat := 128
+  /-- Also read LATENCY LATEST and the history of each event -/
+  latencyHistory : Bool := true
+  /-- How often the task checks for shutdown while waiting, in milliseconds -/
+  pollIntervalMs : Nat := 100
+  deriving Repr
+
+/-- A running collector -/
+structure StatsCollector where
+  config : StatsCollectorConfig
+  ctx : FFI.Ctx
+  metrics : Metrics
+  stopFlag : IO.Ref Bool
+  task : IO.Ref (Option (Task (Except IO.Error Unit)))
+  /-- Collections that failed, and the error of the last one -/
+  failures : IO.Ref Nat
+  lastError : IO.Ref (Option Error)
+
+namespace StatsCollector
+
+private def args (xs : Array String) : Array ByteArray :=
+  xs.map String.toUTF8
+
+private def text (r : Reply) : String :=
+  (r.str?).getD ""
+
+/-- Read the server stats once on `ctx` -/
+def collect (ctx : FFI.Ctx) (config : StatsCollectorConfig := {}) : EIO Error ServerSample := do
+  let replies ← FFI.pipelineExec ctx #[
+    args #["INFO", "commandstats"],
+    args #["INFO", "latencystats"],
+    args #["SLOWLOG", "GET", toString config.slowlogCount],
+    args #["LATENCY", "LATEST"]
+  ]
+  let reply (i : Nat) : Reply := replies[i]?.getD .nil
+  let names := if config.latencyHistory then ServerStats.parseLatencyLatest (reply 3) else #[]
+  let histories ← if names.isEmpty then pure #[] else
+    FFI.pipelineExec ctx (names.map fun e => args #["LATENCY", "HISTORY", e])
+  return {
+    commands := ServerStats.parseCommandStats (text (reply 0)),
+    latencies := ServerStats.parseLatencyStats (text (reply 1)),
+    slowlog := ServerStats.parseSlowlog (reply 2),
+    events := names.zip (histories.map ServerStats.parseLatencyHistory)
+  }
+
+/-- Collect now into the metrics. A failure is recorded, not raised, and the
+    connection reopened for the next collection (if that fails too, the next
+    collection fails and tries again). -/
+def collectNow (c : StatsCollector) : IO Unit := do
+  match ← (collect c.ctx c.config).toBaseIO with
+  | .ok sample => c.metrics.recordServerSample sample
+  | .error e =>
+    c.failures.modify (· + 1)
+    c.lastError.set (some e)
+    let _ ← (FFI.reconnect c.ctx).toBaseIO
+
+private def run (c : StatsCollector) : IO Unit := do
+  while !(← c.stopFlag.get) do
+    c.collectNow
+    let deadline := (← IO.monoMsNow) + c.config.intervalMs
+    while !(← c.stopFlag.get) && (← IO.monoMsNow) < deadline do
+      IO.sleep (UInt32.ofNat c.config.pollIntervalMs)
+
+/-- Open the collector's connection to the server of `cfg` and start
+    collecting into `metrics` (the first collection is immediate) -/
+def start (metrics : Metrics) (cfg : Config) (config : StatsCollectorConfig := {}) :
+    EIO Error StatsCollector := do
+  let ctx ← FFI.connect cfg.host (UInt32.ofNat cfg.port) cfg.ssl
+  let c : StatsCollector := {
+    config
+    ctx
+    metrics
+    stopFlag := ← IO.mkRef false
+    task := ← IO.mkRef none
+    failures := ← IO.mkRef 0
+    lastError := ← IO.mkRef none
+  }
+  let task ← IO.asTask (prio := .dedicated) (run c)
+  c.task.set (some task)
+  return c
+
+/-- Failed collections so far, and the last error -/
+def failureStats (c : StatsCollector) : IO (Nat × Option Error) := do
+  return (← c.failures.get, ← c.lastError.get)
+
+/-- Stop the task and close the connection -/
+def stop (c : StatsCollector) : IO Unit := do
+  c.stopFlag.set true
+  if let some t ← c.task.get then
+    let _ ← IO.wait t
+  let _ ← (FFI.free c.ctx).toBaseIO
+
+end StatsCollector
+
+end Redis
@@ -5,6 +5,11 @@
 import RedisTests.Codec
 import RedisTests.Config
 import RedisTests.Error
+import RedisTests.ReplyTests
+import RedisTests.NearCacheTests
+import RedisTests.AutoPipelineTests
+import RedisTests.PubSubTests
+import RedisTests.ClusterTests
 
 -- Mock and fixtures
 import RedisTests.Mock
@@ -0,0 +1,81 @@
+import LSpec
+import RedisLean.AutoPipeline
+import RedisTests.Fixtures
+
+open Redis LSpec
+open Redis.Fixtures (k okEq)
+
+namespace RedisTests.AutoPipelineTests
+
+/-!
+# Auto-Pipelining Tests
+
+Tests for the reply decoders used when commands go over the multiplexed
+connection: they must give the same results and errors as the blocking C
+wrappers. The multiplexed connection itself needs a server.
+-/
+
+-- Bulk Tests
+def bytesTests : TestSeq :=
+  test "bulk value" (okEq (AutoPipeline.bytes "GET" (k "a") (.bulk (k "1"))) (k "1")) $
+  test "status reply accepted" (okEq (AutoPipeline.bytes "GET" (k "a") (.simple "OK")) (k "OK")) $
+  test "nil is key not found" ((AutoPipeline.bytes "GET" (k "a") .nil) matches .error (.keyNotFoundError "a")) $
+  test "error is a reply error" ((AutoPipeline.bytes "GET" (k "a") (.error "WRONGTYPE Operation against a key")) matches .error (.replyError "WRONGTYPE Operation against a key")) $
+  test "integer is unexpected" ((AutoPipeline.bytes "GET" (k "a") (.int 1)) matches .error (.unexpectedReplyTypeError "GET returned unexpected reply type int"))
+
+-- Hash Field Tests
+def fieldTests : TestSeq :=
+  test "field value" (okEq (AutoPipeline.field (k "h") (.bulk (k "v"))) (k "v")) $
+  test "nil is key not found" ((AutoPipeline.field (k "h") .nil) matches .error (.keyNotFoundError "h")) $
+  test "WRONGTYPE is a null reply error" ((AutoPipeline.field (k "h") (.error "WRONGTYPE Operation against a key")) matches .error (.nullReplyError "WRONGTYPE - key is not a hash")) $
+  test "other error is a reply error" ((AutoPipeline.field (k "h") (.error "ERR boom")) matches .error (.replyError "ERR boom")) $
+  test "integer is unexpected" ((AutoPipeline.field (k "h") (.int 1)) matches .error (.unexpectedReplyTypeError "HGET returned unexpected reply type 3"))
+
+-- Status Tests
+def okTests : TestSeq :=
+  test "OK" (okEq (AutoPipeline.ok "SET" (.simple "OK")) ()) $
+  test "nil when NX/XX not met" ((AutoPipeline.ok "SET" .nil) matches .error (.nullReplyError "SET condition not met (NX/XX)")) $
+  test "error is a reply error" ((AutoPipeline.ok "SET" (.error "ERR syntax error")) matches .error (.replyError "ERR syntax error")) $
+  test "other status is unexpected" ((AutoPipeline.ok "SET" (.simple "QUEUED")) matches .error (.unexpectedReplyTypeError "SET returned unexpected reply type 5"))
+
+-- Integer Tests
+def integerTests : TestSeq :=
+  test "count" (okEq (AutoPipeline.uint64 "DEL" (.int 3)) 3) $
+  test "count error is a reply error" ((AutoPipeline.uint64 "INCR" (.error "ERR not an integer")) matches .error (.replyError "ERR not an integer")) $
+  test "count nil is a null reply error" ((AutoPipeline.uint64 "DEL" .nil) matches .error (.nullReplyError "DEL returned unexpected reply type 4")) $
+  test "count rejects bulk" ((AutoPipeline.uint64 "INCRBY" (.bulk (k "3"))) matches .error (.nullReplyError "INCRBY returned unexpected reply type 1")) $
+  test "hash count" (okEq (AutoPipeline.uint64On "hash" "HSET" (.int 1)) 1) $
+  test "hash count WRONGTYPE" ((AutoPipeline.uint64On "hash" "HSET" (.error "WRONGTYPE Operation against a key")) matches .error (.nullReplyError "WRONGTYPE - key is not a hash")) $
+  test "set count WRONGTYPE" ((AutoPipeline.uint64On "set" "SADD" (.error "WRONGTYPE Operation against a key")) matches .error (.nullReplyError "WRONGTYPE - key is not a set")) $
+  test "set count other error" ((AutoPipeline.uint64On "set" "SADD" (.error "ERR boom")) matches .error (.nullReplyError "ERR boom")) $
+  test "set count nil" ((AutoPipeline.uint64On "set" "SADD" .nil) matches .error (.nullReplyError "SADD returned unexpected reply type 4"))
+
+-- Flag Tests
+def flagTests : TestSeq :=
+  test "flag set" (okEq (AutoPipeline.bool "EXISTS" (.int 1)) true) $
+  test "flag clear" (okEq (AutoPipeline.bool "SISMEMBER" (.int 0)) false) $
+  test "flag error is a reply error" ((AutoPipeline.bool "SISMEMBER" (.error "WRONGTYPE Operation against a key")) matches .error (.replyError "WRONGTYPE Operation against a key")) $
+  test "flag nil" ((AutoPipeline.bool "EXISTS" .nil) matches .error (.nullReplyError "EXISTS returned unexpected reply type 4")) $
+  test "RESP3 boolean rejected like the C wrapper" ((AutoPipeline.bool "EXISTS" (.bool true)) matches .error (.nullReplyError "EXISTS returned unexpected reply type 8")) $
+  test "hash flag" (okEq (AutoPipeline.boolOn "hash" "HEXISTS" (.int 1)) true) $
+  test "hash flag WRONGTYPE" ((AutoPipeline.boolOn "hash" "HEXISTS" (.error "WRONGTYPE Operation against a key")) matches .error (.nullReplyError "WRONGTYPE - key is not a hash")) $
+  test "hash flag other error" ((AutoPipeline.boolOn "hash" "HEXISTS" (.error "ERR boom")) matches .error (.nullReplyError "ERR boom")) $
+  test "hash flag nil" ((AutoPipeline.boolOn "hash" "HEXISTS" .nil) matches .error (.nullReplyError "HEXISTS returned unexpected reply type 4"))
+
+-- Expire Tests
+def expireTests : TestSeq :=
+  test "timeout set" (okEq (AutoPipeline.expire (.int 1)) true) $
+  test "missing key" (okEq (AutoPipeline.expire (.int 0)) false) $
+  test "error is a reply error" ((AutoPipeline.expire (.error "ERR invalid expire time")) matches .error (.replyError "ERR invalid expire time")) $
+  test "nil is unexpected" ((AutoPipeline.expire .nil) matches .error (.unexpectedReplyTypeError "EXPIRE returned unexpected reply type 4"))
+
+-- All Auto-Pipelining Tests
+def allAutoPipelineTests : TestSeq :=
+  group "Bulk" bytesTests $
+  group "Hash Fields" fieldTests $
+  group "Status" okTests $
+  group "Integers" integerTests $
+  group "Flags" flagTests $
+  group "Expire" expireTests
+
+end RedisTests.AutoPipelineTests
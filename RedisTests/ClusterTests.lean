@@ -0,0 +1,174 @@
+import LSpec
+import RedisLean.ClusterSlots
+import RedisLean.Enums
+import RedisLean.Replicas
+import RedisTests.Fixtures
+
+open Redis LSpec
+open Redis.Fixtures (k okEq)
+
+namespace RedisTests.ClusterTests
+
+/-!
+# Cluster Tests
+
+Tests for the pure part of the cluster client: hash slots (with hashtags),
+MOVED/ASK parsing, the decoding of CLUSTER SHARDS / CLUSTER SLOTS into a
+slot map, the splitting and merging of cross-slot commands, and replica
+discovery and choice. Routing itself needs a running cluster.
+-/
+
+def slot (s : String) : Nat := Cluster.keySlot (k s)
+
+-- Hash Slot Tests
+def slotTests : TestSeq :=
+  test "CRC16 check value" (Cluster.crc16 (k "123456789") == 0x31C3) $
+  test "CRC16 of empty input" (Cluster.crc16 ByteArray.empty == 0) $
+  test "slot of foo" (slot "foo" == 12182) $
+  test "slot of bar" (slot "bar" == 5061) $
+  test "slot of hello" (slot "hello" == 866) $
+  test "slots are in range" ((["a", "b", "user:1", "x{y}z"].all (slot · < Cluster.slotCount)))
+
+-- Hashtag Tests
+def hashTagTests : TestSeq :=
+  test "hashtag is hashed" (Cluster.hashTag (k "{user1000}.following") == k "user1000") $
+  test "same tag, same slot" (slot "{user1000}.following" == slot "{user1000}.followers") $
+  test "tag alone equals key" (slot "{foo}bar" == slot "foo") $
+  test "empty tag hashes whole key" (Cluster.hashTag (k "foo{}{bar}") == k "foo{}{bar}") $
+  test "first tag only" (Cluster.hashTag (k "foo{{bar}}zap") == k "{bar") $
+  test "unclosed brace hashes whole key" (Cluster.hashTag (k "foo{bar") == k "foo{bar")
+
+-- Redirection Tests
+def redirectTests : TestSeq :=
+  test "MOVED" (Cluster.Redirect.parse? "MOVED 3999 127.0.0.1:6381" ==
+    some (.moved 3999 { host := "127.0.0.1", port := 6381 })) $
+  test "ASK" (Cluster.Redirect.parse? "ASK 12182 10.0.0.2:7002" ==
+    some (.ask 12182 { host := "10.0.0.2", port := 7002 })) $
+  test "unknown endpoint" (Cluster.Redirect.parse? "MOVED 1 :7001" ==
+    some (.moved 1 { host := "", port := 7001 })) $
+  test "IPv6 address" ((Cluster.Redirect.parse? "MOVED 1 ::1:7001").map (·.addr.host) == some "::1") $
+  test "other errors" (Cluster.Redirect.parse? "WRONGTYPE Operation against a key" == none) $
+  test "CROSSSLOT is not a redirection" (Cluster.Redirect.parse? "CROSSSLOT Keys in request don't hash to the same slot" == none)
+
+-- Slot Map Tests
+def node (port : Int64) (role : String) (health := "online") : Reply :=
+  .map #[(.bulk (k "id"), .bulk (k s!"node{port}")), (.bulk (k "port"), .int port),
+    (.bulk (k "ip"), .bulk (k "127.0.0.1")), (.bulk (k "endpoint"), .bulk (k "127.0.0.1")),
+    (.bulk (k "role"), .bulk (k role)), (.bulk (k "health"), .bulk (k health))]
+
+def shard (slots : Array Int64) (nodes : Array Reply) : Reply :=
+  .map #[(.bulk (k "slots"), .array (slots.map Reply.int)), (.bulk (k "nodes"), .array nodes)]
+
+def shardsReply : Reply := .array #[
+  shard #[0, 5460] #[node 7000 "master", node 7003 "replica"],
+  shard #[5461, 10922] #[node 7001 "master", node 7004 "replica" "fail"],
+  shard #[10923, 16000, 16001, 16383] #[node 7005 "replica", node 7002 "master"]]
+
+def slotMap : Cluster.SlotMap :=
+  Cluster.SlotMap.ofShards ((Cluster.parseShards? shardsReply).getD #[])
+
+def port? (m : Cluster.SlotMap) (s : Nat) : Option Nat :=
+  (m.primary? s).map (·.port)
+
+def slotMapTests : TestSeq :=
+  test "all shards decoded" (slotMap.shards.size == 3) $
+  test "full coverage" (slotMap.coveredSlots == Cluster.slotCount) $
+  test "first slot" (port? slotMap 0 == some 7000) $
+  test "range boundary" (port? slotMap 5460 == some 7000 && port? slotMap 5461 == some 7001) $
+  test "several ranges" (port? slotMap 16001 == some 7002 && port? slotMap 16383 == some 7002) $
+  test "key lookup" (port? slotMap (slot "foo") == some 7002) $
+  test "replicas" ((slotMap.shard? 0).map (·.replicas.size) == some 1) $
+  test "failed replicas dropped" ((slotMap.shard? 6000).map (·.replicas.size) == some 0) $
+  test "primary need not come first" ((slotMap.shard? 12000).map (·.replicas.map (·.port)) == some #[7005]) $
+  test "RESP2 flat arrays" ((Cluster.parseShards? (.array #[.array #[.bulk (k "slots"), .array #[.int 0, .int 16383],
+      .bulk (k "nodes"), .array #[.array #[.bulk (k "ip"), .bulk (k "10.0.0.1"), .bulk (k "port"), .int 6379,
+        .bulk (k "role"), .bulk (k "master")]]]])).map (·.map (·.primary.host)) == some #["10.0.0.1"]) $
+  test "empty map" (({} : Cluster.SlotMap).primary? 0 == none)
+
+-- CLUSTER SLOTS Tests
+def slotsReply : Reply := .array #[
+  .array #[.int 0, .int 8191, .array #[.bulk (k "127.0.0.1"), .int 7000, .bulk (k "a")],
+    .array #[.bulk (k "127.0.0.1"), .int 7003, .bulk (k "b")]],
+  .array #[.int 8192, .int 16383, .array #[.bulk (k "127.0.0.1"), .int 7001, .bulk (k "c")]]]
+
+def clusterSlotsTests : TestSeq :=
+  let m := Cluster.SlotMap.ofShards ((Cluster.parseSlots? slotsReply).getD #[])
+  test "coverage" (m.coveredSlots == Cluster.slotCount) $
+  test "owners" (port? m 8191 == some 7000 && port? m 8192 == some 7001) $
+  test "replicas" ((m.shard? 0).map (·.replicas.size) == some 1)
+
+-- Fan-out Tests
+def fanOutKeys : Array ByteArray := #["foo", "bar", "{foo}x", "hello", "{bar}y"].map k
+
+def fanOutTests : TestSeq :=
+  let groups := Cluster.groupBySlot fanOutKeys
+  test "one group per slot" (groups.map (·.2) == #[#[0, 2], #[1, 4], #[3]]) $
+  test "group slots" (groups.map (·.1) == #[12182, 5061, 866]) $
+  test "no keys, no groups" ((Cluster.groupBySlot #[]).isEmpty) $
+  test "sub-command keeps key order" (Cluster.subCommand "MGET" fanOutKeys #[1, 4] == #["MGET", "bar", "{bar}y"].map k) $
+  test "counts are summed" (okEq (Cluster.sumReplies "DEL" #[.int 2, .int 0, .int 1]) 3) $
+  test "sum rejects non-integers" ((Cluster.sumReplies "DEL" #[.int 2, .nil]) matches .error _) $
+  test "all OK" (okEq (Cluster.allOk "MSET" #[.simple "OK", .simple "OK"]) ()) $
+  test "MSET failure surfaces" ((Cluster.allOk "MSET" #[.simple "OK", .nil]) matches .error _) $
+  test "values back in key order" (okEq (Cluster.scatterValues 5 (groups.map (·.2))
+      #[.array #[.bulk (k "1"), .nil], .array #[.bulk (k "2"), .bulk (k "5")], .array #[.bulk (k "4")]])
+    #[some (k "1"), some (k "2"), none, some (k "4"), some (k "5")]) $
+  test "short MGET reply is an error" ((Cluster.scatterValues 5 (groups.map (·.2))
+      #[.array #[.nil], .array #[.nil, .nil], .array #[.nil]]) matches .error _)
+
+-- Replica Tests
+def addr (port : Nat) (host := "127.0.0.1") : Cluster.NodeAddr := { host, port }
+
+def roleMaster : Reply := .array #[.bulk (k "master"), .int 3129659,
+  .array #[.array #[.bulk (k "10.0.0.2"), .bulk (k "6380"), .bulk (k "3129242")],
+    .array #[.bulk (k "10.0.0.3"), .bulk (k "6381"), .bulk (k "3129543")]]]
+
+def roleReplica (state : String) : Reply :=
+  .array #[.bulk (k "slave"), .bulk (k "10.0.0.1"), .int 6379, .bulk (k state), .int 3167038]
+
+def infoMaster : String :=
+  "# Replication\r\nrole:master\r\nconnected_slaves:2\r\n" ++
+  "slave0:ip=10.0.0.2,port=6380,state=online,offset=3129242,lag=0\r\n" ++
+  "slave1:ip=10.0.0.3,port=6381,state=wait_bgsave,offset=0,lag=0\r\n" ++
+  "master_replid:8371445ee0b4a7b8e5c5a5e2a0c2c7f6d1e3a9b4\r\n"
+
+def infoReplica : String :=
+  "# Replication\r\nrole:slave\r\nmaster_host:10.0.0.1\r\nmaster_port:6379\r\nmaster_link_status:up\r\n"
+
+def ports (s : Option Cluster.Shard) : Option (Nat × Array Nat) :=
+  s.map fun s => (s.primary.port, s.replicas.map (·.port))
+
+def latency (l : List (Nat × Float)) (a : Cluster.NodeAddr) : Option Float :=
+  l.lookup a.port
+
+def replicaTests : TestSeq :=
+  let self := addr 6379 "10.0.0.1"
+  test "ROLE on a primary" (ports (Replicas.ofRole? self roleMaster) == some (6379, #[6380, 6381])) $
+  test "ROLE on a replica" (ports (Replicas.ofRole? (addr 6380) (roleReplica "connected")) == some (6379, #[6380])) $
+  test "replica still syncing" (ports (Replicas.ofRole? (addr 6380) (roleReplica "sync")) == some (6379, #[])) $
+  test "ROLE owns every slot" ((Replicas.ofRole? self roleMaster).map (·.ranges) == some #[(0, 16383)]) $
+  test "INFO on a primary keeps online replicas" (ports (Replicas.ofInfo? self infoMaster) == some (6379, #[6380])) $
+  test "INFO on a replica" ((Replicas.ofInfo? (addr 6380) infoReplica).map (·.primary.host) == some "10.0.0.1") $
+  test "INFO without role" (Replicas.ofInfo? self "# Replication\r\n" |>.isNone) $
+  test "primary preference" (Replicas.choose .primary (addr 1) #[addr 2] (latency []) == addr 1) $
+  test "fastest replica" (Replicas.choose .replica (addr 1) #[addr 2, addr 3]
+    (latency [(1, 10), (2, 300), (3, 120)]) == addr 3) $
+  test "unmeasured replica tried first" (Replicas.choose .replica (addr 1) #[addr 2, addr 3]
+    (latency [(2, 300)]) == addr 3) $
+  test "nearest may pick the primary" (Replicas.choose .nearest (addr 1) #[addr 2]
+    (latency [(1, 10), (2, 300)]) == addr 1) $
+  test "no healthy replica" (Replicas.choose .replica (addr 1) #[] (latency []) == addr 1) $
+  test "reads are read-only" (RedisCmd.GET.isReadOnly && RedisCmd.MGET.isReadOnly && RedisCmd.EXISTS.isReadOnly) $
+  test "writes are not" (!RedisCmd.SET.isReadOnly && !RedisCmd.DEL.isReadOnly && !RedisCmd.TOUCH.isReadOnly)
+
+-- All Cluster Tests
+def allClusterTests : TestSeq :=
+  group "Hash Slots" slotTests $
+  group "Hashtags" hashTagTests $
+  group "Redirections" redirectTests $
+  group "Slot Map" slotMapTests $
+  group "CLUSTER SLOTS" clusterSlotsTests $
+  group "Fan-out" fanOutTests $
+  group "Replicas" replicaTests
+
+end RedisTests.ClusterTests
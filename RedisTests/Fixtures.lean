@@ -6,6 +6,15 @@ import RedisLean.Log
 
 namespace Redis.Fixtures
 
+/-- Key or value given as text, as bytes -/
+def k (s : String) : ByteArray := s.toUTF8
+
+/-- The result is `.ok v` -/
+def okEq [BEq α] (r : Except Error α) (v : α) : Bool :=
+  match r with
+  | .ok x => x == v
+  | .error _ => false
+
 /-- Generate a unique key with timestamp and random suffix for testing.
     Format: "{keyPrefix}:{timestamp_ns}:{random}" -/
 def uniqueKey (keyPrefix : String) : IO String := do
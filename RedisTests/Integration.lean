@@ -109,6 +109,10 @@ def multiOperationTests : TestSeq :=
   test "Multiple SET and GET operations" true $
   test "Sequential INCR operations" true
 
+-- Pipeline Tests (placeholders, see `livePipelineTests`)
+def pipelineTests : TestSeq :=
+  test "Pipeline rejected for an empty command leaves the connection usable" true
+
 -- Complete integration test suite
 def allIntegrationTests : TestSeq :=
   group "String Operations Tests" stringOperationTests $
@@ -119,7 +123,8 @@ def allIntegrationTests : TestSeq :=
   group "Sorted Set Operations Tests" sortedSetOperationTests $
   group "TTL Operations Tests" ttlOperationTests $
   group "Ping Tests" pingTests $
-  group "Multi-operation Tests" multiOperationTests
+  group "Multi-operation Tests" multiOperationTests $
+  group "Pipeline Tests" pipelineTests
 
 /-!
 ## Running Actual Integration Tests
@@ -145,4 +150,24 @@ def testSetGet : IO Bool := runRedisTest do
 ```
 -/
 
+-- Live Pipeline Tests (run by `testRunner integration`)
+
+private def argv (xs : Array String) : Array ByteArray := xs.map String.toUTF8
+
+/-- A pipeline with an empty command in the middle is rejected before any of
+    it is sent: the SET ahead of the empty command never reaches the server,
+    and the next pipeline on the connection reads its own replies -/
+def testPipelineEmptyCommand : IO Bool := do
+  let key := testKey "pipeline-empty-command"
+  let r ← (FFI.withRedis testConfig.host (UInt32.ofNat testConfig.port) fun ctx => do
+    let _ ← FFI.pipelineExec ctx #[argv #["DEL", key]]
+    let rejected ← (FFI.pipelineExec ctx #[argv #["SET", key, "v"], #[], argv #["PING"]]).toBaseIO
+    let after ← FFI.pipelineExec ctx #[argv #["GET", key], argv #["PING"]]
+    return (rejected matches .error _) && (after matches #[.nil, .simple "PONG"])).toBaseIO
+  return r matches .ok true
+
+/-- Live checks against the server of `testConfig`, with their names -/
+def livePipelineTests : List (String × IO Bool) :=
+  [("Pipeline rejected for an empty command leaves the connection usable", testPipelineEmptyCommand)]
+
 end RedisTests.Integration
@@ -1,5 +1,7 @@
 import LSpec
 import RedisLean.Metrics
+import RedisLean.Histogram
+import RedisLean.Enums
 import RedisLean.Mathlib.Core
 
 open Redis LSpec
@@ -188,6 +190,20 @@ def testToPrometheus : IO Bool := do
   let prometheus ← Metrics.toPrometheus metrics
   return containsSubstr prometheus "redis" && prometheus.length > 0
 
+def testPrometheusHistogram : IO Bool := do
+  let metrics ← Metrics.make
+  metrics.recordLatency "GET" 40
+  metrics.recordLatency "GET" 100
+  metrics.recordLatency "GET" 20000
+  let text ← Metrics.toPrometheus metrics
+  return containsSubstr text "# TYPE redis_command_latency_microseconds histogram" &&
+    containsSubstr text "redis_command_latency_microseconds_bucket{command=\"GET\",le=\"50\"} 1" &&
+    containsSubstr text "redis_command_latency_microseconds_bucket{command=\"GET\",le=\"100\"} 2" &&
+    containsSubstr text "redis_command_latency_microseconds_bucket{command=\"GET\",le=\"+Inf\"} 3" &&
+    containsSubstr text "redis_command_latency_microseconds_sum{command=\"GET\"} 20140" &&
+    containsSubstr text "redis_command_latency_microseconds_count{command=\"GET\"} 3" &&
+    !containsSubstr text "quantile="
+
 def testToJson : IO Bool := do
   let metrics ← Metrics.make
   metrics.recordLatency "GET" 100
@@ -204,6 +220,12 @@ def testExportEmpty : IO Bool := do
 
 def exportTests : TestSeq :=
   test "toPrometheus generates output" (ioTest testToPrometheus) $
+  test "toPrometheus exports latency histograms" (ioTest testPrometheusHistogram) $
+  test "Prometheus labels are escaped" (
+    Prometheus.labels [("command", "a\"b\\c")] == "{command=\"a\\\"b\\\\c\"}") $
+  test "Prometheus gauge" (
+    Prometheus.gauge "redis_pool_waiters" "Waiters" [([("pool", "p")], 2)] ==
+      #["# HELP redis_pool_waiters Waiters", "# TYPE redis_pool_waiters gauge", "redis_pool_waiters{pool=\"p\"} 2"]) $
   test "toJson generates output" (ioTest testToJson) $
   test "Export handles empty metrics" (ioTest testExportEmpty)
 
@@ -243,9 +265,42 @@ def testTotalBytes : IO Bool := do
   let (written, read) ← Metrics.getTotalBytes metrics
   return written == 100 && read == 200
 
+def testCommandBytes : IO Bool := do
+  let metrics ← Metrics.make
+  metrics.recordCommandBytes .SET 40 5
+  metrics.recordCommandBytes .GET 20 1000
+  metrics.recordCommandBytes .GET 20 3000
+  metrics.recordBytesWritten 10
+  let (written, read) ← metrics.getTotalBytes
+  let sizes ← metrics.getCommandSizeHistograms
+  let snap ← metrics.snapshot
+  return written == 90 && read == 4005 &&
+    (sizes["GET"]?.map fun (req, reply) => (req.count, reply.max)) == some (2, 3000) &&
+    snap.bytesRead == 4005 && snap.p99ReplyBytes >= 3000
+
+def testCommandBytesMerge : IO Bool := do
+  let a ← Metrics.make
+  let b ← Metrics.make
+  a.recordCommandBytes .HGETALL 30 500
+  b.recordCommandBytes .HGETALL 30 700
+  let merged ← Metrics.merge #[a, b]
+  let (written, read) ← merged.getTotalBytes
+  let sizes ← merged.getCommandSizeHistograms
+  return written == 60 && read == 1200 && (sizes["HGETALL"]?.map (·.2.count)) == some 2
+
+def testCommandBytesPrometheus : IO Bool := do
+  let metrics ← Metrics.make
+  metrics.recordCommandBytes .GET 20 1000
+  let text ← metrics.toPrometheus
+  return containsSubstr text "redis_command_reply_bytes_bucket{command=\"GET\",le=\"1024\"} 1" &&
+    containsSubstr text "redis_bytes_read_total 1000"
+
 def bytesTests : TestSeq :=
   test "Bytes tracking accumulates" (ioTest testBytesTracking) $
-  test "getTotalBytes returns both" (ioTest testTotalBytes)
+  test "getTotalBytes returns both" (ioTest testTotalBytes) $
+  test "command request/reply sizes" (ioTest testCommandBytes) $
+  test "merge includes command sizes" (ioTest testCommandBytesMerge) $
+  test "sizes exported to Prometheus" (ioTest testCommandBytesPrometheus)
 
 -- Stress Tests
 
@@ -269,6 +324,226 @@ def stressTests : TestSeq :=
   test "High volume of records" (ioTest testHighVolume) $
   test "Many different operations" (ioTest testManyOperations)
 
+-- Histogram Tests
+
+def histOf (values : List Nat) : Histogram :=
+  values.foldl Histogram.record .empty
+
+def withinRelError (v exact : Nat) : Bool :=
+  v >= exact && (v - exact) * Histogram.subBuckets <= exact
+
+def histogramTests : TestSeq :=
+  test "small values are exact" ((List.range 32).all fun v => Histogram.upperBound (Histogram.bucketOf v) == v) $
+  test "buckets contain their values" ([32, 33, 100, 1000, 65535, 1000000, 3600000000].all fun v =>
+    let b := Histogram.bucketOf v
+    Histogram.lowerBound b <= v && v <= Histogram.upperBound b) $
+  test "buckets are contiguous" ((List.range 2000).all fun b =>
+    Histogram.upperBound b + 1 == Histogram.lowerBound (b + 1)) $
+  test "bounded relative error" ([100, 999, 12345, 1000000, 3600000000].all fun v =>
+    withinRelError (Histogram.upperBound (Histogram.bucketOf v)) v) $
+  test "an hour in microseconds fits in few buckets" (Histogram.bucketOf 3600000000 < 1100) $
+  test "exact count, sum, min, max" (
+    let h := histOf [5, 1000, 70]
+    h.count == 3 && h.sum == 1075 && h.min == 5 && h.max == 1000) $
+  test "percentiles within the error" (
+    let h := histOf ((List.range 10000).map (· + 1))
+    withinRelError (h.percentile 50) 5000 && withinRelError (h.percentile 99) 9900) $
+  test "percentile clamped to max" ((histOf [1000]).percentile 99 == 1000) $
+  test "empty histogram" (Histogram.empty.percentile 50 == 0 && Histogram.empty.mean == 0) $
+  test "merge equals recording both" (
+    let a := histOf [1, 50, 3000]
+    let b := histOf [7, 400000]
+    let m := a ++ b
+    let both := histOf [1, 50, 3000, 7, 400000]
+    m.counts == both.counts && m.count == 5 && m.min == 1 && m.max == 400000 && m.sum == both.sum) $
+  test "merge with empty" ((histOf [42] ++ .empty).count == 1 && (Histogram.empty ++ histOf [42]).max == 42) $
+  test "non-empty buckets" ((histOf [3, 3, 100]).buckets == #[(3, 2), (101, 1)]) $
+  test "Prometheus buckets are cumulative" (
+    (histOf [10, 60, 60, 300, 9000000]).cumulative #[50, 100, 1000, 10000] == #[1, 3, 4, 4])
+
+-- Command Shards Tests
+
+def testRecordCommand : IO Bool := do
+  let metrics ← Metrics.make
+  metrics.recordCommand .GET 100
+  metrics.recordCommand .GET 300
+  metrics.recordCommand .HSET 50
+  metrics.recordLatency "GET" 200
+  let counts ← metrics.getCommandCounts
+  let get? ← metrics.getLatencyStats "GET"
+  return counts["GET"]? == some 3 && counts["HSET"]? == some 1 &&
+    (get?.map (·.max)) == some 300 && (get?.map (·.min)) == some 100
+
+def testRecordCommandFromThreads : IO Bool := do
+  let metrics ← Metrics.make
+  let tasks ← (List.range 8).mapM fun _ => IO.asTask (prio := .dedicated) do
+    for i in [:500] do
+      metrics.recordCommand .SET (i + 1)
+  for t in tasks do
+    let _ ← IO.wait t
+  return (← metrics.getCommandCounts)["SET"]? == some 4000
+
+def testCommandShardsMerge : IO Bool := do
+  let a ← Metrics.make
+  let b ← Metrics.make
+  a.recordCommand .INCR 10
+  b.recordCommand .INCR 20
+  let merged ← Metrics.merge #[a, b]
+  let snap ← merged.snapshot
+  return snap.totalCommands == 2 && (← merged.getCommandCounts)["INCR"]? == some 2
+
+def testCommandShardsClear : IO Bool := do
+  let metrics ← Metrics.make
+  metrics.recordCommand .DEL 10
+  metrics.clear
+  return (← metrics.getCommandCounts).isEmpty
+
+def commandShardTests : TestSeq :=
+  test "command index is dense and matches RedisCmd.all" (
+    RedisCmd.count == 196 &&
+    (Array.range RedisCmd.count).all fun i => (RedisCmd.all[i]?.map (·.index)) == some i) $
+  test "recordCommand counts and times by command" (ioTest testRecordCommand) $
+  test "recordCommand from many threads" (ioTest testRecordCommandFromThreads) $
+  test "merge includes command shards" (ioTest testCommandShardsMerge) $
+  test "clear resets command shards" (ioTest testCommandShardsClear)
+
+-- Latency Phase Tests
+
+def testRecordPhases : IO Bool := do
+  let metrics ← Metrics.make
+  metrics.recordPhases #[500, 120000, 3000, 800]
+  metrics.recordPhases #[700, 80000, 1000, 1200]
+  let phases ← metrics.getPhaseHistograms
+  return (phases.map (·.1)) == LatencyPhase.all &&
+    (phases.map (·.2.count)) == #[2, 2, 2, 2] &&
+    (phases.find? (·.1 == .network) |>.map (·.2.max)) == some 120000
+
+def testPhasesMergeAndExport : IO Bool := do
+  let a ← Metrics.make
+  let b ← Metrics.make
+  a.recordPhases #[500, 120000, 3000, 800]
+  b.recordPhases #[700, 80000, 1000, 1200]
+  let merged ← Metrics.merge #[a, b]
+  let text ← merged.toPrometheus
+  return ((← merged.getPhaseHistograms).all (·.2.count == 2)) &&
+    containsSubstr text "redis_command_phase_nanoseconds_bucket{phase=\"marshal\",le=\"1000\"} 2" &&
+    containsSubstr text "redis_command_phase_nanoseconds_count{phase=\"network\"} 2"
+
+def testPhasesNotExportedUnused : IO Bool := do
+  let metrics ← Metrics.make
+  metrics.recordCommand .GET 100
+  return !containsSubstr (← metrics.toPrometheus) "redis_command_phase_nanoseconds_count"
+
+def latencyPhaseTests : TestSeq :=
+  -- start 1000, first write 1400, reply parsed at 9000 after 6000 in socket
+  -- calls and 500 in object callbacks, back in Lean at 9300
+  test "split covers the whole command" (
+    LatencyPhase.split 1000 9300 (1400, 9000, 6000, 500) == some #[400, 6000, 1100, 800]) $
+  test "split without a write" (LatencyPhase.split 1000 2000 (0, 0, 0, 0) == none) $
+  test "split without a parsed reply" (
+    LatencyPhase.split 1000 9300 (1400, 0, 6000, 0) == some #[400, 6000, 1900, 0]) $
+  test "phase indices follow LatencyPhase.all" (
+    (Array.range LatencyPhase.all.size).all fun i => (LatencyPhase.all[i]?.map (·.index)) == some i) $
+  test "recordPhases by phase" (ioTest testRecordPhases) $
+  test "phases merged and exported" (ioTest testPhasesMergeAndExport) $
+  test "no phase series when not timed" (ioTest testPhasesNotExportedUnused)
+
+-- Server Stats Tests
+
+def serverSample (getCalls getUsec : Nat) : ServerSample :=
+  { commands := #[{ command := "GET", calls := getCalls, usec := getUsec }],
+    events := #[("command", #[{ timestamp := 1700000000, latencyMs := 12 }])],
+    slowlog := #[{ id := 1, timestamp := 1700000000, durationUs := 25000, args := #["GET", "k"] }] }
+
+def testServerGaps : IO Bool := do
+  let metrics ← Metrics.make
+  metrics.recordServerSample (serverSample 100 400)
+  metrics.recordServerSample (serverSample 300 1200)
+  metrics.recordCommand .GET 90
+  metrics.recordCommand .GET 110
+  metrics.recordCommand .SET 50
+  let gaps ← metrics.serverGaps
+  -- client 100μs on average, server 800μs / 200 calls since the first collection
+  return gaps == #[("GET", 100.0, 4.0)]
+
+def testServerStatsExport : IO Bool := do
+  let metrics ← Metrics.make
+  let before ← metrics.toPrometheus
+  metrics.recordServerSample (serverSample 100 400)
+  metrics.recordCommand .GET 100
+  let text ← metrics.toPrometheus
+  return !containsSubstr before "redis_server_" &&
+    containsSubstr text "redis_server_command_calls_total{command=\"GET\"} 100" &&
+    containsSubstr text "redis_command_server_gap_microseconds{command=\"GET\"}" &&
+    containsSubstr text "redis_server_latency_event_milliseconds{event=\"command\"} 12" &&
+    containsSubstr text "redis_server_slowlog_entries_total 1"
+
+def testServerStatsMergeAndClear : IO Bool := do
+  let a ← Metrics.make
+  let b ← Metrics.make
+  b.recordServerSample (serverSample 100 400)
+  let merged ← Metrics.merge #[a, b]
+  let kept := (← merged.getServerStats).collections == 1
+  merged.clear
+  return kept && (← merged.getServerStats).collections == 0
+
+def serverStatsTests : TestSeq :=
+  test "client and server latency per command" (ioTest testServerGaps) $
+  test "server stats exported once collected" (ioTest testServerStatsExport) $
+  test "merge keeps the latest collection, clear drops it" (ioTest testServerStatsMergeAndClear)
+
+-- Trace Tests
+
+def traceOf (cmd : String) (startNs : Nat) (traceId : UInt64 := 0) : Trace :=
+  { traceId, command := cmd, startTimeNs := startNs, endTimeNs := startNs + 1000,
+    tags := [], success := true, errorMsg := none }
+
+def ringOf (capacity n : Nat) : TraceRing :=
+  (List.range n).foldl (fun r i => r.push (traceOf s!"C{i}" i)) (TraceRing.create capacity)
+
+def testTraceSampling : IO Bool := do
+  let metrics ← Metrics.make
+  metrics.setTraceSampling .errorsOnly
+  metrics.recordTrace "GET" 0 1000 true
+  metrics.recordTrace "SET" 0 1000 false (some "boom")
+  let kept ← metrics.getRecentTraces
+  metrics.setTraceSampling (.slowOnly 500)
+  metrics.recordTrace "FAST" 0 100000 true
+  metrics.recordTrace "SLOW" 0 900000 true
+  let all ← metrics.getRecentTraces
+  return kept.map (·.command) == #["SET"] && all.map (·.command) == #["SET", "SLOW"]
+
+def testTraceIds : IO Bool := do
+  let metrics ← Metrics.make
+  metrics.recordTrace "A" 0 1 true
+  metrics.recordTrace "B" 0 1 true
+  let ts ← metrics.getRecentTraces
+  return ts.size == 2 && (ts[0]?.map (·.traceId + 1)) == (ts[1]?.map (·.traceId)) &&
+    ts.all (·.idString.length == 16)
+
+def testSetMaxTraces : IO Bool := do
+  let metrics ← Metrics.make
+  for i in [:10] do
+    metrics.recordTrace s!"C{i}" i (i + 1) true
+  metrics.setMaxTraces 3
+  let ts ← metrics.getRecentTraces
+  return ts.map (·.command) == #["C7", "C8", "C9"]
+
+def traceTests : TestSeq :=
+  test "ring keeps the most recent, oldest first" ((ringOf 4 10).recent 10 |>.map (·.command) == #["C6", "C7", "C8", "C9"]) $
+  test "ring not yet full" ((ringOf 4 2).recent 10 |>.map (·.command) == #["C0", "C1"]) $
+  test "ring recent n" ((ringOf 4 10).recent 2 |>.map (·.command) == #["C8", "C9"]) $
+  test "ring of capacity 0 keeps nothing" ((ringOf 0 5).size == 0) $
+  test "trace id rendered as hex" ((traceOf "X" 0 255).idString == "00000000000000ff") $
+  test "rate 0 samples nothing, rate 1 everything" (
+    (List.range 100).all fun i => !(TraceSampling.ratio 0).sampled i.toUInt64 && (TraceSampling.ratio 1).sampled i.toUInt64) $
+  test "rate samples about that fraction" (
+    let n := ((List.range 10000).filter fun i => (TraceSampling.ratio 0.1).sampled i.toUInt64).length
+    800 < n && n < 1200) $
+  test "errors kept, fast commands dropped" (ioTest testTraceSampling) $
+  test "trace ids are sequential" (ioTest testTraceIds) $
+  test "setMaxTraces keeps the most recent" (ioTest testSetMaxTraces)
+
 -- All Metrics Tests
 def allMetricsTests : TestSeq :=
   group "Metrics Creation" metricsCreationTests $
@@ -279,6 +554,11 @@ def allMetricsTests : TestSeq :=
   group "Export Formats" exportTests $
   group "Snapshot" snapshotTests $
   group "Bytes Tracking" bytesTests $
-  group "Stress Tests" stressTests
+  group "Stress Tests" stressTests $
+  group "Histograms" histogramTests $
+  group "Command Shards" commandShardTests $
+  group "Latency Phases" latencyPhaseTests $
+  group "Server Stats" serverStatsTests $
+  group "Traces" traceTests
 
 end RedisTests.MetricsTests
@@ -0,0 +1,80 @@
+import LSpec
+import RedisLean.NearCache
+import RedisTests.Fixtures
+
+open Redis LSpec
+open Redis.NearCache
+open Redis.Fixtures (k)
+
+namespace RedisTests.NearCacheTests
+
+/-!
+# Near Cache Tests
+
+Tests for the near cache bookkeeping (reservations, invalidation, eviction)
+and the CLIENT TRACKING arguments. The invalidation reader needs a server.
+-/
+
+/-- Reserve and fill in one step -/
+def put (e : Entries) (key : String) (field : Option String) (v : String) (n : Nat) (max : Nat := 100) : Entries :=
+  let f := field.map String.toUTF8
+  (e.reserve (k key) f n).fill (k key) f n (k v) n max
+
+def get? (e : Entries) (key : String) (field : Option String := none) : Option String :=
+  (e.lookup (k key) (field.map String.toUTF8)).bind String.fromUTF8?
+
+-- Reservation Tests
+def reservationTests : TestSeq :=
+  let e : Entries := {}
+  test "miss on empty cache" (get? e "a" == none) $
+  test "fill after reserve is cached" (get? (put e "a" none "1" 1) "a" == some "1") $
+  test "fill without reservation is ignored" (
+    get? (e.fill (k "a") none 1 (k "1") 1 100) "a" == none) $
+  test "invalidation cancels an in-flight read" (
+    let e := (e.reserve (k "a") none 1).invalidate (k "a")
+    get? (e.fill (k "a") none 1 (k "stale") 2 100) "a" == none) $
+  test "stale token is ignored" (
+    let e := (e.reserve (k "a") none 1).reserve (k "a") none 2
+    get? (e.fill (k "a") none 1 (k "old") 3 100) "a" == none) $
+  test "cancel drops the reservation" (
+    ((e.reserve (k "a") none 1).cancel (k "a") none 1).slots.isEmpty)
+
+-- Invalidation Tests
+def invalidationTests : TestSeq :=
+  let e := put (put (put {} "h" (some "f1") "x" 1) "h" (some "f2") "y" 2) "s" none "z" 3
+  test "hash fields cached separately" (get? e "h" (some "f1") == some "x" && get? e "h" (some "f2") == some "y") $
+  test "size counts values" (e.size == 3) $
+  test "invalidate drops every field of a key" (
+    let e := e.invalidate (k "h")
+    get? e "h" (some "f1") == none && get? e "h" (some "f2") == none && e.size == 1) $
+  test "invalidate leaves other keys" (get? (e.invalidate (k "h")) "s" == some "z") $
+  test "invalidate unknown key is a no-op" ((e.invalidate (k "nope")).size == 3)
+
+-- Eviction Tests
+def evictionTests : TestSeq :=
+  let e := put (put (put {} "a" none "1" 1 2) "b" none "2" 2 2) "c" none "3" 3 2
+  test "size limit enforced" (e.size == 2) $
+  test "oldest entry evicted" (get? e "a" == none && get? e "c" == some "3") $
+  test "invalidated entries are skipped by eviction" (
+    let e := (put (put {} "a" none "1" 1 2) "b" none "2" 2 2).invalidate (k "a")
+    let e := put (put e "c" none "3" 3 2) "d" none "4" 4 2
+    e.size == 2 && get? e "c" == some "3" && get? e "d" == some "4")
+
+-- Tracking Tests
+def trackingTests : TestSeq :=
+  let render (args : Array ByteArray) := args.toList.map fun b => String.fromUTF8! b
+  test "default mode redirects" (render (trackingArgs .default 7) == ["CLIENT", "TRACKING", "ON", "REDIRECT", "7"]) $
+  test "bcast mode lists prefixes" (
+    render (trackingArgs (.bcast ["decl:", "inst:"]) 7) ==
+      ["CLIENT", "TRACKING", "ON", "REDIRECT", "7", "BCAST", "PREFIX", "decl:", "PREFIX", "inst:"]) $
+  test "prefix match" (bytesHasPrefix (k "decl:Nat.add") (k "decl:")) $
+  test "prefix mismatch" (!bytesHasPrefix (k "de") (k "decl:"))
+
+-- All Near Cache Tests
+def allNearCacheTests : TestSeq :=
+  group "Reservations" reservationTests $
+  group "Invalidation" invalidationTests $
+  group "Eviction" evictionTests $
+  group "Tracking" trackingTests
+
+end RedisTests.NearCacheTests
@@ -11,7 +11,8 @@ namespace RedisTests.PoolTests
 
 Tests for connection pool configuration and behavior.
 Note: Actual connection pooling requires a Redis server,
-so we focus on configuration and state management tests.
+so we focus on configuration and state management tests
+(the idle stack and the FIFO waiter queue are pure).
 -/
 
 -- PoolConfig Tests
@@ -140,6 +141,84 @@ def validationConceptTests : TestSeq :=
     let config : PoolConfig := { acquireTimeoutMs := 5000, idleTimeoutMs := 60000 }
     config.acquireTimeoutMs < config.idleTimeoutMs)
 
+-- Slots Tests (idle stack and waiter queue, with waiters named by strings)
+
+abbrev TestSlots := Pool.Slots String
+
+def conn (ctx : FFI.Ctx) (at_ : Nat) : PooledConnection := { ctx, createdAt := at_, lastUsedAt := at_ }
+
+def twoIdle : TestSlots := (({} : TestSlots).add 1 0).add 2 10
+
+def threeWaiters : TestSlots :=
+  (((({} : TestSlots).enqueue 100 "a").2.enqueue 200 "b").2.enqueue 300 "c").2
+
+def slotsTests : TestSeq :=
+  test "most recently released is reused first" ((twoIdle.take?.1.map (·.ctx)) == some 2) $
+  test "take from an empty stack" (({} : TestSlots).take?.1.isNone) $
+  test "reserve below max" ((({} : TestSlots).reserve? 1).map (·.size) == some 1) $
+  test "no reservation at max" ((twoIdle.reserve? 2).isNone) $
+  test "reservations count against max" (((({} : TestSlots).reserve? 1) >>= (·.reserve? 1)).isNone) $
+  test "opened moves the reservation" (((({} : TestSlots).reserve? 1).map (·.opened 7 0 |>.2)).map (fun s => (s.opening, s.conns.size)) == some (0, 1)) $
+  test "tickets increase" ((threeWaiters.enqueue 400 "d").1 == 3) $
+  test "waiters served in order" (
+    let (w1, s) := threeWaiters.dequeue?
+    let (w2, s) := s.dequeue?
+    let (w3, s) := s.dequeue?
+    (w1, w2, w3, s.dequeue?.1) == (some "a", some "b", some "c", none)) $
+  test "release goes to the oldest waiter" (
+    let (w, s) := threeWaiters.put (conn 1 0)
+    w == some "a" && s.idle.isEmpty) $
+  test "release without waiters goes idle" (
+    let (w, s) := ({} : TestSlots).put (conn 1 0)
+    w.isNone && s.idle.size == 1) $
+  test "expired waiters are skipped" (
+    let (expired, next, s) := threeWaiters.expire 200
+    expired.size == 2 && next == some 300 && s.dequeue?.1 == some "c") $
+  test "nothing expires early" ((threeWaiters.expire 50).2.1 == some 100) $
+  test "failed connect wakes the oldest waiter" (
+    let s := { threeWaiters with opening := 1 }
+    let (w, s) := s.openFailed
+    w == some "a" && s.opening == 0) $
+  test "prune oldest idle, keep min" (
+    let (stale, s) := twoIdle.prune 100000 1000 1
+    stale.map (·.ctx) == #[1] && s.conns.size == 1) $
+  test "prune keeps fresh connections" ((twoIdle.prune 500 1000 0).1.isEmpty) $
+  test "close takes idle and waiters" (
+    let (idle, waiters, s) := ({ threeWaiters with idle := twoIdle.idle, conns := twoIdle.conns }).close
+    idle.size == 2 && waiters.size == 3 && s.closed && s.conns.isEmpty && s.dequeue?.1.isNone)
+
+-- Maintenance Tests
+
+def maintenanceTests : TestSeq :=
+  test "maintainer on by default" (({} : PoolConfig).maintenanceIntervalMs > 0) $
+  test "parallel warm-up by default" (({} : PoolConfig).warmupConcurrency > 1) $
+  test "PING replies awaited for less than a period" (
+    let c : PoolConfig := {}
+    c.pingTimeoutMs > 0 && c.pingTimeoutMs < c.maintenanceIntervalMs) $
+  test "checkout takes connections idle long enough" (
+    let (due, s) := twoIdle.checkout 1000 995
+    due.map (·.ctx) == #[1] && s.idle.map (·.ctx) == #[2] && s.conns.size == 2) $
+  test "restored connection keeps its last use" (
+    let (due, s) := twoIdle.checkout 1000 995
+    let ((w, kept), s) := s.restore due[0]!
+    w.isNone && kept && s.idle.any (·.lastUsedAt == 0)) $
+  test "restore after close" (
+    let ((_, kept), s) := ({ ({} : TestSlots).add 1 0 with closed := true }).restore (conn 1 0)
+    !kept && s.conns.isEmpty) $
+  test "discarded connection lets a waiter in" (
+    let (w, s) := ({ threeWaiters with conns := twoIdle.conns }).discard 1
+    w == some "a" && s.conns.size == 1) $
+  test "deficit up to min connections" ((({} : TestSlots).add 1 0).deficit 4 0 10 == 3) $
+  test "deficit up to min idle" ((twoIdle.deficit 0 5 10) == 3) $
+  test "deficit bounded by max" ((twoIdle.deficit 8 8 4) == 2) $
+  test "reserve several" (
+    let (k, s) := twoIdle.reserveUpTo 5 4
+    k == 2 && s.size == 4) $
+  test "ready goes to a waiter" (((({ threeWaiters with opening := 1 }).ready 9 0).1.map (·.1)) == some "a") $
+  test "connections get increasing shards" (twoIdle.idle.map (·.shard) == #[0, 1]) $
+  test "metrics shards bounded" (PoolMetrics.shardCount 0 == 1 && PoolMetrics.shardCount 10 == 10 &&
+    PoolMetrics.shardCount 1000 == 64)
+
 -- All Pool Tests
 def allPoolTests : TestSeq :=
   group "PoolConfig Defaults" poolConfigDefaultTests $
@@ -148,6 +227,8 @@ def allPoolTests : TestSeq :=
   group "PoolConfig Modification" poolConfigModificationTests $
   group "Pool Scenarios" scenarioTests $
   group "Combined Configurations" combinedConfigTests $
-  group "Validation Concepts" validationConceptTests
+  group "Validation Concepts" validationConceptTests $
+  group "Idle Stack and Waiters" slotsTests $
+  group "Maintenance" maintenanceTests
 
 end RedisTests.PoolTests
@@ -0,0 +1,73 @@
+import LSpec
+import RedisLean.PubSub
+
+open Redis LSpec
+open Redis.Subscriber
+
+namespace RedisTests.PubSubTests
+
+/-!
+# Pub/Sub Tests
+
+Tests for message decoding and the bounded subscriber buffer with its
+overflow policies. The subscriber thread needs a server.
+-/
+
+def b (s : String) : Reply := .bulk s.toUTF8
+
+def channelOf (r : Reply) : Option String :=
+  (PubSubMessage.ofReply? r).bind fun m => String.fromUTF8? m.channel
+
+def payloadOf (r : Reply) : Option String :=
+  (PubSubMessage.ofReply? r).bind fun m => String.fromUTF8? m.payload
+
+def msg (s : String) : PubSubMessage := .message "ch".toUTF8 s.toUTF8
+
+def fill (policy : OverflowPolicy) (cap : Nat) (xs : List String) : Buffer :=
+  xs.foldl (fun acc x => acc.push (msg x) cap policy) {}
+
+def drain (buf : Buffer) : List String :=
+  (buf.popMany buf.size).1.toList.filterMap fun m => String.fromUTF8? m.payload
+
+-- Decoding Tests
+def decodingTests : TestSeq :=
+  test "message" (channelOf (.array #[b "message", b "news", b "hi"]) == some "news") $
+  test "message payload" (payloadOf (.array #[b "message", b "news", b "hi"]) == some "hi") $
+  test "RESP3 push" (payloadOf (.push #[b "message", b "news", b "hi"]) == some "hi") $
+  test "pmessage" (
+    match PubSubMessage.ofReply? (.array #[b "pmessage", b "n*", b "news", b "hi"]) with
+    | some (.pmessage p c _) => p == "n*".toUTF8 && c == "news".toUTF8
+    | _ => false) $
+  test "smessage" ((PubSubMessage.ofReply? (.array #[b "smessage", b "s", b "x"])) matches some (.smessage _ _)) $
+  test "confirmation ignored" ((PubSubMessage.ofReply? (.array #[b "subscribe", b "news", .int 1])).isNone) $
+  test "malformed ignored" ((PubSubMessage.ofReply? (.array #[b "message", b "news"])).isNone) $
+  test "non-array ignored" ((PubSubMessage.ofReply? (.simple "OK")).isNone)
+
+-- Buffer Tests
+def bufferTests : TestSeq :=
+  test "fifo order" (drain (fill .dropOldest 10 ["a", "b", "c"]) == ["a", "b", "c"]) $
+  test "pop returns oldest" (
+    match (fill .dropOldest 10 ["a", "b"]).pop? with
+    | (some m, rest) => m.payload == "a".toUTF8 && rest.size == 1
+    | _ => false) $
+  test "pop on empty" ((({} : Buffer).pop?).1.isNone) $
+  test "popMany respects max" (((fill .dropOldest 10 ["a", "b", "c"]).popMany 2).1.size == 2) $
+  test "closed buffer ignores pushes" ((({ closed := true } : Buffer).push (msg "a") 10 .dropOldest).size == 0)
+
+-- Overflow Tests
+def overflowTests : TestSeq :=
+  test "dropNewest keeps the first messages" (drain (fill .dropNewest 2 ["a", "b", "c"]) == ["a", "b"]) $
+  test "dropNewest counts drops" ((fill .dropNewest 2 ["a", "b", "c", "d"]).dropped == 2) $
+  test "dropOldest keeps the latest messages" (drain (fill .dropOldest 2 ["a", "b", "c"]) == ["b", "c"]) $
+  test "dropOldest counts drops" ((fill .dropOldest 2 ["a", "b", "c", "d"]).dropped == 2) $
+  test "size bounded by capacity" ((fill .dropOldest 3 ((List.range 500).map toString)).size == 3) $
+  test "dropOldest survives compaction" (
+    drain (fill .dropOldest 3 ((List.range 500).map toString)) == ["497", "498", "499"])
+
+-- All Pub/Sub Tests
+def allPubSubTests : TestSeq :=
+  group "Decoding" decodingTests $
+  group "Buffer" bufferTests $
+  group "Overflow" overflowTests
+
+end RedisTests.PubSubTests
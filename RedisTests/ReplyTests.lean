@@ -0,0 +1,61 @@
+import LSpec
+import RedisLean.Reply
+
+open Redis LSpec
+
+namespace RedisTests.ReplyTests
+
+/-!
+# Reply Tests
+
+Tests for the typed `Reply` decoder helpers (the C side builds the values).
+-/
+
+def bulk (s : String) : Reply := .bulk s.toUTF8
+
+-- Accessor Tests
+def accessorTests : TestSeq :=
+  test "bulk str?" ((bulk "hello").str? == some "hello") $
+  test "simple str?" ((Reply.simple "OK").str? == some "OK") $
+  test "int has no str?" ((Reply.int 42).str? == none) $
+  test "int?" ((Reply.int 42).int? == some 42) $
+  test "bool int?" ((Reply.bool true).int? == some 1) $
+  test "nil isNil" (Reply.nil.isNil) $
+  test "error isError" ((Reply.error "ERR x").isError) $
+  test "typeName map" ((Reply.map #[]).typeName == "map")
+
+-- Aggregate Tests
+def aggregateTests : TestSeq :=
+  test "array elems?" (((Reply.array #[bulk "a", bulk "b"]).elems?.map (·.size)) == some 2) $
+  test "map elems? flattens" (
+    match (Reply.map #[(bulk "k", bulk "v")]).elems? with
+    | some es => es.size == 2 && es[0]!.str? == some "k" && es[1]!.str? == some "v"
+    | none => false) $
+  test "flat array entries?" (
+    match (Reply.array #[bulk "f1", bulk "v1", bulk "f2", bulk "v2"]).entries? with
+    | some kvs => kvs.size == 2 && kvs[1]!.1.str? == some "f2" && kvs[1]!.2.str? == some "v2"
+    | none => false) $
+  test "odd array has no entries?" ((Reply.array #[bulk "f1"]).entries?.isNone) $
+  test "scalar has no elems?" ((bulk "x").elems?.isNone) $
+  test "bytesArray? rejects mixed" ((Reply.array #[bulk "a", .int 1]).bytesArray?.isNone) $
+  test "optBytesArray? keeps nils" (
+    match (Reply.array #[bulk "a", .nil]).optBytesArray? with
+    | some #[some _, none] => true
+    | _ => false) $
+  test "bytesPairs? from map" (((Reply.map #[(bulk "f", bulk "v")]).bytesPairs?.map (·.size)) == some 1)
+
+-- Decode and Render Tests
+def decodeTests : TestSeq :=
+  test "decode Nat" (match (bulk "17").decode (α := Nat) with | .ok n => n == 17 | .error _ => false) $
+  test "decode error reply fails" (match (Reply.error "ERR").decode (α := String) with | .ok _ => false | .error e => e == "ERR") $
+  test "decode int reply fails" (match (Reply.int 1).decode (α := String) with | .ok _ => false | .error _ => true) $
+  test "render nested" (toString (Reply.array #[bulk "a", .int 1, .nil]) == "[\"a\", (integer) 1, (nil)]") $
+  test "render map" (toString (Reply.map #[(bulk "k", .double 1.5)]) == "{\"k\": (double) 1.500000}")
+
+-- All Reply Tests
+def allReplyTests : TestSeq :=
+  group "Accessors" accessorTests $
+  group "Aggregates" aggregateTests $
+  group "Decode and Render" decodeTests
+
+end RedisTests.ReplyTests
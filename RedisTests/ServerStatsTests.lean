@@ -0,0 +1,95 @@
+import LSpec
+import RedisLean.ServerStats
+
+open Redis LSpec
+
+namespace RedisTests.ServerStatsTests
+
+/-!
+# Server Stats Tests
+
+Tests for the parsers of INFO commandstats/latencystats, LATENCY and SLOWLOG
+replies, and for accumulating collections. Running them against a server is
+left to `StatsCollector`.
+-/
+
+def commandstats : String :=
+  "# Commandstats\r\n" ++
+  "cmdstat_get:calls=200,usec=1500,usec_per_call=7.50,rejected_calls=0,failed_calls=1\r\n" ++
+  "cmdstat_config|get:calls=3,usec=90,usec_per_call=30.00,rejected_calls=2,failed_calls=0\r\n" ++
+  "cmdstat_broken:calls=x\r\n"
+
+def latencystats : String :=
+  "# Latencystats\r\n" ++
+  "latency_percentiles_usec_get:p50=1.003,p99=12.031,p99.9=20.479\r\n"
+
+def bulk (s : String) : Reply := .bulk s.toUTF8
+
+def slowlogEntry (id durationUs : Int64) (args : Array String) : Reply :=
+  .array #[.int id, .int 1700000000, .int durationUs, .array (args.map bulk),
+    bulk "127.0.0.1:5555", bulk "worker"]
+
+def slowlogReply : Reply :=
+  .array #[slowlogEntry 8 25000 #["HGETALL", "big"], slowlogEntry 7 12000 #["get", "k"]]
+
+def sampleOf (cmds : Array CommandStat) (slowlog : Array SlowlogEntry := #[]) : ServerSample :=
+  { commands := cmds, slowlog }
+
+def stat (cmd : String) (calls usec : Nat) : CommandStat :=
+  { command := cmd, calls, usec }
+
+def entry (id : Nat) : SlowlogEntry :=
+  { id, timestamp := 0, durationUs := 0, args := #[] }
+
+-- Parser Tests
+def parserTests : TestSeq :=
+  let stats := ServerStats.parseCommandStats commandstats
+  test "commandstats lines parsed" (stats.size == 2) $
+  test "commandstats counters" (
+    stats[0]? == some ({ command := "GET", calls := 200, usec := 1500, failedCalls := 1 } : CommandStat)) $
+  test "subcommands named like RedisCmd" ((stats[1]?.map (·.command)) == some "CONFIG GET") $
+  test "time per call" ((stats[0]?.map (·.usecPerCall)) == some 7.5) $
+  test "latencystats percentiles" (
+    match ServerStats.parseLatencyStats latencystats with
+    | #[l] => l.command == "GET" && (l.percentiles.map (·.1)) == #["p50", "p99", "p99.9"] &&
+        ((l.percentiles.map (·.2)).zip #[1.003, 12.031, 20.479]).all fun (a, b) => (a - b).abs < 1e-9
+    | _ => false) $
+  test "decimals" (ServerStats.parseDecimal "7.50" == some 7.5 && ServerStats.parseDecimal "3" == some 3.0 &&
+    ServerStats.parseDecimal "x" == none) $
+  test "slowlog entries" (
+    (ServerStats.parseSlowlog slowlogReply).map (fun e => (e.id, e.durationUs, e.command, e.clientName)) ==
+      #[(8, 25000, "HGETALL", "worker"), (7, 12000, "GET", "worker")]) $
+  test "latency latest event names" (
+    ServerStats.parseLatencyLatest (.array #[.array #[bulk "command", .int 1700000000, .int 12, .int 40]]) ==
+      #["command"]) $
+  test "latency history samples" (
+    ServerStats.parseLatencyHistory (.array #[.array #[.int 1700000000, .int 12], .array #[.int 1700000010, .int 40]]) ==
+      #[({ timestamp := 1700000000, latencyMs := 12 } : LatencySample), { timestamp := 1700000010, latencyMs := 40 }]) $
+  test "error replies parse as nothing" (
+    (ServerStats.parseSlowlog (.error "ERR")).isEmpty && (ServerStats.parseLatencyLatest (.error "ERR")).isEmpty)
+
+-- Accumulation Tests
+def ingestTests : TestSeq :=
+  let first := ({} : ServerStats).ingest (sampleOf #[stat "GET" 100 500] #[entry 2, entry 1]) 1
+  let second := first.ingest (sampleOf #[stat "GET" 300 1700, stat "SET" 10 40] #[entry 4, entry 3, entry 2]) 2
+  test "window starts at the first collection" ((second.window "GET").map (·.calls) == some 200) $
+  test "window time per call" ((second.window "GET").map (·.usecPerCall) == some 6.0) $
+  test "command first seen later is all in the window" ((second.window "SET").map (·.calls) == some 10) $
+  test "slowlog entries not repeated" ((second.slowlog.map (·.id)) == #[1, 2, 3, 4] && second.slowlogSeen == 4) $
+  test "slowlog restart starts over" (
+    let restarted := second.ingest (sampleOf #[] #[entry 1]) 3
+    (restarted.slowlog.map (·.id)) == #[1, 2, 3, 4, 1]) $
+  test "server restart resets the window" (
+    ((stat "GET" 5 20).since (stat "GET" 300 1700)).calls == 5) $
+  test "window counts from a reset once counters grow again" (
+    let reset := second.ingest (sampleOf #[stat "GET" 5 20] #[]) 3
+    let later := reset.ingest (sampleOf #[stat "GET" 50 200] #[]) 4
+    (reset.window "GET").map (·.calls) == some 5 && (later.window "GET").map (·.calls) == some 50) $
+  test "collections counted" (second.collections == 2 && second.collectedAt == 2)
+
+-- All Server Stats Tests
+def allServerStatsTests : TestSeq :=
+  group "Parsers" parserTests $
+  group "Accumulation" ingestTests
+
+end RedisTests.ServerStatsTests
@@ -2,9 +2,15 @@ import LSpec
 import RedisTests.Codec
 import RedisTests.Config
 import RedisTests.Error
+import RedisTests.ReplyTests
+import RedisTests.NearCacheTests
+import RedisTests.AutoPipelineTests
+import RedisTests.PubSubTests
+import RedisTests.ClusterTests
 import RedisTests.MockTests
 import RedisTests.TypedKeyTests
 import RedisTests.MetricsTests
+import RedisTests.ServerStatsTests
 import RedisTests.PoolTests
 import RedisTests.MathlibTests
 import RedisTests.Integration
@@ -20,10 +26,16 @@ Comprehensive test suite for redis-lean covering:
 - Codec: Serialization/deserialization of types
 - Config: Redis connection configuration
 - Error: Error types and handling
+- Reply: Typed reply decoding helpers
+- NearCache: Client-side cache bookkeeping and tracking arguments
+- AutoPipeline: Reply decoding for commands sent over the multiplexed connection
+- PubSub: Message decoding and subscriber buffer overflow policies
+- Cluster: Hash slots, redirections, slot map decoding and replica choice
 - Mock: In-memory MockRedis implementation
 - TypedKey: Phantom-typed keys and namespaces
 - Metrics: Observability and metrics collection
-- Pool: Connection pool configuration
+- ServerStats: Parsing of the server's INFO, LATENCY and SLOWLOG figures
+- Pool: Connection pool configuration, idle stack, waiter queue and maintenance
 - Mathlib: Mathlib integration data structures
 - Integration: Redis server integration tests
 -/
@@ -34,9 +46,15 @@ def allUnitTests : TestSeq :=
     RedisTests.Codec.allCodecTests ++
     RedisTests.Config.allConfigTests ++
     RedisTests.Error.allErrorTests ++
+    RedisTests.ReplyTests.allReplyTests ++
+    RedisTests.NearCacheTests.allNearCacheTests ++
+    RedisTests.AutoPipelineTests.allAutoPipelineTests ++
+    RedisTests.PubSubTests.allPubSubTests ++
+    RedisTests.ClusterTests.allClusterTests ++
     RedisTests.MockTests.allMockTests ++
     RedisTests.TypedKeyTests.allTypedKeyTests ++
     RedisTests.MetricsTests.allMetricsTests ++
+    RedisTests.ServerStatsTests.allServerStatsTests ++
     RedisTests.PoolTests.allPoolTests ++
     RedisTests.MathlibTests.allMathlibTests
 
@@ -70,20 +88,23 @@ def main (args : List String) : IO UInt32 := do
     Log.info "  - Error tests (construction, pattern matching)"
     Log.info "  - MockRedis tests (all data structures)"
     Log.info "  - TypedKey tests (phantom types, namespaces)"
-    Log.info "  - Metrics tests (percentiles, counts, export)"
-    Log.info "  - Pool tests (configuration, scenarios)"
+    Log.info "  - Metrics tests (percentiles, counts, export, histograms, phases, server stats, traces)"
+    Log.info "  - Pool tests (configuration, scenarios, waiter queue, maintenance)"
     Log.info "  - Mathlib tests (data structures, key generation)"
     Log.finiZlog
     return 0
   | ["integration"] => do
     Log.info "Running integration tests (Redis server required)..."
-    Log.info "Integration tests are placeholders - require actual Redis server"
+    Log.info "Placeholder tests pass at compile time; live checks follow"
+    Log.info "(start Redis first: docker run -p 6379:6379 redis:alpine)"
     Log.info ""
-    Log.info "To run with a Redis server:"
-    Log.info "  1. Start Redis: docker run -p 6379:6379 redis:alpine"
-    Log.info "  2. Run: lake exe testRunner integration"
+    let mut failed := 0
+    for (name, check) in RedisTests.Integration.livePipelineTests do
+      let ok ← check
+      Log.info s!"  {if ok then "PASS" else "FAIL"} {name}"
+      if !ok then failed := failed + 1
     Log.finiZlog
-    return 0
+    return if failed == 0 then 0 else 1
   | ["mock"] => do
     Log.info "Running MockRedis tests..."
     Log.info "MockRedis tests passed at compile time via #lspec"
@@ -113,10 +134,10 @@ def main (args : List String) : IO UInt32 := do
     Log.info "  - Error: 10 test groups"
     Log.info "  - MockRedis: 6 test groups"
     Log.info "  - TypedKey: 9 test groups"
-    Log.info "  - Metrics: 8 test groups"
-    Log.info "  - Pool: 7 test groups"
+    Log.info "  - Metrics: 14 test groups"
+    Log.info "  - Pool: 9 test groups"
     Log.info "  - Mathlib: 13 test groups"
-    Log.info "  - Integration: 9 test groups (placeholders)"
+    Log.info "  - Integration: 10 test groups (placeholders)"
     Log.finiZlog
     return 0
   | _ => do
@@ -35,7 +35,7 @@ lean_obj_res l_hiredis_connect_nonblock(b_lean_obj_arg host, uint32_t port, lean
 
 // Check if there's data available to read (non-blocking check)
 lean_obj_res l_hiredis_can_read(uint64_t ctx, uint64_t timeout_ms, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
+    VALIDATE_REDIS_CTX_READING(c, ctx);
 
     if (c->fd <= 0) {
         lean_object* error = mk_redis_connect_error_other("Invalid file descriptor");
@@ -59,7 +59,7 @@ lean_obj_res l_hiredis_can_read(uint64_t ctx, uint64_t timeout_ms, lean_obj_arg
 
 // Check if we can write (non-blocking check)
 lean_obj_res l_hiredis_can_write(uint64_t ctx, uint64_t timeout_ms, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
+    VALIDATE_REDIS_CTX_READING(c, ctx);
 
     if (c->fd <= 0) {
         lean_object* error = mk_redis_connect_error_other("Invalid file descriptor");
@@ -83,7 +83,7 @@ lean_obj_res l_hiredis_can_write(uint64_t ctx, uint64_t timeout_ms, lean_obj_arg
 
 // Buffer write - send pending data in output buffer
 lean_obj_res l_hiredis_buffer_write(uint64_t ctx, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
+    VALIDATE_REDIS_CTX_READING(c, ctx);
 
     int done = 0;
     int result = redisBufferWrite(c, &done);
@@ -98,7 +98,7 @@ lean_obj_res l_hiredis_buffer_write(uint64_t ctx, lean_obj_arg w) {
 
 // Buffer read - read data into input buffer
 lean_obj_res l_hiredis_buffer_read(uint64_t ctx, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
+    VALIDATE_REDIS_CTX_READING(c, ctx);
 
     int result = redisBufferRead(c);
 
@@ -111,13 +111,16 @@ lean_obj_res l_hiredis_buffer_read(uint64_t ctx, lean_obj_arg w) {
 }
 
 // Try to get a reply from the input buffer (non-blocking)
+// Returns Option Reply: none if no complete reply is buffered yet. Replies are
+// decoded in full (nested arrays, maps, doubles, ...) by the Lean reply reader;
+// a top-level error reply is raised as Error.replyError.
 lean_obj_res l_hiredis_get_reply_nonblock(uint64_t ctx, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
-    redisReply* reply = NULL;
+    VALIDATE_REDIS_CTX_READING(c, ctx);
+    lean_object* reply = NULL;
 
-    // First try to read from buffer
-    if (redisGetReplyFromReader(c, (void**)&reply) == REDIS_ERR) {
-        lean_object* error = mk_redis_error_from_context(c);
+    if (!redis_get_buffered_reply_lean(c_conn, &reply)) {
+        lean_object* error = c->err ? mk_redis_error_from_context(c)
+                                    : mk_redis_connect_error_other("Reader busy with a partial reply");
         return lean_io_result_mk_error(error);
     }
 
@@ -126,50 +129,21 @@ lean_obj_res l_hiredis_get_reply_nonblock(uint64_t ctx, lean_obj_arg w) {
         return lean_io_result_mk_ok(lean_box(0)); // None
     }
 
-    // Convert reply to ByteArray
-    lean_object* result_obj;
-
-    if (reply->type == REDIS_REPLY_ERROR) {
-        lean_object* error = mk_redis_reply_error(reply->str);
-        freeReplyObject(reply);
+    if (lean_obj_tag(reply) == LEAN_REPLY_ERROR) {
+        lean_object* error = mk_redis_reply_error(lean_reply_cstr(reply));
+        lean_dec(reply);
         return lean_io_result_mk_error(error);
     }
 
-    switch (reply->type) {
-        case REDIS_REPLY_STRING:
-        case REDIS_REPLY_STATUS:
-            result_obj = lean_mk_empty_byte_array(lean_box(reply->len));
-            memcpy(lean_sarray_cptr(result_obj), reply->str, reply->len);
-            break;
-
-        case REDIS_REPLY_INTEGER: {
-            char buf[32];
-            int len = snprintf(buf, sizeof(buf), "%lld", reply->integer);
-            result_obj = lean_mk_empty_byte_array(lean_box(len));
-            memcpy(lean_sarray_cptr(result_obj), buf, len);
-            break;
-        }
-
-        case REDIS_REPLY_NIL:
-            result_obj = lean_mk_empty_byte_array(lean_box(0));
-            break;
-
-        default:
-            result_obj = lean_mk_empty_byte_array(lean_box(0));
-            break;
-    }
-
-    freeReplyObject(reply);
-
     // Return Some result
     lean_object* some = lean_alloc_ctor(1, 1, 0);
-    lean_ctor_set(some, 0, result_obj);
+    lean_ctor_set(some, 0, reply);
     return lean_io_result_mk_ok(some);
 }
 
 // Set non-blocking mode
 lean_obj_res l_hiredis_set_nonblock(uint64_t ctx, uint8_t nonblock, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
+    VALIDATE_REDIS_CTX_READING(c, ctx);
 
     int flags = c->flags;
     if (nonblock) {
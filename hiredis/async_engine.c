@@ -0,0 +1,430 @@
+// Asynchronous engine for redis-lean
+// One redisAsyncContext per engine, driven by a dedicated epoll I/O thread.
+//
+// Lean threads submit commands with l_hiredis_async_send: the command is
+// formatted on the caller's thread and queued under a mutex, then the I/O
+// thread is woken through an eventfd. Only the I/O thread touches the
+// redisAsyncContext. Each reply is decoded into a Redis.Reply on the I/O
+// thread and handed to the Lean callback supplied with the command (which
+// resolves an IO.Promise on the Lean side), so any number of requests can be
+// in flight on one connection without blocking the submitting threads.
+
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+// epoll data tags
+#define ASYNC_EV_WAKE  0
+#define ASYNC_EV_REDIS 1
+
+typedef struct AsyncRequest {
+    struct AsyncRequest* next;
+    char* cmd;              // RESP-formatted command (redisFormatCommandArgv)
+    long long len;
+    lean_object* on_reply;  // Except Error Reply → BaseIO Unit (owned)
+} AsyncRequest;
+
+typedef struct {
+    redisAsyncContext* ac;  // NULL once hiredis has freed it
+    pthread_t thread;
+    pthread_mutex_t lock;   // Guards the submit queue and the flags below
+    AsyncRequest* head;     // Submitted, not yet handed to hiredis
+    AsyncRequest* tail;
+    int stopping;           // close requested (later closes do nothing)
+    int closed;             // connection gone: new submissions fail
+    int epfd;
+    int wakefd;
+    uint32_t events;        // Current epoll interest on the socket
+    int fd;                 // Socket registered with epoll (-1 if none)
+} RedisAsyncEngine;
+
+// ============================================================================
+// Completion
+// ============================================================================
+
+// Hand the result to the Lean callback and release the request.
+// Runs on the I/O thread (or on the submitter when the engine is closed).
+static void async_request_complete(AsyncRequest* req, lean_object* result) {
+    lean_object* r = lean_apply_2(req->on_reply, result, lean_io_mk_world());
+    lean_dec(r);
+    free(req->cmd);
+    free(req);
+}
+
+static void async_request_fail(AsyncRequest* req, const char* msg) {
+    lean_object* except = lean_alloc_ctor(0, 1, 0);  // Except.error
+    lean_ctor_set(except, 0, mk_redis_connect_error_io(msg));
+    async_request_complete(req, except);
+}
+
+// redisCallbackFn: reply is NULL when the context is freed with the command
+// still pending (disconnect, connect failure)
+static void async_engine_on_reply(redisAsyncContext* ac, void* r, void* privdata) {
+    (void)ac;
+    AsyncRequest* req = (AsyncRequest*)privdata;
+    redisReply* reply = (redisReply*)r;
+
+    if (reply == NULL) {
+        async_request_fail(req, "async connection closed");
+        return;
+    }
+
+    lean_object* except;
+    if (reply->type == REDIS_REPLY_ERROR) {
+        except = lean_alloc_ctor(0, 1, 0);  // Except.error
+        lean_ctor_set(except, 0, mk_redis_reply_error(reply->str));
+    } else {
+        except = lean_alloc_ctor(1, 1, 0);  // Except.ok
+        lean_ctor_set(except, 0, lean_reply_from_redis(reply));
+    }
+    async_request_complete(req, except);
+}
+
+// ============================================================================
+// hiredis event adapter (epoll)
+// ============================================================================
+
+static void async_engine_update(RedisAsyncEngine* e, uint32_t add, uint32_t del) {
+    uint32_t ev = (e->events | add) & ~del;
+    if (ev == e->events || e->ac == NULL) return;
+
+    int fd = e->ac->c.fd;
+    struct epoll_event ee;
+    ee.events = ev;
+    ee.data.u64 = ASYNC_EV_REDIS;
+
+    if (e->events == 0) {
+        epoll_ctl(e->epfd, EPOLL_CTL_ADD, fd, &ee);
+        e->fd = fd;
+    } else if (ev == 0) {
+        epoll_ctl(e->epfd, EPOLL_CTL_DEL, fd, &ee);
+        e->fd = -1;
+    } else {
+        epoll_ctl(e->epfd, EPOLL_CTL_MOD, fd, &ee);
+    }
+    e->events = ev;
+}
+
+static void async_engine_add_read(void* privdata) {
+    async_engine_update((RedisAsyncEngine*)privdata, EPOLLIN, 0);
+}
+
+static void async_engine_del_read(void* privdata) {
+    async_engine_update((RedisAsyncEngine*)privdata, 0, EPOLLIN);
+}
+
+static void async_engine_add_write(void* privdata) {
+    async_engine_update((RedisAsyncEngine*)privdata, EPOLLOUT, 0);
+}
+
+static void async_engine_del_write(void* privdata) {
+    async_engine_update((RedisAsyncEngine*)privdata, 0, EPOLLOUT);
+}
+
+static void async_engine_mark_closed(RedisAsyncEngine* e) {
+    pthread_mutex_lock(&e->lock);
+    e->ac = NULL;
+    e->closed = 1;
+    pthread_mutex_unlock(&e->lock);
+}
+
+// Called by hiredis when it frees the context, whatever the reason
+static void async_engine_cleanup(void* privdata) {
+    RedisAsyncEngine* e = (RedisAsyncEngine*)privdata;
+    if (e->fd >= 0) {
+        struct epoll_event ee = {0};
+        epoll_ctl(e->epfd, EPOLL_CTL_DEL, e->fd, &ee);
+        e->fd = -1;
+    }
+    e->events = 0;
+    async_engine_mark_closed(e);
+}
+
+// On failure hiredis frees the context right after this callback
+static void async_engine_on_connect(const redisAsyncContext* ac, int status) {
+    if (status != REDIS_OK) {
+        async_engine_mark_closed((RedisAsyncEngine*)ac->data);
+    }
+}
+
+static void async_engine_on_disconnect(const redisAsyncContext* ac, int status) {
+    (void)status;
+    async_engine_mark_closed((RedisAsyncEngine*)ac->data);
+}
+
+// ============================================================================
+// I/O thread
+// ============================================================================
+
+// Hand every queued request to hiredis (appends to its output buffer)
+static void async_engine_submit_pending(RedisAsyncEngine* e) {
+    pthread_mutex_lock(&e->lock);
+    AsyncRequest* req = e->head;
+    e->head = e->tail = NULL;
+    pthread_mutex_unlock(&e->lock);
+
+    while (req) {
+        AsyncRequest* next = req->next;
+        req->next = NULL;
+        if (e->ac == NULL ||
+            redisAsyncFormattedCommand(e->ac, async_engine_on_reply, req, req->cmd, (size_t)req->len) != REDIS_OK) {
+            async_request_fail(req, "async connection closed");
+        } else {
+            // hiredis copied the command into its output buffer
+            free(req->cmd);
+            req->cmd = NULL;
+        }
+        req = next;
+    }
+}
+
+static void* async_engine_main(void* arg) {
+    RedisAsyncEngine* e = (RedisAsyncEngine*)arg;
+    struct epoll_event evs[16];
+    int disconnecting = 0;
+
+    lean_initialize_thread();
+
+    while (e->ac != NULL) {
+        int n = epoll_wait(e->epfd, evs, 16, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < n && e->ac != NULL; i++) {
+            if (evs[i].data.u64 == ASYNC_EV_WAKE) {
+                uint64_t v;
+                ssize_t rd = read(e->wakefd, &v, sizeof(v));
+                (void)rd;
+                async_engine_submit_pending(e);
+                continue;
+            }
+            if (evs[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+                redisAsyncHandleRead(e->ac);
+            }
+            if (e->ac != NULL && (evs[i].events & EPOLLOUT)) {
+                redisAsyncHandleWrite(e->ac);
+            }
+        }
+
+        pthread_mutex_lock(&e->lock);
+        int stopping = e->stopping;
+        pthread_mutex_unlock(&e->lock);
+        if (stopping && e->ac != NULL && !disconnecting) {
+            // Graceful: hiredis frees the context once pending replies arrive
+            disconnecting = 1;
+            redisAsyncDisconnect(e->ac);
+        }
+    }
+
+    // epoll failure: free the context so pending callbacks fire with NULL
+    if (e->ac != NULL) redisAsyncFree(e->ac);
+    // Context gone: fail anything submitted meanwhile
+    async_engine_mark_closed(e);
+    async_engine_submit_pending(e);
+
+    lean_finalize_thread();
+    return NULL;
+}
+
+static void async_engine_wake(RedisAsyncEngine* e) {
+    uint64_t one = 1;
+    ssize_t wr = write(e->wakefd, &one, sizeof(one));
+    (void)wr;
+}
+
+static void async_engine_close_fds(RedisAsyncEngine* e) {
+    if (e->epfd >= 0) close(e->epfd);
+    if (e->wakefd >= 0) close(e->wakefd);
+    e->epfd = e->wakefd = -1;
+}
+
+static void async_engine_release(RedisAsyncEngine* e) {
+    async_engine_close_fds(e);
+    pthread_mutex_destroy(&e->lock);
+    free(e);
+}
+
+// Wait for in-flight replies and stop the I/O thread; runs once; the struct
+// itself stays until the handle is finalized, so that a send on a closed
+// handle fails instead of touching freed memory
+static void async_engine_shutdown(RedisAsyncEngine* e) {
+    pthread_mutex_lock(&e->lock);
+    int already = e->stopping;
+    e->stopping = 1;
+    if (!already) async_engine_wake(e);
+    pthread_mutex_unlock(&e->lock);
+    if (already) return;
+
+    pthread_join(e->thread, NULL);
+    pthread_mutex_lock(&e->lock);
+    async_engine_close_fds(e);
+    pthread_mutex_unlock(&e->lock);
+}
+
+// ============================================================================
+// Handle
+// ============================================================================
+
+// The engine is a Lean external object: unreachable engines are closed and
+// freed by the GC
+static void async_engine_finalize(void* ptr) {
+    RedisAsyncEngine* e = (RedisAsyncEngine*)ptr;
+    async_engine_shutdown(e);
+    async_engine_release(e);
+}
+
+static void async_engine_foreach(void* ptr, b_lean_obj_arg f) {
+    (void)ptr;
+    (void)f;
+}
+
+static lean_external_class* g_async_engine_class = NULL;
+
+static lean_external_class* get_async_engine_class(void) {
+    if (!g_async_engine_class) {
+        g_async_engine_class = lean_register_external_class(async_engine_finalize, async_engine_foreach);
+    }
+    return g_async_engine_class;
+}
+
+static inline RedisAsyncEngine* async_engine_of(b_lean_obj_arg handle) {
+    return (RedisAsyncEngine*)lean_get_external_data(handle);
+}
+
+// ============================================================================
+// Lean API
+// ============================================================================
+
+// async_connect :: String -> UInt32 -> EIO Error AsyncEngine
+lean_obj_res l_hiredis_async_connect(b_lean_obj_arg host, uint32_t port, lean_obj_arg w) {
+    RedisAsyncEngine* e = (RedisAsyncEngine*)calloc(1, sizeof(RedisAsyncEngine));
+    if (!e) {
+        return lean_io_result_mk_error(mk_redis_connect_error_other("Failed to allocate async engine"));
+    }
+    e->fd = -1;
+    pthread_mutex_init(&e->lock, NULL);
+    e->epfd = epoll_create1(EPOLL_CLOEXEC);
+    e->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (e->epfd < 0 || e->wakefd < 0) {
+        async_engine_release(e);
+        return lean_io_result_mk_error(mk_redis_connect_error_io("Failed to create async event loop"));
+    }
+
+    struct epoll_event ee;
+    ee.events = EPOLLIN;
+    ee.data.u64 = ASYNC_EV_WAKE;
+    epoll_ctl(e->epfd, EPOLL_CTL_ADD, e->wakefd, &ee);
+
+    redisAsyncContext* ac = redisAsyncConnect(lean_string_cstr(host), (int)port);
+    if (ac == NULL) {
+        async_engine_release(e);
+        return lean_io_result_mk_error(mk_redis_connect_error_other("Async connection allocation failed"));
+    }
+    if (ac->err) {
+        lean_object* error = mk_redis_connect_error_io(ac->errstr);
+        redisAsyncFree(ac);
+        async_engine_release(e);
+        return lean_io_result_mk_error(error);
+    }
+
+    e->ac = ac;
+    ac->data = e;
+    ac->ev.data = e;
+    ac->ev.addRead = async_engine_add_read;
+    ac->ev.delRead = async_engine_del_read;
+    ac->ev.addWrite = async_engine_add_write;
+    ac->ev.delWrite = async_engine_del_write;
+    ac->ev.cleanup = async_engine_cleanup;
+    // The connect callback arms the first write event (connection completion)
+    redisAsyncSetConnectCallback(ac, async_engine_on_connect);
+    redisAsyncSetDisconnectCallback(ac, async_engine_on_disconnect);
+
+    if (pthread_create(&e->thread, NULL, async_engine_main, e) != 0) {
+        redisAsyncFree(ac);
+        async_engine_release(e);
+        return lean_io_result_mk_error(mk_redis_connect_error_other("Failed to start async I/O thread"));
+    }
+
+    return lean_io_result_mk_ok(lean_alloc_external(get_async_engine_class(), e));
+}
+
+// async_send :: AsyncEngine -> Array ByteArray -> (Except Error Reply -> BaseIO Unit) -> EIO Error Unit
+// `on_reply` is called exactly once, on the I/O thread, unless an error is
+// returned here.
+lean_obj_res l_hiredis_async_send(b_lean_obj_arg handle, b_lean_obj_arg args, lean_obj_arg on_reply, lean_obj_arg w) {
+    RedisAsyncEngine* e = async_engine_of(handle);
+    size_t argc = lean_array_size(args);
+    if (argc == 0) {
+        lean_dec(on_reply);
+        return lean_io_result_mk_error(mk_redis_null_reply_error("async send: empty command"));
+    }
+
+    // Formatted on the caller's thread; several threads may submit at once,
+    // so the per-connection scratch arena is not used here
+    const char* argv_stack[16];
+    size_t argvlen_stack[16];
+    const char** argv = argc <= 16 ? argv_stack : (const char**)malloc(argc * sizeof(char*));
+    size_t* argvlen = argc <= 16 ? argvlen_stack : (size_t*)malloc(argc * sizeof(size_t));
+    if (!argv || !argvlen) {
+        if (argv != argv_stack) free(argv);
+        if (argvlen != argvlen_stack) free(argvlen);
+        lean_dec(on_reply);
+        return lean_io_result_mk_error(mk_redis_connect_error_other("Failed to allocate command"));
+    }
+    for (size_t i = 0; i < argc; i++) {
+        lean_object* arg = lean_array_get_core(args, i);
+        argv[i] = (const char*)lean_sarray_cptr(arg);
+        argvlen[i] = lean_sarray_size(arg);
+    }
+
+    char* cmd = NULL;
+    long long len = redisFormatCommandArgv(&cmd, (int)argc, argv, argvlen);
+    if (argv != argv_stack) free(argv);
+    if (argvlen != argvlen_stack) free(argvlen);
+    if (len < 0) {
+        lean_dec(on_reply);
+        return lean_io_result_mk_error(mk_redis_connect_error_other("Failed to format command"));
+    }
+
+    AsyncRequest* req = (AsyncRequest*)malloc(sizeof(AsyncRequest));
+    if (!req) {
+        redisFreeCommand(cmd);
+        lean_dec(on_reply);
+        return lean_io_result_mk_error(mk_redis_connect_error_other("Failed to allocate command"));
+    }
+    req->next = NULL;
+    req->cmd = cmd;
+    req->len = len;
+    // The closure is invoked from the I/O thread
+    lean_mark_mt(on_reply);
+    req->on_reply = on_reply;
+
+    pthread_mutex_lock(&e->lock);
+    if (e->closed || e->stopping) {
+        pthread_mutex_unlock(&e->lock);
+        redisFreeCommand(cmd);
+        lean_dec(on_reply);
+        free(req);
+        return lean_io_result_mk_error(mk_redis_connect_error_io("async connection closed"));
+    }
+    int was_empty = e->head == NULL;
+    if (e->tail) e->tail->next = req; else e->head = req;
+    e->tail = req;
+    // One wakeup drains the whole queue. Sent under the lock, so that a
+    // concurrent close cannot have closed the eventfd yet.
+    if (was_empty) async_engine_wake(e);
+    pthread_mutex_unlock(&e->lock);
+
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+// async_close :: AsyncEngine -> BaseIO Unit
+// Waits for in-flight replies, then stops the I/O thread. Idempotent; later
+// sends fail with "async connection closed".
+lean_obj_res l_hiredis_async_close(b_lean_obj_arg handle, lean_obj_arg w) {
+    async_engine_shutdown(async_engine_of(handle));
+    return lean_io_result_mk_ok(lean_box(0));
+}
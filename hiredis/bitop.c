@@ -1,4 +1,4 @@
-// bitop :: UInt64 -> ByteArray -> ByteArray -> List ByteArray -> EIO Error UInt64
+// bitop :: UInt64 -> ByteArray -> ByteArray -> Array ByteArray -> EIO Error UInt64
 // Perform bitwise operations between strings
 // operation: AND, OR, XOR, NOT
 lean_obj_res l_hiredis_bitop(uint64_t ctx, b_lean_obj_arg operation, b_lean_obj_arg destkey, b_lean_obj_arg keys, lean_obj_arg w) {
@@ -9,17 +9,16 @@ lean_obj_res l_hiredis_bitop(uint64_t ctx, b_lean_obj_arg operation, b_lean_obj_
   size_t d_len = lean_sarray_size(destkey);
 
   // Count keys
-  size_t key_count = 0;
-  lean_object* tmp = keys;
-  while (!lean_is_scalar(tmp)) {
-    key_count++;
-    tmp = lean_ctor_get(tmp, 1);
-  }
+  size_t key_count = lean_array_size(keys);
 
   // Build argv: BITOP operation destkey key [key ...]
   int argc = 3 + (int)key_count;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "BITOP";
   argvlen[0] = 5;
@@ -28,19 +27,15 @@ lean_obj_res l_hiredis_bitop(uint64_t ctx, b_lean_obj_arg operation, b_lean_obj_
   argv[2] = d;
   argvlen[2] = d_len;
 
-  tmp = keys;
   int idx = 3;
-  while (!lean_is_scalar(tmp)) {
-    lean_object* key = lean_ctor_get(tmp, 0);
+  for (size_t j = 0; j < key_count; j++) {
+    lean_object* key = lean_array_get_core(keys, j);
     argv[idx] = (const char*)lean_sarray_cptr(key);
     argvlen[idx] = lean_sarray_size(key);
     idx++;
-    tmp = lean_ctor_get(tmp, 1);
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("BITOP returned NULL");
@@ -1,4 +1,4 @@
-// blmpop :: UInt64 -> Float -> List ByteArray -> UInt8 -> Option UInt64 -> EIO Error (Option (ByteArray × List ByteArray))
+// blmpop :: UInt64 -> Float -> Array ByteArray -> UInt8 -> Option UInt64 -> EIO Error (Option (ByteArray × List ByteArray))
 // Blocking pop elements from multiple lists
 // timeout: seconds to wait (0 = wait indefinitely)
 // direction: 0 = LEFT, 1 = RIGHT
@@ -7,12 +7,7 @@ lean_obj_res l_hiredis_blmpop(uint64_t ctx, double timeout, b_lean_obj_arg keys,
   VALIDATE_REDIS_CTX(c, ctx);
 
   // Count keys
-  size_t num_keys = 0;
-  lean_object* current = keys;
-  while (!lean_is_scalar(current)) {
-    num_keys++;
-    current = lean_ctor_get(current, 1);
-  }
+  size_t num_keys = lean_array_size(keys);
 
   if (num_keys == 0) {
     lean_object* error = mk_redis_reply_error("BLMPOP requires at least one key");
@@ -21,8 +16,12 @@ lean_obj_res l_hiredis_blmpop(uint64_t ctx, double timeout, b_lean_obj_arg keys,
 
   // Build argv: BLMPOP timeout numkeys key1 key2 ... LEFT|RIGHT [COUNT count]
   size_t max_argc = 6 + num_keys;
-  const char** argv = (const char**)malloc(max_argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(max_argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, max_argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
   int argc = 0;
 
   argv[argc] = "BLMPOP";
@@ -42,13 +41,11 @@ lean_obj_res l_hiredis_blmpop(uint64_t ctx, double timeout, b_lean_obj_arg keys,
   argc++;
 
   // Add keys
-  current = keys;
-  while (!lean_is_scalar(current)) {
-    lean_object* key = lean_ctor_get(current, 0);
+  for (size_t j = 0; j < num_keys; j++) {
+    lean_object* key = lean_array_get_core(keys, j);
     argv[argc] = (const char*)lean_sarray_cptr(key);
     argvlen[argc] = lean_sarray_size(key);
     argc++;
-    current = lean_ctor_get(current, 1);
   }
 
   // Add direction
@@ -71,8 +68,6 @@ lean_obj_res l_hiredis_blmpop(uint64_t ctx, double timeout, b_lean_obj_arg keys,
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("BLMPOP returned NULL");
@@ -1,16 +1,11 @@
-// brpop :: UInt64 -> List ByteArray -> Float -> EIO Error (Option (ByteArray × ByteArray))
+// brpop :: UInt64 -> Array ByteArray -> Float -> EIO Error (Option (ByteArray × ByteArray))
 // Blocking pop from the tail of lists
 // timeout: seconds to wait (0 = wait indefinitely)
 lean_obj_res l_hiredis_brpop(uint64_t ctx, b_lean_obj_arg keys, double timeout, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
 
   // Count keys
-  size_t num_keys = 0;
-  lean_object* current = keys;
-  while (!lean_is_scalar(current)) {
-    num_keys++;
-    current = lean_ctor_get(current, 1);
-  }
+  size_t num_keys = lean_array_size(keys);
 
   if (num_keys == 0) {
     lean_object* error = mk_redis_reply_error("BRPOP requires at least one key");
@@ -19,19 +14,21 @@ lean_obj_res l_hiredis_brpop(uint64_t ctx, b_lean_obj_arg keys, double timeout,
 
   // Build argv: BRPOP key1 key2 ... timeout
   size_t argc = 2 + num_keys;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "BRPOP";
   argvlen[0] = 5;
 
-  current = keys;
   size_t i = 1;
-  while (!lean_is_scalar(current)) {
-    lean_object* key = lean_ctor_get(current, 0);
+  for (size_t j = 0; j < num_keys; j++) {
+    lean_object* key = lean_array_get_core(keys, j);
     argv[i] = (const char*)lean_sarray_cptr(key);
     argvlen[i] = lean_sarray_size(key);
-    current = lean_ctor_get(current, 1);
     i++;
   }
 
@@ -41,8 +38,6 @@ lean_obj_res l_hiredis_brpop(uint64_t ctx, b_lean_obj_arg keys, double timeout,
   argvlen[i] = strlen(timeout_str);
 
   redisReply* r = (redisReply*)redisCommandArgv(c, (int)argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("BRPOP returned NULL");
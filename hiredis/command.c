@@ -119,11 +119,11 @@ static int parse_command_args(const char* command, char*** argv_out, size_t** ar
     argv[arg_idx][len] = '\0';
     argvlen[arg_idx] = len;
     arg_idx++;
-  
+  }
+
   *argv_out = argv;
   *argvlen_out = argvlen;
   return arg_idx;
-  }
 }
 
 // Helper function to free parsed arguments
@@ -136,122 +136,76 @@ static void free_parsed_args(char** argv, int argc) {
   }
 }
 
-// command :: UInt64 -> String -> EIO RedisError ByteArray
-// Generic command function that accepts a command string and returns the raw reply as ByteArray
-// This allows execution of arbitrary Redis commands
+// command :: UInt64 -> String -> EIO RedisError Reply
+// Generic command function that accepts a command string and returns the decoded reply
+// This allows execution of arbitrary Redis commands. The reply is built by the
+// Lean reply reader, so nested arrays, maps, doubles etc. arrive intact and
+// replies of any size are returned without truncation. A top-level error reply
+// is raised as Error.replyError; errors nested in aggregates stay Reply.error.
 lean_obj_res l_hiredis_command(uint64_t ctx, b_lean_obj_arg command_str, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
   const char* cmd = lean_string_cstr(command_str);
-  
+
   // Parse command string into arguments
   char** argv = NULL;
   size_t* argvlen = NULL;
   int argc = parse_command_args(cmd, &argv, &argvlen);
-  
+
   if (argc <= 0) {
     lean_object* error = mk_redis_null_reply_error("failed to parse command arguments");
     return lean_io_result_mk_error(error);
   }
 
-  // Execute command using redisCommandArgv
-  redisReply* r = (redisReply*)redisCommandArgv(c, argc, (const char**)argv, argvlen);
-  
+  lean_object* r = redis_command_argv_reply(c_conn, argc, (const char**)argv, argvlen);
+
   // Free parsed arguments
   free_parsed_args(argv, argc);
   if (argvlen) free(argvlen);
-  
+
   if (!r) {
-    lean_object* error = mk_redis_null_reply_error("redisCommandArgv returned NULL");
+    lean_object* error = c->err ? mk_redis_error_from_context(c)
+                                : mk_redis_null_reply_error("redisCommandArgv returned NULL");
     return lean_io_result_mk_error(error);
   }
 
-  lean_object* result;
-  
-  // Handle different reply types and convert to ByteArray
-  switch (r->type) {
-    case REDIS_REPLY_STRING:
-    case REDIS_REPLY_STATUS:
-      if (r->str) {
-        result = lean_alloc_sarray(1, r->len, r->len);
-        memcpy(lean_sarray_cptr(result), r->str, r->len);
-      } else {
-        result = lean_alloc_sarray(1, 0, 0);
-      }
-      break;
-      
-    case REDIS_REPLY_INTEGER: {
-      // Convert integer to string representation
-      char int_str[32];
-      int len = snprintf(int_str, sizeof(int_str), "%lld", r->integer);
-      result = lean_alloc_sarray(1, len, len);
-      memcpy(lean_sarray_cptr(result), int_str, len);
-      break;
-    }
-    
-    case REDIS_REPLY_NIL:
-      // Return empty ByteArray for NIL
-      result = lean_alloc_sarray(1, 0, 0);
-      break;
-      
-    case REDIS_REPLY_ERROR:
-      if (r->str) {
-        lean_object* error = mk_redis_null_reply_error(r->str);
-    freeReplyObject(r);
+  if (lean_obj_tag(r) == LEAN_REPLY_ERROR) {
+    lean_object* error = mk_redis_reply_error(lean_reply_cstr(r));
+    lean_dec(r);
     return lean_io_result_mk_error(error);
-      } else {
-        freeReplyObject(r);
-        lean_object* error = mk_redis_null_reply_error("Redis error with no message");
+  }
+
+  return lean_io_result_mk_ok(r);
+}
+
+// command_argv :: UInt64 -> Array ByteArray -> EIO RedisError Reply
+// Binary-safe generic command: every ByteArray is one argument, passed to
+// redisCommandArgv by pointer (no tokenizing, no per-argument copies).
+lean_obj_res l_hiredis_command_argv(uint64_t ctx, b_lean_obj_arg args, lean_obj_arg w) {
+  VALIDATE_REDIS_CTX(c, ctx);
+
+  if (lean_array_size(args) == 0) {
+    lean_object* error = mk_redis_null_reply_error("empty command");
     return lean_io_result_mk_error(error);
-      }
-      
-    case REDIS_REPLY_ARRAY: {
-      // For arrays, create a simple text representation
-      // Format: "[elem1,elem2,...]" 
-      char* array_str = (char*)malloc(4096); // Start with reasonable size
-      if (!array_str) {
-        freeReplyObject(r);
-        lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+  }
+
+  if (redis_scratch_from_array(c_conn, args) != 0) {
+    lean_object* error = mk_redis_connect_error_other("Memory allocation failed");
     return lean_io_result_mk_error(error);
-      }
-      
-      int pos = 0;
-      pos += snprintf(array_str + pos, 4096 - pos, "[");
-      
-      for (size_t i = 0; i < r->elements && pos < 4090; i++) {
-        if (i > 0) {
-          pos += snprintf(array_str + pos, 4096 - pos, ",");
-        }
-        
-        redisReply* elem = r->element[i];
-        if (elem->type == REDIS_REPLY_STRING && elem->str) {
-          pos += snprintf(array_str + pos, 4096 - pos, "\"%.*s\"", (int)elem->len, elem->str);
-        } else if (elem->type == REDIS_REPLY_INTEGER) {
-          pos += snprintf(array_str + pos, 4096 - pos, "%lld", elem->integer);
-        } else if (elem->type == REDIS_REPLY_NIL) {
-          pos += snprintf(array_str + pos, 4096 - pos, "null");
-        } else {
-          pos += snprintf(array_str + pos, 4096 - pos, "?");
-        }
-      }
+  }
 
-      pos += snprintf(array_str + pos, 4096 - pos, "]");
-      
-      result = lean_alloc_sarray(1, pos, pos);
-      memcpy(lean_sarray_cptr(result), array_str, pos);
-      free(array_str);
-      break;
-    }
-    
-    default: {
-      // For unknown types, return type info
-      char type_str[64];
-      int len = snprintf(type_str, sizeof(type_str), "UNKNOWN_TYPE_%d", r->type);
-      result = lean_alloc_sarray(1, len, len);
-      memcpy(lean_sarray_cptr(result), type_str, len);
-      break;
-    }
+  lean_object* r = redis_command_argv_reply(c_conn, (int)lean_array_size(args), c_conn->argv, c_conn->argvlen);
+
+  if (!r) {
+    lean_object* error = c->err ? mk_redis_error_from_context(c)
+                                : mk_redis_null_reply_error("redisCommandArgv returned NULL");
+    return lean_io_result_mk_error(error);
   }
-  
-  freeReplyObject(r);
-  return lean_io_result_mk_ok(result);
+
+  if (lean_obj_tag(r) == LEAN_REPLY_ERROR) {
+    lean_object* error = mk_redis_reply_error(lean_reply_cstr(r));
+    lean_dec(r);
+    return lean_io_result_mk_error(error);
+  }
+
+  return lean_io_result_mk_ok(r);
 }
@@ -1,43 +1,30 @@
-// del :: UInt64 -> List ByteArray -> EIO RedisError UInt64
+// del :: UInt64 -> Array ByteArray -> EIO RedisError UInt64
 lean_obj_res l_hiredis_del(uint64_t ctx, b_lean_obj_arg keys, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
   
-  lean_object* current = keys;
-  size_t key_count = 0;
-  while (!lean_is_scalar(current)) {
-    key_count++;
-    current = lean_ctor_get(current, 1); // tail of the list
-  }
+  size_t key_count = lean_array_size(keys);
   if (key_count == 0) {
     return lean_io_result_mk_ok(lean_box_uint64(0));
   }
   
-  const char** argv = (const char**)malloc((key_count + 1) * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc((key_count + 1) * sizeof(size_t));
-  
-  if (!argv || !argvlen) {
-    if (argv) free(argv);
-    if (argvlen) free(argvlen);
+  if (redis_scratch_reserve(c_conn, key_count + 1) != 0) {
     lean_object* error = mk_redis_null_reply_error("memory allocation failed");
     return lean_io_result_mk_error(error);
   }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "DEL";
   argvlen[0] = 3;
   
-  current = keys;
   for (size_t i = 0; i < key_count; i++) {
-    lean_object* key = lean_ctor_get(current, 0); // head of the list
+    lean_object* key = lean_array_get_core(keys, i);
     argv[i + 1] = (const char*)lean_sarray_cptr(key);
     argvlen[i + 1] = lean_sarray_size(key);
-    current = lean_ctor_get(current, 1); // tail of the list
   }
   
   redisReply* r = (redisReply*)redisCommandArgv(c, (int)(key_count + 1), argv, argvlen);
   
-  free(argv);
-  free(argvlen);
-  
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("redisCommand returned NULL");
     return lean_io_result_mk_error(error);
@@ -46,6 +33,10 @@ lean_obj_res l_hiredis_del(uint64_t ctx, b_lean_obj_arg keys, lean_obj_arg w) {
   uint64_t deleted = 0;
   if (r->type == REDIS_REPLY_INTEGER) {
     deleted = (uint64_t)r->integer;
+  } else if (r->type == REDIS_REPLY_ERROR && r->str) {
+    lean_object* error = mk_redis_reply_error(r->str);
+    freeReplyObject(r);
+    return lean_io_result_mk_error(error);
   } else {
     char error_msg[256];
     snprintf(error_msg, sizeof(error_msg), "DEL returned unexpected reply type %d", r->type);
@@ -1,4 +1,4 @@
-// eval :: UInt64 -> ByteArray -> List ByteArray -> List ByteArray -> EIO Error ByteArray
+// eval :: UInt64 -> ByteArray -> Array ByteArray -> Array ByteArray -> EIO Error ByteArray
 // Execute a Lua script server side
 lean_obj_res l_hiredis_eval(uint64_t ctx, b_lean_obj_arg script, b_lean_obj_arg keys, b_lean_obj_arg args, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
@@ -6,24 +6,18 @@ lean_obj_res l_hiredis_eval(uint64_t ctx, b_lean_obj_arg script, b_lean_obj_arg
   size_t s_len = lean_sarray_size(script);
 
   // Count keys and args
-  size_t key_count = 0;
-  lean_object* tmp = keys;
-  while (!lean_is_scalar(tmp)) {
-    key_count++;
-    tmp = lean_ctor_get(tmp, 1);
-  }
+  size_t key_count = lean_array_size(keys);
 
-  size_t arg_count = 0;
-  tmp = args;
-  while (!lean_is_scalar(tmp)) {
-    arg_count++;
-    tmp = lean_ctor_get(tmp, 1);
-  }
+  size_t arg_count = lean_array_size(args);
 
   // Build argv: EVAL script numkeys key [key ...] arg [arg ...]
   int argc = 3 + (int)key_count + (int)arg_count;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "EVAL";
   argvlen[0] = 4;
@@ -36,27 +30,21 @@ lean_obj_res l_hiredis_eval(uint64_t ctx, b_lean_obj_arg script, b_lean_obj_arg
   argvlen[2] = strlen(numkeys_str);
 
   int idx = 3;
-  tmp = keys;
-  while (!lean_is_scalar(tmp)) {
-    lean_object* key = lean_ctor_get(tmp, 0);
+  for (size_t j = 0; j < key_count; j++) {
+    lean_object* key = lean_array_get_core(keys, j);
     argv[idx] = (const char*)lean_sarray_cptr(key);
     argvlen[idx] = lean_sarray_size(key);
     idx++;
-    tmp = lean_ctor_get(tmp, 1);
   }
 
-  tmp = args;
-  while (!lean_is_scalar(tmp)) {
-    lean_object* arg = lean_ctor_get(tmp, 0);
+  for (size_t j = 0; j < arg_count; j++) {
+    lean_object* arg = lean_array_get_core(args, j);
     argv[idx] = (const char*)lean_sarray_cptr(arg);
     argvlen[idx] = lean_sarray_size(arg);
     idx++;
-    tmp = lean_ctor_get(tmp, 1);
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("EVAL returned NULL");
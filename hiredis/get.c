@@ -6,38 +6,41 @@ lean_obj_res l_hiredis_get(uint64_t ctx, b_lean_obj_arg key, lean_obj_arg w) {
   
   const char* argv[2] = {"GET", k};
   size_t argvlen[2] = {3, k_len};
-  redisReply* r = (redisReply*)redisCommandArgv(c, 2, argv, argvlen);
+  lean_object* r = redis_command_argv_reply(c_conn, 2, argv, argvlen);
   
   if (!r) {
-    lean_object* error = mk_redis_null_reply_error("GET returned NULL");
+    lean_object* error = c->err ? mk_redis_error_from_context(c)
+                                : mk_redis_null_reply_error("GET returned NULL");
     return lean_io_result_mk_error(error);
   }
 
   lean_object* out;
-  if (r->type == REDIS_REPLY_NIL) {
-    lean_object* error = mk_redis_key_not_found_error(k);
-    freeReplyObject(r);
-    return lean_io_result_mk_error(error);
-  } else if (r->type == REDIS_REPLY_STRING && r->str) {
-    lean_object* byte_array = lean_alloc_sarray(1, r->len, r->len);
-    memcpy(lean_sarray_cptr(byte_array), r->str, r->len);
-    out = byte_array;
-  } else if (r->type == REDIS_REPLY_STATUS && r->str) {
-    // handling status reply as normal reply
-    lean_object* byte_array = lean_alloc_sarray(1, r->len, r->len);
-    memcpy(lean_sarray_cptr(byte_array), r->str, r->len);
-    out = byte_array;
-  } else if (r->type == REDIS_REPLY_ERROR && r->str) {
-    lean_object* error = mk_redis_reply_error(r->str);
-    freeReplyObject(r);
-    return lean_io_result_mk_error(error);
-  } else {
-    char error_msg[256];
-    snprintf(error_msg, sizeof(error_msg), "GET returned unexpected reply type %d", r->type);
-    freeReplyObject(r);
-    lean_object* error = mk_redis_unexpected_reply_type_error(error_msg);
-    return lean_io_result_mk_error(error);
+  switch (lean_obj_tag(r)) {
+    case LEAN_REPLY_NIL: {
+      lean_object* error = mk_redis_key_not_found_error(k);
+      lean_dec(r);
+      return lean_io_result_mk_error(error);
+    }
+    case LEAN_REPLY_BULK:
+      out = lean_reply_take_bytes(r);
+      break;
+    case LEAN_REPLY_SIMPLE:
+      // handling status reply as normal reply
+      out = lean_reply_to_bytes_compat(r);
+      break;
+    case LEAN_REPLY_ERROR: {
+      lean_object* error = mk_redis_reply_error(lean_reply_cstr(r));
+      lean_dec(r);
+      return lean_io_result_mk_error(error);
+    }
+    default: {
+      char error_msg[256];
+      snprintf(error_msg, sizeof(error_msg), "GET returned unexpected reply type %s", lean_reply_type_name(r));
+      lean_dec(r);
+      lean_object* error = mk_redis_unexpected_reply_type_error(error_msg);
+      return lean_io_result_mk_error(error);
+    }
   }
-  freeReplyObject(r);
+  lean_dec(r);
   return lean_io_result_mk_ok(out);
 }
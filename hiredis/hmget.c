@@ -1,43 +1,38 @@
-// hmget :: UInt64 -> ByteArray -> List ByteArray -> EIO Error (List (Option ByteArray))
+// hmget :: UInt64 -> ByteArray -> Array ByteArray -> EIO Error (List (Option ByteArray))
 // Get values for multiple fields
 lean_obj_res l_hiredis_hmget(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg fields, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
   const char* k = (const char*)lean_sarray_cptr(key);
   size_t k_len = lean_sarray_size(key);
 
-  size_t num_fields = 0;
-  lean_object* current = fields;
-  while (!lean_is_scalar(current)) {
-    num_fields++;
-    current = lean_ctor_get(current, 1);
-  }
+  size_t num_fields = lean_array_size(fields);
 
   if (num_fields == 0) {
     return lean_io_result_mk_ok(lean_box(0));
   }
 
   size_t argc = 2 + num_fields;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "HMGET";
   argvlen[0] = 5;
   argv[1] = k;
   argvlen[1] = k_len;
 
-  current = fields;
   size_t i = 2;
-  while (!lean_is_scalar(current)) {
-    lean_object* field = lean_ctor_get(current, 0);
+  for (size_t j = 0; j < num_fields; j++) {
+    lean_object* field = lean_array_get_core(fields, j);
     argv[i] = (const char*)lean_sarray_cptr(field);
     argvlen[i] = lean_sarray_size(field);
-    current = lean_ctor_get(current, 1);
     i++;
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, (int)argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("HMGET returned NULL");
@@ -1,16 +1,11 @@
-// hmset :: UInt64 -> ByteArray -> List (ByteArray × ByteArray) -> EIO Error Unit
+// hmset :: UInt64 -> ByteArray -> Array (ByteArray × ByteArray) -> EIO Error Unit
 // Set multiple field-value pairs (deprecated, use HSET)
 lean_obj_res l_hiredis_hmset(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg pairs, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
   const char* k = (const char*)lean_sarray_cptr(key);
   size_t k_len = lean_sarray_size(key);
 
-  size_t num_pairs = 0;
-  lean_object* current = pairs;
-  while (!lean_is_scalar(current)) {
-    num_pairs++;
-    current = lean_ctor_get(current, 1);
-  }
+  size_t num_pairs = lean_array_size(pairs);
 
   if (num_pairs == 0) {
     lean_object* error = mk_redis_reply_error("HMSET requires at least one field-value pair");
@@ -18,34 +13,16 @@ lean_obj_res l_hiredis_hmset(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg pa
   }
 
   size_t argc = 2 + num_pairs * 2;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
-
-  argv[0] = "HMSET";
-  argvlen[0] = 5;
-  argv[1] = k;
-  argvlen[1] = k_len;
-
-  current = pairs;
-  size_t i = 2;
-  while (!lean_is_scalar(current)) {
-    lean_object* pair = lean_ctor_get(current, 0);
-    lean_object* field = lean_ctor_get(pair, 0);
-    lean_object* value = lean_ctor_get(pair, 1);
-
-    argv[i] = (const char*)lean_sarray_cptr(field);
-    argvlen[i] = lean_sarray_size(field);
-    i++;
-    argv[i] = (const char*)lean_sarray_cptr(value);
-    argvlen[i] = lean_sarray_size(value);
-    i++;
-
-    current = lean_ctor_get(current, 1);
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
   }
+  redis_scratch_set_cstr(c_conn, 0, "HMSET");
+  redis_scratch_set(c_conn, 1, k, k_len);
+
+  redis_scratch_set_pairs(c_conn, 2, pairs);
 
-  redisReply* r = (redisReply*)redisCommandArgv(c, (int)argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
+  redisReply* r = (redisReply*)redisCommandArgv(c, (int)argc, c_conn->argv, c_conn->argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("HMSET returned NULL");
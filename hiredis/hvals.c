@@ -7,39 +7,31 @@ lean_obj_res l_hiredis_hvals(uint64_t ctx, b_lean_obj_arg key, lean_obj_arg w) {
 
   const char* argv[2] = {"HVALS", k};
   size_t argvlen[2] = {5, k_len};
-  redisReply* r = (redisReply*)redisCommandArgv(c, 2, argv, argvlen);
+  lean_object* r = redis_command_argv_reply(c_conn, 2, argv, argvlen);
 
   if (!r) {
-    lean_object* error = mk_redis_null_reply_error("HVALS returned NULL");
+    lean_object* error = c->err ? mk_redis_error_from_context(c)
+                                : mk_redis_null_reply_error("HVALS returned NULL");
     return lean_io_result_mk_error(error);
   }
 
   lean_object* result_list;
-  if (r->type == REDIS_REPLY_ARRAY) {
-    result_list = lean_box(0);
-    for (int i = (int)r->elements - 1; i >= 0; i--) {
-      redisReply* element = r->element[i];
-      if (element->type == REDIS_REPLY_STRING && element->str) {
-        lean_object* byte_array = lean_alloc_sarray(1, element->len, element->len);
-        memcpy(lean_sarray_cptr(byte_array), element->str, element->len);
-        lean_object* list_node = lean_alloc_ctor(1, 2, 0);
-        lean_ctor_set(list_node, 0, byte_array);
-        lean_ctor_set(list_node, 1, result_list);
-        result_list = list_node;
-      }
-    }
-  } else if (r->type == REDIS_REPLY_ERROR && r->str) {
-    lean_object* error = mk_redis_reply_error(r->str);
-    freeReplyObject(r);
+  unsigned tag = lean_obj_tag(r);
+  if (tag == LEAN_REPLY_ARRAY) {
+    // The element ByteArrays are shared with the reply, not copied
+    result_list = lean_reply_bytes_list(r);
+  } else if (tag == LEAN_REPLY_ERROR) {
+    lean_object* error = mk_redis_reply_error(lean_reply_cstr(r));
+    lean_dec(r);
     return lean_io_result_mk_error(error);
   } else {
     char error_msg[256];
-    snprintf(error_msg, sizeof(error_msg), "HVALS returned unexpected reply type %d", r->type);
-    freeReplyObject(r);
+    snprintf(error_msg, sizeof(error_msg), "HVALS returned unexpected reply type %s", lean_reply_type_name(r));
+    lean_dec(r);
     lean_object* error = mk_redis_unexpected_reply_type_error(error_msg);
     return lean_io_result_mk_error(error);
   }
 
-  freeReplyObject(r);
+  lean_dec(r);
   return lean_io_result_mk_ok(result_list);
 }
@@ -0,0 +1,79 @@
+// Byte accounting for redis-lean
+// Every connection counts the bytes its transport functions write and read
+// (see redis_io_install in ssl_context.c). These functions expose the totals,
+// and the bytes since the previous take so that a command can be charged with
+// what it sent and received. An invalid or freed context counts nothing.
+//
+// The same connections also time the phases of a command when asked to (see
+// "Latency Phases" in ssl_context.c): io_phase_start turns timing on and
+// clears the stamps, io_phase_take returns what the command left in them.
+
+static RedisConnection* io_stats_conn(uint64_t ctx) {
+    RedisConnection* conn = (RedisConnection*)ctx;
+    if (conn == NULL || conn->freed) return NULL;
+    return conn;
+}
+
+// io_stats :: UInt64 -> BaseIO (UInt64 × UInt64)
+// (bytes written, bytes read) since the connection was opened
+lean_obj_res l_hiredis_io_stats(uint64_t ctx, lean_obj_arg w) {
+    RedisConnection* conn = io_stats_conn(ctx);
+    uint64_t written = conn ? conn->bytes_written : 0;
+    uint64_t rd = conn ? conn->bytes_read : 0;
+    return lean_io_result_mk_ok(lean_mk_pair(lean_box_uint64(written), lean_box_uint64(rd)));
+}
+
+// io_take_written :: UInt64 -> BaseIO UInt64
+// Bytes written since the previous take
+lean_obj_res l_hiredis_io_take_written(uint64_t ctx, lean_obj_arg w) {
+    RedisConnection* conn = io_stats_conn(ctx);
+    uint64_t n = 0;
+    if (conn) {
+        n = conn->bytes_written - conn->mark_written;
+        conn->mark_written = conn->bytes_written;
+    }
+    return lean_io_result_mk_ok(lean_box_uint64(n));
+}
+
+// io_take_read :: UInt64 -> BaseIO UInt64
+// Bytes read since the previous take
+lean_obj_res l_hiredis_io_take_read(uint64_t ctx, lean_obj_arg w) {
+    RedisConnection* conn = io_stats_conn(ctx);
+    uint64_t n = 0;
+    if (conn) {
+        n = conn->bytes_read - conn->mark_read;
+        conn->mark_read = conn->bytes_read;
+    }
+    return lean_io_result_mk_ok(lean_box_uint64(n));
+}
+
+// io_phase_start :: UInt64 -> BaseIO Unit
+// Time the phases of the commands on this connection from now on, and clear
+// the stamps for the next one
+lean_obj_res l_hiredis_io_phase_start(uint64_t ctx, lean_obj_arg w) {
+    RedisConnection* conn = io_stats_conn(ctx);
+    if (conn) {
+        conn->timing = 1;
+        redis_phase_reset(conn);
+    }
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+// io_phase_take :: UInt64 -> BaseIO (UInt64 × UInt64 × UInt64 × UInt64)
+// (start of the first write, end of the last reply object callback,
+// nanoseconds in transport calls, nanoseconds in object callbacks) since
+// io_phase_start; timestamps are 0 when the event did not happen
+lean_obj_res l_hiredis_io_phase_take(uint64_t ctx, lean_obj_arg w) {
+    RedisConnection* conn = io_stats_conn(ctx);
+    uint64_t first_write = 0, parse_end = 0, io_ns = 0, object_ns = 0;
+    if (conn) {
+        first_write = conn->phase_first_write;
+        parse_end = conn->phase_parse_end;
+        io_ns = conn->phase_io_ns;
+        object_ns = conn->phase_object_ns;
+        redis_phase_reset(conn);
+    }
+    lean_object* rest = lean_mk_pair(lean_box_uint64(io_ns), lean_box_uint64(object_ns));
+    rest = lean_mk_pair(lean_box_uint64(parse_end), rest);
+    return lean_io_result_mk_ok(lean_mk_pair(lean_box_uint64(first_write), rest));
+}
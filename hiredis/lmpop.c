@@ -1,4 +1,4 @@
-// lmpop :: UInt64 -> List ByteArray -> UInt8 -> Option UInt64 -> EIO Error (Option (ByteArray × List ByteArray))
+// lmpop :: UInt64 -> Array ByteArray -> UInt8 -> Option UInt64 -> EIO Error (Option (ByteArray × List ByteArray))
 // Pop elements from multiple lists
 // direction: 0 = LEFT, 1 = RIGHT
 // count: optional count of elements to pop
@@ -6,12 +6,7 @@ lean_obj_res l_hiredis_lmpop(uint64_t ctx, b_lean_obj_arg keys, uint8_t directio
   VALIDATE_REDIS_CTX(c, ctx);
 
   // Count keys
-  size_t num_keys = 0;
-  lean_object* current = keys;
-  while (!lean_is_scalar(current)) {
-    num_keys++;
-    current = lean_ctor_get(current, 1);
-  }
+  size_t num_keys = lean_array_size(keys);
 
   if (num_keys == 0) {
     lean_object* error = mk_redis_reply_error("LMPOP requires at least one key");
@@ -20,8 +15,12 @@ lean_obj_res l_hiredis_lmpop(uint64_t ctx, b_lean_obj_arg keys, uint8_t directio
 
   // Build argv: LMPOP numkeys key1 key2 ... LEFT|RIGHT [COUNT count]
   size_t max_argc = 4 + num_keys;
-  const char** argv = (const char**)malloc(max_argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(max_argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, max_argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
   int argc = 0;
 
   argv[argc] = "LMPOP";
@@ -35,13 +34,11 @@ lean_obj_res l_hiredis_lmpop(uint64_t ctx, b_lean_obj_arg keys, uint8_t directio
   argc++;
 
   // Add keys
-  current = keys;
-  while (!lean_is_scalar(current)) {
-    lean_object* key = lean_ctor_get(current, 0);
+  for (size_t j = 0; j < num_keys; j++) {
+    lean_object* key = lean_array_get_core(keys, j);
     argv[argc] = (const char*)lean_sarray_cptr(key);
     argvlen[argc] = lean_sarray_size(key);
     argc++;
-    current = lean_ctor_get(current, 1);
   }
 
   // Add direction
@@ -64,8 +61,6 @@ lean_obj_res l_hiredis_lmpop(uint64_t ctx, b_lean_obj_arg keys, uint8_t directio
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("LMPOP returned NULL");
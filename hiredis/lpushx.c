@@ -1,16 +1,11 @@
-// lpushx :: UInt64 -> ByteArray -> List ByteArray -> EIO Error UInt64
+// lpushx :: UInt64 -> ByteArray -> Array ByteArray -> EIO Error UInt64
 // Push elements to head only if list exists, returns new length
 lean_obj_res l_hiredis_lpushx(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg elements, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
   const char* k = (const char*)lean_sarray_cptr(key);
   size_t k_len = lean_sarray_size(key);
 
-  size_t num_elements = 0;
-  lean_object* current = elements;
-  while (!lean_is_scalar(current)) {
-    num_elements++;
-    current = lean_ctor_get(current, 1);
-  }
+  size_t num_elements = lean_array_size(elements);
 
   if (num_elements == 0) {
     lean_object* error = mk_redis_reply_error("LPUSHX requires at least one element");
@@ -18,27 +13,27 @@ lean_obj_res l_hiredis_lpushx(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg e
   }
 
   size_t argc = 2 + num_elements;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "LPUSHX";
   argvlen[0] = 6;
   argv[1] = k;
   argvlen[1] = k_len;
 
-  current = elements;
   size_t i = 2;
-  while (!lean_is_scalar(current)) {
-    lean_object* elem = lean_ctor_get(current, 0);
+  for (size_t j = 0; j < num_elements; j++) {
+    lean_object* elem = lean_array_get_core(elements, j);
     argv[i] = (const char*)lean_sarray_cptr(elem);
     argvlen[i] = lean_sarray_size(elem);
-    current = lean_ctor_get(current, 1);
     i++;
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, (int)argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("LPUSHX returned NULL");
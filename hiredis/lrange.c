@@ -1,6 +1,7 @@
 // lrange :: UInt64 -> ByteArray -> Int64 -> Int64 -> EIO Error (List ByteArray)
+// lrange_array :: UInt64 -> ByteArray -> Int64 -> Int64 -> EIO Error (Array ByteArray)
 // Get a range of elements from a list
-lean_obj_res l_hiredis_lrange(uint64_t ctx, b_lean_obj_arg key, int64_t start, int64_t stop, lean_obj_arg w) {
+static lean_obj_res redis_lrange_impl(uint64_t ctx, b_lean_obj_arg key, int64_t start, int64_t stop, int as_array) {
   VALIDATE_REDIS_CTX(c, ctx);
   const char* k = (const char*)lean_sarray_cptr(key);
   size_t k_len = lean_sarray_size(key);
@@ -11,39 +12,40 @@ lean_obj_res l_hiredis_lrange(uint64_t ctx, b_lean_obj_arg key, int64_t start, i
 
   const char* argv[4] = {"LRANGE", k, start_str, stop_str};
   size_t argvlen[4] = {6, k_len, strlen(start_str), strlen(stop_str)};
-  redisReply* r = (redisReply*)redisCommandArgv(c, 4, argv, argvlen);
+  lean_object* r = redis_command_argv_reply(c_conn, 4, argv, argvlen);
 
   if (!r) {
-    lean_object* error = mk_redis_null_reply_error("LRANGE returned NULL");
+    lean_object* error = c->err ? mk_redis_error_from_context(c)
+                                : mk_redis_null_reply_error("LRANGE returned NULL");
     return lean_io_result_mk_error(error);
   }
 
   lean_object* result_list;
-  if (r->type == REDIS_REPLY_ARRAY) {
-    result_list = lean_box(0);
-    for (int i = (int)r->elements - 1; i >= 0; i--) {
-      redisReply* element = r->element[i];
-      if (element->type == REDIS_REPLY_STRING && element->str) {
-        lean_object* byte_array = lean_alloc_sarray(1, element->len, element->len);
-        memcpy(lean_sarray_cptr(byte_array), element->str, element->len);
-        lean_object* list_node = lean_alloc_ctor(1, 2, 0);
-        lean_ctor_set(list_node, 0, byte_array);
-        lean_ctor_set(list_node, 1, result_list);
-        result_list = list_node;
-      }
-    }
-  } else if (r->type == REDIS_REPLY_ERROR && r->str) {
-    lean_object* error = mk_redis_reply_error(r->str);
-    freeReplyObject(r);
+  unsigned tag = lean_obj_tag(r);
+  if (tag == LEAN_REPLY_ARRAY) {
+    // The element ByteArrays are shared with the reply, not copied
+    result_list = as_array ? lean_reply_bytes_array(r) : lean_reply_bytes_list(r);
+  } else if (tag == LEAN_REPLY_ERROR) {
+    lean_object* error = mk_redis_reply_error(lean_reply_cstr(r));
+    lean_dec(r);
     return lean_io_result_mk_error(error);
   } else {
     char error_msg[256];
-    snprintf(error_msg, sizeof(error_msg), "LRANGE returned unexpected reply type %d", r->type);
-    freeReplyObject(r);
+    snprintf(error_msg, sizeof(error_msg), "LRANGE returned unexpected reply type %s", lean_reply_type_name(r));
+    lean_dec(r);
     lean_object* error = mk_redis_unexpected_reply_type_error(error_msg);
     return lean_io_result_mk_error(error);
   }
 
-  freeReplyObject(r);
+  lean_dec(r);
   return lean_io_result_mk_ok(result_list);
 }
+
+lean_obj_res l_hiredis_lrange(uint64_t ctx, b_lean_obj_arg key, int64_t start, int64_t stop, lean_obj_arg w) {
+  return redis_lrange_impl(ctx, key, start, stop, 0);
+}
+
+// Same reply built as an Array (contiguous, O(1) size) instead of a List
+lean_obj_res l_hiredis_lrange_array(uint64_t ctx, b_lean_obj_arg key, int64_t start, int64_t stop, lean_obj_arg w) {
+  return redis_lrange_impl(ctx, key, start, stop, 1);
+}
@@ -0,0 +1,284 @@
+// Metrics scrape endpoint for redis-lean
+// A dedicated thread serves HTTP GET /metrics on a local port. Each request
+// calls a Lean callback (`BaseIO String`) that renders the exposition text,
+// so the body always reflects the metrics at scrape time.
+//
+// The server is deliberately minimal: one request per connection, answered
+// with HTTP/1.0 and closed. Scrapes are rare and small, so connections are
+// handled one at a time on the server thread.
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+
+#define METRICS_REQUEST_MAX 4096
+#define METRICS_IO_TIMEOUT_MS 2000
+
+typedef struct {
+    pthread_t thread;
+    pthread_mutex_t lock;    // Guards stopping and the counters
+    int listenfd;
+    int wakefd;
+    int stopping;
+    int port;                // Port actually bound (useful when 0 was asked)
+    lean_object* render;     // BaseIO String
+    uint64_t scrapes;
+} MetricsServer;
+
+static int ms_stopping(MetricsServer* s) {
+    pthread_mutex_lock(&s->lock);
+    int stopping = s->stopping;
+    pthread_mutex_unlock(&s->lock);
+    return stopping;
+}
+
+// Read until the end of the request headers; returns the request length, or
+// -1 on error or timeout
+static ssize_t ms_read_request(int fd, char* buf, size_t cap) {
+    size_t len = 0;
+    while (len < cap - 1) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        if (poll(&pfd, 1, METRICS_IO_TIMEOUT_MS) <= 0) return -1;
+        ssize_t n = read(fd, buf + len, cap - 1 - len);
+        if (n <= 0) return -1;
+        len += (size_t)n;
+        buf[len] = '\0';
+        if (strstr(buf, "\r\n\r\n") || strstr(buf, "\n\n")) break;
+    }
+    return (ssize_t)len;
+}
+
+static int ms_write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        struct pollfd pfd = { fd, POLLOUT, 0 };
+        if (poll(&pfd, 1, METRICS_IO_TIMEOUT_MS) <= 0) return 0;
+        // A scraper that hung up must not raise SIGPIPE in the host process
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            return 0;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+static void ms_respond(int fd, const char* status, const char* body, size_t body_len) {
+    char head[256];
+    int n = snprintf(head, sizeof(head),
+                     "HTTP/1.0 %s\r\n"
+                     "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                     "Content-Length: %zu\r\n"
+                     "Connection: close\r\n\r\n",
+                     status, body_len);
+    if (ms_write_all(fd, head, (size_t)n)) ms_write_all(fd, body, body_len);
+}
+
+static void ms_handle(MetricsServer* s, int fd) {
+    char req[METRICS_REQUEST_MAX];
+    if (ms_read_request(fd, req, sizeof(req)) < 0) return;
+
+    if (strncmp(req, "GET ", 4) != 0) {
+        static const char msg[] = "method not allowed\n";
+        ms_respond(fd, "405 Method Not Allowed", msg, sizeof(msg) - 1);
+        return;
+    }
+    const char* path = req + 4;
+    size_t path_len = strcspn(path, " ?\r\n");
+    if (!((path_len == 8 && strncmp(path, "/metrics", 8) == 0) || (path_len == 1 && path[0] == '/'))) {
+        static const char msg[] = "not found\n";
+        ms_respond(fd, "404 Not Found", msg, sizeof(msg) - 1);
+        return;
+    }
+
+    lean_inc(s->render);
+    lean_object* r = lean_apply_1(s->render, lean_io_mk_world());
+    lean_object* body = lean_io_result_get_value(r);
+    ms_respond(fd, "200 OK", lean_string_cstr(body), lean_string_size(body) - 1);
+    lean_dec(r);
+
+    pthread_mutex_lock(&s->lock);
+    s->scrapes++;
+    pthread_mutex_unlock(&s->lock);
+}
+
+static void* ms_main(void* arg) {
+    MetricsServer* s = (MetricsServer*)arg;
+
+    lean_initialize_thread();
+
+    while (!ms_stopping(s)) {
+        struct pollfd pfds[2] = {
+            { s->listenfd, POLLIN, 0 },
+            { s->wakefd, POLLIN, 0 },
+        };
+        int n = poll(pfds, 2, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (pfds[1].revents & POLLIN) {
+            uint64_t v;
+            ssize_t rd = read(s->wakefd, &v, sizeof(v));
+            (void)rd;
+        }
+        if (pfds[0].revents & POLLIN) {
+            int fd = accept(s->listenfd, NULL, NULL);
+            if (fd >= 0) {
+                ms_handle(s, fd);
+                close(fd);
+            }
+        }
+    }
+
+    lean_finalize_thread();
+    return NULL;
+}
+
+static void ms_release_resources(MetricsServer* s) {
+    if (s->listenfd >= 0) close(s->listenfd);
+    s->listenfd = -1;
+    if (s->wakefd >= 0) close(s->wakefd);
+    s->wakefd = -1;
+    if (s->render) lean_dec(s->render);
+    s->render = NULL;
+}
+
+static void ms_release(MetricsServer* s) {
+    ms_release_resources(s);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+}
+
+// Stop the thread and close the sockets; runs once. The struct stays until
+// the handle is finalized, so that calls on a stopped server are harmless.
+static void ms_shutdown(MetricsServer* s) {
+    pthread_mutex_lock(&s->lock);
+    int already = s->stopping;
+    s->stopping = 1;
+    if (!already) {
+        uint64_t one = 1;
+        ssize_t wr = write(s->wakefd, &one, sizeof(one));
+        (void)wr;
+    }
+    pthread_mutex_unlock(&s->lock);
+    if (already) return;
+
+    pthread_join(s->thread, NULL);
+    pthread_mutex_lock(&s->lock);
+    ms_release_resources(s);
+    pthread_mutex_unlock(&s->lock);
+}
+
+// ============================================================================
+// Handle
+// ============================================================================
+
+// The server is a Lean external object: an unreachable server is stopped and
+// freed by the GC
+static void ms_finalize(void* ptr) {
+    MetricsServer* s = (MetricsServer*)ptr;
+    ms_shutdown(s);
+    ms_release(s);
+}
+
+static void ms_foreach(void* ptr, b_lean_obj_arg f) {
+    (void)ptr;
+    (void)f;
+}
+
+static lean_external_class* g_metrics_server_class = NULL;
+
+static lean_external_class* get_metrics_server_class(void) {
+    if (!g_metrics_server_class) {
+        g_metrics_server_class = lean_register_external_class(ms_finalize, ms_foreach);
+    }
+    return g_metrics_server_class;
+}
+
+static inline MetricsServer* ms_of(b_lean_obj_arg handle) {
+    return (MetricsServer*)lean_get_external_data(handle);
+}
+
+// ============================================================================
+// Lean API
+// ============================================================================
+
+// metrics_server_start :: String -> UInt32 -> BaseIO String -> EIO Error MetricsServerHandle
+// Binds before returning so that address errors are reported here.
+lean_obj_res l_hiredis_metrics_server_start(b_lean_obj_arg host, uint32_t port, lean_obj_arg render,
+                                            lean_obj_arg w) {
+    MetricsServer* s = (MetricsServer*)calloc(1, sizeof(MetricsServer));
+    if (!s) {
+        lean_dec(render);
+        return lean_io_result_mk_error(mk_redis_connect_error_other("Failed to allocate metrics server"));
+    }
+    pthread_mutex_init(&s->lock, NULL);
+    // The callback runs on the server thread
+    lean_mark_mt(render);
+    s->render = render;
+    s->listenfd = -1;
+    s->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (s->wakefd < 0) {
+        ms_release(s);
+        return lean_io_result_mk_error(mk_redis_connect_error_other("Failed to allocate metrics server"));
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, lean_string_cstr(host), &addr.sin_addr) != 1) {
+        ms_release(s);
+        return lean_io_result_mk_error(mk_redis_connect_error_other("metrics server: invalid IPv4 address"));
+    }
+
+    s->listenfd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int one = 1;
+    if (s->listenfd < 0
+        || setsockopt(s->listenfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0
+        || bind(s->listenfd, (struct sockaddr*)&addr, sizeof(addr)) != 0
+        || listen(s->listenfd, 16) != 0) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "metrics server: cannot listen on port %u: %s", port, strerror(errno));
+        ms_release(s);
+        return lean_io_result_mk_error(mk_redis_connect_error_other(msg));
+    }
+    socklen_t len = sizeof(addr);
+    getsockname(s->listenfd, (struct sockaddr*)&addr, &len);
+    s->port = ntohs(addr.sin_port);
+
+    if (pthread_create(&s->thread, NULL, ms_main, s) != 0) {
+        ms_release(s);
+        return lean_io_result_mk_error(mk_redis_connect_error_other("Failed to start metrics server thread"));
+    }
+    return lean_io_result_mk_ok(lean_alloc_external(get_metrics_server_class(), s));
+}
+
+// metrics_server_port :: MetricsServerHandle -> BaseIO UInt32
+lean_obj_res l_hiredis_metrics_server_port(b_lean_obj_arg handle, lean_obj_arg w) {
+    MetricsServer* s = ms_of(handle);
+    return lean_io_result_mk_ok(lean_box_uint32((uint32_t)s->port));
+}
+
+// metrics_server_scrapes :: MetricsServerHandle -> BaseIO UInt64
+lean_obj_res l_hiredis_metrics_server_scrapes(b_lean_obj_arg handle, lean_obj_arg w) {
+    MetricsServer* s = ms_of(handle);
+    pthread_mutex_lock(&s->lock);
+    uint64_t scrapes = s->scrapes;
+    pthread_mutex_unlock(&s->lock);
+    return lean_io_result_mk_ok(lean_box_uint64(scrapes));
+}
+
+// metrics_server_stop :: MetricsServerHandle -> BaseIO Unit
+// Stops the thread and closes the sockets; stopping again does nothing.
+lean_obj_res l_hiredis_metrics_server_stop(b_lean_obj_arg handle, lean_obj_arg w) {
+    ms_shutdown(ms_of(handle));
+    return lean_io_result_mk_ok(lean_box(0));
+}
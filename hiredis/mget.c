@@ -1,84 +1,70 @@
-// mget :: UInt64 -> List ByteArray -> EIO Error (List (Option ByteArray))
+// mget :: UInt64 -> Array ByteArray -> EIO Error (List (Option ByteArray))
+// mget_array :: UInt64 -> Array ByteArray -> EIO Error (Array (Option ByteArray))
 // Get values for multiple keys
-lean_obj_res l_hiredis_mget(uint64_t ctx, b_lean_obj_arg keys, lean_obj_arg w) {
+static lean_obj_res redis_mget_impl(uint64_t ctx, b_lean_obj_arg keys, int as_array) {
   VALIDATE_REDIS_CTX(c, ctx);
 
   // Count keys
-  size_t num_keys = 0;
-  lean_object* current = keys;
-  while (!lean_is_scalar(current)) {
-    num_keys++;
-    current = lean_ctor_get(current, 1);
-  }
+  size_t num_keys = lean_array_size(keys);
 
   if (num_keys == 0) {
-    // Return empty list for empty input
-    return lean_io_result_mk_ok(lean_box(0));
+    // Return empty result for empty input
+    return lean_io_result_mk_ok(as_array ? lean_mk_empty_array() : lean_box(0));
   }
 
   // Build argv: MGET key1 key2 ...
   size_t argc = 1 + num_keys;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "MGET";
   argvlen[0] = 4;
 
-  current = keys;
   size_t i = 1;
-  while (!lean_is_scalar(current)) {
-    lean_object* key = lean_ctor_get(current, 0);
+  for (size_t j = 0; j < num_keys; j++) {
+    lean_object* key = lean_array_get_core(keys, j);
     argv[i] = (const char*)lean_sarray_cptr(key);
     argvlen[i] = lean_sarray_size(key);
-    current = lean_ctor_get(current, 1);
     i++;
   }
 
-  redisReply* r = (redisReply*)redisCommandArgv(c, (int)argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
+  lean_object* r = redis_command_argv_reply(c_conn, (int)argc, argv, argvlen);
 
   if (!r) {
-    lean_object* error = mk_redis_null_reply_error("MGET returned NULL");
+    lean_object* error = c->err ? mk_redis_error_from_context(c)
+                                : mk_redis_null_reply_error("MGET returned NULL");
     return lean_io_result_mk_error(error);
   }
 
   lean_object* result_list;
-  if (r->type == REDIS_REPLY_ARRAY) {
-    result_list = lean_box(0);
-    for (int j = (int)r->elements - 1; j >= 0; j--) {
-      redisReply* element = r->element[j];
-      lean_object* opt_value;
-
-      if (element->type == REDIS_REPLY_NIL) {
-        opt_value = lean_box(0); // None
-      } else if (element->type == REDIS_REPLY_STRING && element->str) {
-        lean_object* byte_array = lean_alloc_sarray(1, element->len, element->len);
-        memcpy(lean_sarray_cptr(byte_array), element->str, element->len);
-        lean_object* some = lean_alloc_ctor(1, 1, 0);
-        lean_ctor_set(some, 0, byte_array);
-        opt_value = some;
-      } else {
-        opt_value = lean_box(0); // None for unexpected types
-      }
-
-      lean_object* list_node = lean_alloc_ctor(1, 2, 0);
-      lean_ctor_set(list_node, 0, opt_value);
-      lean_ctor_set(list_node, 1, result_list);
-      result_list = list_node;
-    }
-  } else if (r->type == REDIS_REPLY_ERROR && r->str) {
-    lean_object* error = mk_redis_reply_error(r->str);
-    freeReplyObject(r);
+  if (lean_obj_tag(r) == LEAN_REPLY_ARRAY) {
+    // None for nil and unexpected element types
+    result_list = as_array ? lean_reply_option_bytes_array(r) : lean_reply_option_bytes_list(r);
+  } else if (lean_obj_tag(r) == LEAN_REPLY_ERROR) {
+    lean_object* error = mk_redis_reply_error(lean_reply_cstr(r));
+    lean_dec(r);
     return lean_io_result_mk_error(error);
   } else {
     char error_msg[256];
-    snprintf(error_msg, sizeof(error_msg), "MGET returned unexpected reply type %d", r->type);
-    freeReplyObject(r);
+    snprintf(error_msg, sizeof(error_msg), "MGET returned unexpected reply type %s", lean_reply_type_name(r));
+    lean_dec(r);
     lean_object* error = mk_redis_unexpected_reply_type_error(error_msg);
     return lean_io_result_mk_error(error);
   }
 
-  freeReplyObject(r);
+  lean_dec(r);
   return lean_io_result_mk_ok(result_list);
 }
+
+lean_obj_res l_hiredis_mget(uint64_t ctx, b_lean_obj_arg keys, lean_obj_arg w) {
+  return redis_mget_impl(ctx, keys, 0);
+}
+
+// Same reply built as an Array (contiguous, O(1) size) instead of a List
+lean_obj_res l_hiredis_mget_array(uint64_t ctx, b_lean_obj_arg keys, lean_obj_arg w) {
+  return redis_mget_impl(ctx, keys, 1);
+}
@@ -1,16 +1,11 @@
-// msetnx :: UInt64 -> List (ByteArray × ByteArray) -> EIO Error Bool
+// msetnx :: UInt64 -> Array (ByteArray × ByteArray) -> EIO Error Bool
 // Set multiple key-value pairs only if none exist
 // Returns true if all keys were set, false if no keys were set
 lean_obj_res l_hiredis_msetnx(uint64_t ctx, b_lean_obj_arg pairs, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
 
   // Count pairs
-  size_t num_pairs = 0;
-  lean_object* current = pairs;
-  while (!lean_is_scalar(current)) {
-    num_pairs++;
-    current = lean_ctor_get(current, 1);
-  }
+  size_t num_pairs = lean_array_size(pairs);
 
   if (num_pairs == 0) {
     lean_object* error = mk_redis_reply_error("MSETNX requires at least one key-value pair");
@@ -19,32 +14,15 @@ lean_obj_res l_hiredis_msetnx(uint64_t ctx, b_lean_obj_arg pairs, lean_obj_arg w
 
   // Build argv: MSETNX key1 val1 key2 val2 ...
   size_t argc = 1 + num_pairs * 2;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
-
-  argv[0] = "MSETNX";
-  argvlen[0] = 6;
-
-  current = pairs;
-  size_t i = 1;
-  while (!lean_is_scalar(current)) {
-    lean_object* pair = lean_ctor_get(current, 0);
-    lean_object* key = lean_ctor_get(pair, 0);
-    lean_object* value = lean_ctor_get(pair, 1);
-
-    argv[i] = (const char*)lean_sarray_cptr(key);
-    argvlen[i] = lean_sarray_size(key);
-    i++;
-    argv[i] = (const char*)lean_sarray_cptr(value);
-    argvlen[i] = lean_sarray_size(value);
-    i++;
-
-    current = lean_ctor_get(current, 1);
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
   }
+  redis_scratch_set_cstr(c_conn, 0, "MSETNX");
+
+  redis_scratch_set_pairs(c_conn, 1, pairs);
 
-  redisReply* r = (redisReply*)redisCommandArgv(c, (int)argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
+  redisReply* r = (redisReply*)redisCommandArgv(c, (int)argc, c_conn->argv, c_conn->argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("MSETNX returned NULL");
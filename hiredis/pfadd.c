@@ -1,4 +1,4 @@
-// pfadd :: UInt64 -> ByteArray -> List ByteArray -> EIO Error Bool
+// pfadd :: UInt64 -> ByteArray -> Array ByteArray -> EIO Error Bool
 // Add elements to a HyperLogLog (returns true if internal registers changed)
 lean_obj_res l_hiredis_pfadd(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg elements, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
@@ -6,36 +6,31 @@ lean_obj_res l_hiredis_pfadd(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg el
   size_t k_len = lean_sarray_size(key);
 
   // Count elements
-  size_t elem_count = 0;
-  lean_object* tmp = elements;
-  while (!lean_is_scalar(tmp)) {
-    elem_count++;
-    tmp = lean_ctor_get(tmp, 1);
-  }
+  size_t elem_count = lean_array_size(elements);
 
   // Build argv: PFADD key element [element ...]
   int argc = 2 + (int)elem_count;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "PFADD";
   argvlen[0] = 5;
   argv[1] = k;
   argvlen[1] = k_len;
 
-  tmp = elements;
   int idx = 2;
-  while (!lean_is_scalar(tmp)) {
-    lean_object* elem = lean_ctor_get(tmp, 0);
+  for (size_t j = 0; j < elem_count; j++) {
+    lean_object* elem = lean_array_get_core(elements, j);
     argv[idx] = (const char*)lean_sarray_cptr(elem);
     argvlen[idx] = lean_sarray_size(elem);
     idx++;
-    tmp = lean_ctor_get(tmp, 1);
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("PFADD returned NULL");
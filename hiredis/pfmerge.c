@@ -1,4 +1,4 @@
-// pfmerge :: UInt64 -> ByteArray -> List ByteArray -> EIO Error Unit
+// pfmerge :: UInt64 -> ByteArray -> Array ByteArray -> EIO Error Unit
 // Merge multiple HyperLogLog keys into a destination key
 lean_obj_res l_hiredis_pfmerge(uint64_t ctx, b_lean_obj_arg dest, b_lean_obj_arg sources, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
@@ -6,36 +6,31 @@ lean_obj_res l_hiredis_pfmerge(uint64_t ctx, b_lean_obj_arg dest, b_lean_obj_arg
   size_t d_len = lean_sarray_size(dest);
 
   // Count source keys
-  size_t src_count = 0;
-  lean_object* tmp = sources;
-  while (!lean_is_scalar(tmp)) {
-    src_count++;
-    tmp = lean_ctor_get(tmp, 1);
-  }
+  size_t src_count = lean_array_size(sources);
 
   // Build argv: PFMERGE dest sourcekey [sourcekey ...]
   int argc = 2 + (int)src_count;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "PFMERGE";
   argvlen[0] = 7;
   argv[1] = d;
   argvlen[1] = d_len;
 
-  tmp = sources;
   int idx = 2;
-  while (!lean_is_scalar(tmp)) {
-    lean_object* src = lean_ctor_get(tmp, 0);
+  for (size_t j = 0; j < src_count; j++) {
+    lean_object* src = lean_array_get_core(sources, j);
     argv[idx] = (const char*)lean_sarray_cptr(src);
     argvlen[idx] = lean_sarray_size(src);
     idx++;
-    tmp = lean_ctor_get(tmp, 1);
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("PFMERGE returned NULL");
@@ -4,10 +4,24 @@
 // Append a command to the output buffer (no network round-trip yet)
 // Returns 0 on success, error code on failure
 lean_obj_res l_hiredis_append_command(uint64_t ctx, b_lean_obj_arg command, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
+    VALIDATE_REDIS_CTX_READING(c, ctx);
     const char* cmd = lean_string_cstr(command);
 
-    int result = redisAppendCommand(c, "%s", cmd);
+    // Tokenize like l_hiredis_command: redisAppendCommand(c, "%s", cmd) would
+    // send the whole string as a single argument
+    char** argv = NULL;
+    size_t* argvlen = NULL;
+    int argc = parse_command_args(cmd, &argv, &argvlen);
+
+    if (argc <= 0) {
+        lean_object* error = mk_redis_null_reply_error("failed to parse command arguments");
+        return lean_io_result_mk_error(error);
+    }
+
+    int result = redisAppendCommandArgv(c, argc, (const char**)argv, argvlen);
+
+    free_parsed_args(argv, argc);
+    if (argvlen) free(argvlen);
 
     if (result != REDIS_OK) {
         lean_object* error = mk_redis_error_from_context(c);
@@ -17,47 +31,21 @@ lean_obj_res l_hiredis_append_command(uint64_t ctx, b_lean_obj_arg command, lean
     return lean_io_result_mk_ok(lean_box(0));
 }
 
-// Append a command with format string and arguments
+// Append a command given as an argument vector (Array ByteArray, binary safe)
 lean_obj_res l_hiredis_append_command_argv(uint64_t ctx, b_lean_obj_arg args, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
+    VALIDATE_REDIS_CTX_READING(c, ctx);
 
-    // Count arguments
-    lean_object* list = args;
-    int argc = 0;
-    while (!lean_is_scalar(list)) {
-        argc++;
-        list = lean_ctor_get(list, 1);
-    }
-
-    if (argc == 0) {
+    if (lean_array_size(args) == 0) {
         lean_object* error = mk_redis_connect_error_other("Empty command");
         return lean_io_result_mk_error(error);
     }
 
-    // Allocate arrays for argv
-    const char** argv = (const char**)malloc(argc * sizeof(char*));
-    size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
-
-    if (!argv || !argvlen) {
-        if (argv) free(argv);
-        if (argvlen) free(argvlen);
+    if (redis_scratch_from_array(c_conn, args) != 0) {
         lean_object* error = mk_redis_connect_error_other("Memory allocation failed");
         return lean_io_result_mk_error(error);
     }
 
-    // Fill argv from list
-    list = args;
-    for (int i = 0; i < argc; i++) {
-        lean_object* elem = lean_ctor_get(list, 0);
-        argv[i] = (const char*)lean_sarray_cptr(elem);
-        argvlen[i] = lean_sarray_size(elem);
-        list = lean_ctor_get(list, 1);
-    }
-
-    int result = redisAppendCommandArgv(c, argc, argv, argvlen);
-
-    free(argv);
-    free(argvlen);
+    int result = redisAppendCommandArgv(c, (int)lean_array_size(args), c_conn->argv, c_conn->argvlen);
 
     if (result != REDIS_OK) {
         lean_object* error = mk_redis_error_from_context(c);
@@ -68,94 +56,31 @@ lean_obj_res l_hiredis_append_command_argv(uint64_t ctx, b_lean_obj_arg args, le
 }
 
 // Get the next reply from the pipeline
-// Returns the reply as ByteArray (serialized)
+// Returns the decoded Redis.Reply (built directly by the Lean reply reader).
+// A top-level error reply is raised as Error.replyError.
 lean_obj_res l_hiredis_get_reply(uint64_t ctx, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
-    redisReply* reply = NULL;
+    VALIDATE_REDIS_CTX_READING(c, ctx);
 
-    int result = redisGetReply(c, (void**)&reply);
+    lean_object* reply = redis_get_reply_lean(c_conn);
 
-    if (result != REDIS_OK || reply == NULL) {
-        if (reply) freeReplyObject(reply);
+    if (reply == NULL) {
         lean_object* error = c->err ? mk_redis_error_from_context(c)
                                     : mk_redis_null_reply_error("No reply available");
         return lean_io_result_mk_error(error);
     }
 
-    // Convert reply to ByteArray based on type
-    lean_object* result_obj;
-
-    switch (reply->type) {
-        case REDIS_REPLY_STRING:
-        case REDIS_REPLY_STATUS:
-        case REDIS_REPLY_VERB:
-            result_obj = lean_mk_empty_byte_array(lean_box(reply->len));
-            memcpy(lean_sarray_cptr(result_obj), reply->str, reply->len);
-            break;
-
-        case REDIS_REPLY_INTEGER: {
-            char buf[32];
-            int len = snprintf(buf, sizeof(buf), "%lld", reply->integer);
-            result_obj = lean_mk_empty_byte_array(lean_box(len));
-            memcpy(lean_sarray_cptr(result_obj), buf, len);
-            break;
-        }
-
-        case REDIS_REPLY_NIL:
-            result_obj = lean_mk_empty_byte_array(lean_box(0));
-            break;
-
-        case REDIS_REPLY_ERROR: {
-            lean_object* err = mk_redis_reply_error(reply->str);
-            freeReplyObject(reply);
-            return lean_io_result_mk_error(err);
-        }
-
-        case REDIS_REPLY_ARRAY:
-        case REDIS_REPLY_SET:
-        case REDIS_REPLY_MAP:
-        case REDIS_REPLY_PUSH:
-            // For arrays, return count as string (caller should use get_reply_array)
-            {
-                char buf[32];
-                int len = snprintf(buf, sizeof(buf), "ARRAY:%zu", reply->elements);
-                result_obj = lean_mk_empty_byte_array(lean_box(len));
-                memcpy(lean_sarray_cptr(result_obj), buf, len);
-            }
-            break;
-
-        case REDIS_REPLY_DOUBLE: {
-            char buf[64];
-            int len = snprintf(buf, sizeof(buf), "%.17g", reply->dval);
-            result_obj = lean_mk_empty_byte_array(lean_box(len));
-            memcpy(lean_sarray_cptr(result_obj), buf, len);
-            break;
-        }
-
-        case REDIS_REPLY_BOOL:
-            result_obj = lean_mk_empty_byte_array(lean_box(1));
-            ((uint8_t*)lean_sarray_cptr(result_obj))[0] = reply->integer ? '1' : '0';
-            break;
-
-        case REDIS_REPLY_BIGNUM:
-            result_obj = lean_mk_empty_byte_array(lean_box(reply->len));
-            memcpy(lean_sarray_cptr(result_obj), reply->str, reply->len);
-            break;
-
-        default: {
-            freeReplyObject(reply);
-            lean_object* err2 = mk_redis_unexpected_reply_type_error("Unknown reply type");
-            return lean_io_result_mk_error(err2);
-        }
+    if (lean_obj_tag(reply) == LEAN_REPLY_ERROR) {
+        lean_object* err = mk_redis_reply_error(lean_reply_cstr(reply));
+        lean_dec(reply);
+        return lean_io_result_mk_error(err);
     }
 
-    freeReplyObject(reply);
-    return lean_io_result_mk_ok(result_obj);
+    return lean_io_result_mk_ok(reply);
 }
 
 // Get pending reply count (commands sent but not yet read)
 lean_obj_res l_hiredis_get_pending_count(uint64_t ctx, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
+    VALIDATE_REDIS_CTX_READING(c, ctx);
 
     // The output buffer length indicates pending commands
     // This is an approximation - hiredis doesn't expose exact count
@@ -166,7 +91,7 @@ lean_obj_res l_hiredis_get_pending_count(uint64_t ctx, lean_obj_arg w) {
 
 // Flush the output buffer (send all pending commands)
 lean_obj_res l_hiredis_flush_pipeline(uint64_t ctx, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
+    VALIDATE_REDIS_CTX_READING(c, ctx);
 
     // redisBufferWrite sends pending data
     int done = 0;
@@ -179,3 +104,79 @@ lean_obj_res l_hiredis_flush_pipeline(uint64_t ctx, lean_obj_arg w) {
 
     return lean_io_result_mk_ok(lean_box(0));
 }
+
+// Drop whatever was appended to the output buffer after it was `len` bytes
+// long (commands not sent yet)
+static void redis_obuf_truncate(redisContext* c, size_t len) {
+    if (len == 0) sdsclear(c->obuf);
+    else sdsrange(c->obuf, 0, (ssize_t)len - 1);
+}
+
+// Execute a whole pipeline in one FFI crossing:
+// append every command, flush the output buffer, then read one reply per
+// command with the Lean reply reader. Returns Array Reply in command order.
+// Error replies stay in the array as Reply.error so that one failing command
+// does not hide the replies of the others; I/O and protocol errors abort.
+lean_obj_res l_hiredis_pipeline_exec(uint64_t ctx, b_lean_obj_arg commands, lean_obj_arg w) {
+    VALIDATE_REDIS_CTX(c, ctx);
+    size_t n = lean_array_size(commands);
+
+    if (!redis_reader_lean_ok(c_conn)) {
+        lean_object* error = mk_redis_connect_error_other("reader busy with a partial reply");
+        return lean_io_result_mk_error(error);
+    }
+
+    // Nothing may reach c->obuf unless the whole batch does: a partly
+    // appended pipeline would be sent with the next command, and its replies
+    // read by the wrong callers
+    for (size_t i = 0; i < n; i++) {
+        if (lean_array_size(lean_array_get_core(commands, i)) == 0) {
+            lean_object* error = mk_redis_connect_error_other("Empty command in pipeline");
+            return lean_io_result_mk_error(error);
+        }
+    }
+
+    size_t obuf_len = sdslen(c->obuf);
+    for (size_t i = 0; i < n; i++) {
+        lean_object* args = lean_array_get_core(commands, i);
+        lean_object* error = NULL;
+        if (redis_scratch_from_array(c_conn, args) != 0) {
+            error = mk_redis_connect_error_other("Memory allocation failed");
+        } else if (redisAppendCommandArgv(c, (int)lean_array_size(args), c_conn->argv, c_conn->argvlen) != REDIS_OK) {
+            error = mk_redis_error_from_context(c);
+        }
+        if (error) {
+            redis_obuf_truncate(c, obuf_len);
+            return lean_io_result_mk_error(error);
+        }
+    }
+
+    int done = 0;
+    while (!done) {
+        if (redisBufferWrite(c, &done) == REDIS_ERR) {
+            lean_object* error = mk_redis_error_from_context(c);
+            return lean_io_result_mk_error(error);
+        }
+    }
+
+    lean_object* replies = lean_alloc_array(0, n);
+    RedisReaderState saved = redis_reader_use_lean(c_conn);
+    for (size_t i = 0; i < n; i++) {
+        void* reply = NULL;
+        int status = redisGetReply(c, &reply);
+        if (status == REDIS_OK) reply = redis_skip_pushes(c, (lean_object*)reply);
+        if (status != REDIS_OK || reply == NULL) {
+            redis_reader_restore(c_conn, saved);
+            if (reply) lean_dec((lean_object*)reply);
+            lean_dec(replies);
+            lean_object* error = c->err ? mk_redis_error_from_context(c)
+                                        : mk_redis_null_reply_error("No reply available");
+            return lean_io_result_mk_error(error);
+        }
+        lean_array_cptr(replies)[i] = (lean_object*)reply;
+        lean_to_array(replies)->m_size = i + 1;
+    }
+    redis_reader_restore(c_conn, saved);
+
+    return lean_io_result_mk_ok(replies);
+}
@@ -2,9 +2,10 @@
 
 // Reconnect using the same connection parameters
 lean_obj_res l_hiredis_reconnect(uint64_t ctx, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
+    VALIDATE_REDIS_CTX_READING(c, ctx);
 
     int result = redisReconnect(c);
+    redis_reader_reset(c_conn);
 
     if (result != REDIS_OK) {
         lean_object* error = mk_redis_error_from_context(c);
@@ -20,7 +21,7 @@ lean_obj_res l_hiredis_is_connected(uint64_t ctx, lean_obj_arg w) {
         return lean_io_result_mk_ok(lean_box(0)); // false
     }
 
-    VALIDATE_REDIS_CTX(c, ctx);
+    VALIDATE_REDIS_CTX_READING(c, ctx);
 
     // Check for errors on the context
     if (c->err) {
@@ -37,13 +38,13 @@ lean_obj_res l_hiredis_is_connected(uint64_t ctx, lean_obj_arg w) {
 
 // Get the file descriptor for the connection
 lean_obj_res l_hiredis_get_fd(uint64_t ctx, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
+    VALIDATE_REDIS_CTX_READING(c, ctx);
     return lean_io_result_mk_ok(lean_box_uint32((uint32_t)c->fd));
 }
 
 // Get the connection error string (if any)
 lean_obj_res l_hiredis_get_error(uint64_t ctx, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
+    VALIDATE_REDIS_CTX_READING(c, ctx);
 
     if (c->err) {
         lean_object* str = lean_mk_string(c->errstr);
@@ -58,7 +59,7 @@ lean_obj_res l_hiredis_get_error(uint64_t ctx, lean_obj_arg w) {
 
 // Clear the error state
 lean_obj_res l_hiredis_clear_error(uint64_t ctx, lean_obj_arg w) {
-    VALIDATE_REDIS_CTX(c, ctx);
+    VALIDATE_REDIS_CTX_READING(c, ctx);
     c->err = 0;
     c->errstr[0] = '\0';
     return lean_io_result_mk_ok(lean_box(0));
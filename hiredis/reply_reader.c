@@ -0,0 +1,567 @@
+// Reply object functions that build Lean `Redis.Reply` values while the
+// hiredis reader parses, instead of an intermediate redisReply tree.
+//
+// Each create* callback allocates the final Lean object and links it into
+// its parent aggregate, so a reply costs one Lean allocation (plus one copy
+// out of the socket buffer) per element, and nothing has to be freed
+// afterwards besides what Lean itself owns.
+
+// Constructor tags of Redis.Reply (RedisLean/Reply.lean) - keep in sync
+#define LEAN_REPLY_BULK    0
+#define LEAN_REPLY_SIMPLE  1
+#define LEAN_REPLY_INT     2
+#define LEAN_REPLY_DOUBLE  3
+#define LEAN_REPLY_BOOL    4
+#define LEAN_REPLY_BIGNUM  5
+#define LEAN_REPLY_ARRAY   6
+#define LEAN_REPLY_MAP     7
+#define LEAN_REPLY_SET     8
+#define LEAN_REPLY_PUSH    9
+#define LEAN_REPLY_NIL     10
+#define LEAN_REPLY_ERROR   11
+
+// ============================================================================
+// Constructors
+// ============================================================================
+
+static inline lean_object* mk_lean_reply_bytes(const char* str, size_t len) {
+    lean_object* data = lean_alloc_sarray(1, len, len);
+    if (len > 0) memcpy(lean_sarray_cptr(data), str, len);
+    lean_object* obj = lean_alloc_ctor(LEAN_REPLY_BULK, 1, 0);
+    lean_ctor_set(obj, 0, data);
+    return obj;
+}
+
+static inline lean_object* mk_lean_reply_string(unsigned tag, const char* str, size_t len) {
+    lean_object* obj = lean_alloc_ctor(tag, 1, 0);
+    lean_ctor_set(obj, 0, lean_mk_string_from_bytes(str, len));
+    return obj;
+}
+
+static inline lean_object* mk_lean_reply_int(long long value) {
+    lean_object* obj = lean_alloc_ctor(LEAN_REPLY_INT, 0, sizeof(uint64_t));
+    lean_ctor_set_uint64(obj, 0, (uint64_t)(int64_t)value);
+    return obj;
+}
+
+static inline lean_object* mk_lean_reply_double(double value) {
+    lean_object* obj = lean_alloc_ctor(LEAN_REPLY_DOUBLE, 0, sizeof(double));
+    lean_ctor_set_float(obj, 0, value);
+    return obj;
+}
+
+static inline lean_object* mk_lean_reply_bool(int value) {
+    lean_object* obj = lean_alloc_ctor(LEAN_REPLY_BOOL, 0, 1);
+    lean_ctor_set_uint8(obj, 0, value ? 1 : 0);
+    return obj;
+}
+
+// Aggregate with room for `capacity` elements (filled in by the children)
+static inline lean_object* mk_lean_reply_aggregate(unsigned tag, size_t capacity) {
+    lean_object* obj = lean_alloc_ctor(tag, 1, 0);
+    lean_ctor_set(obj, 0, lean_alloc_array(0, capacity));
+    return obj;
+}
+
+// ============================================================================
+// Reader callbacks
+// ============================================================================
+
+// Link a freshly created child into its parent aggregate.
+// Arrays/sets/pushes are filled by index. Maps hold (key, value) pairs: the
+// even index creates the pair, the odd index completes it.
+static void lean_reply_attach(const redisReadTask* task, lean_object* obj) {
+    if (task->parent == NULL) return;
+    lean_object* parent = (lean_object*)task->parent->obj;
+    lean_object* elems = lean_ctor_get(parent, 0);
+    size_t idx = (size_t)task->idx;
+
+    if (lean_ptr_tag(parent) == LEAN_REPLY_MAP) {
+        size_t slot = idx / 2;
+        if (idx % 2 == 0) {
+            lean_object* pair = lean_alloc_ctor(0, 2, 0);
+            lean_ctor_set(pair, 0, obj);
+            lean_ctor_set(pair, 1, lean_box(LEAN_REPLY_NIL));
+            lean_array_cptr(elems)[slot] = pair;
+            lean_to_array(elems)->m_size = slot + 1;
+        } else {
+            lean_object* pair = lean_array_cptr(elems)[slot];
+            lean_ctor_set(pair, 1, obj);
+        }
+    } else {
+        lean_array_cptr(elems)[idx] = obj;
+        lean_to_array(elems)->m_size = idx + 1;
+    }
+}
+
+static void* lean_reply_create_string(const redisReadTask* task, char* str, size_t len) {
+    lean_object* obj;
+    switch (task->type) {
+        case REDIS_REPLY_STATUS:
+            obj = mk_lean_reply_string(LEAN_REPLY_SIMPLE, str, len);
+            break;
+        case REDIS_REPLY_ERROR:
+            obj = mk_lean_reply_string(LEAN_REPLY_ERROR, str, len);
+            break;
+        case REDIS_REPLY_BIGNUM:
+            obj = mk_lean_reply_string(LEAN_REPLY_BIGNUM, str, len);
+            break;
+        case REDIS_REPLY_VERB:
+            // Verbatim strings carry a 3 byte format prefix plus ':' ("txt:")
+            obj = len >= 4 ? mk_lean_reply_bytes(str + 4, len - 4)
+                           : mk_lean_reply_bytes(str, len);
+            break;
+        default:
+            obj = mk_lean_reply_bytes(str, len);
+            break;
+    }
+    lean_reply_attach(task, obj);
+    return obj;
+}
+
+static void* lean_reply_create_array(const redisReadTask* task, size_t elements) {
+    lean_object* obj;
+    switch (task->type) {
+        case REDIS_REPLY_MAP:
+        case REDIS_REPLY_ATTR:
+            // hiredis reports maps with 2 * entries elements
+            obj = mk_lean_reply_aggregate(LEAN_REPLY_MAP, elements / 2);
+            break;
+        case REDIS_REPLY_SET:
+            obj = mk_lean_reply_aggregate(LEAN_REPLY_SET, elements);
+            break;
+        case REDIS_REPLY_PUSH:
+            obj = mk_lean_reply_aggregate(LEAN_REPLY_PUSH, elements);
+            break;
+        default:
+            obj = mk_lean_reply_aggregate(LEAN_REPLY_ARRAY, elements);
+            break;
+    }
+    lean_reply_attach(task, obj);
+    return obj;
+}
+
+static void* lean_reply_create_integer(const redisReadTask* task, long long value) {
+    lean_object* obj = mk_lean_reply_int(value);
+    lean_reply_attach(task, obj);
+    return obj;
+}
+
+static void* lean_reply_create_double(const redisReadTask* task, double value, char* str, size_t len) {
+    (void)str;
+    (void)len;
+    lean_object* obj = mk_lean_reply_double(value);
+    lean_reply_attach(task, obj);
+    return obj;
+}
+
+static void* lean_reply_create_nil(const redisReadTask* task) {
+    lean_object* obj = lean_box(LEAN_REPLY_NIL);
+    lean_reply_attach(task, obj);
+    return obj;
+}
+
+static void* lean_reply_create_bool(const redisReadTask* task, int value) {
+    lean_object* obj = mk_lean_reply_bool(value);
+    lean_reply_attach(task, obj);
+    return obj;
+}
+
+// Only ever called by the reader on the root object (children are owned by
+// their parent), so a single dec releases the whole partial tree.
+static void lean_reply_free_object(void* obj) {
+    if (obj) lean_dec((lean_object*)obj);
+}
+
+static redisReplyObjectFunctions lean_reply_functions = {
+    lean_reply_create_string,
+    lean_reply_create_array,
+    lean_reply_create_integer,
+    lean_reply_create_double,
+    lean_reply_create_nil,
+    lean_reply_create_bool,
+    lean_reply_free_object
+};
+
+// ============================================================================
+// Helpers for command wrappers
+// ============================================================================
+
+// Borrow the message of a Reply.error / Reply.simple as a C string
+static inline const char* lean_reply_cstr(b_lean_obj_arg reply) {
+    return lean_string_cstr(lean_ctor_get(reply, 0));
+}
+
+// Number of elements of an aggregate reply (0 for scalars)
+static inline size_t lean_reply_size(b_lean_obj_arg reply) {
+    if (lean_is_scalar(reply)) return 0;
+    switch (lean_ptr_tag(reply)) {
+        case LEAN_REPLY_ARRAY:
+        case LEAN_REPLY_SET:
+        case LEAN_REPLY_PUSH:
+        case LEAN_REPLY_MAP:
+            return lean_array_size(lean_ctor_get(reply, 0));
+        default:
+            return 0;
+    }
+}
+
+static inline int lean_reply_is_aggregate(b_lean_obj_arg reply) {
+    if (lean_is_scalar(reply)) return 0;
+    unsigned tag = lean_ptr_tag(reply);
+    return tag == LEAN_REPLY_ARRAY || tag == LEAN_REPLY_SET ||
+           tag == LEAN_REPLY_PUSH || tag == LEAN_REPLY_MAP;
+}
+
+// Take the ByteArray out of a Reply.bulk (new reference)
+static inline lean_object* lean_reply_take_bytes(b_lean_obj_arg reply) {
+    lean_object* data = lean_ctor_get(reply, 0);
+    lean_inc(data);
+    return data;
+}
+
+// Render a scalar reply as bytes, the way the ByteArray-returning wrappers
+// always have: strings as-is, numbers in decimal, nil and aggregates empty.
+static lean_object* lean_reply_to_bytes_compat(b_lean_obj_arg reply) {
+    if (lean_is_scalar(reply)) return lean_alloc_sarray(1, 0, 0);
+    char buf[64];
+    int len = 0;
+    switch (lean_ptr_tag(reply)) {
+        case LEAN_REPLY_BULK:
+            return lean_reply_take_bytes(reply);
+        case LEAN_REPLY_SIMPLE:
+        case LEAN_REPLY_BIGNUM:
+        case LEAN_REPLY_ERROR: {
+            lean_object* s = lean_ctor_get(reply, 0);
+            size_t n = lean_string_size(s) - 1;
+            lean_object* out = lean_alloc_sarray(1, n, n);
+            memcpy(lean_sarray_cptr(out), lean_string_cstr(s), n);
+            return out;
+        }
+        case LEAN_REPLY_INT:
+            len = snprintf(buf, sizeof(buf), "%" PRId64, (int64_t)lean_ctor_get_uint64(reply, 0));
+            break;
+        case LEAN_REPLY_DOUBLE:
+            len = snprintf(buf, sizeof(buf), "%.17g", lean_ctor_get_float(reply, 0));
+            break;
+        case LEAN_REPLY_BOOL:
+            buf[0] = lean_ctor_get_uint8(reply, 0) ? '1' : '0';
+            len = 1;
+            break;
+        default:
+            return lean_alloc_sarray(1, 0, 0);
+    }
+    lean_object* out = lean_alloc_sarray(1, len, len);
+    memcpy(lean_sarray_cptr(out), buf, len);
+    return out;
+}
+
+// Build a `List ByteArray` from the string elements of an aggregate reply.
+// Maps are flattened to key, value, key, value, ... (RESP3 HGETALL).
+// Non-string elements are skipped, as the redisReply based wrappers did.
+// The ByteArrays are shared with the reply, nothing is copied.
+static lean_object* lean_reply_bytes_list(b_lean_obj_arg reply) {
+    lean_object* list = lean_box(0);
+    if (!lean_reply_is_aggregate(reply)) return list;
+    lean_object* elems = lean_ctor_get(reply, 0);
+    int is_map = lean_ptr_tag(reply) == LEAN_REPLY_MAP;
+    for (size_t i = lean_array_size(elems); i-- > 0; ) {
+        lean_object* elem = lean_array_get_core(elems, i);
+        lean_object* parts[2];
+        int nparts = 0;
+        if (is_map) {
+            parts[0] = lean_ctor_get(elem, 1);
+            parts[1] = lean_ctor_get(elem, 0);
+            nparts = 2;
+        } else {
+            parts[0] = elem;
+            nparts = 1;
+        }
+        for (int j = 0; j < nparts; j++) {
+            lean_object* part = parts[j];
+            if (lean_is_scalar(part) || lean_ptr_tag(part) != LEAN_REPLY_BULK) continue;
+            lean_object* node = lean_alloc_ctor(1, 2, 0);
+            lean_ctor_set(node, 0, lean_reply_take_bytes(part));
+            lean_ctor_set(node, 1, list);
+            list = node;
+        }
+    }
+    return list;
+}
+
+// Build a `List (Option ByteArray)` from an aggregate reply (MGET, HMGET):
+// string elements become `some`, everything else `none`.
+static lean_object* lean_reply_option_bytes_list(b_lean_obj_arg reply) {
+    lean_object* list = lean_box(0);
+    if (!lean_reply_is_aggregate(reply)) return list;
+    lean_object* elems = lean_ctor_get(reply, 0);
+    for (size_t i = lean_array_size(elems); i-- > 0; ) {
+        lean_object* elem = lean_array_get_core(elems, i);
+        lean_object* opt;
+        if (!lean_is_scalar(elem) && lean_ptr_tag(elem) == LEAN_REPLY_BULK) {
+            opt = lean_alloc_ctor(1, 1, 0);
+            lean_ctor_set(opt, 0, lean_reply_take_bytes(elem));
+        } else {
+            opt = lean_box(0);
+        }
+        lean_object* node = lean_alloc_ctor(1, 2, 0);
+        lean_ctor_set(node, 0, opt);
+        lean_ctor_set(node, 1, list);
+        list = node;
+    }
+    return list;
+}
+
+// Array counterparts of the two builders above: one lean_alloc_array sized
+// up front and filled in order, instead of one cons cell per element.
+static lean_object* lean_reply_bytes_array(b_lean_obj_arg reply) {
+    if (!lean_reply_is_aggregate(reply)) return lean_mk_empty_array();
+    lean_object* elems = lean_ctor_get(reply, 0);
+    size_t n = lean_array_size(elems);
+    int is_map = lean_ptr_tag(reply) == LEAN_REPLY_MAP;
+    lean_object* arr = lean_alloc_array(0, is_map ? 2 * n : n);
+    lean_object** out = lean_array_cptr(arr);
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++) {
+        lean_object* elem = lean_array_get_core(elems, i);
+        lean_object* parts[2];
+        int nparts = 0;
+        if (is_map) {
+            parts[0] = lean_ctor_get(elem, 0);
+            parts[1] = lean_ctor_get(elem, 1);
+            nparts = 2;
+        } else {
+            parts[0] = elem;
+            nparts = 1;
+        }
+        for (int j = 0; j < nparts; j++) {
+            lean_object* part = parts[j];
+            if (lean_is_scalar(part) || lean_ptr_tag(part) != LEAN_REPLY_BULK) continue;
+            out[k++] = lean_reply_take_bytes(part);
+        }
+    }
+    lean_to_array(arr)->m_size = k;
+    return arr;
+}
+
+static lean_object* lean_reply_option_bytes_array(b_lean_obj_arg reply) {
+    if (!lean_reply_is_aggregate(reply)) return lean_mk_empty_array();
+    lean_object* elems = lean_ctor_get(reply, 0);
+    size_t n = lean_array_size(elems);
+    lean_object* arr = lean_alloc_array(n, n);
+    lean_object** out = lean_array_cptr(arr);
+    for (size_t i = 0; i < n; i++) {
+        lean_object* elem = lean_array_get_core(elems, i);
+        if (!lean_is_scalar(elem) && lean_ptr_tag(elem) == LEAN_REPLY_BULK) {
+            lean_object* opt = lean_alloc_ctor(1, 1, 0);
+            lean_ctor_set(opt, 0, lean_reply_take_bytes(elem));
+            out[i] = opt;
+        } else {
+            out[i] = lean_box(0);
+        }
+    }
+    return arr;
+}
+
+// Element `i` of an aggregate reply in flattened order: maps count as
+// key, value, key, value, ... like lean_reply_bytes_list
+static lean_object* lean_reply_flat_get(b_lean_obj_arg reply, size_t i) {
+    lean_object* elems = lean_ctor_get(reply, 0);
+    if (lean_ptr_tag(reply) != LEAN_REPLY_MAP) return lean_array_get_core(elems, i);
+    return lean_ctor_get(lean_array_get_core(elems, i / 2), (unsigned)(i % 2));
+}
+
+// Flattened index (see lean_reply_flat_get) of the first element of an
+// aggregate reply that is not a bulk string, or -1 if there is none (used by
+// wrappers that reject mixed replies). Map keys and values are both checked,
+// so that a pair is never half-dropped when the reply is flattened.
+static long lean_reply_first_non_bulk(b_lean_obj_arg reply) {
+    if (!lean_reply_is_aggregate(reply)) return -1;
+    lean_object* elems = lean_ctor_get(reply, 0);
+    size_t n = lean_array_size(elems);
+    if (lean_ptr_tag(reply) == LEAN_REPLY_MAP) n *= 2;
+    for (size_t i = 0; i < n; i++) {
+        lean_object* elem = lean_reply_flat_get(reply, i);
+        if (lean_is_scalar(elem) || lean_ptr_tag(elem) != LEAN_REPLY_BULK) return (long)i;
+    }
+    return -1;
+}
+
+// Short type name used in "unexpected reply type" messages
+static const char* lean_reply_type_name(b_lean_obj_arg reply) {
+    static const char* names[] = {
+        "bulk", "simple", "int", "double", "bool", "bignum",
+        "array", "map", "set", "push", "nil", "error"
+    };
+    unsigned tag = lean_obj_tag(reply);
+    return tag < sizeof(names) / sizeof(names[0]) ? names[tag] : "unknown";
+}
+
+// ============================================================================
+// Stream replies (XREAD, XREADGROUP)
+// ============================================================================
+
+// Append to an array allocated with enough capacity (keeps m_size exact, so
+// a partially filled array can be released with lean_dec on failure)
+static inline void lean_array_append_core(lean_object* arr, lean_object* v) {
+    lean_array_object* a = lean_to_array(arr);
+    a->m_data[a->m_size++] = v;
+}
+
+static inline lean_object* lean_mk_pair(lean_object* a, lean_object* b) {
+    lean_object* pair = lean_alloc_ctor(0, 2, 0);
+    lean_ctor_set(pair, 0, a);
+    lean_ctor_set(pair, 1, b);
+    return pair;
+}
+
+static inline int lean_reply_is_bulk(b_lean_obj_arg reply) {
+    return !lean_is_scalar(reply) && lean_ptr_tag(reply) == LEAN_REPLY_BULK;
+}
+
+// Field/value list of a stream entry -> Array (ByteArray × ByteArray).
+// Entries deleted while pending come back with nil fields (empty result).
+static lean_object* lean_reply_stream_fields(b_lean_obj_arg reply) {
+    if (lean_is_scalar(reply)) return lean_mk_empty_array();
+    lean_object* elems = lean_ctor_get(reply, 0);
+    size_t n = lean_array_size(elems);
+    switch (lean_ptr_tag(reply)) {
+        case LEAN_REPLY_MAP: {
+            lean_object* out = lean_alloc_array(0, n);
+            for (size_t i = 0; i < n; i++) {
+                lean_object* kv = lean_array_get_core(elems, i);
+                lean_object* k = lean_ctor_get(kv, 0);
+                lean_object* v = lean_ctor_get(kv, 1);
+                if (!lean_reply_is_bulk(k) || !lean_reply_is_bulk(v)) { lean_dec(out); return NULL; }
+                lean_array_append_core(out, lean_mk_pair(lean_reply_take_bytes(k), lean_reply_take_bytes(v)));
+            }
+            return out;
+        }
+        case LEAN_REPLY_ARRAY: {
+            if (n % 2 != 0) return NULL;
+            lean_object* out = lean_alloc_array(0, n / 2);
+            for (size_t i = 0; i < n; i += 2) {
+                lean_object* k = lean_array_get_core(elems, i);
+                lean_object* v = lean_array_get_core(elems, i + 1);
+                if (!lean_reply_is_bulk(k) || !lean_reply_is_bulk(v)) { lean_dec(out); return NULL; }
+                lean_array_append_core(out, lean_mk_pair(lean_reply_take_bytes(k), lean_reply_take_bytes(v)));
+            }
+            return out;
+        }
+        default:
+            return NULL;
+    }
+}
+
+// Entries of one stream -> Array (ByteArray × Array (ByteArray × ByteArray))
+static lean_object* lean_reply_stream_entries(b_lean_obj_arg reply) {
+    if (lean_is_scalar(reply)) return lean_mk_empty_array();
+    if (lean_ptr_tag(reply) != LEAN_REPLY_ARRAY) return NULL;
+    lean_object* elems = lean_ctor_get(reply, 0);
+    size_t n = lean_array_size(elems);
+    lean_object* out = lean_alloc_array(0, n);
+    for (size_t i = 0; i < n; i++) {
+        lean_object* entry = lean_array_get_core(elems, i);
+        if (lean_is_scalar(entry) || lean_ptr_tag(entry) != LEAN_REPLY_ARRAY ||
+            lean_reply_size(entry) != 2) { lean_dec(out); return NULL; }
+        lean_object* id = lean_array_get_core(lean_ctor_get(entry, 0), 0);
+        if (!lean_reply_is_bulk(id)) { lean_dec(out); return NULL; }
+        lean_object* fields = lean_reply_stream_fields(lean_array_get_core(lean_ctor_get(entry, 0), 1));
+        if (!fields) { lean_dec(out); return NULL; }
+        lean_array_append_core(out, lean_mk_pair(lean_reply_take_bytes(id), fields));
+    }
+    return out;
+}
+
+// Decode an XREAD/XREADGROUP reply in one pass:
+//   Array (stream × Array (id × Array (field × value)))
+// RESP2 sends [[stream, entries], ...], RESP3 a map stream -> entries; nil
+// (timeout, nothing new) decodes to an empty array. The ByteArrays are
+// shared with the reply. Returns NULL if the reply has an unexpected shape.
+static lean_object* lean_reply_stream_read(b_lean_obj_arg reply) {
+    if (lean_is_scalar(reply)) return lean_mk_empty_array();
+    lean_object* elems = lean_ctor_get(reply, 0);
+    size_t n = lean_array_size(elems);
+    unsigned tag = lean_ptr_tag(reply);
+    if (tag != LEAN_REPLY_ARRAY && tag != LEAN_REPLY_MAP) return NULL;
+    lean_object* out = lean_alloc_array(0, n);
+    for (size_t i = 0; i < n; i++) {
+        lean_object* item = lean_array_get_core(elems, i);
+        lean_object* name;
+        lean_object* entries;
+        if (tag == LEAN_REPLY_MAP) {
+            name = lean_ctor_get(item, 0);
+            entries = lean_ctor_get(item, 1);
+        } else {
+            if (lean_is_scalar(item) || lean_ptr_tag(item) != LEAN_REPLY_ARRAY ||
+                lean_reply_size(item) != 2) { lean_dec(out); return NULL; }
+            name = lean_array_get_core(lean_ctor_get(item, 0), 0);
+            entries = lean_array_get_core(lean_ctor_get(item, 0), 1);
+        }
+        if (!lean_reply_is_bulk(name)) { lean_dec(out); return NULL; }
+        lean_object* decoded = lean_reply_stream_entries(entries);
+        if (!decoded) { lean_dec(out); return NULL; }
+        lean_array_append_core(out, lean_mk_pair(lean_reply_take_bytes(name), decoded));
+    }
+    return out;
+}
+
+// ============================================================================
+// redisReply conversion
+// ============================================================================
+
+// Decode an existing redisReply tree into a Redis.Reply (owned). Used where
+// hiredis hands us replies it built itself (async callbacks); the caller
+// still frees the redisReply.
+static lean_object* lean_reply_from_redis(const redisReply* r) {
+    if (r == NULL) return lean_box(LEAN_REPLY_NIL);
+    switch (r->type) {
+        case REDIS_REPLY_STRING:
+        case REDIS_REPLY_VERB:
+            // redisReply keeps the verbatim format in vtype, str is the text
+            return mk_lean_reply_bytes(r->str, r->len);
+        case REDIS_REPLY_STATUS:
+            return mk_lean_reply_string(LEAN_REPLY_SIMPLE, r->str, r->len);
+        case REDIS_REPLY_ERROR:
+            return mk_lean_reply_string(LEAN_REPLY_ERROR, r->str, r->len);
+        case REDIS_REPLY_BIGNUM:
+            return mk_lean_reply_string(LEAN_REPLY_BIGNUM, r->str, r->len);
+        case REDIS_REPLY_INTEGER:
+            return mk_lean_reply_int(r->integer);
+        case REDIS_REPLY_DOUBLE:
+            return mk_lean_reply_double(r->dval);
+        case REDIS_REPLY_BOOL:
+            return mk_lean_reply_bool((int)r->integer);
+        case REDIS_REPLY_MAP:
+        case REDIS_REPLY_ATTR: {
+            size_t n = r->elements / 2;
+            lean_object* obj = mk_lean_reply_aggregate(LEAN_REPLY_MAP, n);
+            lean_object* elems = lean_ctor_get(obj, 0);
+            for (size_t i = 0; i < n; i++) {
+                lean_object* pair = lean_alloc_ctor(0, 2, 0);
+                lean_ctor_set(pair, 0, lean_reply_from_redis(r->element[2 * i]));
+                lean_ctor_set(pair, 1, lean_reply_from_redis(r->element[2 * i + 1]));
+                lean_array_cptr(elems)[i] = pair;
+            }
+            lean_to_array(elems)->m_size = n;
+            return obj;
+        }
+        case REDIS_REPLY_ARRAY:
+        case REDIS_REPLY_SET:
+        case REDIS_REPLY_PUSH: {
+            unsigned tag = r->type == REDIS_REPLY_SET  ? LEAN_REPLY_SET
+                         : r->type == REDIS_REPLY_PUSH ? LEAN_REPLY_PUSH
+                                                       : LEAN_REPLY_ARRAY;
+            lean_object* obj = mk_lean_reply_aggregate(tag, r->elements);
+            lean_object* elems = lean_ctor_get(obj, 0);
+            for (size_t i = 0; i < r->elements; i++) {
+                lean_array_cptr(elems)[i] = lean_reply_from_redis(r->element[i]);
+            }
+            lean_to_array(elems)->m_size = r->elements;
+            return obj;
+        }
+        case REDIS_REPLY_NIL:
+        default:
+            return lean_box(LEAN_REPLY_NIL);
+    }
+}
@@ -16,6 +16,10 @@ lean_obj_res l_hiredis_scard(uint64_t ctx, b_lean_obj_arg key, lean_obj_arg w) {
   uint64_t count = 0;
   if (r->type == REDIS_REPLY_INTEGER) {
     count = (uint64_t)r->integer;
+  } else if (r->type == REDIS_REPLY_ERROR && r->str) {
+    lean_object* error = mk_redis_reply_error(r->str);
+    freeReplyObject(r);
+    return lean_io_result_mk_error(error);
   } else {
     char error_msg[256];
     snprintf(error_msg, sizeof(error_msg), "SCARD returned unexpected reply type %d", r->type);
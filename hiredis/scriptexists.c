@@ -1,15 +1,10 @@
-// scriptexists :: UInt64 -> List ByteArray -> EIO Error (List Bool)
+// scriptexists :: UInt64 -> Array ByteArray -> EIO Error (List Bool)
 // Check existence of scripts in the script cache
 lean_obj_res l_hiredis_scriptexists(uint64_t ctx, b_lean_obj_arg sha1s, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
 
   // Count SHA1s
-  size_t sha_count = 0;
-  lean_object* tmp = sha1s;
-  while (!lean_is_scalar(tmp)) {
-    sha_count++;
-    tmp = lean_ctor_get(tmp, 1);
-  }
+  size_t sha_count = lean_array_size(sha1s);
 
   if (sha_count == 0) {
     return lean_io_result_mk_ok(lean_box(0)); // empty list
@@ -17,27 +12,27 @@ lean_obj_res l_hiredis_scriptexists(uint64_t ctx, b_lean_obj_arg sha1s, lean_obj
 
   // Build argv: SCRIPT EXISTS sha1 [sha1 ...]
   int argc = 2 + (int)sha_count;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "SCRIPT";
   argvlen[0] = 6;
   argv[1] = "EXISTS";
   argvlen[1] = 6;
 
-  tmp = sha1s;
   int idx = 2;
-  while (!lean_is_scalar(tmp)) {
-    lean_object* sha = lean_ctor_get(tmp, 0);
+  for (size_t j = 0; j < sha_count; j++) {
+    lean_object* sha = lean_array_get_core(sha1s, j);
     argv[idx] = (const char*)lean_sarray_cptr(sha);
     argvlen[idx] = lean_sarray_size(sha);
     idx++;
-    tmp = lean_ctor_get(tmp, 1);
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("SCRIPT EXISTS returned NULL");
@@ -1,39 +1,34 @@
-// sdiff :: UInt64 -> List ByteArray -> EIO Error (List ByteArray)
+// sdiff :: UInt64 -> Array ByteArray -> EIO Error (List ByteArray)
 // Get the difference between the first set and all successive sets
 lean_obj_res l_hiredis_sdiff(uint64_t ctx, b_lean_obj_arg keys, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
 
-  size_t num_keys = 0;
-  lean_object* current = keys;
-  while (!lean_is_scalar(current)) {
-    num_keys++;
-    current = lean_ctor_get(current, 1);
-  }
+  size_t num_keys = lean_array_size(keys);
 
   if (num_keys == 0) {
     return lean_io_result_mk_ok(lean_box(0));
   }
 
   size_t argc = 1 + num_keys;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "SDIFF";
   argvlen[0] = 5;
 
-  current = keys;
   size_t i = 1;
-  while (!lean_is_scalar(current)) {
-    lean_object* key = lean_ctor_get(current, 0);
+  for (size_t j = 0; j < num_keys; j++) {
+    lean_object* key = lean_array_get_core(keys, j);
     argv[i] = (const char*)lean_sarray_cptr(key);
     argvlen[i] = lean_sarray_size(key);
-    current = lean_ctor_get(current, 1);
     i++;
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, (int)argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("SDIFF returned NULL");
@@ -1,39 +1,34 @@
-// sdiffstore :: UInt64 -> ByteArray -> List ByteArray -> EIO Error UInt64
+// sdiffstore :: UInt64 -> ByteArray -> Array ByteArray -> EIO Error UInt64
 // Store the difference of sets in a destination key
 lean_obj_res l_hiredis_sdiffstore(uint64_t ctx, b_lean_obj_arg dst, b_lean_obj_arg keys, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
   const char* d = (const char*)lean_sarray_cptr(dst);
   size_t d_len = lean_sarray_size(dst);
 
-  size_t num_keys = 0;
-  lean_object* current = keys;
-  while (!lean_is_scalar(current)) {
-    num_keys++;
-    current = lean_ctor_get(current, 1);
-  }
+  size_t num_keys = lean_array_size(keys);
 
   size_t argc = 2 + num_keys;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "SDIFFSTORE";
   argvlen[0] = 10;
   argv[1] = d;
   argvlen[1] = d_len;
 
-  current = keys;
   size_t i = 2;
-  while (!lean_is_scalar(current)) {
-    lean_object* key = lean_ctor_get(current, 0);
+  for (size_t j = 0; j < num_keys; j++) {
+    lean_object* key = lean_array_get_core(keys, j);
     argv[i] = (const char*)lean_sarray_cptr(key);
     argvlen[i] = lean_sarray_size(key);
-    current = lean_ctor_get(current, 1);
     i++;
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, (int)argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("SDIFFSTORE returned NULL");
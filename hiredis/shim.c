@@ -5,10 +5,12 @@
 #include <stdlib.h>
 #include <inttypes.h>
 #include <hiredis/hiredis.h>
+#include <hiredis/async.h>
 #include <hiredis/hiredis_ssl.h>
 #include <lean/lean.h>
 
 #include "csu_stubs.c"
+#include "reply_reader.c"
 #include "ssl_context.c"
 #include "errors.c"
 #include "ssl_errors.c"
@@ -223,7 +225,13 @@
 #include "timeout.c"
 #include "unix_socket.c"
 #include "reconnect.c"
+#include "io_stats.c"
 // Pipeline support
 #include "pipeline.c"
 // Async support
-#include "async.c"
\ No newline at end of file
+#include "async.c"
+#include "async_engine.c"
+// Pub/Sub subscriber thread
+#include "subscriber.c"
+// Metrics scrape endpoint
+#include "metrics_server.c"
\ No newline at end of file
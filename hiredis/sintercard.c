@@ -1,22 +1,21 @@
-// sintercard :: UInt64 -> List ByteArray -> Option UInt64 -> EIO Error UInt64
+// sintercard :: UInt64 -> Array ByteArray -> Option UInt64 -> EIO Error UInt64
 // Get the cardinality of the intersection of sets
 lean_obj_res l_hiredis_sintercard(uint64_t ctx, b_lean_obj_arg keys, b_lean_obj_arg limit_opt, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
 
-  size_t num_keys = 0;
-  lean_object* current = keys;
-  while (!lean_is_scalar(current)) {
-    num_keys++;
-    current = lean_ctor_get(current, 1);
-  }
+  size_t num_keys = lean_array_size(keys);
 
   if (num_keys == 0) {
     return lean_io_result_mk_ok(lean_box_uint64(0));
   }
 
   size_t max_argc = 4 + num_keys;
-  const char** argv = (const char**)malloc(max_argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(max_argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, max_argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
   int argc = 0;
 
   argv[argc] = "SINTERCARD";
@@ -29,13 +28,11 @@ lean_obj_res l_hiredis_sintercard(uint64_t ctx, b_lean_obj_arg keys, b_lean_obj_
   argvlen[argc] = strlen(numkeys_str);
   argc++;
 
-  current = keys;
-  while (!lean_is_scalar(current)) {
-    lean_object* key = lean_ctor_get(current, 0);
+  for (size_t j = 0; j < num_keys; j++) {
+    lean_object* key = lean_array_get_core(keys, j);
     argv[argc] = (const char*)lean_sarray_cptr(key);
     argvlen[argc] = lean_sarray_size(key);
     argc++;
-    current = lean_ctor_get(current, 1);
   }
 
   char limit_str[32];
@@ -51,8 +48,6 @@ lean_obj_res l_hiredis_sintercard(uint64_t ctx, b_lean_obj_arg keys, b_lean_obj_
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("SINTERCARD returned NULL");
@@ -18,6 +18,10 @@ lean_obj_res l_hiredis_sismember(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_ar
   int is_member = 0;
   if (r->type == REDIS_REPLY_INTEGER) {
     is_member = (r->integer > 0) ? 1 : 0;
+  } else if (r->type == REDIS_REPLY_ERROR && r->str) {
+    lean_object* error = mk_redis_reply_error(r->str);
+    freeReplyObject(r);
+    return lean_io_result_mk_error(error);
   } else {
     char error_msg[256];
     snprintf(error_msg, sizeof(error_msg), "SISMEMBER returned unexpected reply type %d", r->type);
@@ -1,56 +1,57 @@
 // smembers :: UInt64 -> ByteArray -> EIO Error (List ByteArray)
-lean_obj_res l_hiredis_smembers(uint64_t ctx, b_lean_obj_arg key, lean_obj_arg w) {
+// smembers_array :: UInt64 -> ByteArray -> EIO Error (Array ByteArray)
+static lean_obj_res redis_smembers_impl(uint64_t ctx, b_lean_obj_arg key, int as_array) {
   VALIDATE_REDIS_CTX(c, ctx);
   const char* k = (const char*)lean_sarray_cptr(key);
   size_t k_len = lean_sarray_size(key);
-  
+
   const char* argv[2] = {"SMEMBERS", k};
   size_t argvlen[2] = {8, k_len};
-  redisReply* r = (redisReply*)redisCommandArgv(c, 2, argv, argvlen);
-  
+  lean_object* r = redis_command_argv_reply(c_conn, 2, argv, argvlen);
+
   if (!r) {
-    lean_object* error = mk_redis_null_reply_error("SMEMBERS returned NULL");
+    lean_object* error = c->err ? mk_redis_error_from_context(c)
+                                : mk_redis_null_reply_error("SMEMBERS returned NULL");
     return lean_io_result_mk_error(error);
   }
 
   lean_object* result_list;
-  if (r->type == REDIS_REPLY_ARRAY) {
-    // Build a Lean list from the array reply
-    result_list = lean_box(0); // Start with empty list (nil)
-    
-    // Process array elements in reverse order to build list correctly
-    for (int i = (int)r->elements - 1; i >= 0; i--) {
-      redisReply* element = r->element[i];
-      if (element->type == REDIS_REPLY_STRING && element->str) {
-        lean_object* byte_array = lean_alloc_sarray(1, element->len, element->len);
-        memcpy(lean_sarray_cptr(byte_array), element->str, element->len);
-        
-        lean_object* list_node = lean_alloc_ctor(1, 2, 0); // cons constructor
-        lean_ctor_set(list_node, 0, byte_array);
-        lean_ctor_set(list_node, 1, result_list);
-        result_list = list_node;
-      } else {
-        char error_msg[256];
-        snprintf(error_msg, sizeof(error_msg), "SMEMBERS array element %d has unexpected type %d", i, element->type);
-        freeReplyObject(r);
-        lean_object* error = mk_redis_null_reply_error(error_msg);
-        return lean_io_result_mk_error(error);
-      }
+  unsigned tag = lean_obj_tag(r);
+  if (tag == LEAN_REPLY_ARRAY || tag == LEAN_REPLY_SET) {
+    long bad = lean_reply_first_non_bulk(r);
+    if (bad >= 0) {
+      char error_msg[256];
+      snprintf(error_msg, sizeof(error_msg), "SMEMBERS array element %ld has unexpected type %s",
+               bad, lean_reply_type_name(lean_reply_flat_get(r, (size_t)bad)));
+      lean_dec(r);
+      lean_object* error = mk_redis_null_reply_error(error_msg);
+      return lean_io_result_mk_error(error);
     }
-  } else if (r->type == REDIS_REPLY_ERROR) {
+    // The element ByteArrays are shared with the reply, not copied
+    result_list = as_array ? lean_reply_bytes_array(r) : lean_reply_bytes_list(r);
+  } else if (tag == LEAN_REPLY_ERROR) {
     char error_msg[512];
-    snprintf(error_msg, sizeof(error_msg), "SMEMBERS error: %s", r->str);
-    freeReplyObject(r);
+    snprintf(error_msg, sizeof(error_msg), "SMEMBERS error: %s", lean_reply_cstr(r));
+    lean_dec(r);
     lean_object* error = mk_redis_reply_error(error_msg);
     return lean_io_result_mk_error(error);
   } else {
     char error_msg[256];
-    snprintf(error_msg, sizeof(error_msg), "SMEMBERS returned unexpected reply type %d", r->type);
-    freeReplyObject(r);
+    snprintf(error_msg, sizeof(error_msg), "SMEMBERS returned unexpected reply type %s", lean_reply_type_name(r));
+    lean_dec(r);
     lean_object* error = mk_redis_null_reply_error(error_msg);
     return lean_io_result_mk_error(error);
   }
 
-  freeReplyObject(r);
+  lean_dec(r);
   return lean_io_result_mk_ok(result_list);
 }
+
+lean_obj_res l_hiredis_smembers(uint64_t ctx, b_lean_obj_arg key, lean_obj_arg w) {
+  return redis_smembers_impl(ctx, key, 0);
+}
+
+// Same reply built as an Array (contiguous, O(1) size) instead of a List
+lean_obj_res l_hiredis_smembers_array(uint64_t ctx, b_lean_obj_arg key, lean_obj_arg w) {
+  return redis_smembers_impl(ctx, key, 1);
+}
@@ -1,43 +1,38 @@
-// smismember :: UInt64 -> ByteArray -> List ByteArray -> EIO Error (List Bool)
+// smismember :: UInt64 -> ByteArray -> Array ByteArray -> EIO Error (List Bool)
 // Check if multiple members exist in a set
 lean_obj_res l_hiredis_smismember(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg members, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
   const char* k = (const char*)lean_sarray_cptr(key);
   size_t k_len = lean_sarray_size(key);
 
-  size_t num_members = 0;
-  lean_object* current = members;
-  while (!lean_is_scalar(current)) {
-    num_members++;
-    current = lean_ctor_get(current, 1);
-  }
+  size_t num_members = lean_array_size(members);
 
   if (num_members == 0) {
     return lean_io_result_mk_ok(lean_box(0));
   }
 
   size_t argc = 2 + num_members;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "SMISMEMBER";
   argvlen[0] = 10;
   argv[1] = k;
   argvlen[1] = k_len;
 
-  current = members;
   size_t i = 2;
-  while (!lean_is_scalar(current)) {
-    lean_object* member = lean_ctor_get(current, 0);
+  for (size_t j = 0; j < num_members; j++) {
+    lean_object* member = lean_array_get_core(members, j);
     argv[i] = (const char*)lean_sarray_cptr(member);
     argvlen[i] = lean_sarray_size(member);
-    current = lean_ctor_get(current, 1);
     i++;
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, (int)argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("SMISMEMBER returned NULL");
@@ -2,12 +2,201 @@
 // Holds both redisContext and redisSSLContext together
 // Includes safety features: freed flag, GC finalizer, validation
 
+#include <time.h>
+
+// Number of integer arguments a single command can format into the scratch area
+#define REDIS_SCRATCH_NUMS 4
+
 typedef struct {
     redisContext* redis;
     redisSSLContext* ssl;  // NULL for non-SSL connections
     int freed;             // Safety: track if connection has been freed
+    int lean_partial;      // Reader holds a partially parsed Redis.Reply
+    // Functions to put back into the reader once that reply is complete
+    redisReplyObjectFunctions* legacy_fn;
+    // Scratch argument vector reused by every command on this connection
+    // (see redis_scratch_reserve); grows on demand, freed with the connection
+    const char** argv;
+    size_t* argvlen;
+    size_t argv_cap;
+    char nums[REDIS_SCRATCH_NUMS][32];  // Formatted integer arguments
+    // Byte accounting (see redis_io_install): the transport functions of the
+    // context are wrapped so that every command path is counted, plain or SSL
+    redisContextFuncs funcs;
+    const redisContextFuncs* inner;
+    uint64_t bytes_written;  // Flushed from c->obuf to the socket
+    uint64_t bytes_read;     // Read from the socket into the reader
+    uint64_t mark_written;   // Totals at the last redis_io_take
+    uint64_t mark_read;
+    // Latency phases (see redis_phase_wrap_reader), stamped once timing is on
+    int timing;
+    uint64_t phase_first_write;  // Start of the first write since the reset
+    uint64_t phase_parse_end;    // End of the last reply object callback
+    uint64_t phase_io_ns;        // Spent in transport reads and writes
+    uint64_t phase_object_ns;    // Spent in reply object callbacks
+    // Timed copies of the reader functions: [0] for redisReply, [1] for Redis.Reply
+    redisReplyObjectFunctions timed_fn[2];
+    redisReplyObjectFunctions* timed_inner[2];
 } RedisConnection;
 
+// ============================================================================
+// Latency Phases
+// ============================================================================
+
+// With timing on, a connection stamps the points where a command changes
+// phase, on the same clock as IO.monoNanosNow: the first write (the end of
+// argument marshalling), the time inside the transport functions (network
+// and server) and inside the reply object callbacks (object allocation), and
+// the end of the last callback (the end of reply parsing).
+
+static inline uint64_t redis_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// Functions the timed table in use by the reader stands for
+static inline redisReplyObjectFunctions* redis_phase_inner(RedisConnection* conn) {
+    return conn->redis->reader->fn == &conn->timed_fn[1] ? conn->timed_inner[1] : conn->timed_inner[0];
+}
+
+static inline void redis_phase_object(RedisConnection* conn, uint64_t start) {
+    uint64_t end = redis_now_ns();
+    conn->phase_object_ns += end - start;
+    conn->phase_parse_end = end;
+}
+
+static void* redis_phase_create_string(const redisReadTask* task, char* str, size_t len) {
+    RedisConnection* conn = (RedisConnection*)task->privdata;
+    uint64_t start = redis_now_ns();
+    void* obj = redis_phase_inner(conn)->createString(task, str, len);
+    redis_phase_object(conn, start);
+    return obj;
+}
+
+static void* redis_phase_create_array(const redisReadTask* task, size_t elements) {
+    RedisConnection* conn = (RedisConnection*)task->privdata;
+    uint64_t start = redis_now_ns();
+    void* obj = redis_phase_inner(conn)->createArray(task, elements);
+    redis_phase_object(conn, start);
+    return obj;
+}
+
+static void* redis_phase_create_integer(const redisReadTask* task, long long value) {
+    RedisConnection* conn = (RedisConnection*)task->privdata;
+    uint64_t start = redis_now_ns();
+    void* obj = redis_phase_inner(conn)->createInteger(task, value);
+    redis_phase_object(conn, start);
+    return obj;
+}
+
+static void* redis_phase_create_double(const redisReadTask* task, double value, char* str, size_t len) {
+    RedisConnection* conn = (RedisConnection*)task->privdata;
+    uint64_t start = redis_now_ns();
+    void* obj = redis_phase_inner(conn)->createDouble(task, value, str, len);
+    redis_phase_object(conn, start);
+    return obj;
+}
+
+static void* redis_phase_create_nil(const redisReadTask* task) {
+    RedisConnection* conn = (RedisConnection*)task->privdata;
+    uint64_t start = redis_now_ns();
+    void* obj = redis_phase_inner(conn)->createNil(task);
+    redis_phase_object(conn, start);
+    return obj;
+}
+
+static void* redis_phase_create_bool(const redisReadTask* task, int value) {
+    RedisConnection* conn = (RedisConnection*)task->privdata;
+    uint64_t start = redis_now_ns();
+    void* obj = redis_phase_inner(conn)->createBool(task, value);
+    redis_phase_object(conn, start);
+    return obj;
+}
+
+// Time the object callbacks of the reader. Its functions change under us
+// (redis_reader_use_lean, a fresh reader after redisReconnect), so this runs
+// before every transport call: a table that is not one of ours is copied into
+// the slot of its kind with each callback wrapped. Callbacks the reader does
+// not have stay NULL, and freeing is not timed. Only done between replies, so
+// that every task a timed callback sees carries the connection in privdata.
+static void redis_phase_wrap_reader(RedisConnection* conn) {
+    redisReader* r = conn->redis->reader;
+    if (r == NULL || r->fn == NULL || r->ridx != -1) return;
+    if (r->fn == &conn->timed_fn[0] || r->fn == &conn->timed_fn[1]) return;
+    int slot = r->fn == &lean_reply_functions;
+    redisReplyObjectFunctions* inner = r->fn;
+    redisReplyObjectFunctions* fn = &conn->timed_fn[slot];
+    fn->createString = inner->createString ? redis_phase_create_string : NULL;
+    fn->createArray = inner->createArray ? redis_phase_create_array : NULL;
+    fn->createInteger = inner->createInteger ? redis_phase_create_integer : NULL;
+    fn->createDouble = inner->createDouble ? redis_phase_create_double : NULL;
+    fn->createNil = inner->createNil ? redis_phase_create_nil : NULL;
+    fn->createBool = inner->createBool ? redis_phase_create_bool : NULL;
+    fn->freeObject = inner->freeObject;
+    conn->timed_inner[slot] = inner;
+    r->fn = fn;
+    r->privdata = conn;
+}
+
+// Start of a transport call
+static inline uint64_t redis_phase_io_begin(RedisConnection* conn) {
+    redis_phase_wrap_reader(conn);
+    return redis_now_ns();
+}
+
+static void redis_phase_reset(RedisConnection* conn) {
+    conn->phase_first_write = conn->phase_parse_end = 0;
+    conn->phase_io_ns = conn->phase_object_ns = 0;
+}
+
+// ============================================================================
+// Byte Accounting
+// ============================================================================
+
+static ssize_t redis_io_read(redisContext* c, char* buf, size_t len) {
+    RedisConnection* conn = (RedisConnection*)c->privdata;
+    uint64_t start = conn->timing ? redis_phase_io_begin(conn) : 0;
+    ssize_t n = conn->inner->read(c, buf, len);
+    if (conn->timing) conn->phase_io_ns += redis_now_ns() - start;
+    if (n > 0) conn->bytes_read += (uint64_t)n;
+    return n;
+}
+
+static ssize_t redis_io_write(redisContext* c) {
+    RedisConnection* conn = (RedisConnection*)c->privdata;
+    uint64_t start = 0;
+    if (conn->timing) {
+        start = redis_phase_io_begin(conn);
+        if (conn->phase_first_write == 0) conn->phase_first_write = start;
+    }
+    ssize_t n = conn->inner->write(c);
+    if (conn->timing) conn->phase_io_ns += redis_now_ns() - start;
+    if (n > 0) conn->bytes_written += (uint64_t)n;
+    return n;
+}
+
+// Route the reads and writes of the context through the counters. Must run
+// after the SSL handshake, which installs its own transport functions.
+static void redis_io_install(RedisConnection* conn) {
+    redisContext* c = conn->redis;
+    if (c == NULL || c->funcs == NULL || c->funcs->read == NULL || c->funcs->write == NULL) return;
+    conn->inner = c->funcs;
+    conn->funcs = *c->funcs;
+    conn->funcs.read = redis_io_read;
+    conn->funcs.write = redis_io_write;
+    c->funcs = &conn->funcs;
+    c->privdata = conn;
+}
+
+static void redis_scratch_release(RedisConnection* conn) {
+    free(conn->argv);
+    free(conn->argvlen);
+    conn->argv = NULL;
+    conn->argvlen = NULL;
+    conn->argv_cap = 0;
+}
+
 // ============================================================================
 // GC Finalizer Registration
 // ============================================================================
@@ -27,6 +216,7 @@ static void redis_connection_finalizer(void* ptr) {
                 conn->ssl = NULL;
             }
         }
+        redis_scratch_release(conn);
         free(conn);
     }
 }
@@ -54,9 +244,10 @@ static lean_external_class* get_redis_connection_class(void) {
 // Validation Macro
 // ============================================================================
 
-// Use this macro at the start of every FFI function that takes a context
-// It validates the pointer and checks if the connection has been freed
-#define VALIDATE_REDIS_CTX(ctx_var, conn_ptr) \
+// Like VALIDATE_REDIS_CTX, but also accepted while the reader holds a
+// partial Redis.Reply: for the entry points that drive or finish non-blocking
+// reads (buffer reads and writes, getReply, appends) or do not read at all
+#define VALIDATE_REDIS_CTX_READING(ctx_var, conn_ptr) \
     if ((conn_ptr) == 0) { \
         return lean_io_result_mk_error( \
             mk_redis_connect_error_other("Invalid context: null pointer")); \
@@ -72,6 +263,18 @@ static lean_external_class* get_redis_connection_class(void) {
     } \
     redisContext* ctx_var = ctx_var##_conn->redis;
 
+// Use this macro at the start of every FFI function that takes a context
+// It validates the pointer and checks if the connection has been freed.
+// A command is refused while a reply is partially read: its own reply would
+// be mixed up with the rest of that one. c->err is left alone, so the
+// connection works again once the reply has been read.
+#define VALIDATE_REDIS_CTX(ctx_var, conn_ptr) \
+    VALIDATE_REDIS_CTX_READING(ctx_var, conn_ptr) \
+    if (ctx_var##_conn->lean_partial) { \
+        return lean_io_result_mk_error( \
+            mk_redis_connect_error_other("Reader busy with a partial reply")); \
+    }
+
 // Simpler validation that just gets the connection struct
 #define GET_REDIS_CONN(conn_var, conn_ptr) \
     if ((conn_ptr) == 0) { \
@@ -111,6 +314,18 @@ static RedisConnection* create_redis_connection(redisContext* redis, redisSSLCon
         conn->redis = redis;
         conn->ssl = ssl;
         conn->freed = 0;  // Initialize as not freed
+        conn->lean_partial = 0;
+        conn->legacy_fn = NULL;
+        conn->argv = NULL;
+        conn->argvlen = NULL;
+        conn->argv_cap = 0;
+        conn->inner = NULL;
+        conn->bytes_written = conn->bytes_read = 0;
+        conn->mark_written = conn->mark_read = 0;
+        conn->timing = 0;
+        redis_phase_reset(conn);
+        conn->timed_inner[0] = conn->timed_inner[1] = NULL;
+        redis_io_install(conn);
     }
     return conn;
 }
@@ -129,6 +344,7 @@ static void free_redis_connection(RedisConnection* conn) {
                 conn->ssl = NULL;
             }
         }
+        redis_scratch_release(conn);
         free(conn);
     }
 }
@@ -143,3 +359,215 @@ static lean_object* mk_redis_connection_external(RedisConnection* conn) {
 static inline RedisConnection* get_redis_connection_from_external(lean_object* obj) {
     return (RedisConnection*)lean_get_external_data(obj);
 }
+
+// ============================================================================
+// Lean Reply Reader
+// ============================================================================
+
+// The reader of a connection normally builds redisReply trees. Wrappers that
+// want `Redis.Reply` objects instead switch it to lean_reply_functions
+// (reply_reader.c) around a single request. The push callback is detached at
+// the same time: hiredis' default one inspects replies as redisReply*, which
+// Lean objects are not, so RESP3 pushes come back as Reply.push instead
+// (from getReply; command wrappers skip them, see redis_skip_pushes).
+typedef struct {
+    redisReplyObjectFunctions* fn;
+    redisPushFn* push_cb;
+} RedisReaderState;
+
+// Only safe between replies: a half-parsed reply must be finished by the
+// same object functions that started it.
+static inline int redis_reader_idle(redisContext* c) {
+    return c->reader == NULL || c->reader->ridx == -1;
+}
+
+// The Lean functions may be used when the reader is idle, or when the reply
+// it is in the middle of was started by them (non-blocking reads).
+static inline int redis_reader_lean_ok(RedisConnection* conn) {
+    return redis_reader_idle(conn->redis) || conn->lean_partial;
+}
+
+// While a reply is partial the reader keeps the Lean functions (see
+// redis_reader_restore); the ones to go back to are in conn->legacy_fn.
+static inline RedisReaderState redis_reader_use_lean(RedisConnection* conn) {
+    redisContext* c = conn->redis;
+    RedisReaderState saved = { conn->lean_partial ? conn->legacy_fn : c->reader->fn, c->push_cb };
+    if (!conn->lean_partial) c->reader->fn = &lean_reply_functions;
+    c->push_cb = NULL;
+    // A buffered reply may be parsed without another read
+    if (conn->timing) redis_phase_wrap_reader(conn);
+    return saved;
+}
+
+// A partial reply is made of Lean objects and must be completed (or freed,
+// by redisFree and redisReconnect) by the Lean functions, so they stay in the
+// reader until it is; VALIDATE_REDIS_CTX keeps redisReply commands out.
+static inline void redis_reader_restore(RedisConnection* conn, RedisReaderState saved) {
+    redisContext* c = conn->redis;
+    conn->lean_partial = !redis_reader_idle(c);
+    if (conn->lean_partial) conn->legacy_fn = saved.fn;
+    else if (c->reader) c->reader->fn = saved.fn;
+    c->push_cb = saved.push_cb;
+}
+
+// The reader is in the middle of a reply built by the redisReply functions,
+// which the Lean ones cannot complete: report it in c->err (keeping an
+// earlier error, which is the likely cause) so that the caller's message
+// says why the command was not run
+static void redis_reader_busy(redisContext* c) {
+    if (c->err) return;
+    c->err = REDIS_ERR_OTHER;
+    snprintf(c->errstr, sizeof(c->errstr), "Reader busy with a partial reply");
+}
+
+// The reader after redisReconnect is a fresh one: any partial reply is gone
+static inline void redis_reader_reset(RedisConnection* conn) {
+    conn->lean_partial = 0;
+    conn->legacy_fn = NULL;
+}
+
+// Drop RESP3 pushes (invalidations, keyspace events) that arrive ahead of
+// the reply to a command: with push_cb detached they would be read in its
+// place. `reply` is owned; returns the command reply, or NULL on I/O or
+// protocol errors with the cause in c->err.
+static lean_object* redis_skip_pushes(redisContext* c, lean_object* reply) {
+    while (reply != NULL && lean_obj_tag(reply) == LEAN_REPLY_PUSH) {
+        lean_dec(reply);
+        void* next = NULL;
+        if (redisGetReply(c, &next) != REDIS_OK) {
+            if (next) lean_dec((lean_object*)next);
+            return NULL;
+        }
+        reply = (lean_object*)next;
+    }
+    return reply;
+}
+
+// Execute a command and return the reply as an owned Redis.Reply object.
+// Returns NULL on I/O or protocol errors, or when the reader is busy with a
+// redisReply reply; the cause is left in c->err.
+static lean_object* redis_command_argv_reply(RedisConnection* conn, int argc,
+                                             const char** argv, const size_t* argvlen) {
+    redisContext* c = conn->redis;
+    if (!redis_reader_lean_ok(conn)) {
+        redis_reader_busy(c);
+        return NULL;
+    }
+    RedisReaderState saved = redis_reader_use_lean(conn);
+    lean_object* reply = (lean_object*)redisCommandArgv(c, argc, argv, argvlen);
+    reply = redis_skip_pushes(c, reply);
+    redis_reader_restore(conn, saved);
+    return reply;
+}
+
+// Read the next reply of a pipeline as an owned Redis.Reply object.
+// Returns NULL on I/O or protocol errors, or when the reader is busy with a
+// redisReply reply; the cause is left in c->err.
+static lean_object* redis_get_reply_lean(RedisConnection* conn) {
+    redisContext* c = conn->redis;
+    if (!redis_reader_lean_ok(conn)) {
+        redis_reader_busy(c);
+        return NULL;
+    }
+    RedisReaderState saved = redis_reader_use_lean(conn);
+    void* reply = NULL;
+    int status = redisGetReply(c, &reply);
+    redis_reader_restore(conn, saved);
+    if (status != REDIS_OK) {
+        if (reply) lean_dec((lean_object*)reply);
+        return NULL;
+    }
+    return (lean_object*)reply;
+}
+
+// ============================================================================
+// Argument Scratch Arena
+// ============================================================================
+
+// Commands build their argv/argvlen in a buffer owned by the connection
+// instead of malloc/free per call. The entries borrow Lean ByteArray payloads
+// (or the nums slots) and are only valid until the next command on the same
+// connection, which is fine: hiredis formats the command before returning.
+
+// Make room for at least n arguments. Returns 0, or -1 on allocation failure.
+static int redis_scratch_reserve(RedisConnection* conn, size_t n) {
+    if (n <= conn->argv_cap) return 0;
+    size_t cap = conn->argv_cap ? conn->argv_cap : 16;
+    while (cap < n) cap *= 2;
+    const char** argv = (const char**)realloc((void*)conn->argv, cap * sizeof(char*));
+    if (!argv) return -1;
+    conn->argv = argv;
+    size_t* argvlen = (size_t*)realloc(conn->argvlen, cap * sizeof(size_t));
+    if (!argvlen) return -1;
+    conn->argvlen = argvlen;
+    conn->argv_cap = cap;
+    return 0;
+}
+
+static inline void redis_scratch_set(RedisConnection* conn, size_t i, const char* s, size_t len) {
+    conn->argv[i] = s;
+    conn->argvlen[i] = len;
+}
+
+static inline void redis_scratch_set_cstr(RedisConnection* conn, size_t i, const char* s) {
+    redis_scratch_set(conn, i, s, strlen(s));
+}
+
+static inline void redis_scratch_set_bytes(RedisConnection* conn, size_t i, b_lean_obj_arg bytes) {
+    redis_scratch_set(conn, i, (const char*)lean_sarray_cptr(bytes), lean_sarray_size(bytes));
+}
+
+// Copy the elements of an `Array ByteArray` into argv[at ..]; returns the next index
+static size_t redis_scratch_set_array(RedisConnection* conn, size_t at, b_lean_obj_arg arr) {
+    size_t n = lean_array_size(arr);
+    lean_object** data = lean_array_cptr(arr);
+    for (size_t i = 0; i < n; i++) {
+        redis_scratch_set_bytes(conn, at + i, data[i]);
+    }
+    return at + n;
+}
+
+// Flatten an `Array (ByteArray × ByteArray)` into argv[at ..]; returns the next index
+static size_t redis_scratch_set_pairs(RedisConnection* conn, size_t at, b_lean_obj_arg arr) {
+    size_t n = lean_array_size(arr);
+    lean_object** data = lean_array_cptr(arr);
+    for (size_t i = 0; i < n; i++) {
+        redis_scratch_set_bytes(conn, at++, lean_ctor_get(data[i], 0));
+        redis_scratch_set_bytes(conn, at++, lean_ctor_get(data[i], 1));
+    }
+    return at;
+}
+
+// Format an integer argument into nums[slot] and store it at argv[i]
+static void redis_scratch_set_u64(RedisConnection* conn, size_t i, int slot, uint64_t v) {
+    int len = snprintf(conn->nums[slot], sizeof(conn->nums[slot]), "%" PRIu64, v);
+    redis_scratch_set(conn, i, conn->nums[slot], (size_t)len);
+}
+
+// Fill the scratch argv from an `Array ByteArray` (one argument per element).
+// Returns 0, or -1 on allocation failure.
+static int redis_scratch_from_array(RedisConnection* conn, b_lean_obj_arg args) {
+    if (redis_scratch_reserve(conn, lean_array_size(args)) != 0) return -1;
+    redis_scratch_set_array(conn, 0, args);
+    return 0;
+}
+
+// Take the next reply out of the input buffer without touching the socket.
+// Returns 1 with *out set (NULL if no complete reply is buffered yet), or 0
+// on protocol errors with the cause in c->err. A partial reply stays in the
+// reader as Lean objects and is completed by the next call.
+static int redis_get_buffered_reply_lean(RedisConnection* conn, lean_object** out) {
+    redisContext* c = conn->redis;
+    *out = NULL;
+    if (!redis_reader_lean_ok(conn)) return 0;
+    RedisReaderState saved = redis_reader_use_lean(conn);
+    void* reply = NULL;
+    int status = redisGetReplyFromReader(c, &reply);
+    redis_reader_restore(conn, saved);
+    if (status != REDIS_OK) {
+        if (reply) lean_dec((lean_object*)reply);
+        return 0;
+    }
+    *out = (lean_object*)reply;
+    return 1;
+}
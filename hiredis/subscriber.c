@@ -0,0 +1,536 @@
+// Pub/Sub subscriber for redis-lean
+// A dedicated thread owns a subscribed connection and delivers messages to
+// Lean in batches.
+//
+// The connection uses the Lean reply reader permanently, so messages are
+// decoded straight into Redis.Reply values. Each time the socket is readable
+// the thread reads everything available and passes up to `batch_max` replies
+// per call to the Lean callback (`Array Reply → BaseIO Unit`), instead of one
+// FFI round trip per message.
+//
+// SUBSCRIBE / PSUBSCRIBE / SSUBSCRIBE and their UNSUBSCRIBE counterparts are
+// queued by Lean threads and written by the subscriber thread. The current
+// subscription sets are kept here so that, when the connection drops, the
+// thread reconnects (with backoff) and subscribes to everything again.
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#define SUB_KINDS 3              // channels, patterns, shard channels
+#define SUB_BACKOFF_MIN_MS 100
+#define SUB_BACKOFF_MAX_MS 5000
+
+static const char* sub_commands[SUB_KINDS] = { "SUBSCRIBE", "PSUBSCRIBE", "SSUBSCRIBE" };
+static const char* unsub_commands[SUB_KINDS] = { "UNSUBSCRIBE", "PUNSUBSCRIBE", "SUNSUBSCRIBE" };
+
+typedef struct {
+    char* data;
+    size_t len;
+} SubName;
+
+typedef struct {
+    SubName* items;
+    size_t count;
+    size_t cap;
+} SubSet;
+
+typedef struct SubCommand {
+    struct SubCommand* next;
+    int argc;
+    char** argv;
+    size_t* argvlen;
+} SubCommand;
+
+typedef struct {
+    redisContext* c;         // Owned by the subscriber thread (NULL while reconnecting)
+    char* host;
+    int port;
+    pthread_t thread;
+    pthread_mutex_t lock;    // Guards the sets, the command queue and the counters
+    SubSet sets[SUB_KINDS];
+    SubCommand* head;        // Commands not yet written
+    SubCommand* tail;
+    int stopping;            // stop requested (later stops do nothing)
+    int wakefd;
+    lean_object* on_batch;   // Array Reply → BaseIO Unit
+    size_t batch_max;
+    uint64_t received;       // Replies delivered to Lean
+    uint64_t reconnects;
+} RedisSubscriber;
+
+// ============================================================================
+// Subscription sets
+// ============================================================================
+
+static long sub_set_find(const SubSet* s, const char* data, size_t len) {
+    for (size_t i = 0; i < s->count; i++) {
+        if (s->items[i].len == len && memcmp(s->items[i].data, data, len) == 0) return (long)i;
+    }
+    return -1;
+}
+
+static void sub_set_add(SubSet* s, const char* data, size_t len) {
+    if (sub_set_find(s, data, len) >= 0) return;
+    if (s->count == s->cap) {
+        size_t cap = s->cap ? s->cap * 2 : 8;
+        SubName* items = (SubName*)realloc(s->items, cap * sizeof(SubName));
+        if (!items) return;
+        s->items = items;
+        s->cap = cap;
+    }
+    char* copy = (char*)malloc(len ? len : 1);
+    if (!copy) return;
+    memcpy(copy, data, len);
+    s->items[s->count].data = copy;
+    s->items[s->count].len = len;
+    s->count++;
+}
+
+static void sub_set_remove(SubSet* s, const char* data, size_t len) {
+    long i = sub_set_find(s, data, len);
+    if (i < 0) return;
+    free(s->items[i].data);
+    s->items[i] = s->items[--s->count];
+}
+
+static void sub_set_clear(SubSet* s) {
+    for (size_t i = 0; i < s->count; i++) free(s->items[i].data);
+    s->count = 0;
+}
+
+// ============================================================================
+// Command queue
+// ============================================================================
+
+static void sub_command_free(SubCommand* cmd) {
+    for (int i = 0; i < cmd->argc; i++) free(cmd->argv[i]);
+    free(cmd->argv);
+    free(cmd->argvlen);
+    free(cmd);
+}
+
+// Build `verb name...` from (data, len) pairs; names may be NULL for argc 1
+static SubCommand* sub_command_new(const char* verb, size_t n, const char** names, const size_t* lens) {
+    SubCommand* cmd = (SubCommand*)calloc(1, sizeof(SubCommand));
+    if (!cmd) return NULL;
+    cmd->argv = (char**)calloc(n + 1, sizeof(char*));
+    cmd->argvlen = (size_t*)calloc(n + 1, sizeof(size_t));
+    if (!cmd->argv || !cmd->argvlen) {
+        sub_command_free(cmd);
+        return NULL;
+    }
+    cmd->argv[0] = strdup(verb);
+    if (!cmd->argv[0]) {
+        sub_command_free(cmd);
+        return NULL;
+    }
+    cmd->argvlen[0] = strlen(verb);
+    cmd->argc = 1;
+    for (size_t i = 0; i < n; i++) {
+        char* copy = (char*)malloc(lens[i] ? lens[i] : 1);
+        if (!copy) {
+            sub_command_free(cmd);
+            return NULL;
+        }
+        memcpy(copy, names[i], lens[i]);
+        cmd->argv[cmd->argc] = copy;
+        cmd->argvlen[cmd->argc] = lens[i];
+        cmd->argc++;
+    }
+    return cmd;
+}
+
+// Caller holds the lock
+static void sub_enqueue(RedisSubscriber* s, SubCommand* cmd) {
+    if (s->tail) s->tail->next = cmd; else s->head = cmd;
+    s->tail = cmd;
+}
+
+// Queue a SUBSCRIBE for every name in the sets (after a reconnect).
+// Caller holds the lock; the queue is dropped first since the new
+// connection starts with no subscriptions.
+static void sub_enqueue_resubscribe(RedisSubscriber* s) {
+    while (s->head) {
+        SubCommand* next = s->head->next;
+        sub_command_free(s->head);
+        s->head = next;
+    }
+    s->tail = NULL;
+    for (int k = 0; k < SUB_KINDS; k++) {
+        SubSet* set = &s->sets[k];
+        if (set->count == 0) continue;
+        const char** names = (const char**)malloc(set->count * sizeof(char*));
+        size_t* lens = (size_t*)malloc(set->count * sizeof(size_t));
+        if (names && lens) {
+            for (size_t i = 0; i < set->count; i++) {
+                names[i] = set->items[i].data;
+                lens[i] = set->items[i].len;
+            }
+            SubCommand* cmd = sub_command_new(sub_commands[k], set->count, names, lens);
+            if (cmd) sub_enqueue(s, cmd);
+        }
+        free(names);
+        free(lens);
+    }
+}
+
+static void sub_wake(RedisSubscriber* s) {
+    uint64_t one = 1;
+    ssize_t wr = write(s->wakefd, &one, sizeof(one));
+    (void)wr;
+}
+
+// ============================================================================
+// Subscriber thread
+// ============================================================================
+
+static redisContext* sub_connect(const char* host, int port) {
+    redisContext* c = redisConnect(host, port);
+    if (c == NULL) return NULL;
+    if (c->err) {
+        redisFree(c);
+        return NULL;
+    }
+    // Messages are decoded straight into Redis.Reply values
+    c->reader->fn = &lean_reply_functions;
+    c->push_cb = NULL;
+    return c;
+}
+
+// Write every queued command; returns 0 on I/O error
+static int sub_flush_commands(RedisSubscriber* s) {
+    pthread_mutex_lock(&s->lock);
+    SubCommand* cmd = s->head;
+    s->head = s->tail = NULL;
+    pthread_mutex_unlock(&s->lock);
+
+    int ok = 1;
+    while (cmd) {
+        SubCommand* next = cmd->next;
+        if (ok && redisAppendCommandArgv(s->c, cmd->argc, (const char**)cmd->argv, cmd->argvlen) != REDIS_OK) {
+            ok = 0;
+        }
+        sub_command_free(cmd);
+        cmd = next;
+    }
+    int done = 0;
+    while (ok && !done) {
+        if (redisBufferWrite(s->c, &done) != REDIS_OK) ok = 0;
+    }
+    return ok;
+}
+
+static void sub_deliver(RedisSubscriber* s, lean_object* batch) {
+    pthread_mutex_lock(&s->lock);
+    s->received += lean_array_size(batch);
+    pthread_mutex_unlock(&s->lock);
+    lean_inc(s->on_batch);
+    lean_object* r = lean_apply_2(s->on_batch, batch, lean_io_mk_world());
+    lean_dec(r);
+}
+
+// Read what is available and hand complete replies to Lean in batches;
+// returns 0 on I/O or protocol error
+static int sub_read_batches(RedisSubscriber* s) {
+    if (redisBufferRead(s->c) != REDIS_OK) return 0;
+
+    lean_object* batch = lean_alloc_array(0, s->batch_max);
+    for (;;) {
+        void* reply = NULL;
+        if (redisGetReplyFromReader(s->c, &reply) != REDIS_OK) {
+            lean_dec(batch);
+            return 0;
+        }
+        if (reply == NULL) break;
+        lean_array_append_core(batch, (lean_object*)reply);
+        if (lean_array_size(batch) == s->batch_max) {
+            sub_deliver(s, batch);
+            batch = lean_alloc_array(0, s->batch_max);
+        }
+    }
+    if (lean_array_size(batch) > 0) {
+        sub_deliver(s, batch);
+    } else {
+        lean_dec(batch);
+    }
+    return 1;
+}
+
+// Wait up to `ms` for a wakeup; returns 1 if stopping
+static int sub_sleep(RedisSubscriber* s, int ms) {
+    struct pollfd pfd = { s->wakefd, POLLIN, 0 };
+    if (poll(&pfd, 1, ms) > 0) {
+        uint64_t v;
+        ssize_t rd = read(s->wakefd, &v, sizeof(v));
+        (void)rd;
+    }
+    pthread_mutex_lock(&s->lock);
+    int stopping = s->stopping;
+    pthread_mutex_unlock(&s->lock);
+    return stopping;
+}
+
+static void* sub_main(void* arg) {
+    RedisSubscriber* s = (RedisSubscriber*)arg;
+    int backoff = SUB_BACKOFF_MIN_MS;
+
+    lean_initialize_thread();
+
+    for (;;) {
+        pthread_mutex_lock(&s->lock);
+        int stopping = s->stopping;
+        pthread_mutex_unlock(&s->lock);
+        if (stopping) break;
+
+        if (s->c == NULL) {
+            if (sub_sleep(s, backoff)) break;
+            s->c = sub_connect(s->host, s->port);
+            if (s->c == NULL) {
+                backoff = backoff * 2 > SUB_BACKOFF_MAX_MS ? SUB_BACKOFF_MAX_MS : backoff * 2;
+                continue;
+            }
+            backoff = SUB_BACKOFF_MIN_MS;
+            pthread_mutex_lock(&s->lock);
+            s->reconnects++;
+            sub_enqueue_resubscribe(s);
+            pthread_mutex_unlock(&s->lock);
+        }
+
+        if (!sub_flush_commands(s)) {
+            redisFree(s->c);
+            s->c = NULL;
+            continue;
+        }
+
+        struct pollfd pfds[2] = {
+            { s->c->fd, POLLIN, 0 },
+            { s->wakefd, POLLIN, 0 },
+        };
+        int n = poll(pfds, 2, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (pfds[1].revents & POLLIN) {
+            uint64_t v;
+            ssize_t rd = read(s->wakefd, &v, sizeof(v));
+            (void)rd;
+        }
+        if (pfds[0].revents & (POLLIN | POLLERR | POLLHUP)) {
+            if (!sub_read_batches(s)) {
+                redisFree(s->c);
+                s->c = NULL;
+            }
+        }
+    }
+
+    if (s->c) {
+        redisFree(s->c);
+        s->c = NULL;
+    }
+    lean_finalize_thread();
+    return NULL;
+}
+
+// Everything but the struct and its lock
+static void sub_release_resources(RedisSubscriber* s) {
+    for (int k = 0; k < SUB_KINDS; k++) {
+        sub_set_clear(&s->sets[k]);
+        free(s->sets[k].items);
+        s->sets[k].items = NULL;
+        s->sets[k].cap = 0;
+    }
+    while (s->head) {
+        SubCommand* next = s->head->next;
+        sub_command_free(s->head);
+        s->head = next;
+    }
+    s->tail = NULL;
+    if (s->wakefd >= 0) close(s->wakefd);
+    s->wakefd = -1;
+    if (s->on_batch) lean_dec(s->on_batch);
+    s->on_batch = NULL;
+    free(s->host);
+    s->host = NULL;
+}
+
+static void sub_release(RedisSubscriber* s) {
+    sub_release_resources(s);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+}
+
+// Stop the thread and release the connection and the subscription state;
+// runs once. The struct stays until the handle is finalized, so that calls
+// on a stopped subscriber fail instead of touching freed memory.
+static void sub_shutdown(RedisSubscriber* s) {
+    pthread_mutex_lock(&s->lock);
+    int already = s->stopping;
+    s->stopping = 1;
+    if (!already) sub_wake(s);
+    pthread_mutex_unlock(&s->lock);
+    if (already) return;
+
+    pthread_join(s->thread, NULL);
+    pthread_mutex_lock(&s->lock);
+    sub_release_resources(s);
+    pthread_mutex_unlock(&s->lock);
+}
+
+// ============================================================================
+// Handle
+// ============================================================================
+
+// The subscriber is a Lean external object: unreachable subscribers are
+// stopped and freed by the GC
+static void sub_finalize(void* ptr) {
+    RedisSubscriber* s = (RedisSubscriber*)ptr;
+    sub_shutdown(s);
+    sub_release(s);
+}
+
+static void sub_foreach(void* ptr, b_lean_obj_arg f) {
+    (void)ptr;
+    (void)f;
+}
+
+static lean_external_class* g_subscriber_class = NULL;
+
+static lean_external_class* get_subscriber_class(void) {
+    if (!g_subscriber_class) {
+        g_subscriber_class = lean_register_external_class(sub_finalize, sub_foreach);
+    }
+    return g_subscriber_class;
+}
+
+static inline RedisSubscriber* sub_of(b_lean_obj_arg handle) {
+    return (RedisSubscriber*)lean_get_external_data(handle);
+}
+
+// ============================================================================
+// Lean API
+// ============================================================================
+
+// subscriber_start :: String -> UInt32 -> (Array Reply -> BaseIO Unit) -> UInt64 -> EIO Error SubscriberHandle
+// Connects before returning so that connection errors are reported here.
+lean_obj_res l_hiredis_subscriber_start(b_lean_obj_arg host, uint32_t port, lean_obj_arg on_batch,
+                                        uint64_t batch_max, lean_obj_arg w) {
+    RedisSubscriber* s = (RedisSubscriber*)calloc(1, sizeof(RedisSubscriber));
+    if (!s) {
+        lean_dec(on_batch);
+        return lean_io_result_mk_error(mk_redis_connect_error_other("Failed to allocate subscriber"));
+    }
+    pthread_mutex_init(&s->lock, NULL);
+    // The callback runs on the subscriber thread
+    lean_mark_mt(on_batch);
+    s->on_batch = on_batch;
+    s->batch_max = batch_max > 0 ? (size_t)batch_max : 1;
+    s->port = (int)port;
+    s->host = strdup(lean_string_cstr(host));
+    s->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (!s->host || s->wakefd < 0) {
+        sub_release(s);
+        return lean_io_result_mk_error(mk_redis_connect_error_other("Failed to allocate subscriber"));
+    }
+
+    redisContext* c = redisConnect(s->host, s->port);
+    if (c == NULL || c->err) {
+        lean_object* error = c ? mk_redis_error_from_context(c)
+                               : mk_redis_connect_error_other("Connection allocation failed");
+        if (c) redisFree(c);
+        sub_release(s);
+        return lean_io_result_mk_error(error);
+    }
+    c->reader->fn = &lean_reply_functions;
+    c->push_cb = NULL;
+    s->c = c;
+
+    if (pthread_create(&s->thread, NULL, sub_main, s) != 0) {
+        redisFree(c);
+        s->c = NULL;
+        sub_release(s);
+        return lean_io_result_mk_error(mk_redis_connect_error_other("Failed to start subscriber thread"));
+    }
+    return lean_io_result_mk_ok(lean_alloc_external(get_subscriber_class(), s));
+}
+
+// subscriber_command :: SubscriberHandle -> UInt8 -> UInt8 -> Array ByteArray -> EIO Error Unit
+// kind: 0 = channels, 1 = patterns, 2 = shard channels. An unsubscribe with
+// no names drops every subscription of that kind.
+lean_obj_res l_hiredis_subscriber_command(b_lean_obj_arg handle, uint8_t kind, uint8_t unsubscribe,
+                                          b_lean_obj_arg names, lean_obj_arg w) {
+    RedisSubscriber* s = sub_of(handle);
+    size_t n = lean_array_size(names);
+    if (kind >= SUB_KINDS || (!unsubscribe && n == 0)) {
+        return lean_io_result_mk_error(mk_redis_null_reply_error("subscriber: invalid subscription request"));
+    }
+
+    const char* stack_names[16];
+    size_t stack_lens[16];
+    const char** ptrs = n <= 16 ? stack_names : (const char**)malloc(n * sizeof(char*));
+    size_t* lens = n <= 16 ? stack_lens : (size_t*)malloc(n * sizeof(size_t));
+    if (!ptrs || !lens) {
+        if (ptrs != stack_names) free(ptrs);
+        if (lens != stack_lens) free(lens);
+        return lean_io_result_mk_error(mk_redis_connect_error_other("Failed to allocate command"));
+    }
+    for (size_t i = 0; i < n; i++) {
+        lean_object* name = lean_array_get_core(names, i);
+        ptrs[i] = (const char*)lean_sarray_cptr(name);
+        lens[i] = lean_sarray_size(name);
+    }
+
+    SubCommand* cmd = sub_command_new(unsubscribe ? unsub_commands[kind] : sub_commands[kind], n, ptrs, lens);
+    if (!cmd) {
+        if (ptrs != stack_names) free(ptrs);
+        if (lens != stack_lens) free(lens);
+        return lean_io_result_mk_error(mk_redis_connect_error_other("Failed to allocate command"));
+    }
+
+    pthread_mutex_lock(&s->lock);
+    if (s->stopping) {
+        pthread_mutex_unlock(&s->lock);
+        sub_command_free(cmd);
+        if (ptrs != stack_names) free(ptrs);
+        if (lens != stack_lens) free(lens);
+        return lean_io_result_mk_error(mk_redis_connect_error_io("subscriber closed"));
+    }
+    SubSet* set = &s->sets[kind];
+    if (!unsubscribe) {
+        for (size_t i = 0; i < n; i++) sub_set_add(set, ptrs[i], lens[i]);
+    } else if (n == 0) {
+        sub_set_clear(set);
+    } else {
+        for (size_t i = 0; i < n; i++) sub_set_remove(set, ptrs[i], lens[i]);
+    }
+    sub_enqueue(s, cmd);
+    // Under the lock, so that a concurrent stop cannot have closed the eventfd
+    sub_wake(s);
+    pthread_mutex_unlock(&s->lock);
+
+    if (ptrs != stack_names) free(ptrs);
+    if (lens != stack_lens) free(lens);
+    return lean_io_result_mk_ok(lean_box(0));
+}
+
+// subscriber_stats :: SubscriberHandle -> BaseIO (UInt64 × UInt64)
+// (replies delivered, reconnects); the final counts once stopped
+lean_obj_res l_hiredis_subscriber_stats(b_lean_obj_arg handle, lean_obj_arg w) {
+    RedisSubscriber* s = sub_of(handle);
+    pthread_mutex_lock(&s->lock);
+    uint64_t received = s->received;
+    uint64_t reconnects = s->reconnects;
+    pthread_mutex_unlock(&s->lock);
+    return lean_io_result_mk_ok(lean_mk_pair(lean_box_uint64(received), lean_box_uint64(reconnects)));
+}
+
+// subscriber_stop :: SubscriberHandle -> BaseIO Unit
+// Stops the thread and closes the connection. Idempotent; later
+// (un)subscribe calls fail with "subscriber closed".
+lean_obj_res l_hiredis_subscriber_stop(b_lean_obj_arg handle, lean_obj_arg w) {
+    sub_shutdown(sub_of(handle));
+    return lean_io_result_mk_ok(lean_box(0));
+}
@@ -32,6 +32,10 @@ lean_obj_res l_hiredis_ttl(uint64_t ctx, b_lean_obj_arg key, lean_obj_arg w) {
       lean_object* error = mk_redis_no_expiry_defined_error(k);
       return lean_io_result_mk_error(error);
     }
+  } else if (r->type == REDIS_REPLY_ERROR && r->str) {
+    lean_object* error = mk_redis_reply_error(r->str);
+    freeReplyObject(r);
+    return lean_io_result_mk_error(error);
   } else {
     char error_msg[256];
     snprintf(error_msg, sizeof(error_msg), "TTL returned unexpected reply type %d", r->type);
@@ -79,6 +83,10 @@ lean_obj_res l_hiredis_pttl(uint64_t ctx, b_lean_obj_arg key, lean_obj_arg w) {
       lean_object* error = mk_redis_no_expiry_defined_error(k);
       return lean_io_result_mk_error(error);
     }
+  } else if (r->type == REDIS_REPLY_ERROR && r->str) {
+    lean_object* error = mk_redis_reply_error(r->str);
+    freeReplyObject(r);
+    return lean_io_result_mk_error(error);
   } else {
     char error_msg[256];
     snprintf(error_msg, sizeof(error_msg), "PTTL returned unexpected reply type %d", r->type);
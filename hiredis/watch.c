@@ -1,15 +1,10 @@
-// watch :: UInt64 -> List ByteArray -> EIO Error Unit
+// watch :: UInt64 -> Array ByteArray -> EIO Error Unit
 // Watch keys for changes before a transaction
 lean_obj_res l_hiredis_watch(uint64_t ctx, b_lean_obj_arg keys, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
 
   // Count keys
-  size_t key_count = 0;
-  lean_object* tmp = keys;
-  while (!lean_is_scalar(tmp)) {
-    key_count++;
-    tmp = lean_ctor_get(tmp, 1);
-  }
+  size_t key_count = lean_array_size(keys);
 
   if (key_count == 0) {
     return lean_io_result_mk_ok(lean_box(0));
@@ -17,25 +12,25 @@ lean_obj_res l_hiredis_watch(uint64_t ctx, b_lean_obj_arg keys, lean_obj_arg w)
 
   // Build argv: WATCH key [key ...]
   int argc = 1 + (int)key_count;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "WATCH";
   argvlen[0] = 5;
 
-  tmp = keys;
   int idx = 1;
-  while (!lean_is_scalar(tmp)) {
-    lean_object* key = lean_ctor_get(tmp, 0);
+  for (size_t j = 0; j < key_count; j++) {
+    lean_object* key = lean_array_get_core(keys, j);
     argv[idx] = (const char*)lean_sarray_cptr(key);
     argvlen[idx] = lean_sarray_size(key);
     idx++;
-    tmp = lean_ctor_get(tmp, 1);
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("WATCH returned NULL");
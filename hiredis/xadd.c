@@ -1,4 +1,4 @@
-// xadd :: UInt64 -> ByteArray -> ByteArray -> List (ByteArray × ByteArray) -> Option UInt64 -> EIO RedisError ByteArray
+// xadd :: UInt64 -> ByteArray -> ByteArray -> Array (ByteArray × ByteArray) -> Option UInt64 -> EIO RedisError ByteArray
 // Adds entry to stream with specified ID (or "*" for auto-generation)
 // When maxlen_opt is Some n, uses XADD key MAXLEN ~ n * field value ...
 lean_obj_res l_hiredis_xadd(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg stream_id, b_lean_obj_arg field_values, b_lean_obj_arg maxlen_opt, lean_obj_arg w) {
@@ -9,71 +9,34 @@ lean_obj_res l_hiredis_xadd(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg str
   size_t id_len = lean_sarray_size(stream_id);
 
   // Count field-value pairs
-  lean_object* fv_list = field_values;
-  size_t pair_count = 0;
-  while (lean_obj_tag(fv_list) != 0) { // while not Nil
-    pair_count++;
-    fv_list = lean_ctor_get(fv_list, 1); // get tail
-  }
+  size_t pair_count = lean_array_size(field_values);
 
   // Check if MAXLEN is requested
   int has_maxlen = !lean_is_scalar(maxlen_opt);
 
   // Prepare command: XADD key [MAXLEN ~ N] id field1 value1 field2 value2 ...
   size_t argc = 3 + (pair_count * 2) + (has_maxlen ? 3 : 0);
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
-
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
   size_t arg_idx = 0;
-  argv[arg_idx] = "XADD";
-  argvlen[arg_idx] = 4;
-  arg_idx++;
-
-  argv[arg_idx] = k;
-  argvlen[arg_idx] = k_len;
-  arg_idx++;
+  redis_scratch_set_cstr(c_conn, arg_idx++, "XADD");
+  redis_scratch_set(c_conn, arg_idx++, k, k_len);
 
-  char maxlen_str[32];
   if (has_maxlen) {
-    uint64_t maxlen = lean_unbox_uint64(lean_ctor_get(maxlen_opt, 0));
-    argv[arg_idx] = "MAXLEN";
-    argvlen[arg_idx] = 6;
-    arg_idx++;
-    argv[arg_idx] = "~";
-    argvlen[arg_idx] = 1;
-    arg_idx++;
-    snprintf(maxlen_str, sizeof(maxlen_str), "%lu", (unsigned long)maxlen);
-    argv[arg_idx] = maxlen_str;
-    argvlen[arg_idx] = strlen(maxlen_str);
-    arg_idx++;
+    redis_scratch_set_cstr(c_conn, arg_idx++, "MAXLEN");
+    redis_scratch_set_cstr(c_conn, arg_idx++, "~");
+    redis_scratch_set_u64(c_conn, arg_idx++, 0, lean_unbox_uint64(lean_ctor_get(maxlen_opt, 0)));
   }
 
-  argv[arg_idx] = id;
-  argvlen[arg_idx] = id_len;
-  arg_idx++;
+  redis_scratch_set(c_conn, arg_idx++, id, id_len);
 
   // Add field-value pairs
-  fv_list = field_values;
-  while (lean_obj_tag(fv_list) != 0) {
-    lean_object* pair = lean_ctor_get(fv_list, 0); // get head (field, value)
-    lean_object* field = lean_ctor_get(pair, 0);
-    lean_object* value = lean_ctor_get(pair, 1);
-
-    argv[arg_idx] = (const char*)lean_sarray_cptr(field);
-    argvlen[arg_idx] = lean_sarray_size(field);
-    arg_idx++;
-
-    argv[arg_idx] = (const char*)lean_sarray_cptr(value);
-    argvlen[arg_idx] = lean_sarray_size(value);
-    arg_idx++;
-
-    fv_list = lean_ctor_get(fv_list, 1); // get tail
-  }
+  redis_scratch_set_pairs(c_conn, arg_idx, field_values);
 
-  redisReply* r = (redisReply*)redisCommandArgv(c, argc, argv, argvlen);
+  redisReply* r = (redisReply*)redisCommandArgv(c, argc, c_conn->argv, c_conn->argvlen);
 
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("XADD returned NULL");
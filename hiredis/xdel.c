@@ -1,4 +1,4 @@
-// xdel :: UInt64 -> ByteArray -> List ByteArray -> EIO RedisError UInt64
+// xdel :: UInt64 -> ByteArray -> Array ByteArray -> EIO RedisError UInt64
 // Delete specific entries from a stream by ID
 lean_obj_res l_hiredis_xdel(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg entry_ids, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
@@ -6,12 +6,7 @@ lean_obj_res l_hiredis_xdel(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg ent
   size_t k_len = lean_sarray_size(key);
   
   // Count entry IDs
-  lean_object* id_list = entry_ids;
-  size_t id_count = 0;
-  while (lean_obj_tag(id_list) != 0) { // while not Nil
-    id_count++;
-    id_list = lean_ctor_get(id_list, 1); // get tail
-  }
+  size_t id_count = lean_array_size(entry_ids);
   
   if (id_count == 0) {
     lean_object* error = mk_redis_reply_error("XDEL: no entry IDs provided");
@@ -20,8 +15,12 @@ lean_obj_res l_hiredis_xdel(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg ent
   
   // Build command: XDEL key id1 id2 id3 ...
   size_t argc = 2 + id_count;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
   
   argv[0] = "XDEL";
   argv[1] = k;
@@ -29,20 +28,16 @@ lean_obj_res l_hiredis_xdel(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg ent
   argvlen[1] = k_len;
   
   // Add entry IDs
-  id_list = entry_ids;
   size_t arg_idx = 2;
-  while (lean_obj_tag(id_list) != 0) {
-    lean_object* entry_id = lean_ctor_get(id_list, 0); // get head
+  for (size_t j = 0; j < id_count; j++) {
+    lean_object* entry_id = lean_array_get_core(entry_ids, j);
     argv[arg_idx] = (const char*)lean_sarray_cptr(entry_id);
     argvlen[arg_idx] = lean_sarray_size(entry_id);
     arg_idx++;
-    id_list = lean_ctor_get(id_list, 1); // get tail
   }
   
   redisReply* r = (redisReply*)redisCommandArgv(c, argc, argv, argvlen);
   
-  free(argv);
-  free(argvlen);
   
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("XDEL returned NULL");
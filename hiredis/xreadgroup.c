@@ -1,68 +1,7 @@
-// xreadgroup :: UInt64 -> String -> String -> String -> UInt64 -> EIO RedisError ByteArray
+// xreadgroup :: UInt64 -> String -> String -> String -> UInt64 -> EIO RedisError (Array (ByteArray × Array (ByteArray × Array (ByteArray × ByteArray))))
 // Read from stream using consumer group
 // Args: ctx, group, consumer, stream, count
 
-#include <string.h>
-#include <stdlib.h>
-#include <stdio.h>
-
-// Helper to calculate size needed for serializing a reply to newline-separated format
-static size_t xrg_calc_reply_size(redisReply* reply) {
-  if (!reply) return 0;
-
-  switch (reply->type) {
-    case REDIS_REPLY_STRING:
-    case REDIS_REPLY_STATUS:
-    case REDIS_REPLY_ERROR:
-      return reply->len + 1; // +1 for newline
-    case REDIS_REPLY_INTEGER: {
-      char buf[32];
-      return snprintf(buf, sizeof(buf), "%lld", reply->integer) + 1;
-    }
-    case REDIS_REPLY_ARRAY: {
-      size_t total = 0;
-      for (size_t i = 0; i < reply->elements; i++) {
-        total += xrg_calc_reply_size(reply->element[i]);
-      }
-      return total;
-    }
-    case REDIS_REPLY_NIL:
-      return 0;
-    default:
-      return 0;
-  }
-}
-
-// Helper to serialize a reply to newline-separated format
-static size_t xrg_serialize_reply(redisReply* reply, char* buf, size_t offset) {
-  if (!reply) return offset;
-
-  switch (reply->type) {
-    case REDIS_REPLY_STRING:
-    case REDIS_REPLY_STATUS:
-    case REDIS_REPLY_ERROR:
-      memcpy(buf + offset, reply->str, reply->len);
-      offset += reply->len;
-      buf[offset++] = '\n';
-      return offset;
-    case REDIS_REPLY_INTEGER: {
-      int written = sprintf(buf + offset, "%lld\n", reply->integer);
-      return offset + written;
-    }
-    case REDIS_REPLY_ARRAY: {
-      for (size_t i = 0; i < reply->elements; i++) {
-        offset = xrg_serialize_reply(reply->element[i], buf, offset);
-      }
-      return offset;
-    }
-    case REDIS_REPLY_NIL:
-      return offset;
-    default:
-      return offset;
-  }
-}
-
-// xreadgroup :: UInt64 -> String -> String -> String -> UInt64 -> EIO RedisError ByteArray
 lean_obj_res l_hiredis_xreadgroup(uint64_t ctx, b_lean_obj_arg group_arg, b_lean_obj_arg consumer_arg,
                                    b_lean_obj_arg stream_arg, uint64_t count, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
@@ -105,51 +44,31 @@ lean_obj_res l_hiredis_xreadgroup(uint64_t ctx, b_lean_obj_arg group_arg, b_lean
   argv[8] = ">";  // Read only new messages not yet delivered
   argvlen[8] = 1;
 
-  redisReply* r = (redisReply*)redisCommandArgv(c, 9, argv, argvlen);
+  lean_object* r = redis_command_argv_reply(c_conn, 9, argv, argvlen);
 
   if (!r) {
-    lean_object* error = mk_redis_null_reply_error("XREADGROUP returned NULL");
+    lean_object* error = c->err ? mk_redis_error_from_context(c)
+                                : mk_redis_null_reply_error("XREADGROUP returned NULL");
     return lean_io_result_mk_error(error);
   }
 
-  lean_object* out;
-  if (r->type == REDIS_REPLY_NIL) {
-    // No data available
-    lean_object* result = lean_alloc_sarray(1, 0, 0);
-    out = result;
-  } else if (r->type == REDIS_REPLY_ARRAY) {
-    // Parse the nested structure and serialize to newline-separated format
-    size_t total_size = xrg_calc_reply_size(r);
-    if (total_size == 0) {
-      lean_object* result = lean_alloc_sarray(1, 0, 0);
-      out = result;
-    } else {
-      char* buf = (char*)malloc(total_size + 1);
-      size_t written = xrg_serialize_reply(r, buf, 0);
-
-      // Remove trailing newline if present
-      if (written > 0 && buf[written - 1] == '\n') {
-        written--;
-      }
-
-      lean_object* result = lean_alloc_sarray(1, written, written);
-      memcpy(lean_sarray_cptr(result), buf, written);
-      free(buf);
-      out = result;
-    }
-  } else if (r->type == REDIS_REPLY_ERROR && r->str) {
-    lean_object* error = mk_redis_reply_error(r->str);
-    freeReplyObject(r);
+  if (lean_obj_tag(r) == LEAN_REPLY_ERROR) {
+    lean_object* error = mk_redis_reply_error(lean_reply_cstr(r));
+    lean_dec(r);
     return lean_io_result_mk_error(error);
-  } else {
+  }
+
+  // nil (timeout or no new entries) decodes to an empty array
+  lean_object* out = lean_reply_stream_read(r);
+  if (!out) {
     char error_msg[256];
-    snprintf(error_msg, sizeof(error_msg), "XREADGROUP returned unexpected reply type %d", r->type);
-    freeReplyObject(r);
+    snprintf(error_msg, sizeof(error_msg), "XREADGROUP returned malformed %s reply", lean_reply_type_name(r));
+    lean_dec(r);
     lean_object* error = mk_redis_unexpected_reply_type_error(error_msg);
     return lean_io_result_mk_error(error);
   }
 
-  freeReplyObject(r);
+  lean_dec(r);
   return lean_io_result_mk_ok(out);
 }
 
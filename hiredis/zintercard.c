@@ -1,15 +1,10 @@
-// zintercard :: UInt64 -> List ByteArray -> Option UInt64 -> EIO Error UInt64
+// zintercard :: UInt64 -> Array ByteArray -> Option UInt64 -> EIO Error UInt64
 // Get the cardinality of the intersection of multiple sorted sets
 lean_obj_res l_hiredis_zintercard(uint64_t ctx, b_lean_obj_arg keys, b_lean_obj_arg limit_opt, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
 
   // Count keys
-  size_t key_count = 0;
-  lean_object* tmp = keys;
-  while (!lean_is_scalar(tmp)) {
-    key_count++;
-    tmp = lean_ctor_get(tmp, 1);
-  }
+  size_t key_count = lean_array_size(keys);
 
   if (key_count == 0) {
     return lean_io_result_mk_ok(lean_box_uint64(0));
@@ -18,8 +13,12 @@ lean_obj_res l_hiredis_zintercard(uint64_t ctx, b_lean_obj_arg keys, b_lean_obj_
   // Build argv: ZINTERCARD numkeys key [key ...] [LIMIT limit]
   int has_limit = !lean_is_scalar(limit_opt);
   int argc = 2 + (int)key_count + (has_limit ? 2 : 0);
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "ZINTERCARD";
   argvlen[0] = 10;
@@ -29,14 +28,12 @@ lean_obj_res l_hiredis_zintercard(uint64_t ctx, b_lean_obj_arg keys, b_lean_obj_
   argv[1] = numkeys_str;
   argvlen[1] = strlen(numkeys_str);
 
-  tmp = keys;
   int idx = 2;
-  while (!lean_is_scalar(tmp)) {
-    lean_object* key = lean_ctor_get(tmp, 0);
+  for (size_t j = 0; j < key_count; j++) {
+    lean_object* key = lean_array_get_core(keys, j);
     argv[idx] = (const char*)lean_sarray_cptr(key);
     argvlen[idx] = lean_sarray_size(key);
     idx++;
-    tmp = lean_ctor_get(tmp, 1);
   }
 
   char limit_str[32];
@@ -51,8 +48,6 @@ lean_obj_res l_hiredis_zintercard(uint64_t ctx, b_lean_obj_arg keys, b_lean_obj_
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("ZINTERCARD returned NULL");
@@ -1,4 +1,4 @@
-// zmscore :: UInt64 -> ByteArray -> List ByteArray -> EIO Error (List (Option Float))
+// zmscore :: UInt64 -> ByteArray -> Array ByteArray -> EIO Error (List (Option Float))
 // Get the scores of multiple members in a sorted set
 lean_obj_res l_hiredis_zmscore(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg members, lean_obj_arg w) {
   VALIDATE_REDIS_CTX(c, ctx);
@@ -6,12 +6,7 @@ lean_obj_res l_hiredis_zmscore(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg
   size_t k_len = lean_sarray_size(key);
 
   // Count members
-  size_t member_count = 0;
-  lean_object* tmp = members;
-  while (!lean_is_scalar(tmp)) {
-    member_count++;
-    tmp = lean_ctor_get(tmp, 1);
-  }
+  size_t member_count = lean_array_size(members);
 
   if (member_count == 0) {
     return lean_io_result_mk_ok(lean_box(0)); // empty list
@@ -19,27 +14,27 @@ lean_obj_res l_hiredis_zmscore(uint64_t ctx, b_lean_obj_arg key, b_lean_obj_arg
 
   // Build argv: ZMSCORE key member [member ...]
   int argc = 2 + (int)member_count;
-  const char** argv = (const char**)malloc(argc * sizeof(char*));
-  size_t* argvlen = (size_t*)malloc(argc * sizeof(size_t));
+  if (redis_scratch_reserve(c_conn, argc) != 0) {
+    lean_object* error = mk_redis_null_reply_error("memory allocation failed");
+    return lean_io_result_mk_error(error);
+  }
+  const char** argv = c_conn->argv;
+  size_t* argvlen = c_conn->argvlen;
 
   argv[0] = "ZMSCORE";
   argvlen[0] = 7;
   argv[1] = k;
   argvlen[1] = k_len;
 
-  tmp = members;
   int idx = 2;
-  while (!lean_is_scalar(tmp)) {
-    lean_object* member = lean_ctor_get(tmp, 0);
+  for (size_t j = 0; j < member_count; j++) {
+    lean_object* member = lean_array_get_core(members, j);
     argv[idx] = (const char*)lean_sarray_cptr(member);
     argvlen[idx] = lean_sarray_size(member);
     idx++;
-    tmp = lean_ctor_get(tmp, 1);
   }
 
   redisReply* r = (redisReply*)redisCommandArgv(c, argc, argv, argvlen);
-  free(argv);
-  free(argvlen);
 
   if (!r) {
     lean_object* error = mk_redis_null_reply_error("ZMSCORE returned NULL");